@@ -8,9 +8,67 @@
 #include <cstring>
 #include <algorithm>
 
+// Start of a snapshot, "SRSN", and its layout version
+static const uint32_t SNAPSHOT_MAGIC = 0x5352534e;
+static const uint32_t SNAPSHOT_VERSION = 5;
+
+// Seed of the next instance
+static std::atomic<uint32_t> nextNoiseSeed(0);
+
+// Salts that tell the noise generators of an instance apart
+static const uint32_t NOISE_SALT_ROOM = 1;
+static const uint32_t NOISE_SALT_HALL = 2;
+static const uint32_t NOISE_SALT_HYBRID = 3;
+
+// Seed of one generator, the instance seed and salt mixed (murmur3 finalizer)
+static uint32_t noiseSeedFor(uint32_t seed, uint32_t salt)
+{
+    uint32_t x = seed * 0x9e3779b9U + salt;
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+
+// nrevb damps with one-pole comb filters, the coefficient for a cutoff (Hz)
+float StudioReverbDSP::plateDamp(float freq, double rate)
+{
+    return static_cast<float>(std::exp(-2.0 * M_PI * std::max(freq, 0.0f) / rate));
+}
+
+// The plate allpass feedback for a diffusion of 0-1
+float StudioReverbDSP::plateDiffusion(float diffusion)
+{
+    return 0.2f + diffusion * 0.6f;
+}
+
+// A mono block comes with the same pointer for both channels
+static void processInputs(fv3::revbase_f& reverb, const float** inputs, uint32_t offset,
+                          float* outputL, float* outputR, uint32_t frames)
+{
+    float* inputL = const_cast<float*>(inputs[0]) + offset;
+    if (inputs[0] == inputs[1])
+        reverb.processreplaceM(inputL, outputL, outputR, frames);
+    else
+        reverb.processreplace(inputL, const_cast<float*>(inputs[1]) + offset, outputL, outputR, frames);
+}
+
 StudioReverbDSP::StudioReverbDSP(double sampleRate)
     : sampleRate(sampleRate),
-      currentReverbType(REVERB_ROOM)
+      currentReverbType(REVERB_ROOM),
+      quality(QUALITY_HIGH),
+      pendingQuality(QUALITY_HIGH),
+      activeQuality(QUALITY_HIGH),
+      modulationPending(false),
+      monoInput(false),
+      noiseSeed(0),
+      hybrid(sampleRate),
+      probe(nullptr),
+      load(sampleRate),
+      governedQuality(QUALITY_HIGH),
+      lastBlockFrames(0)
 {
     // Initialize parameters with defaults
     params[paramReverbType] = REVERB_ROOM;
@@ -32,6 +90,8 @@ StudioReverbDSP::StudioReverbDSP(double sampleRate)
     initializeHallReverb();
     initializePlateReverb();
     initializeEarlyReflections();
+    initializeHybridReverb();
+    setNoiseSeed(nextNoiseSeed.fetch_add(1));
 
     // Apply initial parameters
     for (uint32_t i = 0; i < paramCount; i++) {
@@ -43,18 +103,102 @@ StudioReverbDSP::~StudioReverbDSP()
 {
 }
 
+void StudioReverbDSP::initializeEarly(fv3::earlyref_f& early, ReverbType type, double sampleRate)
+{
+    early.setMuteOnChange(false);
+    early.setdryr(0);  // No dry signal in processor
+    early.setwet(0);   // 0dB wet signal
+
+    switch(type) {
+        case REVERB_ROOM:
+            early.loadPresetReflection(FV3_EARLYREF_PRESET_1);
+            early.setwidth(0.8f);
+            early.setLRDelay(0.3f);
+            early.setLRCrossApFreq(750, 4);
+            early.setDiffusionApFreq(150, 4);
+            break;
+
+        case REVERB_HALL:
+            early.loadPresetReflection(FV3_EARLYREF_PRESET_2);  // Different preset for hall
+            early.setwidth(1.0f);
+            early.setLRDelay(0.5f);
+            early.setLRCrossApFreq(500, 4);
+            early.setDiffusionApFreq(100, 4);
+            break;
+
+        case REVERB_EARLY_REFLECTIONS:
+            early.loadPresetReflection(FV3_EARLYREF_PRESET_0);  // Simple early reflections
+            early.setwidth(1.0f);
+            early.setLRDelay(0.2f);
+            early.setLRCrossApFreq(1000, 4);
+            early.setDiffusionApFreq(200, 4);
+            break;
+
+        default:
+            // The hybrid's stand-in for the IR head, the plate has none
+            early.loadPresetReflection(FV3_EARLYREF_PRESET_1);
+            early.setwidth(1.0f);
+            early.setLRDelay(0.3f);
+            early.setLRCrossApFreq(750, 4);
+            early.setDiffusionApFreq(150, 4);
+            break;
+    }
+
+    early.setSampleRate(sampleRate);
+}
+
+void StudioReverbDSP::setEarlyParameter(fv3::earlyref_f& early, ReverbType type, uint32_t index, float value)
+{
+    switch(index) {
+        case paramSize:
+            {
+                float sizeFactor = value / 50.0f;  // 0-100% -> 0-2x
+                if (type == REVERB_HALL)
+                    sizeFactor *= 1.5f;  // Hall is larger
+                early.setRSFactor(sizeFactor);
+            }
+            break;
+
+        case paramWidth:
+            early.setwidth(value / 100.0f);
+            break;
+
+        case paramPredelay:
+            early.setPreDelay(value);
+            break;
+
+        case paramDiffuse:
+            {
+                float diffusion = value / 100.0f;
+                int diffuseStages = static_cast<int>(diffusion * 10);
+                switch(type) {
+                    case REVERB_HALL:
+                        early.setDiffusionApFreq(100 + diffusion * 400, diffuseStages);
+                        break;
+                    case REVERB_EARLY_REFLECTIONS:
+                        early.setDiffusionApFreq(200 + diffusion * 300, diffuseStages);
+                        break;
+                    default:
+                        early.setDiffusionApFreq(150 + diffusion * 350, diffuseStages);
+                        break;
+                }
+            }
+            break;
+
+        case paramLowCut:
+            early.setoutputhpf(value);
+            break;
+
+        case paramHighCut:
+            early.setoutputlpf(value);
+            break;
+    }
+}
+
 void StudioReverbDSP::initializeRoomReverb()
 {
     // Room reverb uses earlyref + progenitor2
-    roomEarly.loadPresetReflection(FV3_EARLYREF_PRESET_1);
-    roomEarly.setMuteOnChange(false);
-    roomEarly.setdryr(0);  // No dry signal in processor
-    roomEarly.setwet(0);   // 0dB wet signal
-    roomEarly.setwidth(0.8f);
-    roomEarly.setLRDelay(0.3f);
-    roomEarly.setLRCrossApFreq(750, 4);
-    roomEarly.setDiffusionApFreq(150, 4);
-    roomEarly.setSampleRate(sampleRate);
+    initializeEarly(roomEarly, REVERB_ROOM, sampleRate);
 
     roomLate.setMuteOnChange(false);
     roomLate.setwet(0);   // 0dB wet signal
@@ -74,15 +218,7 @@ void StudioReverbDSP::initializeRoomReverb()
 void StudioReverbDSP::initializeHallReverb()
 {
     // Hall reverb uses earlyref + progenitor2 with different settings
-    hallEarly.loadPresetReflection(FV3_EARLYREF_PRESET_2);  // Different preset for hall
-    hallEarly.setMuteOnChange(false);
-    hallEarly.setdryr(0);
-    hallEarly.setwet(0);
-    hallEarly.setwidth(1.0f);
-    hallEarly.setLRDelay(0.5f);
-    hallEarly.setLRCrossApFreq(500, 4);
-    hallEarly.setDiffusionApFreq(100, 4);
-    hallEarly.setSampleRate(sampleRate);
+    initializeEarly(hallEarly, REVERB_HALL, sampleRate);
 
     hallLate.setMuteOnChange(false);
     hallLate.setwet(0);
@@ -100,8 +236,8 @@ void StudioReverbDSP::initializeHallReverb()
 
     // Hall has modulation
     hallLate.setdccutfreq(100.0f);
-    hallLate.setmoddepth(0.02f);
-    hallLate.setmodfreq(0.5f);
+    hallLate.setspin(0.5f);
+    hallLate.setwander(0.3f);
 }
 
 void StudioReverbDSP::initializePlateReverb()
@@ -112,29 +248,222 @@ void StudioReverbDSP::initializePlateReverb()
     plateReverb.setwet(0);
     plateReverb.setSampleRate(sampleRate);
 
-    // Plate-specific defaults
+    // Plate-specific defaults, nrevb has no modulation
     plateReverb.setrt60(2.5f);
-    plateReverb.setdiffusion(0.8f);
-    plateReverb.setbandwidthfreq(8000.0f);
-    plateReverb.setdamping(0.0005f);
-
-    // Plate modulation
-    plateReverb.setmoddepth(0.03f);
-    plateReverb.setmodfreq(1.0f);
+    plateReverb.setfeedback(plateDiffusion(0.8f));
+    plateReverb.setdamp(plateDamp(8000.0f, sampleRate));
 }
 
 void StudioReverbDSP::initializeEarlyReflections()
 {
     // Early reflections only - no late reverb
-    earlyOnly.loadPresetReflection(FV3_EARLYREF_PRESET_0);  // Simple early reflections
-    earlyOnly.setMuteOnChange(false);
-    earlyOnly.setdryr(0);
-    earlyOnly.setwet(0);
-    earlyOnly.setwidth(1.0f);
-    earlyOnly.setLRDelay(0.2f);
-    earlyOnly.setLRCrossApFreq(1000, 4);
-    earlyOnly.setDiffusionApFreq(200, 4);
-    earlyOnly.setSampleRate(sampleRate);
+    initializeEarly(earlyOnly, REVERB_EARLY_REFLECTIONS, sampleRate);
+}
+
+void StudioReverbDSP::initializeHybridReverb()
+{
+    // The tail level and spectrum are matched to the IR when it is loaded,
+    // this earlyref only stands in for the IR head until then
+    initializeEarly(hybridEarly, REVERB_HYBRID, sampleRate);
+
+    hybrid.setRSFactor(1.0f);
+    hybrid.setDecay(2.0f);
+    hybrid.setDiffusion(0.75f);
+    hybrid.setDamping(8000.0f);
+}
+
+bool StudioReverbDSP::loadImpulseFile(const char* path)
+{
+    return hybrid.loadImpulseFile(path);
+}
+
+void StudioReverbDSP::clearImpulse()
+{
+    hybrid.clearImpulse();
+}
+
+const std::string& StudioReverbDSP::getImpulseFile() const
+{
+    return hybrid.getImpulseFile();
+}
+
+bool StudioReverbDSP::isImpulseLoading()
+{
+    return hybrid.isLoading();
+}
+
+size_t StudioReverbDSP::getMemorySize()
+{
+    long size = roomEarly.getMemorySize() + roomLate.getMemorySize()
+        + hallEarly.getMemorySize() + hallLate.getMemorySize()
+        + plateReverb.getMemorySize() + earlyOnly.getMemorySize()
+        + hybridEarly.getMemorySize() + hybrid.getMemorySize();
+    return sizeof(*this) + static_cast<size_t>(size);
+}
+
+bool StudioReverbDSP::isTailActive() const
+{
+    // Only the last BUFFER_SIZE block is still in the buffers
+    for (uint32_t i = 0; i < lastBlockFrames; i++) {
+        float wet = earlyLevel * (std::fabs(early_out_buffer[0][i]) + std::fabs(early_out_buffer[1][i]))
+                  + lateLevel * (std::fabs(late_out_buffer[0][i]) + std::fabs(late_out_buffer[1][i]));
+        if (wet > TAIL_SILENCE)
+            return true;
+    }
+    return false;
+}
+
+double StudioReverbDSP::getTailSeconds()
+{
+    double predelay = params[paramPredelay] / 1000.0;
+    double early = EARLY_REFLECTION_SECONDS * params[paramSize] / 50.0;
+    double decay = params[paramDecay];
+
+    switch (currentReverbType) {
+        case REVERB_ROOM:
+        case REVERB_PLATE:
+            return predelay + std::max(early, decay);
+        case REVERB_HALL:
+            return predelay + std::max(early * 1.5, decay * HALL_DECAY_SCALE);
+        case REVERB_HYBRID:
+            // The tail starts where the convolved head ends
+            if (hybrid.hasImpulse())
+                return predelay + hybrid.getHeadLength() / 1000.0 + decay;
+            // Without an IR the tail still runs behind the reflections
+            return predelay + std::max(early, decay);
+        default:
+            return predelay + early;
+    }
+}
+
+uint32_t StudioReverbDSP::getLatency()
+{
+    if (currentReverbType == REVERB_HYBRID && hybrid.hasImpulse())
+        return static_cast<uint32_t>(hybrid.getLatency());
+    return 0;
+}
+
+size_t StudioReverbDSP::getSnapshotSize()
+{
+    fv3::state_io io;
+    double rate = sampleRate;
+    int32_t requested = getQuality(), active = quality;
+    snapshotHeader(io, params, rate, requested, active);
+    snapshotSignal(io);
+    return io.size();
+}
+
+size_t StudioReverbDSP::saveSnapshot(void* data, size_t size)
+{
+    FV3_TRACE_SCOPE("saveSnapshot");
+    fv3::state_io io(data, size);
+    double rate = sampleRate;
+    int32_t requested = getQuality(), active = quality;
+    snapshotHeader(io, params, rate, requested, active);
+    snapshotSignal(io);
+    return io.good() ? io.size() : 0;
+}
+
+bool StudioReverbDSP::loadSnapshot(const void* data, size_t size)
+{
+    FV3_TRACE_SCOPE("loadSnapshot");
+    fv3::state_io io(data, size);
+    float values[paramCount];
+    double rate = 0.0;
+    int32_t requested = 0, active = 0;
+    snapshotHeader(io, values, rate, requested, active);
+    if (!io.good())
+        return false;
+
+    // The buffer lengths follow from the settings, so they go first. With
+    // the same settings only the buffers are copied: the other types are
+    // muted already, a type change mutes them. A new sample rate applies
+    // every parameter again, some filters are only set up by theirs.
+    const bool rateChanged = (rate != sampleRate);
+    if (rateChanged)
+        sampleRateChanged(rate);
+    for (uint32_t i = 0; i < paramCount; i++) {
+        if (rateChanged || values[i] != params[i])
+            setParameterValue(i, values[i]);
+    }
+    // The tier the user asked for stays requested. The state is that of
+    // the tier that ran, which may be lower while the budget held it down,
+    // run() moves on from there as after any block.
+    setQuality(static_cast<ReverbQuality>(requested));
+    if (active != quality || modulationPending.exchange(false, std::memory_order_acq_rel))
+        applyQuality(static_cast<ReverbQuality>(active));
+
+    snapshotSignal(io);
+    if (!io.good()) {
+        muteAll();
+        lastBlockFrames = 0;
+        return false;
+    }
+    return true;
+}
+
+void StudioReverbDSP::snapshotHeader(fv3::state_io& io, float* values, double& rate,
+                                     int32_t& requested, int32_t& active)
+{
+    uint32_t magic = SNAPSHOT_MAGIC;
+    uint32_t version = SNAPSHOT_VERSION;
+    uint32_t count = paramCount;
+    io.value(magic);
+    io.value(version);
+    io.value(count);
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION || count != paramCount) {
+        io.fail();
+        return;
+    }
+    io.value(rate);
+    io.io(values, paramCount * sizeof(float));
+    io.value(requested);
+    io.value(active);
+    if (!(rate > 0.0) || requested < 0 || requested >= QUALITY_COUNT || active < 0 || active >= QUALITY_COUNT)
+        io.fail();
+}
+
+void StudioReverbDSP::snapshotSignal(fv3::state_io& io)
+{
+    // A type change mutes everything, only the current type has a state
+    switch(currentReverbType) {
+        case REVERB_ROOM:
+            roomEarly.state(io);
+            roomLate.state(io);
+            break;
+
+        case REVERB_HALL:
+            hallEarly.state(io);
+            hallLate.state(io);
+            break;
+
+        case REVERB_PLATE:
+            plateReverb.state(io);
+            break;
+
+        case REVERB_EARLY_REFLECTIONS:
+            earlyOnly.state(io);
+            break;
+
+        case REVERB_HYBRID:
+            hybrid.state(io);
+            hybridEarly.state(io);
+            break;
+
+        default:
+            break;
+    }
+
+    // The last block, for isTailActive()
+    io.value(lastBlockFrames);
+    if (lastBlockFrames > BUFFER_SIZE) {
+        io.fail();
+        return;
+    }
+    for (int ch = 0; ch < 2; ch++) {
+        io.io(early_out_buffer[ch], lastBlockFrames * sizeof(float));
+        io.io(late_out_buffer[ch], lastBlockFrames * sizeof(float));
+    }
 }
 
 float StudioReverbDSP::getParameterValue(uint32_t index) const
@@ -146,14 +475,25 @@ float StudioReverbDSP::getParameterValue(uint32_t index) const
 
 void StudioReverbDSP::setParameterValue(uint32_t index, float value)
 {
+    FV3_TRACE_SCOPE_ARG("setParameterValue", index);
+
     if (index >= paramCount)
         return;
 
+    // The nearest type, NaN fails the comparison and selects the first
+    if (index == paramReverbType)
+        value = value > 0.0f ? std::min(std::floor(value + 0.5f), REVERB_TYPE_COUNT - 1.0f) : 0.0f;
+
     params[index] = value;
 
+    setEarlyParameter(roomEarly, REVERB_ROOM, index, value);
+    setEarlyParameter(hallEarly, REVERB_HALL, index, value);
+    setEarlyParameter(earlyOnly, REVERB_EARLY_REFLECTIONS, index, value);
+    setEarlyParameter(hybridEarly, REVERB_HYBRID, index, value);
+
     switch(index) {
         case paramReverbType:
-            currentReverbType = static_cast<ReverbType>(static_cast<int>(value + 0.5f));
+            currentReverbType = static_cast<ReverbType>(static_cast<int>(value));
             // Mute all processors when switching to avoid artifacts
             muteAll();
             break;
@@ -173,39 +513,34 @@ void StudioReverbDSP::setParameterValue(uint32_t index, float value)
         case paramSize:
             {
                 float sizeFactor = value / 50.0f;  // 0-100% -> 0-2x
-                roomEarly.setRSFactor(sizeFactor);
                 roomLate.setRSFactor(sizeFactor);
-                hallEarly.setRSFactor(sizeFactor * 1.5f);  // Hall is larger
-                hallLate.setRSFactor(sizeFactor * 1.5f);
-                earlyOnly.setRSFactor(sizeFactor);
+                hallLate.setRSFactor(sizeFactor * 1.5f);  // Hall is larger
+                hybrid.setRSFactor(sizeFactor);
             }
             break;
 
         case paramWidth:
             {
                 float width = value / 100.0f;
-                roomEarly.setwidth(width);
                 roomLate.setwidth(width);
-                hallEarly.setwidth(width);
                 hallLate.setwidth(width);
                 plateReverb.setwidth(width);
-                earlyOnly.setwidth(width);
+                hybrid.setWidth(width);
             }
             break;
 
         case paramPredelay:
-            roomEarly.setPreDelay(value);
             roomLate.setPreDelay(value);
-            hallEarly.setPreDelay(value);
             hallLate.setPreDelay(value);
             plateReverb.setPreDelay(value);
-            earlyOnly.setPreDelay(value);
+            hybrid.setPreDelay(value);
             break;
 
         case paramDecay:
             roomLate.setrt60(value);
-            hallLate.setrt60(value * 1.5f);  // Hall has longer decay
+            hallLate.setrt60(value * HALL_DECAY_SCALE);
             plateReverb.setrt60(value);
+            hybrid.setDecay(value);
             break;
 
         case paramDiffuse:
@@ -215,13 +550,8 @@ void StudioReverbDSP::setParameterValue(uint32_t index, float value)
                 roomLate.setodiffusion1(diffusion);
                 hallLate.setidiffusion1(diffusion);
                 hallLate.setodiffusion1(diffusion);
-                plateReverb.setdiffusion(diffusion);
-
-                // Early reflections diffusion
-                int diffuseStages = static_cast<int>(diffusion * 10);
-                roomEarly.setDiffusionApFreq(150 + diffusion * 350, diffuseStages);
-                hallEarly.setDiffusionApFreq(100 + diffusion * 400, diffuseStages);
-                earlyOnly.setDiffusionApFreq(200 + diffusion * 300, diffuseStages);
+                plateReverb.setfeedback(plateDiffusion(diffusion));
+                hybrid.setDiffusion(diffusion);
             }
             break;
 
@@ -232,47 +562,54 @@ void StudioReverbDSP::setParameterValue(uint32_t index, float value)
                 roomLate.setoutputdamp(dampFreq);
                 hallLate.setdamp(dampFreq);
                 hallLate.setoutputdamp(dampFreq);
-                plateReverb.setbandwidthfreq(dampFreq);
+                plateReverb.setdamp(plateDamp(dampFreq, sampleRate));
+                hybrid.setDamping(dampFreq);
             }
             break;
 
         case paramModulation:
             {
-                float modDepth = value / 100.0f * 0.05f;  // 0-5% pitch modulation
-                float modFreq = 0.1f + value / 100.0f * 2.0f;  // 0.1-2.1 Hz
-
-                hallLate.setmoddepth(modDepth);
-                hallLate.setmodfreq(modFreq);
-                plateReverb.setmoddepth(modDepth * 1.5f);  // Plate has more modulation
-                plateReverb.setmodfreq(modFreq * 1.5f);
+                // Same LFO ranges as the hybrid tail, the plate has none
+                hallLate.setspin(0.1f + value / 100.0f * 2.0f);     // 0.1-2.1 Hz
+                hallLate.setwander(0.2f + value / 100.0f * 0.6f);
+                hybrid.setModulation(value / 100.0f);
+
+                // No modulation skips the LFOs and the interpolation. The
+                // mode depends on the tier, which only the audio thread
+                // changes, so it is set with the tier in run().
+                modulationPending.store(true, std::memory_order_release);
             }
             break;
 
         case paramLowCut:
-            roomEarly.setoutputhpf(value);
             roomLate.setdccutfreq(value);
-            hallEarly.setoutputhpf(value);
             hallLate.setdccutfreq(value);
             plateReverb.setdccutfreq(value);
-            earlyOnly.setoutputhpf(value);
+            hybrid.setLowCut(value);
             break;
 
         case paramHighCut:
-            roomEarly.setoutputlpf(value);
-            hallEarly.setoutputlpf(value);
-            earlyOnly.setoutputlpf(value);
-            // Late reverb high cut is handled by damping
+            // Early reflections only, late reverb high cut is handled by damping
             break;
     }
 }
 
 void StudioReverbDSP::run(const float** inputs, float** outputs, uint32_t frames)
 {
+    FV3_TRACE_SCOPE_ARG("run", frames);
+    load.callbackBegin();
+
+    applyPendingQuality();
+
     // Process in blocks
     uint32_t offset = 0;
 
     while (offset < frames) {
         uint32_t buffer_frames = std::min(BUFFER_SIZE, frames - offset);
+        // A mono block takes the left input for both channels
+        const float* blockInputs[2] = {
+            inputs[0], isMonoBlock(inputs, offset, buffer_frames) ? inputs[0] : inputs[1]
+        };
 
         // Clear output buffers
         std::memset(early_out_buffer[0], 0, buffer_frames * sizeof(float));
@@ -283,26 +620,38 @@ void StudioReverbDSP::run(const float** inputs, float** outputs, uint32_t frames
         // Process based on selected reverb type
         switch(currentReverbType) {
             case REVERB_ROOM:
-                processRoomReverb(inputs, buffer_frames, offset);
+                processRoomReverb(blockInputs, buffer_frames, offset);
                 break;
 
             case REVERB_HALL:
-                processHallReverb(inputs, buffer_frames, offset);
+                processHallReverb(blockInputs, buffer_frames, offset);
                 break;
 
             case REVERB_PLATE:
-                processPlateReverb(inputs, buffer_frames, offset);
+                processPlateReverb(blockInputs, buffer_frames, offset);
                 break;
 
             case REVERB_EARLY_REFLECTIONS:
-                processEarlyReflections(inputs, buffer_frames, offset);
+                processEarlyReflections(blockInputs, buffer_frames, offset);
+                break;
+
+            case REVERB_HYBRID:
+                processHybridReverb(blockInputs, buffer_frames, offset);
+                break;
+
+            default:
                 break;
         }
 
         // Mix dry, early, and late signals
+        stageBegin(DSP_STAGE_MIX, "mix");
         for (uint32_t i = 0; i < buffer_frames; i++) {
-            outputs[0][offset + i] = dryLevel * inputs[0][offset + i];
-            outputs[1][offset + i] = dryLevel * inputs[1][offset + i];
+            // Read both before writing, on a mono block with in-place
+            // buffers blockInputs[1] is outputs[0]
+            const float dryL = blockInputs[0][offset + i];
+            const float dryR = blockInputs[1][offset + i];
+            outputs[0][offset + i] = dryLevel * dryL;
+            outputs[1][offset + i] = dryLevel * dryR;
 
             outputs[0][offset + i] += earlyLevel * early_out_buffer[0][i];
             outputs[1][offset + i] += earlyLevel * early_out_buffer[1][i];
@@ -310,69 +659,134 @@ void StudioReverbDSP::run(const float** inputs, float** outputs, uint32_t frames
             outputs[0][offset + i] += lateLevel * late_out_buffer[0][i];
             outputs[1][offset + i] += lateLevel * late_out_buffer[1][i];
         }
+        stageEnd(DSP_STAGE_MIX, "mix");
+
+        offset += buffer_frames;
+        lastBlockFrames = buffer_frames;
+    }
+
+    callbackEnd(frames);
+}
+
+void StudioReverbDSP::runLate(const float** inputs, float** outputs, uint32_t frames)
+{
+    FV3_TRACE_SCOPE_ARG("runLate", frames);
+    load.callbackBegin();
+
+    applyPendingQuality();
+
+    uint32_t offset = 0;
+
+    while (offset < frames) {
+        uint32_t buffer_frames = std::min(BUFFER_SIZE, frames - offset);
+        const float* blockInputs[2] = {
+            inputs[0], isMonoBlock(inputs, offset, buffer_frames) ? inputs[0] : inputs[1]
+        };
+
+        std::memset(early_out_buffer[0], 0, buffer_frames * sizeof(float));
+        std::memset(early_out_buffer[1], 0, buffer_frames * sizeof(float));
+        std::memset(late_out_buffer[0], 0, buffer_frames * sizeof(float));
+        std::memset(late_out_buffer[1], 0, buffer_frames * sizeof(float));
+
+        // Into the buffers run() mixes the tank from
+        switch(currentReverbType) {
+            case REVERB_ROOM:
+                stageBegin(DSP_STAGE_LATE, "room.late");
+                processInputs(roomLate, blockInputs, offset, late_out_buffer[0], late_out_buffer[1], buffer_frames);
+                stageEnd(DSP_STAGE_LATE, "room.late");
+                break;
+
+            case REVERB_HALL:
+                stageBegin(DSP_STAGE_LATE, "hall.late");
+                processInputs(hallLate, blockInputs, offset, early_out_buffer[0], early_out_buffer[1], buffer_frames);
+                for (uint32_t i = 0; i < buffer_frames; i++) {
+                    early_out_buffer[0][i] *= HALL_LATE_MIX;
+                    early_out_buffer[1][i] *= HALL_LATE_MIX;
+                }
+                stageEnd(DSP_STAGE_LATE, "hall.late");
+                break;
+
+            case REVERB_PLATE:
+                processPlateReverb(blockInputs, buffer_frames, offset);
+                break;
+
+            case REVERB_HYBRID:
+                // The IR head is part of the shared response
+                stageBegin(DSP_STAGE_LATE, "hybrid");
+                hybrid.process(
+                    blockInputs[0] + offset,
+                    blockInputs[1] + offset,
+                    early_out_buffer[0],
+                    early_out_buffer[1],
+                    late_out_buffer[0],
+                    late_out_buffer[1],
+                    buffer_frames);
+                stageEnd(DSP_STAGE_LATE, "hybrid");
+                break;
+
+            default:
+                break;
+        }
+
+        stageBegin(DSP_STAGE_MIX, "mix");
+        for (uint32_t i = 0; i < buffer_frames; i++) {
+            outputs[0][offset + i] = earlyLevel * early_out_buffer[0][i] + lateLevel * late_out_buffer[0][i];
+            outputs[1][offset + i] = earlyLevel * early_out_buffer[1][i] + lateLevel * late_out_buffer[1][i];
+        }
+        stageEnd(DSP_STAGE_MIX, "mix");
 
         offset += buffer_frames;
+        lastBlockFrames = buffer_frames;
     }
+
+    callbackEnd(frames);
 }
 
 void StudioReverbDSP::processRoomReverb(const float** inputs, uint32_t frames, uint32_t offset)
 {
     // Process early reflections
-    roomEarly.processreplace(
-        const_cast<float*>(inputs[0]) + offset,
-        const_cast<float*>(inputs[1]) + offset,
-        early_out_buffer[0],
-        early_out_buffer[1],
-        frames);
+    stageBegin(DSP_STAGE_EARLY, "room.early");
+    processInputs(roomEarly, inputs, offset, early_out_buffer[0], early_out_buffer[1], frames);
+    stageEnd(DSP_STAGE_EARLY, "room.early");
 
     // Process late reverb
-    roomLate.processreplace(
-        const_cast<float*>(inputs[0]) + offset,
-        const_cast<float*>(inputs[1]) + offset,
-        late_out_buffer[0],
-        late_out_buffer[1],
-        frames);
+    stageBegin(DSP_STAGE_LATE, "room.late");
+    processInputs(roomLate, inputs, offset, late_out_buffer[0], late_out_buffer[1], frames);
+    stageEnd(DSP_STAGE_LATE, "room.late");
 }
 
 void StudioReverbDSP::processHallReverb(const float** inputs, uint32_t frames, uint32_t offset)
 {
     // Process early reflections
-    hallEarly.processreplace(
-        const_cast<float*>(inputs[0]) + offset,
-        const_cast<float*>(inputs[1]) + offset,
-        early_out_buffer[0],
-        early_out_buffer[1],
-        frames);
+    stageBegin(DSP_STAGE_EARLY, "hall.early");
+    processInputs(hallEarly, inputs, offset, early_out_buffer[0], early_out_buffer[1], frames);
+    stageEnd(DSP_STAGE_EARLY, "hall.early");
 
     // Process late reverb
-    hallLate.processreplace(
-        const_cast<float*>(inputs[0]) + offset,
-        const_cast<float*>(inputs[1]) + offset,
-        late_out_buffer[0],
-        late_out_buffer[1],
-        frames);
+    stageBegin(DSP_STAGE_LATE, "hall.late");
+    processInputs(hallLate, inputs, offset, late_out_buffer[0], late_out_buffer[1], frames);
+    stageEnd(DSP_STAGE_LATE, "hall.late");
 
     // Hall combines early and late into single output (no separate early/late mix)
     // So we mix them here based on a fixed ratio
+    stageBegin(DSP_STAGE_MIX, "hall.mix");
     for (uint32_t i = 0; i < frames; i++) {
-        float mixedL = early_out_buffer[0][i] * 0.3f + late_out_buffer[0][i] * 0.7f;
-        float mixedR = early_out_buffer[1][i] * 0.3f + late_out_buffer[1][i] * 0.7f;
+        float mixedL = early_out_buffer[0][i] * HALL_EARLY_MIX + late_out_buffer[0][i] * HALL_LATE_MIX;
+        float mixedR = early_out_buffer[1][i] * HALL_EARLY_MIX + late_out_buffer[1][i] * HALL_LATE_MIX;
         early_out_buffer[0][i] = mixedL;
         early_out_buffer[1][i] = mixedR;
         late_out_buffer[0][i] = 0;
         late_out_buffer[1][i] = 0;
     }
+    stageEnd(DSP_STAGE_MIX, "hall.mix");
 }
 
 void StudioReverbDSP::processPlateReverb(const float** inputs, uint32_t frames, uint32_t offset)
 {
     // Plate reverb processes everything as a single unit
-    plateReverb.processreplace(
-        const_cast<float*>(inputs[0]) + offset,
-        const_cast<float*>(inputs[1]) + offset,
-        early_out_buffer[0],
-        early_out_buffer[1],
-        frames);
+    stageBegin(DSP_STAGE_LATE, "plate");
+    processInputs(plateReverb, inputs, offset, early_out_buffer[0], early_out_buffer[1], frames);
+    stageEnd(DSP_STAGE_LATE, "plate");
 
     // Plate has no separate late reverb
     std::memset(late_out_buffer[0], 0, frames * sizeof(float));
@@ -382,18 +796,169 @@ void StudioReverbDSP::processPlateReverb(const float** inputs, uint32_t frames,
 void StudioReverbDSP::processEarlyReflections(const float** inputs, uint32_t frames, uint32_t offset)
 {
     // Only early reflections, no late reverb
-    earlyOnly.processreplace(
-        const_cast<float*>(inputs[0]) + offset,
-        const_cast<float*>(inputs[1]) + offset,
-        early_out_buffer[0],
-        early_out_buffer[1],
-        frames);
+    stageBegin(DSP_STAGE_EARLY, "early");
+    processInputs(earlyOnly, inputs, offset, early_out_buffer[0], early_out_buffer[1], frames);
+    stageEnd(DSP_STAGE_EARLY, "early");
 
     // No late reverb for early reflections mode
     std::memset(late_out_buffer[0], 0, frames * sizeof(float));
     std::memset(late_out_buffer[1], 0, frames * sizeof(float));
 }
 
+void StudioReverbDSP::processHybridReverb(const float** inputs, uint32_t frames, uint32_t offset)
+{
+    // IR head to early, matched progenitor2 tail to late
+    stageBegin(DSP_STAGE_LATE, "hybrid");
+    hybrid.process(
+        inputs[0] + offset,
+        inputs[1] + offset,
+        early_out_buffer[0],
+        early_out_buffer[1],
+        late_out_buffer[0],
+        late_out_buffer[1],
+        frames);
+    stageEnd(DSP_STAGE_LATE, "hybrid");
+
+    // Without an IR the head is replaced by early reflections
+    if (!hybrid.hasImpulse()) {
+        stageBegin(DSP_STAGE_EARLY, "hybrid.early");
+        processInputs(hybridEarly, inputs, offset, early_out_buffer[0], early_out_buffer[1], frames);
+        stageEnd(DSP_STAGE_EARLY, "hybrid.early");
+    }
+}
+
+void StudioReverbDSP::setQuality(ReverbQuality newQuality)
+{
+    if (newQuality >= 0 && newQuality < QUALITY_COUNT)
+        pendingQuality.store(newQuality, std::memory_order_release);
+}
+
+ReverbQuality StudioReverbDSP::getQuality() const
+{
+    return static_cast<ReverbQuality>(pendingQuality.load(std::memory_order_acquire));
+}
+
+static const char* const qualityNames[QUALITY_COUNT] = { "eco", "standard", "high" };
+
+const char* StudioReverbDSP::getQualityName(ReverbQuality quality)
+{
+    if (quality >= 0 && quality < QUALITY_COUNT)
+        return qualityNames[quality];
+    return "";
+}
+
+bool StudioReverbDSP::parseQuality(const char* name, ReverbQuality& quality)
+{
+    if (name == nullptr)
+        return false;
+    for (int q = 0; q < QUALITY_COUNT; q++) {
+        if (std::strcmp(name, qualityNames[q]) == 0) {
+            quality = static_cast<ReverbQuality>(q);
+            return true;
+        }
+    }
+    return false;
+}
+
+void StudioReverbDSP::setQualityBudget(float budget)
+{
+    if (budget > 0.0f) {
+        governor.setBudget(budget);
+        // Start from the requested tier, not from where an earlier budget
+        // left it
+        governedQuality.store(QUALITY_HIGH, std::memory_order_relaxed);
+    }
+    governor.setEnabled(budget > 0.0f);
+}
+
+float StudioReverbDSP::getQualityBudget() const
+{
+    return governor.isEnabled() ? governor.getBudget() : 0.0f;
+}
+
+ReverbQuality StudioReverbDSP::getActiveQuality() const
+{
+    return static_cast<ReverbQuality>(activeQuality.load(std::memory_order_relaxed));
+}
+
+void StudioReverbDSP::setMonoInput(bool mono)
+{
+    monoInput.store(mono, std::memory_order_relaxed);
+}
+
+bool StudioReverbDSP::isMonoInput() const
+{
+    return monoInput.load(std::memory_order_relaxed);
+}
+
+void StudioReverbDSP::setNoiseSeed(uint32_t seed)
+{
+    noiseSeed = seed;
+    roomLate.setnoiseseed(noiseSeedFor(seed, NOISE_SALT_ROOM));
+    hallLate.setnoiseseed(noiseSeedFor(seed, NOISE_SALT_HALL));
+    hybrid.setNoiseSeed(noiseSeedFor(seed, NOISE_SALT_HYBRID));
+}
+
+uint32_t StudioReverbDSP::getNoiseSeed() const
+{
+    return noiseSeed;
+}
+
+bool StudioReverbDSP::isMonoBlock(const float** inputs, uint32_t offset, uint32_t frames) const
+{
+    if (inputs[0] == inputs[1] || isMonoInput())
+        return true;
+    // Only bit-identical samples, anything else takes the stereo path
+    return std::memcmp(inputs[0] + offset, inputs[1] + offset, frames * sizeof(float)) == 0;
+}
+
+ReverbQuality StudioReverbDSP::getTargetQuality() const
+{
+    const ReverbQuality requested = getQuality();
+    if (!governor.isEnabled())
+        return requested;
+    return std::min(requested,
+                    static_cast<ReverbQuality>(governedQuality.load(std::memory_order_relaxed)));
+}
+
+void StudioReverbDSP::callbackEnd(uint32_t frames)
+{
+    if (load.callbackEnd(frames))
+        governedQuality.store(governor.update(load.getWindowLoad(), getQuality()),
+                              std::memory_order_relaxed);
+}
+
+void StudioReverbDSP::applyPendingQuality()
+{
+    const ReverbQuality target = getTargetQuality();
+    const bool modulationChanged = modulationPending.exchange(false, std::memory_order_acq_rel);
+    if (target != quality || modulationChanged)
+        applyQuality(target);
+}
+
+void StudioReverbDSP::applyQuality(ReverbQuality target)
+{
+    FV3_TRACE_SCOPE("applyQuality");
+    quality = target;
+    activeQuality.store(target, std::memory_order_relaxed);
+
+    const long stages = QUALITY_DIFFUSION_STAGES[quality];
+    const long mode = getModulationMode(quality);
+    roomLate.setidiffusionstages(stages);
+    roomLate.setmodulationmode(mode);
+    hallLate.setidiffusionstages(stages);
+    hallLate.setmodulationmode(mode);
+    hybrid.setTailQuality(stages, mode);
+}
+
+long StudioReverbDSP::getModulationMode(ReverbQuality tier) const
+{
+    if (params[paramModulation] <= 0.0f)
+        return FV3_PROGENITOR2_MOD_OFF;
+    // Below High the delay taps are read with linear interpolation
+    return tier == QUALITY_HIGH ? FV3_PROGENITOR2_MOD_ALLPASS : FV3_PROGENITOR2_MOD_LINEAR;
+}
+
 void StudioReverbDSP::sampleRateChanged(double newSampleRate)
 {
     sampleRate = newSampleRate;
@@ -404,7 +969,11 @@ void StudioReverbDSP::sampleRateChanged(double newSampleRate)
     hallEarly.setSampleRate(newSampleRate);
     hallLate.setSampleRate(newSampleRate);
     plateReverb.setSampleRate(newSampleRate);
+    plateReverb.setdamp(plateDamp(20000.0f * (1.0f - params[paramDamping] / 100.0f), newSampleRate));
     earlyOnly.setSampleRate(newSampleRate);
+    hybridEarly.setSampleRate(newSampleRate);
+    hybrid.sampleRateChanged(newSampleRate);
+    load.setSampleRate(newSampleRate);
 }
 
 void StudioReverbDSP::mute()
@@ -412,12 +981,32 @@ void StudioReverbDSP::mute()
     muteAll();
 }
 
+void StudioReverbDSP::setProbe(StudioReverbProbe* newProbe)
+{
+    probe = newProbe;
+}
+
+bool StudioReverbDSP::getLoadSnapshot(DSPLoadSnapshot& snapshot) const
+{
+    return load.read(snapshot);
+}
+
+void StudioReverbDSP::resetLoad()
+{
+    load.reset();
+    governor.reset();
+    governedQuality.store(QUALITY_HIGH, std::memory_order_relaxed);
+}
+
 void StudioReverbDSP::muteAll()
 {
+    FV3_TRACE_SCOPE("muteAll");
     roomEarly.mute();
     roomLate.mute();
     hallEarly.mute();
     hallLate.mute();
     plateReverb.mute();
     earlyOnly.mute();
+    hybridEarly.mute();
+    hybrid.mute();
 }
\ No newline at end of file
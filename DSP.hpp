@@ -7,14 +7,51 @@
 
 #include "DistrhoPluginInfo.h"
 
+#include <atomic>
+
 // Freeverb3 includes
 #include "freeverb/earlyref.hpp"
 #include "freeverb/progenitor2.hpp"
 #include "freeverb/nrevb.hpp"
+#include "freeverb/fv3_trace.hpp"
+#include "freeverb/fv3_state.hpp"
+
+#include "DSPLoad.hpp"
+#include "DSPGovernor.hpp"
+#include "HybridReverb.hpp"
 
 // Buffer size for processing
 static const uint32_t BUFFER_SIZE = 256;
 
+// The hall tank decays this much longer than the Decay parameter
+static const float HALL_DECAY_SCALE = 1.5f;
+
+// The hall output is this mix of its early reflections and tank, scaled by
+// the Early Level
+static const float HALL_EARLY_MIX = 0.3f;
+static const float HALL_LATE_MIX = 0.7f;
+
+// Wet level below which the reverb tail counts as finished (-100 dBFS)
+static const float TAIL_SILENCE = 1e-5f;
+
+// Last early reflection at Size 50%, the longest factory pattern rounded up
+static const float EARLY_REFLECTION_SECONDS = 0.1f;
+
+// Input diffusion stages of the room, hall and hybrid tanks per quality
+// tier, High is the full progenitor2 network. The plate is the same in
+// every tier.
+static const long QUALITY_DIFFUSION_STAGES[QUALITY_COUNT] = { 3, 6, 10 };
+
+// Observer called on the audio thread around each processing stage, used
+// by the offline tools to attribute cost to a stage
+class StudioReverbProbe
+{
+public:
+    virtual ~StudioReverbProbe() {}
+    virtual void stageBegin(DSPStage stage) = 0;
+    virtual void stageEnd(DSPStage stage) = 0;
+};
+
 class StudioReverbDSP
 {
 public:
@@ -28,32 +65,169 @@ public:
     // Audio processing
     void run(const float** inputs, float** outputs, uint32_t frames);
 
+    // Only the tank of the current type, at the level run() mixes it in:
+    // no dry signal and no early reflections. Early reflections only gives
+    // silence. Used to share one tank between several sources.
+    void runLate(const float** inputs, float** outputs, uint32_t frames);
+
+    // The early reflections of a type as this class sets them up, and the
+    // effect of a parameter on them. The plate has none, it gets the
+    // hybrid's.
+    static void initializeEarly(fv3::earlyref_f& early, ReverbType type, double sampleRate);
+    static void setEarlyParameter(fv3::earlyref_f& early, ReverbType type, uint32_t index, float value);
+
+    // The plate's comb damping for a cutoff (Hz) and its allpass feedback
+    // for a Diffuse of 0-1, also used by the batch plate
+    static float plateDamp(float freq, double rate);
+    static float plateDiffusion(float diffusion);
+
+    // Quality tier, from any thread. It is applied at the start of the next
+    // run(), a change of the diffusion stages is crossfaded. The default is
+    // QUALITY_HIGH.
+    void setQuality(ReverbQuality quality);
+    ReverbQuality getQuality() const;
+
+    // Automatic quality, from any thread: while run() takes more than this
+    // share of the block deadline the tier steps down, and back up towards
+    // the one set with setQuality() when there is room again. 0 (the
+    // default) switches it off.
+    void setQualityBudget(float budget);
+    float getQualityBudget() const;
+
+    // Tier that run() uses, below getQuality() while the budget holds it
+    // down. From any thread.
+    ReverbQuality getActiveQuality() const;
+
+    // Mono input, from any thread: the left input feeds both channels and
+    // the right one is ignored. Off by default, run() then takes a block
+    // with the same samples on both inputs as mono. Mono blocks give the
+    // same output, the algorithms only share their input side work.
+    void setMonoInput(bool mono);
+    bool isMonoInput() const;
+
+    // Seed of the modulation noise, each tank draws its own sequence from
+    // it. Every instance gets the next seed of a process wide count, so
+    // instances fed the same signal do not modulate alike. Set a fixed
+    // seed for output that can be compared between runs. Not while run()
+    // is called, the noise restarts from the seed.
+    void setNoiseSeed(uint32_t seed);
+    uint32_t getNoiseSeed() const;
+
+    // "eco", "standard" and "high", for states and command lines
+    static const char* getQualityName(ReverbQuality quality);
+    static bool parseQuality(const char* name, ReverbQuality& quality);
+
     // Sample rate handling
     void sampleRateChanged(double sampleRate);
 
     // Mute all reverb tails
     void mute();
 
+    // Stage observer, nullptr to disable (the default)
+    void setProbe(StudioReverbProbe* probe);
+
+    // Latest DSP load, from any thread. resetLoad() not while run() is
+    // called, it also lets the governor start over at the requested tier.
+    bool getLoadSnapshot(DSPLoadSnapshot& snapshot) const;
+    void resetLoad();
+
+    // Impulse response for the hybrid algorithm (not on the audio thread)
+    bool loadImpulseFile(const char* path);
+    void clearImpulse();
+    const std::string& getImpulseFile() const;
+
+    // True until a new IR head has been crossfaded in, which needs run() calls
+    bool isImpulseLoading();
+
+    // Delay line and convolver memory of all algorithms, in bytes
+    size_t getMemorySize();
+
+    // True while the wet output of the last run() is above -100 dBFS
+    bool isTailActive() const;
+
+    // Time the output takes to decay by 60 dB once the input stops, from
+    // the current settings
+    double getTailSeconds();
+
+    // Frames the output is delayed by, for the host's compensation
+    uint32_t getLatency();
+
+    // Snapshot of the signal state of the current type (delay lines,
+    // indices, filter memories) with the parameters, the requested and the
+    // active quality tier and the sample rate, to resume a render without
+    // pre-roll. A snapshot loads into an engine of the same build with the
+    // same impulse response; the hybrid's convolved head restarts from
+    // silence. Not while run() is called.
+    size_t getSnapshotSize();
+    // Bytes written, 0 if size is too small
+    size_t saveSnapshot(void* data, size_t size);
+    // False for a snapshot that does not fit, the tails are then muted
+    bool loadSnapshot(const void* data, size_t size);
+
 private:
     // Initialize reverb processors
     void initializeRoomReverb();
     void initializeHallReverb();
     void initializePlateReverb();
     void initializeEarlyReflections();
+    void initializeHybridReverb();
 
     // Process functions for each algorithm
     void processRoomReverb(const float** inputs, uint32_t frames, uint32_t offset);
     void processHallReverb(const float** inputs, uint32_t frames, uint32_t offset);
     void processPlateReverb(const float** inputs, uint32_t frames, uint32_t offset);
     void processEarlyReflections(const float** inputs, uint32_t frames, uint32_t offset);
+    void processHybridReverb(const float** inputs, uint32_t frames, uint32_t offset);
 
     // Utility
     void muteAll();
 
+    // Tier from setQuality() and the governor, its stage counts and
+    // modulation
+    ReverbQuality getTargetQuality() const;
+    void applyQuality(ReverbQuality target);
+    void applyPendingQuality();
+    long getModulationMode(ReverbQuality tier) const;
+
+    // Declared mono or the same samples on both inputs
+    bool isMonoBlock(const float** inputs, uint32_t offset, uint32_t frames) const;
+
+    // Once a block is timed, a closed load window goes to the governor
+    void callbackEnd(uint32_t frames);
+
+    // Snapshot parts, the same calls save, load and measure
+    void snapshotHeader(fv3::state_io& io, float* values, double& rate,
+                        int32_t& requested, int32_t& active);
+    void snapshotSignal(fv3::state_io& io);
+
+    // The name labels the stage in FV3_TRACE builds, a string literal
+    inline void stageBegin(DSPStage stage, const char* name)
+    {
+        FV3_TRACE_BEGIN(name);
+        load.stageBegin(stage);
+        if (probe != nullptr)
+            probe->stageBegin(stage);
+    }
+
+    inline void stageEnd(DSPStage stage, const char* name)
+    {
+        if (probe != nullptr)
+            probe->stageEnd(stage);
+        load.stageEnd(stage);
+        FV3_TRACE_END(name);
+    }
+
     // State
     double sampleRate;
     float params[paramCount];
     ReverbType currentReverbType;
+    ReverbQuality quality;
+    std::atomic<int> pendingQuality;
+    std::atomic<int> activeQuality;
+    // Set by a Modulation change, run() applies the tier's mode again
+    std::atomic<bool> modulationPending;
+    std::atomic<bool> monoInput;
+    uint32_t noiseSeed;
 
     // Mix levels
     float dryLevel;
@@ -74,6 +248,17 @@ private:
     // Early reflections only
     fv3::earlyref_f earlyOnly;
 
+    // Hybrid: convolved IR head + progenitor2 tail, earlyref until an IR is loaded
+    HybridReverb hybrid;
+    fv3::earlyref_f hybridEarly;
+
+    StudioReverbProbe* probe;
+    DSPLoadMeter load;
+    DSPGovernor governor;
+    // Written by setQualityBudget() as well as the audio thread
+    std::atomic<int> governedQuality;
+    uint32_t lastBlockFrames;
+
     // Processing buffers
     float early_out_buffer[2][BUFFER_SIZE];
     float late_out_buffer[2][BUFFER_SIZE];
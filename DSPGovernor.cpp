@@ -0,0 +1,94 @@
+/*
+ * Studio Reverb DSP Governor Implementation
+ * Steps the quality tier down when the DSP load stays over a budget
+ */
+
+#include "DSPGovernor.hpp"
+#include <algorithm>
+
+DSPGovernor::DSPGovernor()
+    : enabled(false),
+      budget(GOVERNOR_DEFAULT_BUDGET),
+      steps(0),
+      active(false)
+{
+    reset();
+}
+
+void DSPGovernor::setEnabled(bool newEnabled)
+{
+    enabled.store(newEnabled, std::memory_order_relaxed);
+}
+
+bool DSPGovernor::isEnabled() const
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void DSPGovernor::setBudget(float newBudget)
+{
+    budget.store(std::max(GOVERNOR_MIN_BUDGET, std::min(GOVERNOR_MAX_BUDGET, newBudget)),
+                 std::memory_order_relaxed);
+}
+
+float DSPGovernor::getBudget() const
+{
+    return budget.load(std::memory_order_relaxed);
+}
+
+uint32_t DSPGovernor::getStepCount() const
+{
+    return steps.load(std::memory_order_relaxed);
+}
+
+void DSPGovernor::reset()
+{
+    quality = QUALITY_COUNT;
+    over = under = hold = 0;
+}
+
+ReverbQuality DSPGovernor::update(float load, ReverbQuality requested)
+{
+    if (!isEnabled()) {
+        active = false;
+        return requested;
+    }
+    if (!active) {
+        reset();
+        active = true;
+    }
+
+    const int current = std::min<int>(quality, requested);
+    if (hold > 0) {
+        hold--;
+        return static_cast<ReverbQuality>(current);
+    }
+
+    // Hysteresis: a step down needs the load over the budget for a while, a
+    // step up needs it well under the budget for much longer
+    const float limit = getBudget();
+    if (load > limit) {
+        under = 0;
+        if (++over >= GOVERNOR_DOWN_WINDOWS && current > QUALITY_ECO) {
+            quality = current - 1;
+            over = 0;
+            hold = GOVERNOR_HOLD_WINDOWS;
+            steps.fetch_add(1, std::memory_order_relaxed);
+        }
+        over = std::min(over, GOVERNOR_DOWN_WINDOWS);
+    } else if (load < limit * GOVERNOR_RECOVER_SHARE && current < requested) {
+        over = 0;
+        if (++under >= GOVERNOR_UP_WINDOWS) {
+            quality = current + 1;
+            if (quality >= requested)
+                quality = QUALITY_COUNT;
+            under = 0;
+            hold = GOVERNOR_HOLD_WINDOWS;
+            steps.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        over = under = 0;
+    }
+
+    return static_cast<ReverbQuality>(std::min<int>(quality, requested));
+}
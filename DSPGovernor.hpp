@@ -0,0 +1,71 @@
+/*
+ * Studio Reverb DSP Governor Header
+ * Steps the quality tier down when the DSP load stays over a budget
+ */
+
+#ifndef STUDIO_REVERB_DSP_GOVERNOR_HPP_INCLUDED
+#define STUDIO_REVERB_DSP_GOVERNOR_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Budget range, share of the block deadline that run() may take
+static const float GOVERNOR_MIN_BUDGET = 0.1f;
+static const float GOVERNOR_MAX_BUDGET = 1.0f;
+static const float GOVERNOR_DEFAULT_BUDGET = 0.7f;
+
+// Load windows (DSP_LOAD_WINDOW_SECONDS each) over the budget before a step
+// down, and under the recovery level before a step up
+static const uint32_t GOVERNOR_DOWN_WINDOWS = 2;
+static const uint32_t GOVERNOR_UP_WINDOWS = 16;
+
+// A step up needs the load under this share of the budget. The tier above
+// costs a fifth to a quarter more (the tier table in BUILD.md), so it
+// still fits with room to spare.
+static const float GOVERNOR_RECOVER_SHARE = 0.6f;
+
+// Windows after a step in which the governor does not step again. The
+// window of the step mixes both tiers and the crossfade.
+static const uint32_t GOVERNOR_HOLD_WINDOWS = 2;
+
+// Picks the tier to run, at most the one that was asked for. Configured
+// from any thread, updated by the audio thread once per load window.
+class DSPGovernor
+{
+public:
+    DSPGovernor();
+
+    // Off by default. Switching on starts from the requested tier.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Share of the block deadline, clamped to the budget range
+    void setBudget(float budget);
+    float getBudget() const;
+
+    // Audio thread. Takes the load of the last window, measured at the
+    // tier this returned last time, and returns the tier to run next.
+    ReverbQuality update(float load, ReverbQuality requested);
+
+    // Audio thread, back to the requested tier with no history
+    void reset();
+
+    // Tier steps taken since the start, from any thread
+    uint32_t getStepCount() const;
+
+private:
+    std::atomic<bool> enabled;
+    std::atomic<float> budget;
+    std::atomic<uint32_t> steps;
+
+    // Audio thread state
+    bool active;
+    int quality;        // QUALITY_COUNT: follows the requested tier
+    uint32_t over;
+    uint32_t under;
+    uint32_t hold;
+};
+
+#endif // STUDIO_REVERB_DSP_GOVERNOR_HPP_INCLUDED
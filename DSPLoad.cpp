@@ -0,0 +1,130 @@
+/*
+ * Studio Reverb DSP Load Implementation
+ * Per-stage cycle counts and callback time against the block deadline
+ */
+
+#include "DSPLoad.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Read attempts before giving up on a snapshot that keeps changing
+static const int DSP_LOAD_READ_TRIES = 8;
+
+DSPLoadMeter::DSPLoadMeter(double sampleRate)
+    : sampleRate(sampleRate),
+      sequence(0)
+{
+    reset();
+}
+
+void DSPLoadMeter::setSampleRate(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void DSPLoadMeter::reset()
+{
+    windowLength = static_cast<uint64_t>(sampleRate * DSP_LOAD_WINDOW_SECONDS);
+    if (windowLength == 0)
+        windowLength = 1;
+
+    calibrationTicks = readTicks();
+    calibrationTime = std::chrono::steady_clock::now();
+    ticksPerSecond = 0.0;
+
+    callbackStart = stageStart = 0;
+    std::fill(stageTicks, stageTicks + DSP_STAGE_COUNT, 0);
+    windowTicks = windowFrames = 0;
+    windowPeak = 0.0;
+    std::memset(&current, 0, sizeof(current));
+
+    // Readers see no snapshot until the first window is published
+    sequence.store(0, std::memory_order_release);
+}
+
+bool DSPLoadMeter::callbackEnd(uint32_t frames)
+{
+    if (frames == 0)
+        return false;
+
+    uint64_t ticks = readTicks() - callbackStart;
+    windowTicks += ticks;
+    windowFrames += frames;
+    windowPeak = std::max(windowPeak, static_cast<double>(ticks) / frames);
+
+    if (ticksPerSecond > 0.0)
+    {
+        double load = ticks * sampleRate / (ticksPerSecond * frames);
+        uint32_t bin = static_cast<uint32_t>(load / DSP_LOAD_BIN_WIDTH);
+        current.histogram[std::min(bin, DSP_LOAD_BINS - 1)]++;
+        current.callbacks++;
+        if (load > DSP_LOAD_XRUN_RISK)
+            current.xrunRisk++;
+        if (load > 1.0)
+            current.overruns++;
+    }
+
+    if (windowFrames >= windowLength)
+        return publish();
+    return false;
+}
+
+bool DSPLoadMeter::publish()
+{
+    // One clock read per window keeps the calibration current
+    uint64_t nowTicks = readTicks();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - calibrationTime).count();
+    if (elapsed > 0.0 && nowTicks > calibrationTicks)
+        ticksPerSecond = (nowTicks - calibrationTicks) / elapsed;
+
+    if (ticksPerSecond > 0.0)
+    {
+        double deadlineTicks = windowFrames * ticksPerSecond / sampleRate;
+        current.load = static_cast<float>(windowTicks / deadlineTicks);
+        current.peak = static_cast<float>(windowPeak * sampleRate / ticksPerSecond);
+        for (uint32_t s = 0; s < DSP_STAGE_COUNT; s++)
+            current.stageShare[s] = windowTicks > 0 ? static_cast<float>(stageTicks[s]) / windowTicks : 0.0f;
+
+        current.p99 = 0.0f;
+        uint64_t rank = current.callbacks - current.callbacks / 100, seen = 0;
+        for (uint32_t b = 0; b < DSP_LOAD_BINS && current.callbacks > 0; b++)
+        {
+            seen += current.histogram[b];
+            if (seen >= rank)
+            {
+                current.p99 = (b + 1) * DSP_LOAD_BIN_WIDTH;
+                break;
+            }
+        }
+
+        uint32_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&published, &current, sizeof(published));
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    std::fill(stageTicks, stageTicks + DSP_STAGE_COUNT, 0);
+    windowTicks = windowFrames = 0;
+    windowPeak = 0.0;
+    return ticksPerSecond > 0.0;
+}
+
+bool DSPLoadMeter::read(DSPLoadSnapshot& snapshot) const
+{
+    for (int i = 0; i < DSP_LOAD_READ_TRIES; i++)
+    {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return false;
+        if (before & 1)
+            continue;
+
+        std::memcpy(&snapshot, &published, sizeof(snapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
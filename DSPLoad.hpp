@@ -0,0 +1,126 @@
+/*
+ * Studio Reverb DSP Load Header
+ * Per-stage cycle counts and callback time against the block deadline
+ */
+
+#ifndef STUDIO_REVERB_DSP_LOAD_HPP_INCLUDED
+#define STUDIO_REVERB_DSP_LOAD_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+// Processing stages reported to a StudioReverbProbe. Algorithms that run as
+// one unit (plate, the hybrid head and tail) are reported as the late stage.
+enum DSPStage
+{
+    DSP_STAGE_EARLY = 0,
+    DSP_STAGE_LATE,
+    DSP_STAGE_MIX,
+    DSP_STAGE_COUNT
+};
+
+// Callback load histogram, in steps of DSP_LOAD_BIN_WIDTH of the deadline.
+// The last bin holds everything from 200% up.
+static const uint32_t DSP_LOAD_BINS = 41;
+static const float DSP_LOAD_BIN_WIDTH = 0.05f;
+
+// A callback that takes more than this share of its deadline leaves the
+// host too little room for the rest of the graph
+static const float DSP_LOAD_XRUN_RISK = 0.8f;
+
+// Audio time between two published snapshots (s)
+static const double DSP_LOAD_WINDOW_SECONDS = 0.25;
+
+// Loads are fractions of the deadline, frames / sample rate
+struct DSPLoadSnapshot
+{
+    float load;                         // busy time over the last window
+    float peak;                         // slowest callback of the last window
+    float p99;                          // 99th percentile callback since reset
+    float stageShare[DSP_STAGE_COUNT];  // share of the busy time per stage
+    uint64_t callbacks;
+    uint64_t xrunRisk;                  // callbacks above DSP_LOAD_XRUN_RISK
+    uint64_t overruns;                  // callbacks above their deadline
+    uint32_t histogram[DSP_LOAD_BINS];
+};
+
+// Written by the audio thread, read from any thread without locking. The
+// time stamp counter is calibrated against the steady clock once per window,
+// the histogram starts with the second window.
+class DSPLoadMeter
+{
+public:
+    DSPLoadMeter(double sampleRate);
+
+    // Not while the audio thread runs
+    void setSampleRate(double sampleRate);
+    void reset();
+
+    // Audio thread
+    inline void callbackBegin()
+    {
+        callbackStart = readTicks();
+    }
+
+    inline void stageBegin(DSPStage)
+    {
+        stageStart = readTicks();
+    }
+
+    inline void stageEnd(DSPStage stage)
+    {
+        stageTicks[stage] += readTicks() - stageStart;
+    }
+
+    // True when it closed a window, whose load getWindowLoad() returns
+    bool callbackEnd(uint32_t frames);
+    float getWindowLoad() const
+    {
+        return current.load;
+    }
+
+    // Any thread, false if no snapshot was published yet or the writer
+    // kept overwriting it
+    bool read(DSPLoadSnapshot& snapshot) const;
+
+    static inline uint64_t readTicks()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+private:
+    bool publish();
+
+    double sampleRate;
+    uint64_t windowLength;
+
+    // Calibration, ticks per second from reset() to the last window
+    uint64_t calibrationTicks;
+    std::chrono::steady_clock::time_point calibrationTime;
+    double ticksPerSecond;
+
+    // Audio thread state
+    uint64_t callbackStart;
+    uint64_t stageStart;
+    uint64_t stageTicks[DSP_STAGE_COUNT];
+    uint64_t windowTicks;
+    uint64_t windowFrames;
+    double windowPeak;  // ticks per frame
+    DSPLoadSnapshot current;
+
+    // Seqlock, odd while the snapshot is written
+    std::atomic<uint32_t> sequence;
+    DSPLoadSnapshot published;
+};
+
+#endif // STUDIO_REVERB_DSP_LOAD_HPP_INCLUDED
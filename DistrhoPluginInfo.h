@@ -41,7 +41,18 @@ enum Parameters
     paramModulation,
     paramLowCut,
     paramHighCut,
-    paramCount
+    paramCount,
+
+    // Outputs, the DSP load shown in the UI (percent of the block deadline)
+    paramDspLoad = paramCount,
+    paramDspPeak,
+    paramDspP99,
+    paramDspEarlyShare,
+    paramDspLateShare,
+    paramDspMixShare,
+    paramXrunRisk,
+    paramActiveQuality,     // ReverbQuality that runs, lowered by the CPU budget
+    paramTotalCount
 };
 
 // Reverb Types
@@ -51,9 +62,19 @@ enum ReverbType
     REVERB_HALL,
     REVERB_PLATE,
     REVERB_EARLY_REFLECTIONS,
+    REVERB_HYBRID,
     REVERB_TYPE_COUNT
 };
 
+// Quality tiers, trading tank density for CPU
+enum ReverbQuality
+{
+    QUALITY_ECO = 0,
+    QUALITY_STANDARD,
+    QUALITY_HIGH,
+    QUALITY_COUNT
+};
+
 // Parameter visibility structure
 struct ParameterVisibility
 {
@@ -0,0 +1,491 @@
+/*
+ * Studio Reverb Hybrid Reverb Implementation
+ * The first 80-150 ms of a measured IR are convolved, the progenitor2 tail
+ * takes over at the end of the IR with matched level and spectrum
+ */
+
+#include "HybridReverb.hpp"
+#include "freeverb/irsource.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+// Convolver partitions: 128 sample head fragments, 1024 sample tail fragments
+static const long HYBRID_FRAGMENT_SIZE = 128;
+static const long HYBRID_FRAGMENT_FACTOR = 8;
+
+// Convolver memory per IR sample, estimated: each channel keeps the
+// fragment spectra and the block delay of the input spectra
+static const long HYBRID_CONVOLVER_BYTES_PER_SAMPLE = 2 * 4 * sizeof(float);
+
+// Energy of L+R in [start, start+count) for the full band, below the low
+// shelf and above the high shelf. The filters run from the first sample so
+// that they have settled inside the window.
+static void bandEnergies(const float* L, const float* R, long start, long count,
+                         double sampleRate, double energies[3])
+{
+    fv3::biquad_f lowL, lowR, highL, highR;
+    lowL.setLPF_RBJ(HYBRID_LOW_SHELF_HZ, FV3_BIQUAD_RBJ_Q_BUTTERWORTH, sampleRate, FV3_BIQUAD_RBJ_Q);
+    lowR.setLPF_RBJ(HYBRID_LOW_SHELF_HZ, FV3_BIQUAD_RBJ_Q_BUTTERWORTH, sampleRate, FV3_BIQUAD_RBJ_Q);
+    highL.setHPF_RBJ(HYBRID_HIGH_SHELF_HZ, FV3_BIQUAD_RBJ_Q_BUTTERWORTH, sampleRate, FV3_BIQUAD_RBJ_Q);
+    highR.setHPF_RBJ(HYBRID_HIGH_SHELF_HZ, FV3_BIQUAD_RBJ_Q_BUTTERWORTH, sampleRate, FV3_BIQUAD_RBJ_Q);
+    lowL.mute(); lowR.mute(); highL.mute(); highR.mute();
+
+    energies[0] = energies[1] = energies[2] = 0.0;
+    for (long i = 0; i < start + count; i++) {
+        float lo = lowL(L[i]) + lowR(R[i]);
+        float hi = highL(L[i]) + highR(R[i]);
+        if (i < start)
+            continue;
+        float full = L[i] + R[i];
+        energies[0] += full * full;
+        energies[1] += lo * lo;
+        energies[2] += hi * hi;
+    }
+}
+
+HybridReverb::HybridReverb(double sampleRate)
+    : sampleRate(sampleRate),
+      headLengthMs(HYBRID_DEFAULT_HEAD_MS),
+      preDelayMs(0.0f),
+      publishedMatch(-1),
+      lastPublished(1),
+      preDelaySamples(0),
+      tailDelaySamples(0)
+{
+    settings.rsFactor = 1.0f;
+    settings.rt60 = 2.0f;
+    settings.diffusion = 0.7f;
+    settings.damping = 9000.0f;
+    settings.modulation = 0.2f;
+    settings.width = 1.0f;
+    settings.lowCut = 20.0f;
+    settings.diffusionStages = FV3_PROGENITOR2_NUM_IALLPASS;
+    settings.modulationMode = FV3_PROGENITOR2_MOD_ALLPASS;
+
+    currentMatch.gain = 1.0f;
+    currentMatch.lowShelfDb = 0.0f;
+    currentMatch.highShelfDb = 0.0f;
+    currentMatch.tailDelayMs = 0.0f;
+
+    // The head is a wet-only convolver, dry and filters are handled by the DSP
+    head.setFragmentSize(HYBRID_FRAGMENT_SIZE, HYBRID_FRAGMENT_FACTOR);
+    head.setFragCache(&fragCache);
+    head.setprocessoptions(FV3_IR_MUTE_DRY | FV3_IR_SKIP_FILTER);
+    head.setwet(0);
+    head.setwidth(1.0f);
+
+    tail.setMuteOnChange(false);
+    tail.setwet(0);   // 0dB wet signal
+    tail.setdryr(0);  // No dry signal in processor
+    tail.setSampleRate(sampleRate);
+    applyTailSettings(tail, settings);
+    allocDelays();
+    applyMatch(currentMatch);
+}
+
+HybridReverb::~HybridReverb()
+{
+}
+
+bool HybridReverb::loadImpulseFile(const char* path)
+{
+    FV3_TRACE_SCOPE("hybrid.loadImpulseFile");
+
+    fv3::irsource_f source;
+    if (path == nullptr || !source.open(path))
+        return false;
+
+    const double fileRate = source.getSampleRate();
+    const long available = source.getSize();
+    if (fileRate <= 0 || available <= 0)
+        return false;
+
+    // Find the direct sound (-20dB of the peak) within the first HYBRID_MAX_ONSET_MS
+    const long maxHead = static_cast<long>(fileRate * HYBRID_MAX_HEAD_MS / 1000.0);
+    const long readLength = std::min(available, static_cast<long>(fileRate * HYBRID_MAX_ONSET_MS / 1000.0) + maxHead);
+    std::vector<float> fileL(readLength), fileR(readLength);
+    source.read(0, 0, fileL.data(), readLength);
+    source.read(source.getChannels() > 1 ? 1 : 0, 0, fileR.data(), readLength);
+
+    float peak = 0.0f;
+    for (long i = 0; i < readLength; i++)
+        peak = std::max(peak, std::max(std::fabs(fileL[i]), std::fabs(fileR[i])));
+    if (peak <= 0.0f)
+        return false;
+
+    long fileOnset = 0;
+    while (fileOnset < readLength &&
+           std::fabs(fileL[fileOnset]) < peak * 0.1f && std::fabs(fileR[fileOnset]) < peak * 0.1f)
+        fileOnset++;
+
+    const long fileLength = std::min(readLength, fileOnset + static_cast<long>(fileRate * headLengthMs / 1000.0));
+
+    // Linear resampling to the processing rate
+    const double ratio = fileRate / sampleRate;
+    const long length = static_cast<long>(fileLength / ratio);
+    const long onset = static_cast<long>(fileOnset / ratio);
+    std::vector<float> irL(length), irR(length);
+    for (long i = 0; i < length; i++) {
+        double pos = i * ratio;
+        long index = static_cast<long>(pos);
+        float frac = static_cast<float>(pos - index);
+        long next = std::min(index + 1, fileLength - 1);
+        irL[i] = fileL[index] + frac * (fileL[next] - fileL[index]);
+        irR[i] = fileR[index] + frac * (fileR[next] - fileR[index]);
+    }
+
+    TailMatch match;
+    if (!analyze(irL.data(), irR.data(), length, onset, match))
+        return false;
+
+    // Raised cosine fade over the handover to the tail
+    const long fade = static_cast<long>(sampleRate * HYBRID_FADE_MS / 1000.0);
+    for (long i = 0; i < fade; i++) {
+        float g = 0.5f * (1.0f + std::cos(static_cast<float>(M_PI) * (i + 1) / fade));
+        irL[length - fade + i] *= g;
+        irR[length - fade + i] *= g;
+    }
+
+    try {
+        // Returns once the loader thread runs, the old head is crossfaded out
+        head.loadImpulse(irL.data(), irR.data(), length);
+    } catch (std::bad_alloc&) {
+        return false;
+    }
+
+    impulseFile = path;
+    publishMatch(match);
+    return true;
+}
+
+bool HybridReverb::analyze(const float* irL, const float* irR, long length, long onset, TailMatch& match) const
+{
+    const long fade = static_cast<long>(sampleRate * HYBRID_FADE_MS / 1000.0);
+    const long window = static_cast<long>(sampleRate * HYBRID_MATCH_MS / 1000.0);
+    const long fadeStart = length - fade;
+    const long windowStart = fadeStart - window;
+    if (fade <= 0 || window <= 0 || windowStart <= onset)
+        return false;
+
+    double headEnergy[3];
+    bandEnergies(irL, irR, windowStart, window, sampleRate, headEnergy);
+
+    // Decay slope of the head from the Schroeder integral over the second
+    // half between the direct sound and the fade
+    const long edcStart = onset + (fadeStart - onset) / 2;
+    std::vector<double> edc(fadeStart - edcStart);
+    double sum = 0.0;
+    for (long i = fadeStart - 1; i >= edcStart; i--) {
+        sum += irL[i] * irL[i] + irR[i] * irR[i];
+        edc[i - edcStart] = sum;
+    }
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    long n = 0;
+    for (long i = 0; i < static_cast<long>(edc.size()) - window; i++) {
+        if (edc[i] <= 0.0)
+            break;
+        double x = static_cast<double>(i);
+        double y = 10.0 * std::log10(edc[i]);
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        n++;
+    }
+    double slope = 0.0;  // dB per sample
+    if (n > 2 && (n * sxx - sx * sx) > 0.0)
+        slope = std::min(0.0, (n * sxy - sx * sy) / (n * sxx - sx * sx));
+
+    // The tail input starts with the fade. Its level is compared in the
+    // window right after the head, fade + window samples after the head
+    // window, so the head level is extrapolated along its own decay.
+    const double decay = std::pow(10.0, slope * (fade + window) / 10.0);
+
+    fv3::progenitor2_f probe;
+    probe.setMuteOnChange(false);
+    probe.setwet(0);
+    probe.setdryr(0);
+    probe.setSampleRate(sampleRate);
+    applyTailSettings(probe, settings);
+    probe.setPreDelay(0);
+    probe.mute();
+
+    const long probeLength = fade + window;
+    std::vector<float> inL(probeLength, 0.0f), inR(probeLength, 0.0f);
+    std::vector<float> outL(probeLength, 0.0f), outR(probeLength, 0.0f);
+    inL[0] = inR[0] = 1.0f;
+    probe.processreplace(inL.data(), inR.data(), outL.data(), outR.data(), probeLength);
+
+    double tailEnergy[3];
+    bandEnergies(outL.data(), outR.data(), fade, window, sampleRate, tailEnergy);
+
+    double gains[3];
+    for (int b = 0; b < 3; b++)
+        gains[b] = std::sqrt(headEnergy[b] * decay / std::max(tailEnergy[b], 1e-20));
+    if (gains[0] <= 0.0)
+        return false;
+
+    match.gain = static_cast<float>(gains[0]);
+    match.lowShelfDb = std::max(-HYBRID_MAX_SHELF_DB, std::min(HYBRID_MAX_SHELF_DB,
+                       static_cast<float>(20.0 * std::log10(std::max(gains[1], 1e-10) / gains[0]))));
+    match.highShelfDb = std::max(-HYBRID_MAX_SHELF_DB, std::min(HYBRID_MAX_SHELF_DB,
+                        static_cast<float>(20.0 * std::log10(std::max(gains[2], 1e-10) / gains[0]))));
+    match.tailDelayMs = static_cast<float>(fadeStart * 1000.0 / sampleRate);
+    return true;
+}
+
+void HybridReverb::clearImpulse()
+{
+    head.unloadImpulse();
+    impulseFile.clear();
+
+    TailMatch neutral;
+    neutral.gain = 1.0f;
+    neutral.lowShelfDb = 0.0f;
+    neutral.highShelfDb = 0.0f;
+    neutral.tailDelayMs = 0.0f;
+    publishMatch(neutral);
+}
+
+bool HybridReverb::hasImpulse()
+{
+    return head.getImpulseSize() > 0 || head.isLoading();
+}
+
+bool HybridReverb::isLoading()
+{
+    return head.isLoading();
+}
+
+long HybridReverb::getMemorySize()
+{
+    return tail.getMemorySize() + (tailDelay[0].getsize() + tailDelay[1].getsize()) * sizeof(float) +
+           (headDelay[0].getsize() + headDelay[1].getsize()) * sizeof(float) +
+           head.getImpulseSize() * HYBRID_CONVOLVER_BYTES_PER_SAMPLE;
+}
+
+long HybridReverb::getLatency()
+{
+    return head.getLatency();
+}
+
+const std::string& HybridReverb::getImpulseFile() const
+{
+    return impulseFile;
+}
+
+void HybridReverb::setHeadLength(float ms)
+{
+    headLengthMs = std::max(HYBRID_MIN_HEAD_MS, std::min(HYBRID_MAX_HEAD_MS, ms));
+}
+
+float HybridReverb::getHeadLength() const
+{
+    return headLengthMs;
+}
+
+void HybridReverb::applyTailSettings(fv3::progenitor2_f& reverb, const TailSettings& s) const
+{
+    reverb.setRSFactor(s.rsFactor);
+    reverb.setrt60(s.rt60);
+    reverb.setidiffusion1(s.diffusion);
+    reverb.setodiffusion1(s.diffusion);
+    reverb.setdamp(s.damping);
+    reverb.setoutputdamp(s.damping);
+    reverb.setspin(0.1f + s.modulation * 2.0f);     // 0.1-2.1 Hz
+    reverb.setwander(0.2f + s.modulation * 0.6f);
+    reverb.setwidth(s.width);
+    reverb.setdccutfreq(s.lowCut);
+    reverb.setidiffusionstages(s.diffusionStages);
+    reverb.setmodulationmode(s.modulationMode);
+}
+
+void HybridReverb::publishMatch(const TailMatch& match)
+{
+    // A slot taken back before process() read it is free, otherwise the
+    // audio thread may still copy the last one and the other slot is used
+    int slot = publishedMatch.exchange(-1, std::memory_order_acq_rel);
+    if (slot < 0)
+        slot = 1 - lastPublished;
+    matchSlots[slot] = match;
+    lastPublished = slot;
+    publishedMatch.store(slot, std::memory_order_release);
+}
+
+void HybridReverb::applyMatch(const TailMatch& match)
+{
+    currentMatch = match;
+    tailDelaySamples = static_cast<long>(sampleRate * match.tailDelayMs / 1000.0);
+    for (int ch = 0; ch < 2; ch++) {
+        lowShelf[ch].setLSF_RBJ(HYBRID_LOW_SHELF_HZ, match.lowShelfDb, 1.0f, sampleRate);
+        highShelf[ch].setHSF_RBJ(HYBRID_HIGH_SHELF_HZ, match.highShelfDb, 1.0f, sampleRate);
+    }
+}
+
+void HybridReverb::setRSFactor(float value)
+{
+    settings.rsFactor = value;
+    tail.setRSFactor(value);
+}
+
+void HybridReverb::setDecay(float rt60)
+{
+    settings.rt60 = rt60;
+    tail.setrt60(rt60);
+}
+
+void HybridReverb::setDiffusion(float value)
+{
+    settings.diffusion = value;
+    tail.setidiffusion1(value);
+    tail.setodiffusion1(value);
+}
+
+void HybridReverb::setDamping(float freq)
+{
+    settings.damping = freq;
+    tail.setdamp(freq);
+    tail.setoutputdamp(freq);
+}
+
+void HybridReverb::setModulation(float amount)
+{
+    settings.modulation = amount;
+    tail.setspin(0.1f + amount * 2.0f);
+    tail.setwander(0.2f + amount * 0.6f);
+}
+
+void HybridReverb::setWidth(float value)
+{
+    settings.width = value;
+    tail.setwidth(value);
+    head.setwidth(value);
+}
+
+void HybridReverb::setLowCut(float freq)
+{
+    settings.lowCut = freq;
+    tail.setdccutfreq(freq);
+}
+
+void HybridReverb::setPreDelay(float ms)
+{
+    // Only moves the taps, the convolver's own initial delay would
+    // reallocate its delay lines under the audio thread
+    preDelayMs = std::max(0.0f, std::min(HYBRID_MAX_PREDELAY_MS, ms));
+    preDelaySamples.store(static_cast<long>(sampleRate * preDelayMs / 1000.0), std::memory_order_relaxed);
+}
+
+void HybridReverb::allocDelays()
+{
+    // The match delay is the head length from the start of the file
+    const long size = static_cast<long>(sampleRate * (HYBRID_MAX_ONSET_MS + HYBRID_MAX_HEAD_MS + HYBRID_MAX_PREDELAY_MS) / 1000.0) + 1;
+    const long headSize = static_cast<long>(sampleRate * HYBRID_MAX_PREDELAY_MS / 1000.0) + 1;
+    for (int ch = 0; ch < 2; ch++) {
+        tailDelay[ch].setsize(size);
+        tailDelay[ch].mute();
+        headDelay[ch].setsize(headSize);
+        headDelay[ch].mute();
+    }
+}
+
+void HybridReverb::setTailQuality(long diffusionStages, long modulationMode)
+{
+    settings.diffusionStages = diffusionStages;
+    settings.modulationMode = modulationMode;
+    tail.setidiffusionstages(diffusionStages);
+    tail.setmodulationmode(modulationMode);
+}
+
+void HybridReverb::setNoiseSeed(uint32_t seed)
+{
+    tail.setnoiseseed(seed);
+}
+
+void HybridReverb::sampleRateChanged(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    tail.setSampleRate(newSampleRate);
+    allocDelays();
+    setPreDelay(preDelayMs);
+
+    // The head is resampled and matched again at the new rate
+    publishMatch(currentMatch);
+    if (!impulseFile.empty()) {
+        std::string path = impulseFile;
+        if (!loadImpulseFile(path.c_str()))
+            clearImpulse();
+    }
+}
+
+void HybridReverb::process(const float* inputL, const float* inputR,
+                           float* earlyL, float* earlyR,
+                           float* lateL, float* lateR,
+                           uint32_t frames)
+{
+    const int slot = publishedMatch.exchange(-1, std::memory_order_acq_rel);
+    if (slot >= 0)
+        applyMatch(matchSlots[slot]);
+
+    // The convolver leaves the output untouched while it has no impulse
+    std::memset(earlyL, 0, frames * sizeof(float));
+    std::memset(earlyR, 0, frames * sizeof(float));
+    head.processreplace(inputL, inputR, earlyL, earlyR, frames);
+
+    // Head pre-delay, read before the write as for the tail
+    const long preDelay = preDelaySamples.load(std::memory_order_relaxed);
+    if (preDelay > 0) {
+        for (uint32_t i = 0; i < frames; i++) {
+            const float L = headDelay[0].get_z(preDelay);
+            const float R = headDelay[1].get_z(preDelay);
+            headDelay[0]._process(earlyL[i]);
+            headDelay[1]._process(earlyR[i]);
+            earlyL[i] = L;
+            earlyR[i] = R;
+        }
+    }
+
+    if (inputL == inputR)
+        tail.processreplaceM(const_cast<float*>(inputL), lateL, lateR, frames);
+    else
+        tail.processreplace(const_cast<float*>(inputL), const_cast<float*>(inputR), lateL, lateR, frames);
+
+    // Tail pre-delay, read before the write so that a delay of 0 passes through
+    const long delay = preDelay + tailDelaySamples;
+    const float gain = currentMatch.gain;
+    for (uint32_t i = 0; i < frames; i++) {
+        float L = delay > 0 ? tailDelay[0].get_z(delay) : lateL[i];
+        float R = delay > 0 ? tailDelay[1].get_z(delay) : lateR[i];
+        tailDelay[0]._process(lateL[i]);
+        tailDelay[1]._process(lateR[i]);
+        lateL[i] = gain * highShelf[0](lowShelf[0](L));
+        lateR[i] = gain * highShelf[1](lowShelf[1](R));
+    }
+}
+
+void HybridReverb::mute()
+{
+    // The loader of a head which is still loading keeps running
+    head.mute();
+    tail.mute();
+    for (int ch = 0; ch < 2; ch++) {
+        headDelay[ch].mute();
+        tailDelay[ch].mute();
+        lowShelf[ch].mute();
+        highShelf[ch].mute();
+    }
+}
+
+void HybridReverb::state(fv3::state_io& io)
+{
+    tail.state(io);
+    for (int ch = 0; ch < 2; ch++) {
+        tailDelay[ch].state(io);
+        lowShelf[ch].state(io);
+        highShelf[ch].state(io);
+    }
+    if (io.isLoading()) {
+        head.mute();
+        headDelay[0].mute();
+        headDelay[1].mute();
+    }
+}
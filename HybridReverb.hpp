@@ -0,0 +1,160 @@
+/*
+ * Studio Reverb Hybrid Reverb Header
+ * Convolved early response with an algorithmic tail
+ */
+
+#ifndef STUDIO_REVERB_HYBRID_HPP_INCLUDED
+#define STUDIO_REVERB_HYBRID_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Freeverb3 includes
+#include "freeverb/irmodel3p.hpp"
+#include "freeverb/fragcache.hpp"
+#include "freeverb/progenitor2.hpp"
+#include "freeverb/biquad.hpp"
+#include "freeverb/delay.hpp"
+
+// Bounds of the convolved head, measured from the direct sound (ms)
+static const float HYBRID_MIN_HEAD_MS = 80.0f;
+static const float HYBRID_MAX_HEAD_MS = 150.0f;
+static const float HYBRID_DEFAULT_HEAD_MS = 120.0f;
+
+// The direct sound is searched for within the first HYBRID_MAX_ONSET_MS
+static const float HYBRID_MAX_ONSET_MS = 500.0f;
+
+// Longest pre-delay, the Pre-Delay parameter range (ms)
+static const float HYBRID_MAX_PREDELAY_MS = 200.0f;
+
+// The head fades out over its last HYBRID_FADE_MS while the tail builds up
+static const float HYBRID_FADE_MS = 20.0f;
+
+// Window used to measure the head level and spectrum before the fade (ms)
+static const float HYBRID_MATCH_MS = 15.0f;
+
+// Tail spectrum correction: shelf frequencies (Hz) and range (dB)
+static const float HYBRID_LOW_SHELF_HZ = 500.0f;
+static const float HYBRID_HIGH_SHELF_HZ = 4000.0f;
+static const float HYBRID_MAX_SHELF_DB = 12.0f;
+
+class HybridReverb
+{
+public:
+    HybridReverb(double sampleRate);
+    ~HybridReverb();
+
+    // Load the head of an impulse response file. This reads and analyzes
+    // the file, so it must not be called from the audio thread. The
+    // convolver swaps to the new head with a crossfade.
+    bool loadImpulseFile(const char* path);
+    void clearImpulse();
+    bool hasImpulse();
+    bool isLoading();
+    long getMemorySize();
+
+    // Convolver latency in frames, 0 for the zero latency partitioning
+    long getLatency();
+    const std::string& getImpulseFile() const;
+
+    // Length of the convolved head (ms), applied on the next load
+    void setHeadLength(float ms);
+    float getHeadLength() const;
+
+    // Tail settings. They are mirrored to the probe reverb that is used to
+    // match the tail to the end of the head.
+    void setRSFactor(float value);
+    void setDecay(float rt60);
+    void setDiffusion(float value);
+    void setDamping(float freq);
+    void setModulation(float amount);
+    void setWidth(float value);
+    void setLowCut(float freq);
+    void setPreDelay(float ms);
+
+    // Input diffusion stages and FV3_PROGENITOR2_MOD_* of the tail
+    void setTailQuality(long diffusionStages, long modulationMode);
+
+    // Seed of the tail's modulation noise
+    void setNoiseSeed(uint32_t seed);
+
+    void sampleRateChanged(double sampleRate);
+
+    // Head goes to early, tail to late. The same pointer for both inputs
+    // runs the tail on mono input.
+    void process(const float* inputL, const float* inputR,
+                 float* earlyL, float* earlyR,
+                 float* lateL, float* lateR,
+                 uint32_t frames);
+
+    void mute();
+
+    // Signal state of the tail and its spectrum correction. The
+    // convolver's input history is not kept, loading restarts the head
+    // from silence.
+    void state(fv3::state_io& io);
+
+private:
+    struct TailSettings
+    {
+        float rsFactor;
+        float rt60;
+        float diffusion;
+        float damping;
+        float modulation;
+        float width;
+        float lowCut;
+        long diffusionStages;
+        long modulationMode;
+    };
+
+    struct TailMatch
+    {
+        float gain;
+        float lowShelfDb;
+        float highShelfDb;
+        float tailDelayMs;
+    };
+
+    void applyTailSettings(fv3::progenitor2_f& reverb, const TailSettings& s) const;
+    void publishMatch(const TailMatch& match);
+    void applyMatch(const TailMatch& match);
+    void allocDelays();
+    bool analyze(const float* irL, const float* irR, long length, long onset, TailMatch& match) const;
+
+    double sampleRate;
+    float headLengthMs;
+    float preDelayMs;
+    std::string impulseFile;
+
+    TailSettings settings;
+
+    // Written by the loading thread, picked up at the start of process().
+    // A published slot is only rewritten after it was taken back unread,
+    // the other one may still be copied by the audio thread.
+    TailMatch matchSlots[2];
+    std::atomic<int> publishedMatch;
+    int lastPublished;
+
+    // Pre-delay in samples. The head is delayed by this, the tail by this
+    // plus the match delay.
+    std::atomic<long> preDelaySamples;
+
+    // Head spectra of earlier loads, shared on disk with other instances.
+    // Declared before the head, whose loader thread uses it.
+    fv3::fragcache_f fragCache;
+
+    // Audio thread state. The delay lines are sized for the longest head
+    // and pre-delay, a match or a Pre-Delay change only moves their taps.
+    TailMatch currentMatch;
+    long tailDelaySamples;
+    fv3::irmodel3p_f head;
+    fv3::progenitor2_f tail;
+    fv3::delay_f headDelay[2];
+    fv3::delay_f tailDelay[2];
+    fv3::biquad_f lowShelf[2];
+    fv3::biquad_f highShelf[2];
+};
+
+#endif // STUDIO_REVERB_HYBRID_HPP_INCLUDED
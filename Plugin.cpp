@@ -4,6 +4,11 @@
 
 #include "DistrhoPlugin.hpp"
 #include "DSP.hpp"
+#include "Programs.hpp"
+#include "Telemetry.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 
 START_NAMESPACE_DISTRHO
@@ -14,11 +19,16 @@ class StudioReverbPlugin : public Plugin
 {
 public:
     StudioReverbPlugin()
-        : Plugin(paramCount, 16, 1),  // 16 programs, 1 state
+        : Plugin(paramTotalCount, PROGRAM_COUNT, 4),  // 16 programs, 4 states
           dsp(getSampleRate())
     {
         // Load default program
         loadProgram(0);
+
+        // Opt-in, for monitoring tools outside the host
+        const char* enable = std::getenv(TELEMETRY_ENV);
+        if (enable != nullptr && std::atoi(enable) == 1 && telemetry.open())
+            telemetry.setMemorySize(dsp.getMemorySize());
     }
 
 protected:
@@ -32,7 +42,7 @@ protected:
 
     const char* getDescription() const override
     {
-        return "High-quality reverb with four distinct algorithms";
+        return "High-quality reverb with five distinct algorithms";
     }
 
     const char* getMaker() const override
@@ -87,6 +97,8 @@ protected:
                 values[2].value = REVERB_PLATE;
                 values[3].label = "Early Reflections";
                 values[3].value = REVERB_EARLY_REFLECTIONS;
+                values[4].label = "Hybrid";
+                values[4].value = REVERB_HYBRID;
                 parameter.enumValues.values = values;
             }
             break;
@@ -210,64 +222,50 @@ protected:
             parameter.ranges.min = 1000.0f;
             parameter.ranges.max = 20000.0f;
             break;
-        }
-    }
 
-    void initProgramName(uint32_t index, String& programName) override
-    {
-        switch (index)
-        {
-        case 0:
-            programName = "Default";
-            break;
-        case 1:
-            programName = "Small Room";
-            break;
-        case 2:
-            programName = "Medium Room";
-            break;
-        case 3:
-            programName = "Large Room";
+        case paramDspLoad:
+            initLoadParameter(parameter, "DSP Load", "dspload", "%", 200.0f);
             break;
-        case 4:
-            programName = "Small Hall";
-            break;
-        case 5:
-            programName = "Concert Hall";
-            break;
-        case 6:
-            programName = "Cathedral";
-            break;
-        case 7:
-            programName = "Bright Plate";
-            break;
-        case 8:
-            programName = "Dark Plate";
-            break;
-        case 9:
-            programName = "Vintage Plate";
+
+        case paramDspPeak:
+            initLoadParameter(parameter, "DSP Peak", "dsppeak", "%", 200.0f);
             break;
-        case 10:
-            programName = "Subtle";
+
+        case paramDspP99:
+            initLoadParameter(parameter, "DSP 99th Percentile", "dspp99", "%", 200.0f);
             break;
-        case 11:
-            programName = "Ambient";
+
+        case paramDspEarlyShare:
+            initLoadParameter(parameter, "DSP Early Share", "dspearly", "%", 100.0f);
             break;
-        case 12:
-            programName = "Dense";
+
+        case paramDspLateShare:
+            initLoadParameter(parameter, "DSP Late Share", "dsplate", "%", 100.0f);
             break;
-        case 13:
-            programName = "Spacious";
+
+        case paramDspMixShare:
+            initLoadParameter(parameter, "DSP Mix Share", "dspmix", "%", 100.0f);
             break;
-        case 14:
-            programName = "Short";
+
+        case paramXrunRisk:
+            initLoadParameter(parameter, "Xrun Risk", "xrunrisk", "", 1e6f);
+            parameter.hints |= kParameterIsInteger;
             break;
-        case 15:
-            programName = "Long";
+
+        case paramActiveQuality:
+            initLoadParameter(parameter, "Active Quality", "activequality", "", QUALITY_COUNT - 1.0f);
+            parameter.hints |= kParameterIsInteger;
+            parameter.ranges.def = QUALITY_HIGH;
             break;
         }
     }
 
+
+    void initProgramName(uint32_t index, String& programName) override
+    {
+        programName = getProgram(index).name;
+    }
+
     void initState(uint32_t index, String& stateKey, String& defaultStateValue) override
     {
         if (index == 0)
@@ -275,6 +273,21 @@ protected:
             stateKey = "preset";
             defaultStateValue = "0";  // Default preset
         }
+        else if (index == 1)
+        {
+            stateKey = "irfile";
+            defaultStateValue = "";  // No IR, Hybrid uses early reflections
+        }
+        else if (index == 2)
+        {
+            stateKey = "quality";
+            defaultStateValue = "high";
+        }
+        else if (index == 3)
+        {
+            stateKey = "cpubudget";
+            defaultStateValue = "0";  // Percent of the block deadline, 0 is off
+        }
     }
 
     // -------------------------------------------------------------------
@@ -282,7 +295,34 @@ protected:
 
     float getParameterValue(uint32_t index) const override
     {
-        return dsp.getParameterValue(index);
+        if (index < paramCount)
+            return dsp.getParameterValue(index);
+        if (index == paramActiveQuality)
+            return static_cast<float>(dsp.getActiveQuality());
+
+        // Outputs come from the load snapshot, published by the audio thread
+        DSPLoadSnapshot load;
+        if (!dsp.getLoadSnapshot(load))
+            return 0.0f;
+
+        switch (index)
+        {
+        case paramDspLoad:
+            return std::min(load.load * 100.0f, 200.0f);
+        case paramDspPeak:
+            return std::min(load.peak * 100.0f, 200.0f);
+        case paramDspP99:
+            return std::min(load.p99 * 100.0f, 200.0f);
+        case paramDspEarlyShare:
+            return load.stageShare[DSP_STAGE_EARLY] * 100.0f;
+        case paramDspLateShare:
+            return load.stageShare[DSP_STAGE_LATE] * 100.0f;
+        case paramDspMixShare:
+            return load.stageShare[DSP_STAGE_MIX] * 100.0f;
+        case paramXrunRisk:
+            return static_cast<float>(std::min<uint64_t>(load.xrunRisk, 1000000));
+        }
+        return 0.0f;
     }
 
     void setParameterValue(uint32_t index, float value) override
@@ -292,150 +332,10 @@ protected:
 
     void loadProgram(uint32_t index) override
     {
-        switch (index)
-        {
-        case 0:  // Default
-            setParameterValue(paramReverbType, REVERB_ROOM);
-            setParameterValue(paramDry, 100.0f);
-            setParameterValue(paramEarly, 75.0f);
-            setParameterValue(paramLate, 75.0f);
-            setParameterValue(paramSize, 50.0f);
-            setParameterValue(paramWidth, 100.0f);
-            setParameterValue(paramPredelay, 10.0f);
-            setParameterValue(paramDecay, 2.0f);
-            setParameterValue(paramDiffuse, 70.0f);
-            setParameterValue(paramDamping, 50.0f);
-            setParameterValue(paramModulation, 20.0f);
-            setParameterValue(paramLowCut, 20.0f);
-            setParameterValue(paramHighCut, 16000.0f);
-            break;
-
-        case 1:  // Small Room
-            setParameterValue(paramReverbType, REVERB_ROOM);
-            setParameterValue(paramDry, 85.0f);
-            setParameterValue(paramEarly, 90.0f);
-            setParameterValue(paramLate, 60.0f);
-            setParameterValue(paramSize, 25.0f);
-            setParameterValue(paramWidth, 80.0f);
-            setParameterValue(paramPredelay, 5.0f);
-            setParameterValue(paramDecay, 0.8f);
-            setParameterValue(paramDiffuse, 60.0f);
-            setParameterValue(paramDamping, 70.0f);
-            break;
-
-        case 2:  // Medium Room
-            setParameterValue(paramReverbType, REVERB_ROOM);
-            setParameterValue(paramDry, 80.0f);
-            setParameterValue(paramEarly, 80.0f);
-            setParameterValue(paramLate, 70.0f);
-            setParameterValue(paramSize, 50.0f);
-            setParameterValue(paramWidth, 90.0f);
-            setParameterValue(paramPredelay, 10.0f);
-            setParameterValue(paramDecay, 1.5f);
-            setParameterValue(paramDiffuse, 70.0f);
-            setParameterValue(paramDamping, 60.0f);
-            break;
-
-        case 3:  // Large Room
-            setParameterValue(paramReverbType, REVERB_ROOM);
-            setParameterValue(paramDry, 75.0f);
-            setParameterValue(paramEarly, 70.0f);
-            setParameterValue(paramLate, 80.0f);
-            setParameterValue(paramSize, 75.0f);
-            setParameterValue(paramWidth, 100.0f);
-            setParameterValue(paramPredelay, 20.0f);
-            setParameterValue(paramDecay, 2.5f);
-            setParameterValue(paramDiffuse, 80.0f);
-            setParameterValue(paramDamping, 50.0f);
-            break;
-
-        case 4:  // Small Hall
-            setParameterValue(paramReverbType, REVERB_HALL);
-            setParameterValue(paramDry, 70.0f);
-            setParameterValue(paramEarly, 50.0f);
-            setParameterValue(paramLate, 85.0f);
-            setParameterValue(paramSize, 60.0f);
-            setParameterValue(paramWidth, 100.0f);
-            setParameterValue(paramPredelay, 25.0f);
-            setParameterValue(paramDecay, 2.0f);
-            setParameterValue(paramDiffuse, 75.0f);
-            setParameterValue(paramDamping, 55.0f);
-            setParameterValue(paramModulation, 15.0f);
-            break;
-
-        case 5:  // Concert Hall
-            setParameterValue(paramReverbType, REVERB_HALL);
-            setParameterValue(paramDry, 60.0f);
-            setParameterValue(paramEarly, 40.0f);
-            setParameterValue(paramLate, 90.0f);
-            setParameterValue(paramSize, 85.0f);
-            setParameterValue(paramWidth, 100.0f);
-            setParameterValue(paramPredelay, 35.0f);
-            setParameterValue(paramDecay, 3.5f);
-            setParameterValue(paramDiffuse, 85.0f);
-            setParameterValue(paramDamping, 45.0f);
-            setParameterValue(paramModulation, 20.0f);
-            break;
-
-        case 6:  // Cathedral
-            setParameterValue(paramReverbType, REVERB_HALL);
-            setParameterValue(paramDry, 50.0f);
-            setParameterValue(paramEarly, 30.0f);
-            setParameterValue(paramLate, 95.0f);
-            setParameterValue(paramSize, 100.0f);
-            setParameterValue(paramWidth, 100.0f);
-            setParameterValue(paramPredelay, 50.0f);
-            setParameterValue(paramDecay, 6.0f);
-            setParameterValue(paramDiffuse, 90.0f);
-            setParameterValue(paramDamping, 35.0f);
-            setParameterValue(paramModulation, 25.0f);
-            break;
-
-        case 7:  // Bright Plate
-            setParameterValue(paramReverbType, REVERB_PLATE);
-            setParameterValue(paramDry, 85.0f);
-            setParameterValue(paramEarly, 80.0f);
-            setParameterValue(paramLate, 75.0f);
-            setParameterValue(paramPredelay, 0.0f);
-            setParameterValue(paramDecay, 2.0f);
-            setParameterValue(paramDiffuse, 85.0f);
-            setParameterValue(paramDamping, 20.0f);
-            setParameterValue(paramModulation, 30.0f);
-            setParameterValue(paramHighCut, 18000.0f);
-            break;
+        const Program& program = getProgram(index);
 
-        case 8:  // Dark Plate
-            setParameterValue(paramReverbType, REVERB_PLATE);
-            setParameterValue(paramDry, 80.0f);
-            setParameterValue(paramEarly, 75.0f);
-            setParameterValue(paramLate, 80.0f);
-            setParameterValue(paramPredelay, 5.0f);
-            setParameterValue(paramDecay, 2.5f);
-            setParameterValue(paramDiffuse, 80.0f);
-            setParameterValue(paramDamping, 70.0f);
-            setParameterValue(paramModulation, 20.0f);
-            setParameterValue(paramHighCut, 8000.0f);
-            break;
-
-        case 9:  // Vintage Plate
-            setParameterValue(paramReverbType, REVERB_PLATE);
-            setParameterValue(paramDry, 75.0f);
-            setParameterValue(paramEarly, 85.0f);
-            setParameterValue(paramLate, 70.0f);
-            setParameterValue(paramPredelay, 10.0f);
-            setParameterValue(paramDecay, 3.0f);
-            setParameterValue(paramDiffuse, 75.0f);
-            setParameterValue(paramDamping, 50.0f);
-            setParameterValue(paramModulation, 40.0f);
-            setParameterValue(paramHighCut, 12000.0f);
-            break;
-
-        // Add more presets as needed...
-        default:
-            // Load default for unimplemented presets
-            loadProgram(0);
-            break;
-        }
+        for (uint32_t i = 0; i < program.count; i++)
+            setParameterValue(program.values[i].index, program.values[i].value);
     }
 
     String getState(const char* key) const override
@@ -445,6 +345,18 @@ protected:
             // Return current preset index as string
             return String(getCurrentProgram());
         }
+        if (std::strcmp(key, "irfile") == 0)
+        {
+            return String(dsp.getImpulseFile().c_str());
+        }
+        if (std::strcmp(key, "quality") == 0)
+        {
+            return String(StudioReverbDSP::getQualityName(dsp.getQuality()));
+        }
+        if (std::strcmp(key, "cpubudget") == 0)
+        {
+            return String(static_cast<int>(dsp.getQualityBudget() * 100.0f + 0.5f));
+        }
         return String();
     }
 
@@ -454,9 +366,26 @@ protected:
         {
             // Load preset from saved state
             int preset = std::atoi(value);
-            if (preset >= 0 && preset < 16)
+            if (preset >= 0 && preset < static_cast<int>(PROGRAM_COUNT))
                 loadProgram(preset);
         }
+        else if (std::strcmp(key, "irfile") == 0)
+        {
+            // Reads and analyzes the IR head, states are not set from the audio thread
+            if (value == nullptr || value[0] == '\0' || !dsp.loadImpulseFile(value))
+                dsp.clearImpulse();
+        }
+        else if (std::strcmp(key, "quality") == 0)
+        {
+            // Unknown names keep the current tier
+            ReverbQuality quality;
+            if (StudioReverbDSP::parseQuality(value, quality))
+                dsp.setQuality(quality);
+        }
+        else if (std::strcmp(key, "cpubudget") == 0)
+        {
+            dsp.setQualityBudget(std::atoi(value) / 100.0f);
+        }
     }
 
     // -------------------------------------------------------------------
@@ -464,18 +393,41 @@ protected:
 
     void activate() override
     {
-        // Nothing to do here
+        // Load statistics cover one activation
+        dsp.resetLoad();
+        telemetry.setSleeping(false);
     }
 
     void deactivate() override
     {
         // Mute reverb tails
         dsp.mute();
+        telemetry.setSleeping(true);
+
+#ifdef FV3_TRACE
+        if (const char* tracePath = std::getenv("STUDIOREVERB_TRACE"))
+            fv3::trace_dump(tracePath);
+#endif
     }
 
     void run(const float** inputs, float** outputs, uint32_t frames) override
     {
+        if (!telemetry.isOpen())
+        {
+            dsp.run(inputs, outputs, frames);
+            return;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         dsp.run(inputs, outputs, frames);
+        uint64_t runNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        // Delay lines follow Size and the sample rate, the IR loads in the
+        // background, so the memory is refreshed once per window
+        if (telemetry.update(static_cast<uint32_t>(dsp.getParameterValue(paramReverbType) + 0.5f),
+                             getSampleRate(), frames, runNs, dsp.isTailActive()))
+            telemetry.setMemorySize(dsp.getMemorySize());
     }
 
     void sampleRateChanged(double newSampleRate) override
@@ -486,7 +438,21 @@ protected:
     // -------------------------------------------------------------------
 
 private:
+    // Output parameters, read only for the host
+    void initLoadParameter(Parameter& parameter, const char* name, const char* symbol,
+                           const char* unit, float max)
+    {
+        parameter.hints = kParameterIsOutput;
+        parameter.name = name;
+        parameter.symbol = symbol;
+        parameter.unit = unit;
+        parameter.ranges.def = 0.0f;
+        parameter.ranges.min = 0.0f;
+        parameter.ranges.max = max;
+    }
+
     StudioReverbDSP dsp;
+    Telemetry telemetry;
 
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StudioReverbPlugin)
 };
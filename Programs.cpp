@@ -0,0 +1,170 @@
+/*
+ * Studio Reverb Factory Programs
+ */
+
+#include "Programs.hpp"
+
+#define PROGRAM_VALUES(values) values, sizeof(values) / sizeof(values[0])
+
+static const ProgramValue defaultValues[] = {
+    { paramReverbType, REVERB_ROOM },
+    { paramDry, 100.0f },
+    { paramEarly, 75.0f },
+    { paramLate, 75.0f },
+    { paramSize, 50.0f },
+    { paramWidth, 100.0f },
+    { paramPredelay, 10.0f },
+    { paramDecay, 2.0f },
+    { paramDiffuse, 70.0f },
+    { paramDamping, 50.0f },
+    { paramModulation, 20.0f },
+    { paramLowCut, 20.0f },
+    { paramHighCut, 16000.0f },
+};
+
+static const ProgramValue smallRoomValues[] = {
+    { paramReverbType, REVERB_ROOM },
+    { paramDry, 85.0f },
+    { paramEarly, 90.0f },
+    { paramLate, 60.0f },
+    { paramSize, 25.0f },
+    { paramWidth, 80.0f },
+    { paramPredelay, 5.0f },
+    { paramDecay, 0.8f },
+    { paramDiffuse, 60.0f },
+    { paramDamping, 70.0f },
+};
+
+static const ProgramValue mediumRoomValues[] = {
+    { paramReverbType, REVERB_ROOM },
+    { paramDry, 80.0f },
+    { paramEarly, 80.0f },
+    { paramLate, 70.0f },
+    { paramSize, 50.0f },
+    { paramWidth, 90.0f },
+    { paramPredelay, 10.0f },
+    { paramDecay, 1.5f },
+    { paramDiffuse, 70.0f },
+    { paramDamping, 60.0f },
+};
+
+static const ProgramValue largeRoomValues[] = {
+    { paramReverbType, REVERB_ROOM },
+    { paramDry, 75.0f },
+    { paramEarly, 70.0f },
+    { paramLate, 80.0f },
+    { paramSize, 75.0f },
+    { paramWidth, 100.0f },
+    { paramPredelay, 20.0f },
+    { paramDecay, 2.5f },
+    { paramDiffuse, 80.0f },
+    { paramDamping, 50.0f },
+};
+
+static const ProgramValue smallHallValues[] = {
+    { paramReverbType, REVERB_HALL },
+    { paramDry, 70.0f },
+    { paramEarly, 50.0f },
+    { paramLate, 85.0f },
+    { paramSize, 60.0f },
+    { paramWidth, 100.0f },
+    { paramPredelay, 25.0f },
+    { paramDecay, 2.0f },
+    { paramDiffuse, 75.0f },
+    { paramDamping, 55.0f },
+    { paramModulation, 15.0f },
+};
+
+static const ProgramValue concertHallValues[] = {
+    { paramReverbType, REVERB_HALL },
+    { paramDry, 60.0f },
+    { paramEarly, 40.0f },
+    { paramLate, 90.0f },
+    { paramSize, 85.0f },
+    { paramWidth, 100.0f },
+    { paramPredelay, 35.0f },
+    { paramDecay, 3.5f },
+    { paramDiffuse, 85.0f },
+    { paramDamping, 45.0f },
+    { paramModulation, 20.0f },
+};
+
+static const ProgramValue cathedralValues[] = {
+    { paramReverbType, REVERB_HALL },
+    { paramDry, 50.0f },
+    { paramEarly, 30.0f },
+    { paramLate, 95.0f },
+    { paramSize, 100.0f },
+    { paramWidth, 100.0f },
+    { paramPredelay, 50.0f },
+    { paramDecay, 6.0f },
+    { paramDiffuse, 90.0f },
+    { paramDamping, 35.0f },
+    { paramModulation, 25.0f },
+};
+
+static const ProgramValue brightPlateValues[] = {
+    { paramReverbType, REVERB_PLATE },
+    { paramDry, 85.0f },
+    { paramEarly, 80.0f },
+    { paramLate, 75.0f },
+    { paramPredelay, 0.0f },
+    { paramDecay, 2.0f },
+    { paramDiffuse, 85.0f },
+    { paramDamping, 20.0f },
+    { paramModulation, 30.0f },
+    { paramHighCut, 18000.0f },
+};
+
+static const ProgramValue darkPlateValues[] = {
+    { paramReverbType, REVERB_PLATE },
+    { paramDry, 80.0f },
+    { paramEarly, 75.0f },
+    { paramLate, 80.0f },
+    { paramPredelay, 5.0f },
+    { paramDecay, 2.5f },
+    { paramDiffuse, 80.0f },
+    { paramDamping, 70.0f },
+    { paramModulation, 20.0f },
+    { paramHighCut, 8000.0f },
+};
+
+static const ProgramValue vintagePlateValues[] = {
+    { paramReverbType, REVERB_PLATE },
+    { paramDry, 75.0f },
+    { paramEarly, 85.0f },
+    { paramLate, 70.0f },
+    { paramPredelay, 10.0f },
+    { paramDecay, 3.0f },
+    { paramDiffuse, 75.0f },
+    { paramDamping, 50.0f },
+    { paramModulation, 40.0f },
+    { paramHighCut, 12000.0f },
+};
+
+// Programs 10-15 are named but still load the default settings
+static const Program programs[PROGRAM_COUNT] = {
+    { "Default", PROGRAM_VALUES(defaultValues) },
+    { "Small Room", PROGRAM_VALUES(smallRoomValues) },
+    { "Medium Room", PROGRAM_VALUES(mediumRoomValues) },
+    { "Large Room", PROGRAM_VALUES(largeRoomValues) },
+    { "Small Hall", PROGRAM_VALUES(smallHallValues) },
+    { "Concert Hall", PROGRAM_VALUES(concertHallValues) },
+    { "Cathedral", PROGRAM_VALUES(cathedralValues) },
+    { "Bright Plate", PROGRAM_VALUES(brightPlateValues) },
+    { "Dark Plate", PROGRAM_VALUES(darkPlateValues) },
+    { "Vintage Plate", PROGRAM_VALUES(vintagePlateValues) },
+    { "Subtle", PROGRAM_VALUES(defaultValues) },
+    { "Ambient", PROGRAM_VALUES(defaultValues) },
+    { "Dense", PROGRAM_VALUES(defaultValues) },
+    { "Spacious", PROGRAM_VALUES(defaultValues) },
+    { "Short", PROGRAM_VALUES(defaultValues) },
+    { "Long", PROGRAM_VALUES(defaultValues) },
+};
+
+const Program& getProgram(uint32_t index)
+{
+    if (index >= PROGRAM_COUNT)
+        index = 0;
+    return programs[index];
+}
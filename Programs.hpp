@@ -0,0 +1,33 @@
+/*
+ * Studio Reverb Factory Programs
+ * Shared by the plugin and the offline tools
+ */
+
+#ifndef STUDIO_REVERB_PROGRAMS_HPP_INCLUDED
+#define STUDIO_REVERB_PROGRAMS_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+
+#include <cstdint>
+
+static const uint32_t PROGRAM_COUNT = 16;
+
+struct ProgramValue
+{
+    uint32_t index;
+    float value;
+};
+
+// A program only sets the parameters it lists, the others keep their
+// current value.
+struct Program
+{
+    const char* name;
+    const ProgramValue* values;
+    uint32_t count;
+};
+
+// Returns the default program for an out of range index
+const Program& getProgram(uint32_t index);
+
+#endif // STUDIO_REVERB_PROGRAMS_HPP_INCLUDED
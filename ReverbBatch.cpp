@@ -0,0 +1,215 @@
+/*
+ * Studio Reverb Batch Implementation
+ */
+
+#include "ReverbBatch.hpp"
+#include "Programs.hpp"
+
+#include <algorithm>
+
+StudioReverbBatch::StudioReverbBatch(ReverbType type, uint32_t count, double sampleRate)
+    : type(type),
+      count(std::min(std::max(count, 1u), BATCH_MAX_INSTANCES)),
+      plate(nullptr)
+{
+    for (uint32_t k = 0; k < BATCH_MAX_INSTANCES; k++)
+        engines[k] = nullptr;
+
+    if (type == REVERB_PLATE) {
+        plate = new fv3::nrevbatch_f();
+        plate->setSampleRate(sampleRate);
+        plate->setLanes(this->count);
+    } else {
+        for (uint32_t k = 0; k < this->count; k++) {
+            engines[k] = new StudioReverbDSP(sampleRate);
+            engines[k]->setParameterValue(paramReverbType, type);
+        }
+    }
+
+    const Program& program = getProgram(0);
+    for (uint32_t k = 0; k < this->count; k++) {
+        params[k][paramReverbType] = type;
+        if (plate != nullptr)
+            initializePlate(k);
+        for (uint32_t i = 0; i < program.count; i++)
+            setParameterValue(k, program.values[i].index, program.values[i].value);
+    }
+    mute();
+}
+
+StudioReverbBatch::~StudioReverbBatch()
+{
+    delete plate;
+    for (uint32_t k = 0; k < count; k++)
+        delete engines[k];
+}
+
+void StudioReverbBatch::initializePlate(uint32_t instance)
+{
+    // As StudioReverbDSP::initializePlateReverb()
+    plate->setdryr(instance, 0);
+    plate->setwetr(instance, 1);  // 0dB wet signal
+    plate->setrt60(instance, 2.5f);
+    plate->setfeedback(instance, StudioReverbDSP::plateDiffusion(0.8f));
+    plate->setdamp(instance, StudioReverbDSP::plateDamp(8000.0f, plate->getSampleRate()));
+}
+
+ReverbType StudioReverbBatch::getType() const
+{
+    return type;
+}
+
+uint32_t StudioReverbBatch::getCount() const
+{
+    return count;
+}
+
+bool StudioReverbBatch::isLaneParallel() const
+{
+    return plate != nullptr;
+}
+
+float StudioReverbBatch::getParameterValue(uint32_t instance, uint32_t index) const
+{
+    if (instance >= count || index >= paramCount)
+        return 0.0f;
+    return params[instance][index];
+}
+
+void StudioReverbBatch::setParameterValue(uint32_t instance, uint32_t index, float value)
+{
+    if (instance >= count || index >= paramCount || index == paramReverbType)
+        return;
+
+    params[instance][index] = value;
+
+    if (plate == nullptr) {
+        engines[instance]->setParameterValue(index, value);
+        return;
+    }
+
+    // The plate parameters of StudioReverbDSP::setParameterValue(). The
+    // others have no counterpart in the nrev loop and are only stored.
+    long lane = instance;
+    switch(index) {
+        case paramDry:
+            dryLevel[instance] = value / 100.0f;
+            break;
+
+        case paramEarly:
+            earlyLevel[instance] = value / 100.0f;
+            break;
+
+        case paramWidth:
+            plate->setwidth(lane, value / 100.0f);
+            break;
+
+        case paramPredelay:
+            plate->setPreDelay(lane, value);
+            break;
+
+        case paramDecay:
+            plate->setrt60(lane, value);
+            break;
+
+        case paramDiffuse:
+            plate->setfeedback(lane, StudioReverbDSP::plateDiffusion(value / 100.0f));
+            break;
+
+        case paramDamping:
+            plate->setdamp(lane, StudioReverbDSP::plateDamp(20000.0f * (1.0f - value / 100.0f),
+                                                            plate->getSampleRate()));
+            break;
+
+        case paramLowCut:
+            plate->setdccutfreq(lane, value);
+            break;
+    }
+}
+
+void StudioReverbBatch::run(const float** inputs, float** outputs, uint32_t frames)
+{
+    if (plate == nullptr) {
+        for (uint32_t k = 0; k < count; k++)
+            engines[k]->run(inputs + 2 * k, outputs + 2 * k, frames);
+        return;
+    }
+
+    float* laneIn[2][BATCH_MAX_INSTANCES];
+    float* laneOut[2][BATCH_MAX_INSTANCES];
+    for (uint32_t k = 0; k < count; k++) {
+        laneOut[0][k] = plate_out_buffer[0][k];
+        laneOut[1][k] = plate_out_buffer[1][k];
+    }
+
+    uint32_t offset = 0;
+
+    while (offset < frames) {
+        uint32_t buffer_frames = std::min(BUFFER_SIZE, frames - offset);
+
+        for (uint32_t k = 0; k < count; k++) {
+            laneIn[0][k] = const_cast<float*>(inputs[2 * k]) + offset;
+            laneIn[1][k] = const_cast<float*>(inputs[2 * k + 1]) + offset;
+        }
+        plate->processreplace(laneIn[0], laneIn[1], laneOut[0], laneOut[1], buffer_frames);
+
+        // Mix dry and plate, as StudioReverbDSP::run()
+        for (uint32_t k = 0; k < count; k++) {
+            for (uint32_t c = 0; c < 2; c++) {
+                const float* in = inputs[2 * k + c] + offset;
+                float* out = outputs[2 * k + c] + offset;
+                for (uint32_t i = 0; i < buffer_frames; i++)
+                    out[i] = dryLevel[k] * in[i] + earlyLevel[k] * plate_out_buffer[c][k][i];
+            }
+        }
+
+        offset += buffer_frames;
+    }
+}
+
+void StudioReverbBatch::sampleRateChanged(double sampleRate)
+{
+    if (plate == nullptr) {
+        for (uint32_t k = 0; k < count; k++)
+            engines[k]->sampleRateChanged(sampleRate);
+        return;
+    }
+
+    plate->setSampleRate(sampleRate);
+    // The damping coefficient depends on the rate
+    for (uint32_t k = 0; k < count; k++)
+        setParameterValue(k, paramDamping, params[k][paramDamping]);
+}
+
+void StudioReverbBatch::mute()
+{
+    if (plate == nullptr) {
+        for (uint32_t k = 0; k < count; k++)
+            engines[k]->mute();
+        return;
+    }
+
+    plate->mute();
+}
+
+void StudioReverbBatch::mute(uint32_t instance)
+{
+    if (instance >= count)
+        return;
+
+    if (plate == nullptr)
+        engines[instance]->mute();
+    else
+        plate->mute(instance);
+}
+
+size_t StudioReverbBatch::getMemorySize()
+{
+    if (plate != nullptr)
+        return plate->getMemorySize();
+
+    size_t size = 0;
+    for (uint32_t k = 0; k < count; k++)
+        size += engines[k]->getMemorySize();
+    return size;
+}
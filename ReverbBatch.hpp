@@ -0,0 +1,75 @@
+/*
+ * Studio Reverb Batch
+ * Several engines of one type processed together
+ */
+
+#ifndef STUDIO_REVERB_BATCH_HPP_INCLUDED
+#define STUDIO_REVERB_BATCH_HPP_INCLUDED
+
+#include "DSP.hpp"
+
+// Freeverb3 includes
+#include "freeverb/nrevbatch.hpp"
+
+// Most engines in one batch, the lanes of fv3::nrevbatch
+static const uint32_t BATCH_MAX_INSTANCES = FV3_NREVBATCH_MAX_LANES;
+
+// Engines of one reverb type with their own parameters. The plate runs all
+// instances in one fv3::nrevbatch, instance k in lane k of each SIMD
+// register. That is the loop the nrevb plate in StudioReverbDSP runs
+// (nrevb processes through nrev), with the same parameter mapping, so an
+// instance renders as StudioReverbDSP on Plate (golden's plate-batch).
+// The other types have no lane parallel tank yet and run one
+// StudioReverbDSP per instance.
+class StudioReverbBatch
+{
+public:
+    // count is 1 to BATCH_MAX_INSTANCES, every instance starts on the
+    // default program
+    StudioReverbBatch(ReverbType type, uint32_t count, double sampleRate);
+    ~StudioReverbBatch();
+
+    ReverbType getType() const;
+    uint32_t getCount() const;
+
+    // True when the instances are processed together
+    bool isLaneParallel() const;
+
+    // As StudioReverbDSP, the type of the batch does not change
+    float getParameterValue(uint32_t instance, uint32_t index) const;
+    void setParameterValue(uint32_t instance, uint32_t index, float value);
+
+    // Planar stereo, inputs[2 * instance + channel], the same for outputs.
+    // The inputs and outputs may be the same buffers.
+    void run(const float** inputs, float** outputs, uint32_t frames);
+
+    void sampleRateChanged(double sampleRate);
+
+    // Mute the tails of every instance or of one
+    void mute();
+    void mute(uint32_t instance);
+
+    // Delay line and convolver memory of all instances, in bytes
+    size_t getMemorySize();
+
+private:
+    void initializePlate(uint32_t instance);
+
+    ReverbType type;
+    uint32_t count;
+    float params[BATCH_MAX_INSTANCES][paramCount];
+
+    // Plate, all instances as lanes
+    fv3::nrevbatch_f* plate;
+    float dryLevel[BATCH_MAX_INSTANCES];
+    float earlyLevel[BATCH_MAX_INSTANCES];
+    float plate_out_buffer[2][BATCH_MAX_INSTANCES][BUFFER_SIZE];
+
+    // Other types, one engine per instance
+    StudioReverbDSP* engines[BATCH_MAX_INSTANCES];
+
+    StudioReverbBatch(const StudioReverbBatch&);
+    StudioReverbBatch& operator=(const StudioReverbBatch&);
+};
+
+#endif // STUDIO_REVERB_BATCH_HPP_INCLUDED
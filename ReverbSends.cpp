@@ -0,0 +1,261 @@
+/*
+ * Studio Reverb Sends Implementation
+ */
+
+#include "ReverbSends.hpp"
+#include "Programs.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+StudioReverbSends::StudioReverbSends(ReverbType type, uint32_t sourceCount, double sampleRate)
+    : type(type),
+      sampleRate(sampleRate),
+      hasEarly(type != REVERB_PLATE),  // The plate has no early reflections
+      tank(sampleRate),
+      delayPosition(0)
+{
+    tank.setParameterValue(paramReverbType, type);
+    params[paramReverbType] = type;
+
+    sourceCount = std::max(sourceCount, 1u);
+    for (uint32_t s = 0; s < sourceCount; s++) {
+        Source* source = new Source();
+        StudioReverbDSP::initializeEarly(source->early, type, sampleRate);
+        source->delayFrames = 0;
+        source->preDelay = 0.0f;
+        source->send = 1.0f;
+        source->earlyGain = 1.0f;
+        resizeDelays(*source);
+        sources.push_back(source);
+    }
+
+    const Program& program = getProgram(0);
+    for (uint32_t i = 0; i < program.count; i++)
+        setParameterValue(program.values[i].index, program.values[i].value);
+    mute();
+}
+
+StudioReverbSends::~StudioReverbSends()
+{
+    for (size_t s = 0; s < sources.size(); s++)
+        delete sources[s];
+}
+
+void StudioReverbSends::resizeDelays(Source& source)
+{
+    // One frame more than the longest delay, written before it is read
+    size_t length = static_cast<size_t>(sampleRate * SENDS_MAX_PREDELAY_MS / 1000.0) + 1;
+    source.delay[0].assign(length, 0.0f);
+    source.delay[1].assign(length, 0.0f);
+    source.delayFrames = static_cast<uint32_t>(sampleRate * source.preDelay / 1000.0);
+    source.monoFrames = 0;
+    source.stereoFrames = 0;
+}
+
+void StudioReverbSends::syncDelays(Source& source, uint32_t position)
+{
+    uint32_t length = static_cast<uint32_t>(source.delay[0].size());
+    uint32_t write = (position + length - source.monoFrames) % length;
+    for (uint32_t i = 0; i < source.monoFrames; i++) {
+        source.delay[1][write] = source.delay[0][write];
+        if (++write == length) write = 0;
+    }
+    source.monoFrames = 0;
+}
+
+ReverbType StudioReverbSends::getType() const
+{
+    return type;
+}
+
+uint32_t StudioReverbSends::getSourceCount() const
+{
+    return static_cast<uint32_t>(sources.size());
+}
+
+float StudioReverbSends::getParameterValue(uint32_t index) const
+{
+    if (index < paramCount)
+        return params[index];
+    return 0.0f;
+}
+
+void StudioReverbSends::setParameterValue(uint32_t index, float value)
+{
+    if (index >= paramCount || index == paramReverbType)
+        return;
+
+    params[index] = value;
+    tank.setParameterValue(index, value);
+    if (hasEarly) {
+        for (size_t s = 0; s < sources.size(); s++)
+            StudioReverbDSP::setEarlyParameter(sources[s]->early, type, index, value);
+    }
+}
+
+void StudioReverbSends::setSourcePreDelay(uint32_t source, float ms)
+{
+    if (source >= sources.size())
+        return;
+
+    Source& s = *sources[source];
+    s.preDelay = std::min(std::max(ms, 0.0f), SENDS_MAX_PREDELAY_MS);
+    s.delayFrames = std::min(static_cast<uint32_t>(sampleRate * s.preDelay / 1000.0),
+                             static_cast<uint32_t>(s.delay[0].size() - 1));
+}
+
+void StudioReverbSends::setSourceSend(uint32_t source, float gain)
+{
+    if (source < sources.size())
+        sources[source]->send = gain;
+}
+
+void StudioReverbSends::setSourceEarly(uint32_t source, float gain)
+{
+    if (source < sources.size())
+        sources[source]->earlyGain = gain;
+}
+
+float StudioReverbSends::getSourcePreDelay(uint32_t source) const
+{
+    return source < sources.size() ? sources[source]->preDelay : 0.0f;
+}
+
+float StudioReverbSends::getSourceSend(uint32_t source) const
+{
+    return source < sources.size() ? sources[source]->send : 0.0f;
+}
+
+float StudioReverbSends::getSourceEarly(uint32_t source) const
+{
+    return source < sources.size() ? sources[source]->earlyGain : 0.0f;
+}
+
+void StudioReverbSends::run(const float** inputs, float** outputs, uint32_t frames)
+{
+    // The early reflections are mixed in as StudioReverbDSP::run() does
+    float earlyLevel = params[paramEarly] / 100.0f;
+    if (type == REVERB_HALL)
+        earlyLevel *= HALL_EARLY_MIX;
+
+    uint32_t offset = 0;
+
+    while (offset < frames) {
+        uint32_t buffer_frames = std::min(BUFFER_SIZE, frames - offset);
+
+        std::memset(early_bus[0], 0, buffer_frames * sizeof(float));
+        std::memset(early_bus[1], 0, buffer_frames * sizeof(float));
+        std::memset(send_bus[0], 0, buffer_frames * sizeof(float));
+        std::memset(send_bus[1], 0, buffer_frames * sizeof(float));
+
+        uint32_t position = delayPosition;
+        for (size_t s = 0; s < sources.size(); s++) {
+            Source& source = *sources[s];
+            uint32_t length = static_cast<uint32_t>(source.delay[0].size());
+
+            const float* inL = inputs[2 * s] + offset;
+            const float* inR = inputs[2 * s + 1] + offset;
+            const bool monoInput = inL == inR
+                || std::memcmp(inL, inR, buffer_frames * sizeof(float)) == 0;
+            // Mono input runs as stereo until the delays read no stereo
+            // frames any more, whatever the pre-delay
+            const bool mono = monoInput && source.stereoFrames == 0;
+            if (mono)
+                source.monoFrames = std::min(source.monoFrames + buffer_frames, length);
+            else if (source.monoFrames > 0)
+                syncDelays(source, position);
+            if (!monoInput)
+                source.stereoFrames = length;
+            else if (!mono)
+                source.stereoFrames -= std::min(source.stereoFrames, buffer_frames);
+
+            // Mono runs the left delay only
+            for (uint32_t c = 0; c < (mono ? 1u : 2u); c++) {
+                const float* in = c == 0 ? inL : inR;
+                float* delay = source.delay[c].data();
+                uint32_t write = position;
+                uint32_t read = (position + length - source.delayFrames) % length;
+                for (uint32_t i = 0; i < buffer_frames; i++) {
+                    delay[write] = in[i];
+                    delayed_buffer[c][i] = delay[read];
+                    if (++write == length) write = 0;
+                    if (++read == length) read = 0;
+                }
+            }
+            for (uint32_t c = 0; c < 2; c++) {
+                const float* delayed = delayed_buffer[mono ? 0 : c];
+                for (uint32_t i = 0; i < buffer_frames; i++)
+                    send_bus[c][i] += source.send * delayed[i];
+            }
+
+            if (!hasEarly)
+                continue;
+            if (mono)
+                source.early.processreplaceM(delayed_buffer[0], early_buffer[0], early_buffer[1], buffer_frames);
+            else
+                source.early.processreplace(
+                    delayed_buffer[0],
+                    delayed_buffer[1],
+                    early_buffer[0],
+                    early_buffer[1],
+                    buffer_frames);
+            for (uint32_t c = 0; c < 2; c++) {
+                for (uint32_t i = 0; i < buffer_frames; i++)
+                    early_bus[c][i] += source.earlyGain * early_buffer[c][i];
+            }
+        }
+        // All rings have the length of the first
+        delayPosition = (position + buffer_frames) % static_cast<uint32_t>(sources[0]->delay[0].size());
+
+        const float* tankIn[2] = { send_bus[0], send_bus[1] };
+        float* tankOut[2] = { outputs[0] + offset, outputs[1] + offset };
+        tank.runLate(tankIn, tankOut, buffer_frames);
+
+        for (uint32_t c = 0; c < 2; c++) {
+            for (uint32_t i = 0; i < buffer_frames; i++)
+                tankOut[c][i] += earlyLevel * early_bus[c][i];
+        }
+
+        offset += buffer_frames;
+    }
+}
+
+void StudioReverbSends::sampleRateChanged(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    tank.sampleRateChanged(newSampleRate);
+    for (size_t s = 0; s < sources.size(); s++) {
+        sources[s]->early.setSampleRate(newSampleRate);
+        resizeDelays(*sources[s]);
+    }
+    delayPosition = 0;
+    mute();
+}
+
+void StudioReverbSends::mute()
+{
+    tank.mute();
+    for (size_t s = 0; s < sources.size(); s++) {
+        sources[s]->early.mute();
+        std::fill(sources[s]->delay[0].begin(), sources[s]->delay[0].end(), 0.0f);
+        std::fill(sources[s]->delay[1].begin(), sources[s]->delay[1].end(), 0.0f);
+        sources[s]->monoFrames = 0;
+        sources[s]->stereoFrames = 0;
+    }
+}
+
+void StudioReverbSends::setNoiseSeed(uint32_t seed)
+{
+    tank.setNoiseSeed(seed);
+}
+
+size_t StudioReverbSends::getMemorySize()
+{
+    size_t size = tank.getMemorySize();
+    for (size_t s = 0; s < sources.size(); s++) {
+        size += sizeof(Source) + static_cast<size_t>(sources[s]->early.getMemorySize());
+        size += (sources[s]->delay[0].size() + sources[s]->delay[1].size()) * sizeof(float);
+    }
+    return size;
+}
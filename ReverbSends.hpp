@@ -0,0 +1,100 @@
+/*
+ * Studio Reverb Sends
+ * Many sources in one space, sharing a single reverb tank
+ */
+
+#ifndef STUDIO_REVERB_SENDS_HPP_INCLUDED
+#define STUDIO_REVERB_SENDS_HPP_INCLUDED
+
+#include "DSP.hpp"
+
+#include <vector>
+
+// Longest pre-delay of a single source (ms), on top of the Pre-Delay of
+// the space
+static const float SENDS_MAX_PREDELAY_MS = 200.0f;
+
+// Each source gets its own pre-delay and early reflections, then all of
+// them are summed with their send gains into one tank of the chosen type.
+// Only the per-source part grows with the number of sources. The output is
+// wet only, one stereo bus.
+class StudioReverbSends
+{
+public:
+    // sourceCount is at least 1. The space starts on the default program,
+    // the sources with send and early gains of 1 and no pre-delay.
+    StudioReverbSends(ReverbType type, uint32_t sourceCount, double sampleRate);
+    ~StudioReverbSends();
+
+    ReverbType getType() const;
+    uint32_t getSourceCount() const;
+
+    // The space, as StudioReverbDSP. The type does not change and the Dry
+    // Level has no effect.
+    float getParameterValue(uint32_t index) const;
+    void setParameterValue(uint32_t index, float value);
+
+    // Per source, from the thread that calls run(). The pre-delay is
+    // clamped to 0-SENDS_MAX_PREDELAY_MS.
+    void setSourcePreDelay(uint32_t source, float ms);
+    void setSourceSend(uint32_t source, float gain);
+    void setSourceEarly(uint32_t source, float gain);
+    float getSourcePreDelay(uint32_t source) const;
+    float getSourceSend(uint32_t source) const;
+    float getSourceEarly(uint32_t source) const;
+
+    // Planar stereo, source s reads inputs[2 * s] and inputs[2 * s + 1].
+    // outputs[0] and outputs[1] receive the mix of all sources. A source
+    // with the same samples (or pointer) on both inputs runs its pre-delay
+    // and early reflections as mono, with the same output, once its delay
+    // holds no stereo input.
+    void run(const float** inputs, float** outputs, uint32_t frames);
+
+    // Not while run() is called, the tails are muted
+    void sampleRateChanged(double sampleRate);
+
+    void mute();
+
+    // Seed of the tank's modulation noise, as StudioReverbDSP::setNoiseSeed()
+    void setNoiseSeed(uint32_t seed);
+
+    // Delay line memory of the tank and all sources, in bytes
+    size_t getMemorySize();
+
+private:
+    struct Source
+    {
+        fv3::earlyref_f early;
+        std::vector<float> delay[2];
+        uint32_t delayFrames;
+        uint32_t monoFrames;    // last frames written to delay[0] only
+        uint32_t stereoFrames;  // frames until stereo input has left the rings
+        float preDelay;
+        float send;
+        float earlyGain;
+    };
+
+    void resizeDelays(Source& source);
+    // Catches delay[1] up with the mono frames it missed
+    void syncDelays(Source& source, uint32_t position);
+
+    ReverbType type;
+    double sampleRate;
+    float params[paramCount];
+    bool hasEarly;
+
+    StudioReverbDSP tank;
+    std::vector<Source*> sources;
+    uint32_t delayPosition;
+
+    // Processing buffers
+    float delayed_buffer[2][BUFFER_SIZE];
+    float early_buffer[2][BUFFER_SIZE];
+    float early_bus[2][BUFFER_SIZE];
+    float send_bus[2][BUFFER_SIZE];
+
+    StudioReverbSends(const StudioReverbSends&);
+    StudioReverbSends& operator=(const StudioReverbSends&);
+};
+
+#endif // STUDIO_REVERB_SENDS_HPP_INCLUDED
@@ -0,0 +1,207 @@
+/*
+ * Studio Reverb Telemetry Implementation
+ * Optional per-instance slots in a POSIX shared memory segment
+ */
+
+#include "Telemetry.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define TELEMETRY_HAVE_SHM 1
+#endif
+
+// The segment is shared by all instances of the process
+static std::mutex segmentMutex;
+static TelemetrySegment* segment = nullptr;
+static uint32_t segmentUsers = 0;
+
+void telemetrySegmentName(char* name, size_t size, long pid)
+{
+    std::snprintf(name, size, "%s%ld", TELEMETRY_PREFIX, pid);
+}
+
+#ifdef TELEMETRY_HAVE_SHM
+// Unmaps and removes the segment once no instance uses it, segmentMutex held
+static void releaseSegment()
+{
+    if (segment == nullptr || segmentUsers > 0)
+        return;
+
+    char name[64];
+    telemetrySegmentName(name, sizeof(name), static_cast<long>(getpid()));
+    munmap(segment, sizeof(TelemetrySegment));
+    shm_unlink(name);
+    segment = nullptr;
+}
+#endif
+
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+Telemetry::Telemetry()
+    : slot(nullptr),
+      windowFrames(0),
+      windowRunNs(0),
+      windowBlocks(0),
+      windowMaxNs(0),
+      previousMaxNs(0),
+      windowCompleted(false),
+      blocks(0)
+{
+}
+
+Telemetry::~Telemetry()
+{
+    close();
+}
+
+bool Telemetry::open()
+{
+#ifdef TELEMETRY_HAVE_SHM
+    if (slot != nullptr)
+        return true;
+
+    std::lock_guard<std::mutex> lock(segmentMutex);
+
+    if (segment == nullptr)
+    {
+        char name[64];
+        telemetrySegmentName(name, sizeof(name), static_cast<long>(getpid()));
+
+        // A segment left by a crashed process with the same pid is reused
+        int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            std::fprintf(stderr, "StudioReverb: shm_open(%s) failed, telemetry disabled\n", name);
+            return false;
+        }
+        if (ftruncate(fd, sizeof(TelemetrySegment)) != 0)
+        {
+            ::close(fd);
+            shm_unlink(name);
+            return false;
+        }
+        void* memory = mmap(nullptr, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(name);
+            return false;
+        }
+
+        segment = static_cast<TelemetrySegment*>(memory);
+        std::memset(static_cast<void*>(segment), 0, sizeof(TelemetrySegment));
+        segment->version = TELEMETRY_VERSION;
+        segment->slotCount = TELEMETRY_SLOTS;
+        segment->slotSize = sizeof(TelemetrySlot);
+        segment->pid = static_cast<uint32_t>(getpid());
+        // Readers check the magic last
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = TELEMETRY_MAGIC;
+    }
+
+    for (uint32_t i = 0; i < TELEMETRY_SLOTS; i++)
+    {
+        uint32_t expected = TELEMETRY_SLOT_FREE;
+        TelemetrySlot& candidate = segment->slots[i];
+        if (candidate.state.load(std::memory_order_relaxed) != TELEMETRY_SLOT_FREE)
+            continue;
+
+        candidate.instance.store(segment->registrations.fetch_add(1, std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+        candidate.algorithm.store(0, std::memory_order_relaxed);
+        candidate.sampleRate.store(0, std::memory_order_relaxed);
+        candidate.blockSize.store(0, std::memory_order_relaxed);
+        candidate.sleeping.store(1, std::memory_order_relaxed);
+        candidate.tailActive.store(0, std::memory_order_relaxed);
+        candidate.averageRunNs.store(0, std::memory_order_relaxed);
+        candidate.maxRunNs.store(0, std::memory_order_relaxed);
+        candidate.memoryBytes.store(0, std::memory_order_relaxed);
+        candidate.blocks.store(0, std::memory_order_relaxed);
+        candidate.updatedNs.store(monotonicNs(), std::memory_order_relaxed);
+        if (candidate.state.compare_exchange_strong(expected, TELEMETRY_SLOT_USED, std::memory_order_release))
+        {
+            slot = &candidate;
+            segmentUsers++;
+            return true;
+        }
+    }
+
+    std::fprintf(stderr, "StudioReverb: all %u telemetry slots are in use\n", TELEMETRY_SLOTS);
+    releaseSegment();
+    return false;
+#else
+    return false;
+#endif
+}
+
+void Telemetry::close()
+{
+#ifdef TELEMETRY_HAVE_SHM
+    if (slot == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(segmentMutex);
+    slot->state.store(TELEMETRY_SLOT_FREE, std::memory_order_release);
+    slot = nullptr;
+    segmentUsers--;
+    releaseSegment();
+#endif
+}
+
+void Telemetry::setSleeping(bool sleeping)
+{
+    if (slot != nullptr)
+        slot->sleeping.store(sleeping ? 1 : 0, std::memory_order_relaxed);
+}
+
+void Telemetry::setMemorySize(size_t bytes)
+{
+    if (slot != nullptr)
+        slot->memoryBytes.store(bytes, std::memory_order_relaxed);
+}
+
+bool Telemetry::update(uint32_t algorithm, double sampleRate, uint32_t frames,
+                       uint64_t runNs, bool tailActive)
+{
+    if (slot == nullptr)
+        return false;
+
+    blocks++;
+    windowFrames += frames;
+    windowRunNs += runNs;
+    windowBlocks++;
+    windowMaxNs = std::max(windowMaxNs, runNs);
+
+    bool completed = windowFrames >= static_cast<uint64_t>(sampleRate * TELEMETRY_WINDOW_SECONDS);
+
+    // The average of the running window is shown until the first one completes
+    if (completed || !windowCompleted)
+        slot->averageRunNs.store(windowRunNs / windowBlocks, std::memory_order_relaxed);
+    slot->maxRunNs.store(std::max(previousMaxNs, windowMaxNs), std::memory_order_relaxed);
+    slot->algorithm.store(algorithm, std::memory_order_relaxed);
+    slot->sampleRate.store(static_cast<uint32_t>(sampleRate), std::memory_order_relaxed);
+    slot->blockSize.store(frames, std::memory_order_relaxed);
+    slot->tailActive.store(tailActive ? 1 : 0, std::memory_order_relaxed);
+    slot->blocks.store(blocks, std::memory_order_relaxed);
+    slot->updatedNs.store(monotonicNs(), std::memory_order_relaxed);
+
+    if (completed)
+    {
+        previousMaxNs = windowMaxNs;
+        windowFrames = windowRunNs = windowBlocks = windowMaxNs = 0;
+        windowCompleted = true;
+    }
+    return completed;
+}
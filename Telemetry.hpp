@@ -0,0 +1,105 @@
+/*
+ * Studio Reverb Telemetry Header
+ * Optional per-instance slots in a POSIX shared memory segment
+ */
+
+#ifndef STUDIO_REVERB_TELEMETRY_HPP_INCLUDED
+#define STUDIO_REVERB_TELEMETRY_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Set to 1 to publish telemetry, the segment is then "/studioreverb-<pid>"
+static const char* const TELEMETRY_ENV = "STUDIOREVERB_TELEMETRY";
+static const char* const TELEMETRY_PREFIX = "/studioreverb-";
+
+static const uint32_t TELEMETRY_MAGIC = 0x53525431;  // "SRT1"
+static const uint32_t TELEMETRY_VERSION = 1;
+static const uint32_t TELEMETRY_SLOTS = 64;
+
+// Run time statistics cover at least this much audio (s)
+static const double TELEMETRY_WINDOW_SECONDS = 1.0;
+
+enum TelemetrySlotState
+{
+    TELEMETRY_SLOT_FREE = 0,
+    TELEMETRY_SLOT_USED
+};
+
+// One instance. Every field is written by the instance with relaxed stores
+// once per block, so a reader sees each value whole but not necessarily
+// all values of the same block.
+struct TelemetrySlot
+{
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> instance;     // increments per registration
+    std::atomic<uint32_t> algorithm;    // ReverbType
+    std::atomic<uint32_t> sampleRate;
+    std::atomic<uint32_t> blockSize;    // frames of the last run()
+    std::atomic<uint32_t> sleeping;     // deactivated by the host
+    std::atomic<uint32_t> tailActive;   // wet output above -100 dBFS
+    std::atomic<uint32_t> reserved;
+    std::atomic<uint64_t> averageRunNs; // over the last window
+    std::atomic<uint64_t> maxRunNs;     // over the last one to two windows
+    std::atomic<uint64_t> memoryBytes;
+    std::atomic<uint64_t> blocks;
+    std::atomic<uint64_t> updatedNs;    // CLOCK_MONOTONIC of the last update
+};
+
+struct TelemetrySegment
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    std::atomic<uint32_t> registrations;
+    uint32_t pid;
+    TelemetrySlot slots[TELEMETRY_SLOTS];
+};
+
+#if ATOMIC_INT_LOCK_FREE != 2 || ATOMIC_LLONG_LOCK_FREE != 2
+#error "Telemetry needs lock-free 32 and 64 bit atomics to share them between processes"
+#endif
+
+// Segment name of a process, buffer of at least 32 bytes
+void telemetrySegmentName(char* name, size_t size, long pid);
+
+// The slot of one instance. Does nothing until open() succeeds.
+class Telemetry
+{
+public:
+    Telemetry();
+    ~Telemetry();
+
+    // Maps the segment of this process, creating it for the first instance,
+    // and takes a free slot. Not on the audio thread.
+    bool open();
+    void close();
+    bool isOpen() const { return slot != nullptr; }
+
+    void setSleeping(bool sleeping);
+    void setMemorySize(size_t bytes);
+
+    // Audio thread, once per block. Returns true when a window completed,
+    // a good time to refresh the values that are not sent every block.
+    bool update(uint32_t algorithm, double sampleRate, uint32_t frames,
+                uint64_t runNs, bool tailActive);
+
+private:
+    TelemetrySlot* slot;
+
+    // Audio thread state
+    uint64_t windowFrames;
+    uint64_t windowRunNs;
+    uint64_t windowBlocks;
+    uint64_t windowMaxNs;
+    uint64_t previousMaxNs;
+    bool windowCompleted;
+    uint64_t blocks;
+
+    Telemetry(const Telemetry&);
+    Telemetry& operator=(const Telemetry&);
+};
+
+#endif // STUDIO_REVERB_TELEMETRY_HPP_INCLUDED
@@ -5,6 +5,7 @@
 
 #include "UI.hpp"
 #include "DistrhoPluginInfo.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 
@@ -27,6 +28,10 @@ StudioReverbUI::StudioReverbUI()
     for (int i = 0; i < paramCount; ++i) {
         fParameters[i] = getParameterDefault(i);
     }
+    for (int i = paramCount; i < paramTotalCount; ++i) {
+        fOutputs[i - paramCount] = 0.0f;
+    }
+    fOutputs[paramActiveQuality - paramCount] = QUALITY_HIGH;
 
     // Initialize knob positions
     initializeKnobPositions();
@@ -44,9 +49,18 @@ StudioReverbUI::~StudioReverbUI()
 
 void StudioReverbUI::parameterChanged(uint32_t index, float value)
 {
-    if (index >= paramCount)
+    if (index >= paramTotalCount)
         return;
 
+    // DSP load outputs
+    if (index >= paramCount) {
+        if (fOutputs[index - paramCount] != value) {
+            fOutputs[index - paramCount] = value;
+            repaint();
+        }
+        return;
+    }
+
     fParameters[index] = value;
 
     // Update visibility if reverb type changed
@@ -103,6 +117,9 @@ void StudioReverbUI::onNanoDisplay()
 
     // Spectrum analyzer (placeholder for now)
     drawSpectrumAnalyzer();
+
+    // CPU use of this instance
+    drawDspLoadMeter();
 }
 
 bool StudioReverbUI::onMouse(const MouseEvent& ev)
@@ -254,6 +271,16 @@ ParameterVisibility StudioReverbUI::getParameterVisibility(ReverbType type)
             vis.showLate = false;
             break;
 
+        case REVERB_HYBRID:
+            vis.showSize = true;
+            vis.showDecay = true;
+            vis.showDiffuse = true;
+            vis.showDamping = true;
+            vis.showModulation = true;
+            vis.showEarly = true;   // IR head
+            vis.showLate = true;    // Algorithmic tail
+            break;
+
         case REVERB_EARLY_REFLECTIONS:
             vis.showSize = true;
             vis.showDecay = false;  // No late reverb
@@ -299,7 +326,7 @@ void StudioReverbUI::drawHeader()
     fontSize(14);
     fillColor(Color(0.6f, 0.6f, 0.6f));
 
-    const char* algorithmNames[] = {"Room", "Hall", "Plate", "Early Reflections"};
+    const char* algorithmNames[] = {"Room", "Hall", "Plate", "Early Reflections", "Hybrid"};
     char subtitle[64];
     snprintf(subtitle, sizeof(subtitle), "Algorithm: %s", algorithmNames[fReverbType]);
     text(width/2, 40, subtitle, nullptr);
@@ -307,12 +334,12 @@ void StudioReverbUI::drawHeader()
 
 void StudioReverbUI::drawReverbTypeSelector()
 {
-    const float buttonWidth = 150;
+    const float buttonWidth = 120;
     const float buttonHeight = 30;
-    const float startX = (getWidth() - (buttonWidth * 4 + 30)) / 2;
+    const float startX = (getWidth() - (buttonWidth * REVERB_TYPE_COUNT + 10 * (REVERB_TYPE_COUNT - 1))) / 2;
     const float y = 70;
 
-    const char* typeNames[] = {"Room", "Hall", "Plate", "Early Ref"};
+    const char* typeNames[] = {"Room", "Hall", "Plate", "Early Ref", "Hybrid"};
 
     for (int i = 0; i < REVERB_TYPE_COUNT; ++i) {
         float x = startX + i * (buttonWidth + 10);
@@ -527,6 +554,105 @@ void StudioReverbUI::drawSpectrumAnalyzer()
     text(x + width/2, y + height/2, "Spectrum Analyzer", nullptr);
 }
 
+void StudioReverbUI::drawDspLoadMeter()
+{
+    const float x = 400;
+    const float y = 370;
+    const float width = 280;
+    const float barY = y + 25;
+    const float barHeight = 16;
+
+    const float load = fOutputs[paramDspLoad - paramCount];
+    const float peak = fOutputs[paramDspPeak - paramCount];
+    const float p99 = fOutputs[paramDspP99 - paramCount];
+    const float xrunRisk = fOutputs[paramXrunRisk - paramCount];
+
+    // Section header
+    fontSize(14);
+    fillColor(Color(0.7f, 0.7f, 0.7f));
+    textAlign(ALIGN_LEFT | ALIGN_TOP);
+    text(x, y, "DSP Load", nullptr);
+
+    char str[64];
+    snprintf(str, sizeof(str), "Xrun risk: %.0f", xrunRisk);
+    fontSize(12);
+    fillColor(xrunRisk > 0 ? Color(0.9f, 0.4f, 0.3f) : Color(0.5f, 0.5f, 0.5f));
+    textAlign(ALIGN_RIGHT | ALIGN_TOP);
+    text(x + width, y + 2, str, nullptr);
+
+    // Background, the full width is the block deadline
+    beginPath();
+    rect(x, barY, width, barHeight);
+    fillColor(Color(0.1f, 0.1f, 0.12f));
+    fill();
+
+    // Average load, split by stage
+    const uint32_t stageParams[] = { paramDspEarlyShare, paramDspLateShare, paramDspMixShare };
+    const Color stageColors[] = { Color(0.2f, 0.3f, 0.6f), Color(0.8f, 0.4f, 0.2f), Color(0.4f, 0.4f, 0.45f) };
+    const float loadWidth = width * std::min(load, 100.0f) / 100.0f;
+    float stageX = x;
+
+    for (int i = 0; i < 3; ++i) {
+        const float stageWidth = loadWidth * fOutputs[stageParams[i] - paramCount] / 100.0f;
+        beginPath();
+        rect(stageX, barY, stageWidth, barHeight);
+        fillColor(stageColors[i]);
+        fill();
+        stageX += stageWidth;
+    }
+
+    // Time outside the stages (buffer clearing, block loop)
+    beginPath();
+    rect(stageX, barY, std::max(0.0f, x + loadWidth - stageX), barHeight);
+    fillColor(Color(0.3f, 0.3f, 0.32f));
+    fill();
+
+    // 99th percentile and peak markers
+    beginPath();
+    moveTo(x + width * std::min(p99, 100.0f) / 100.0f, barY - 2);
+    lineTo(x + width * std::min(p99, 100.0f) / 100.0f, barY + barHeight + 2);
+    strokeColor(Color(0.7f, 0.7f, 0.3f));
+    strokeWidth(2);
+    stroke();
+
+    beginPath();
+    moveTo(x + width * std::min(peak, 100.0f) / 100.0f, barY - 2);
+    lineTo(x + width * std::min(peak, 100.0f) / 100.0f, barY + barHeight + 2);
+    strokeColor(Color(0.9f, 0.4f, 0.3f));
+    strokeWidth(2);
+    stroke();
+
+    // Border, red once a callback missed its deadline
+    beginPath();
+    rect(x, barY, width, barHeight);
+    strokeColor(peak > 100.0f ? Color(0.9f, 0.3f, 0.3f) : Color(0.3f, 0.3f, 0.35f));
+    strokeWidth(1);
+    stroke();
+
+    // Values
+    fontSize(11);
+    fillColor(Color(0.6f, 0.6f, 0.6f));
+    textAlign(ALIGN_LEFT | ALIGN_TOP);
+    snprintf(str, sizeof(str), "Avg %.1f%%   P99 %.0f%%   Peak %.1f%%", load, p99, peak);
+    text(x, barY + barHeight + 8, str, nullptr);
+
+    fillColor(Color(0.5f, 0.5f, 0.5f));
+    snprintf(str, sizeof(str), "Early %.0f%%   Late %.0f%%   Mix %.0f%%",
+             fOutputs[paramDspEarlyShare - paramCount],
+             fOutputs[paramDspLateShare - paramCount],
+             fOutputs[paramDspMixShare - paramCount]);
+    text(x, barY + barHeight + 24, str, nullptr);
+
+    // Tier that runs, amber while the CPU budget holds it below High
+    static const char* const qualityNames[QUALITY_COUNT] = { "Eco", "Standard", "High" };
+    const int quality = std::max(0, std::min(static_cast<int>(fOutputs[paramActiveQuality - paramCount] + 0.5f),
+                                             static_cast<int>(QUALITY_COUNT) - 1));
+    snprintf(str, sizeof(str), "Quality %s", qualityNames[quality]);
+    fillColor(quality < QUALITY_HIGH ? Color(0.9f, 0.7f, 0.3f) : Color(0.5f, 0.5f, 0.5f));
+    textAlign(ALIGN_RIGHT | ALIGN_TOP);
+    text(x + width, barY + barHeight + 24, str, nullptr);
+}
+
 void StudioReverbUI::formatParameterValue(uint32_t param, float value, char* str, size_t maxLen)
 {
     switch (param) {
@@ -570,9 +696,9 @@ bool StudioReverbUI::isInKnob(float x, float y, const Knob& knob)
 
 bool StudioReverbUI::isInReverbTypeButton(float x, float y, int type)
 {
-    const float buttonWidth = 150;
+    const float buttonWidth = 120;
     const float buttonHeight = 30;
-    const float startX = (getWidth() - (buttonWidth * 4 + 30)) / 2;
+    const float startX = (getWidth() - (buttonWidth * REVERB_TYPE_COUNT + 10 * (REVERB_TYPE_COUNT - 1))) / 2;
     const float buttonY = 70;
 
     float buttonX = startX + type * (buttonWidth + 10);
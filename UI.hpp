@@ -45,6 +45,7 @@ private:
     // UI State
     ReverbType fReverbType;
     float fParameters[paramCount];
+    float fOutputs[paramTotalCount - paramCount];
     double fSampleRate;
 
     // Knob management
@@ -69,6 +70,7 @@ private:
     void drawCharacterSection();
     void drawFilterSection();
     void drawSpectrumAnalyzer();
+    void drawDspLoadMeter();
 
     // Helper methods
     void formatParameterValue(uint32_t param, float value, char* str, size_t maxLen);
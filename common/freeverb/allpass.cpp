@@ -92,6 +92,12 @@ void FV3_(allpass)::mute()
   bufidx = 0;
 }
 
+void FV3_(allpass)::state(state_io& io)
+{
+  io.buffer(buffer, bufsize);
+  io.value(bufidx);
+}
+
 void FV3_(allpass)::setfeedback(fv3_float_t val) 
 {
   feedback = val;
@@ -194,6 +200,12 @@ void FV3_(allpassm)::mute()
   writeidx = 0; z_1 = 0; readidx = modulationsize * 2; feedback_mod = feedback;
 }
 
+void FV3_(allpassm)::state(state_io& io)
+{
+  io.buffer(buffer, bufsize);
+  io.value(writeidx); io.value(readidx); io.value(z_1); io.value(feedback_mod);
+}
+
 void FV3_(allpassm)::setfeedback(fv3_float_t val) 
 {
   feedback_mod = feedback = val;
@@ -259,6 +271,11 @@ void FV3_(allpass2)::setsize(long size1, long size2)
   mute();
 }
 
+long FV3_(allpass2)::getsize()
+{
+  return bufsize1 + bufsize2;
+}
+
 void FV3_(allpass2)::free()
 {
   if(buffer1 == NULL||bufsize1 == 0||buffer2 == NULL||bufsize2 == 0) return;
@@ -273,6 +290,13 @@ void FV3_(allpass2)::mute()
   FV3_(utils)::mute(buffer2, bufsize2);
 }
 
+void FV3_(allpass2)::state(state_io& io)
+{
+  io.buffer(buffer1, bufsize1);
+  io.buffer(buffer2, bufsize2);
+  io.value(bufidx1); io.value(bufidx2);
+}
+
 void FV3_(allpass2)::setfeedback1(fv3_float_t val) 
 {
   feedback1 = val;
@@ -348,6 +372,11 @@ void FV3_(allpass3)::setsize(long size1, long size1mod, long size2, long size3)
   mute();
 }
 
+long FV3_(allpass3)::getsize()
+{
+  return bufsize1 + bufsize2 + bufsize3;
+}
+
 void FV3_(allpass3)::free()
 {
   if(buffer1 == NULL||bufsize1 == 0||buffer2 == NULL||bufsize2 == 0||buffer3 == NULL||bufsize3 == 0) return;
@@ -365,6 +394,14 @@ void FV3_(allpass3)::mute()
   writeidx1 = 0; readidx1 = modulationsize * 2;
 }
 
+void FV3_(allpass3)::state(state_io& io)
+{
+  io.buffer(buffer1, bufsize1);
+  io.buffer(buffer2, bufsize2);
+  io.buffer(buffer3, bufsize3);
+  io.value(writeidx1); io.value(readidx1); io.value(bufidx2); io.value(bufidx3);
+}
+
 void FV3_(allpass3)::setfeedback1(fv3_float_t val) 
 {
   feedback1 = val;
@@ -36,6 +36,7 @@ class _FV3_(allpass)
   void setsize(long size) throw(std::bad_alloc);
   long getsize();
   void mute();
+  void state(state_io& io);
   void         setfeedback(_fv3_float_t val);
   _fv3_float_t getfeedback();
   void         setdecay(_fv3_float_t val);
@@ -153,6 +154,7 @@ class _FV3_(allpassm)
   long getdelaysize();
   long getmodulationsize();
   void mute();
+  void state(state_io& io);
   void         setfeedback(_fv3_float_t val);
   _fv3_float_t getfeedback();
   void         setdecay(_fv3_float_t val);
@@ -306,6 +308,38 @@ class _FV3_(allpassm)
     feedback_mod = feedback + fmod;
     return _process_li(input,modulation);
   }
+
+  /**
+   * An allpass filter with a linear interpolated modulation, a allpass feedback modulation and a decay.
+   * @param[in] input The input signal.
+   * @param[in] modulation The delayline modulation difference. This must be -1~+1.
+   * @param[in] fmod The feedback modulation difference.
+   * @return The processed signal.
+   */
+  inline _fv3_float_t process_dc_li(_fv3_float_t input, _fv3_float_t modulation, _fv3_float_t fmod)
+  {
+    if(bufsize == 0) return input;
+    return _process_dc_li(input, modulation, fmod);
+  }
+  inline _fv3_float_t _process_dc_li(_fv3_float_t input, _fv3_float_t modulation, _fv3_float_t fmod)
+  {
+    feedback_mod = feedback + fmod;
+    modulation = (modulation + 1.) * modulationsize_f;
+    _fv3_float_t floor_mod = std::floor(modulation); // >= 0
+    _fv3_float_t frac = modulation - floor_mod; // >= 0
+    
+    long readidx_a = readidx - (long)floor_mod; if(readidx_a < 0) readidx_a += bufsize;
+    long readidx_b = readidx_a - 1; if(readidx_b < 0) readidx_b += bufsize;
+
+    _fv3_float_t temp = buffer[readidx_b]*frac + buffer[readidx_a]*(1.-frac);
+    readidx ++; if(readidx >= bufsize) readidx = 0;
+
+    buffer[writeidx] = input + temp * feedback_mod;
+    input = decay * temp - buffer[writeidx] * feedback_mod;
+    writeidx ++; if(writeidx >= bufsize) writeidx = 0;
+    
+    return input;
+  }
  
  private:
   _FV3_(allpassm)(const _FV3_(allpassm)& x);
@@ -330,6 +364,10 @@ class _FV3_(allpass2)
    * @param[in] size2 The outer allpass delay size.
    */
   void setsize(long size1, long size2) throw(std::bad_alloc);
+  /**
+   * @return The total size of the inner and outer delays.
+   */
+  long getsize();
 
   /**
    * set the innter allpass feedback.
@@ -426,6 +464,7 @@ class _FV3_(allpass2)
   }
   
   void mute();
+  void state(state_io& io);
  
  private:
   _FV3_(allpass2)(const _FV3_(allpass2)& x);
@@ -446,6 +485,7 @@ class _FV3_(allpass3)
 
   void setsize(long size1, long size2, long size3) throw(std::bad_alloc);
   void setsize(long size1, long size1mod, long size2, long size3) throw(std::bad_alloc);
+  long getsize();
   
   inline _fv3_float_t _getlast1(){ return buffer1[readidx1]; }
   inline _fv3_float_t _getlast2(){ return buffer2[bufidx2]; }
@@ -551,6 +591,7 @@ class _FV3_(allpass3)
   }
 
   void mute();
+  void state(state_io& io);
   void setfeedback1(_fv3_float_t val);
   void setfeedback2(_fv3_float_t val);
   void setfeedback3(_fv3_float_t val);
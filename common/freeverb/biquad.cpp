@@ -47,6 +47,12 @@ void FV3_(biquad)::mute()
   i1 = i2 = o1 = o2 = t0 = t1 = t2 = 0;
 }
 
+void FV3_(biquad)::state(state_io& io)
+{
+  io.value(i1); io.value(i2); io.value(o1); io.value(o2);
+  io.value(t1); io.value(t2);
+}
+
 void FV3_(biquad)::setCoefficients(fv3_float_t _b0, fv3_float_t _b1, fv3_float_t _b2, fv3_float_t _a1, fv3_float_t _a2)
 {
   b0 = _b0; b1 = _b1; b2 = _b2; a1 = _a1; a2 = _a2;
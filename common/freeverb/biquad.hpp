@@ -26,6 +26,7 @@
 
 #include "freeverb/utils.hpp"
 #include "freeverb/fv3_defs.h"
+#include "freeverb/fv3_state.hpp"
 
 #ifdef __cplusplus
 extern "C" {
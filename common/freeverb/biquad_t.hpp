@@ -24,6 +24,7 @@ class _FV3_(biquad)
   _FV3_(biquad)();
   void printconfig();
   void mute();
+  void state(state_io& io);
   _fv3_float_t get_A1(){return a1;}
   _fv3_float_t get_A2(){return a2;}
   _fv3_float_t get_B0(){return b0;}
@@ -94,6 +94,12 @@ void FV3_(comb)::mute()
   filterstore = 0; bufidx = 0;
 }
 
+void FV3_(comb)::state(state_io& io)
+{
+  io.buffer(buffer, bufsize);
+  io.value(filterstore); io.value(bufidx);
+}
+
 void FV3_(comb)::setdamp(fv3_float_t val) 
 {
   damp1 = val; damp2 = 1-val;
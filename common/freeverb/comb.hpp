@@ -27,6 +27,7 @@
 
 #include "freeverb/utils.hpp"
 #include "freeverb/fv3_defs.h"
+#include "freeverb/fv3_state.hpp"
 
 namespace fv3
 {
@@ -36,6 +36,7 @@ public:
   void setsize(long size) throw(std::bad_alloc);
   long getsize();
   void mute();
+  void state(state_io& io);
   void          setdamp(_fv3_float_t val);
   _fv3_float_t  getdamp();
   inline void   setfeedback(_fv3_float_t val){ feedback = val; }
@@ -88,6 +88,12 @@ void FV3_(delay)::mute()
   bufidx = 0;
 }
 
+void FV3_(delay)::state(state_io& io)
+{
+  io.buffer(buffer, bufsize);
+  io.value(bufidx);
+}
+
 void FV3_(delay)::setfeedback(fv3_float_t val) 
 {
   feedback = val;
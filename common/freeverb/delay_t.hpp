@@ -96,6 +96,7 @@ class _FV3_(delay)
   }
 
   void mute();
+  void state(state_io& io);
   void setfeedback(_fv3_float_t val);
   _fv3_float_t getfeedback();
   
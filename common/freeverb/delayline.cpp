@@ -95,6 +95,12 @@ void FV3_(delayline)::mute()
   FV3_(utils)::mute(buffer, bufsize);
 }
 
+void FV3_(delayline)::state(state_io& io)
+{
+  io.buffer(buffer, bufsize);
+  io.value(baseidx);
+}
+
 fv3_float_t FV3_(delayline)::process(fv3_float_t input)
 {
   // simple delay line example
@@ -32,6 +32,7 @@ class _FV3_(delayline)
   void setsize(long size) throw(std::bad_alloc);
   long getsize();
   virtual void mute();
+  virtual void state(state_io& io);
   virtual _fv3_float_t process(_fv3_float_t input);
   /**
    * set the prime mode for delay lines.
@@ -129,6 +129,7 @@ FV3_(earlyref)::FV3_(earlyref)()
 {
   tapLengthL = tapLengthR = 0;
   gainTableL = gainTableR = delayTableL = delayTableR = NULL;
+  monoLength = 0; lineRSkipped = false;
   setdryr(0.8); setwetr(0.5); setwidth(0.2);
   setLRDelay(0.3);
   setLRCrossApFreq(750, 4);
@@ -149,6 +150,25 @@ void FV3_(earlyref)::mute()
   FV3_(revbase)::mute();
   delayLineL.mute(); delayLineR.mute(); delayLtoR.mute(); delayRtoL.mute();
   allpassXL.mute(); allpassXR.mute(); allpassL2.mute(); allpassR2.mute();
+  monoLength = 0; lineRSkipped = false;
+}
+
+void FV3_(earlyref)::state(state_io& io)
+{
+  FV3_(revbase)::state(io);
+  // the state keeps both lines complete
+  if(lineRSkipped) syncLineR();
+  monoLength = 0;
+  delayLineL.state(io); delayLineR.state(io); delayLtoR.state(io); delayRtoL.state(io);
+  allpassXL.state(io); allpassXR.state(io); allpassL2.state(io); allpassR2.state(io);
+  out1_lpf.state(io); out2_lpf.state(io); out1_hpf.state(io); out2_hpf.state(io);
+}
+
+long FV3_(earlyref)::getMemorySize()
+{
+  long size = delayLineL.getsize() + delayLineR.getsize() + delayLtoR.getsize() + delayRtoL.getsize()
+    + 2*(tapLengthL + tapLengthR);
+  return FV3_(revbase)::getMemorySize() + size*sizeof(fv3_float_t);
 }
 
 void FV3_(earlyref)::loadPresetReflection(long program)
@@ -268,7 +288,7 @@ void FV3_(earlyref)::loadReflection(const fv3_float_t * delayL, const fv3_float_
     }
   long maxLengthL = (long)(maxDelay(delayTableL, tapLengthL)+10);
   long maxLengthR = (long)(maxDelay(delayTableR, tapLengthR)+10);
-  delayLineL.setsize(maxLengthL);
+  delayLineL.setsize(maxLengthL > maxLengthR ? maxLengthL : maxLengthR);
   delayLineR.setsize(maxLengthR);
   mute();
 }
@@ -298,6 +318,8 @@ void FV3_(earlyref)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR, fv
 {
   if(numsamples <= 0) return;
   if(tapLengthL == 0||tapLengthR == 0) return;
+  if(lineRSkipped) syncLineR();
+  monoLength = 0;
 
   while(numsamples-- > 0)
     {
@@ -316,6 +338,38 @@ void FV3_(earlyref)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR, fv
     }
 }
 
+void FV3_(earlyref)::processreplaceM(fv3_float_t *input, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+  throw(std::bad_alloc)
+{
+  if(numsamples <= 0) return;
+  if(tapLengthL == 0||tapLengthR == 0) return;
+
+  while(numsamples-- > 0)
+    {
+      // delayLineR holds the same samples as the start of delayLineL
+      if(!lineRSkipped&&monoLength >= delayLineR.getsize()) lineRSkipped = true;
+      *outputL = delayL(*input)*dry;
+      *outputR = delayR(*input)*dry;
+      fv3_float_t wetL = 0, wetR = 0;
+      delayLineL.process(*input);
+      if(!lineRSkipped){ delayLineR.process(*input); monoLength ++; }
+      FV3_(delayline)& lineR = lineRSkipped ? delayLineL : delayLineR;
+      for(long i = 0;i < tapLengthL;i ++){ wetL += gainTableL[i]*delayLineL.at(delayTableL[i]); }
+      for(long i = 0;i < tapLengthR;i ++){ wetR += gainTableR[i]*lineR.at(delayTableR[i]); }
+      wetL = delayWL(wetL); wetR = delayWR(wetR);
+      *outputL += out1_lpf(out1_hpf(allpassL2(wet1 * wetL + wet2 * allpassXL(delayRtoL(*input + wetR)))));
+      *outputR += out2_lpf(out2_hpf(allpassR2(wet1 * wetR + wet2 * allpassXR(delayLtoR(*input + wetL)))));
+      input ++; outputL ++; outputR ++;
+    }
+}
+
+void FV3_(earlyref)::syncLineR()
+{
+  // delayLineR only missed mono input, which is still in delayLineL
+  for(long i = 0;i < delayLineR.getsize();i ++) delayLineR[i] = delayLineL[i];
+  lineRSkipped = false;
+}
+
 void FV3_(earlyref)::setLRDelay(fv3_float_t value_ms)
 {
   lrDelay = (long)((fv3_float_t)currentfs*value_ms/1000.0f);
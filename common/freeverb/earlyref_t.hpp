@@ -25,8 +25,17 @@ public:
   virtual _FV3_(~earlyref)();
 
   virtual void mute();
+  virtual void state(state_io& io);
+  virtual long getMemorySize();
   virtual void processreplace(_fv3_float_t *inputL, _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
     throw(std::bad_alloc);
+  /**
+   * process the same input on both channels. Once delayLineR only holds
+   * mono input, it is no longer written and the right taps read
+   * delayLineL. The next processreplace() copies the line back.
+   */
+  virtual void processreplaceM(_fv3_float_t *input, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
+    throw(std::bad_alloc);
 
   void loadPresetReflection(long program);
   long getCurrentPreset();
@@ -54,8 +63,13 @@ public:
   virtual void setFsFactors();
 
   _fv3_float_t maxDelay(const _fv3_float_t * delaySet, long size);
+  void syncLineR();
 
+  // delayLineL is long enough for the right taps as well
   _FV3_(delayline) delayLineL, delayLineR;
+  // mono samples in a row written to delayLineR, and whether it is skipped
+  long monoLength;
+  bool lineRSkipped;
   _FV3_(delay) delayLtoR, delayRtoL;
   _FV3_(biquad) allpassXL, allpassL2, allpassXR, allpassR2;
   _FV3_(iir_1st) out1_lpf, out2_lpf, out1_hpf, out2_hpf;
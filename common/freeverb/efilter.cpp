@@ -34,6 +34,11 @@ void FV3_(iir_1st)::mute()
   y1 = 0;
 }
 
+void FV3_(iir_1st)::state(state_io& io)
+{
+  io.value(y1);
+}
+
 void FV3_(iir_1st)::printconfig()
 {
   std::fprintf(stderr, "<< 1st order IIR Filter Coefficients >>\n");
@@ -261,6 +266,11 @@ void FV3_(dccut)::mute()
   y1 = y2 = 0;
 }
 
+void FV3_(dccut)::state(state_io& io)
+{
+  io.value(y1); io.value(y2);
+}
+
 void FV3_(dccut)::seta(fv3_float_t val) 
 {
   gain = val;
@@ -24,8 +24,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <stdint.h>
 
 #include "freeverb/fv3_defs.h"
+#include "freeverb/fv3_state.hpp"
 #include "freeverb/slot.hpp"
 
 namespace fv3
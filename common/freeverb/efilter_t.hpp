@@ -24,6 +24,7 @@ class _FV3_(iir_1st)
   _FV3_(iir_1st)();
   void printconfig();
   void mute();
+  void state(state_io& io);
   _fv3_float_t get_A1(){return 1;}
   _fv3_float_t get_A2(){return a2;}
   _fv3_float_t get_B1(){return b1;}
@@ -143,6 +144,15 @@ class _FV3_(dccut)
   }
   
   void mute();
+  void state(state_io& io);
+  /**
+   * true if x gives the same output as this one for any input.
+   */
+  inline bool samestate(const _FV3_(dccut)& x) const
+  {
+    return gain == x.gain&&y1 == x.y1&&y2 == x.y2;
+  }
+  inline void copystate(const _FV3_(dccut)& x){ y1 = x.y1; y2 = x.y2; }
   void seta(_fv3_float_t val);
   _fv3_float_t geta();
   void setCutOnFreq(_fv3_float_t fc, _fv3_float_t fs);
@@ -182,6 +192,7 @@ class _FV3_(lfo)
   inline _fv3_float_t operator()(){ return this->processarc(); }
 
   void mute(){ re = 1; im = 0; count = 0; }
+  void state(state_io& io){ io.value(re); io.value(im); io.value(count); }
   void setFreq(_fv3_float_t freq, _fv3_float_t fs){setFreq(freq/fs);}
   void setFreq(_fv3_float_t fc){ s_fc = fc; _fv3_float_t theta = 2.*M_PI*fc; arc_re = std::cos(theta); arc_im = std::sin(theta); }
   void setRCount(long v){if(v>0)count_max=v;}
@@ -214,6 +225,38 @@ class _FV3_(ahdsr)
   bool loopMode;
 };
 
+/**
+ * Seeded uniform random numbers for the noise generators (xorshift32).
+ * Every generator owns one, so its output depends only on the seed and
+ * not on other users of std::rand() or on the order instances run in.
+ */
+class _FV3_(noisegen_random)
+{
+ public:
+  _FV3_(noisegen_random)(){ setSeed(FV3_NOISEGEN_DEFAULT_SEED); }
+  void setSeed(uint32_t seed){ initial = (seed != 0 ? seed : FV3_NOISEGEN_DEFAULT_SEED); current = initial; }
+  uint32_t getSeed(){ return initial; }
+  /**
+   * Restart the sequence from the seed.
+   */
+  void reset(){ current = initial; }
+  void state(state_io& io){ io.value(current); }
+  inline uint32_t next()
+  {
+    current ^= current << 13;
+    current ^= current >> 17;
+    current ^= current << 5;
+    return current;
+  }
+  /**
+   * Uniform in [0,1], the range of std::rand()/RAND_MAX.
+   */
+  inline _fv3_float_t uniform(){ return (_fv3_float_t)next() / (_fv3_float_t)4294967295.0; }
+
+ private:
+  uint32_t initial, current;
+};
+
 class _FV3_(noisegen_pink_frac)
 {
  public:
@@ -239,7 +282,10 @@ class _FV3_(noisegen_pink_frac)
     mute();
   }
   
-  void mute(){ pfn1_slot.mute(); pfn1_count = 0; }
+  void mute(){ pfn1_slot.mute(); pfn1_count = 0; pfn1_random.reset(); }
+  void state(state_io& io){ io.buffer(pfn1_slot.L, pfn1_slot.getsize()); io.value(pfn1_count); pfn1_random.state(io); }
+  void setSeed(uint32_t seed){ pfn1_random.setSeed(seed); }
+  uint32_t getSeed(){ return pfn1_random.getSeed(); }
   
   inline _fv3_float_t process()
   {
@@ -277,7 +323,7 @@ class _FV3_(noisegen_pink_frac)
 	for (c = 0; c < k; c++)
 	  {
 	    v[c*l + l/2] = (v[c*l] + v[((c+1) * l) % N]) / 2.0
-	      + 2.0 * r * ((_fv3_float_t)std::rand() - (_fv3_float_t)RAND_MAX/2.0) / (_fv3_float_t)RAND_MAX;
+	      + 2.0 * r * (pfn1_random.uniform() - 0.5);
 	    if(v[c*l + l/2] < -1.) v[c*l + l/2] = -1.;
 	    if(v[c*l + l/2] >  1.) v[c*l + l/2] =  1.;
 	  }
@@ -289,13 +335,15 @@ class _FV3_(noisegen_pink_frac)
   _fv3_float_t pfn1_param;
   long pfn1_length, pfn1_count;
   _FV3_(slot) pfn1_slot;
+  _FV3_(noisegen_random) pfn1_random;
 };
 
 class _FV3_(noisegen_gaussian_white_noise_1)
 {
  public:
   _FV3_(noisegen_gaussian_white_noise_1)(){ mute(); }
-  void mute(){ gwn1_pass = false; gwn1_y2 = 0; }
+  void mute(){ gwn1_pass = false; gwn1_y2 = 0; gwn1_random.reset(); }
+  void setSeed(uint32_t seed){ gwn1_random.setSeed(seed); }
   inline _fv3_float_t process()
   {
     // http://www.musicdsp.org/archive.php?classid=1#109
@@ -305,8 +353,8 @@ class _FV3_(noisegen_gaussian_white_noise_1)
       {
 	do
 	  {
-	    x1 = 2.0 * ((_fv3_float_t)std::rand() / (_fv3_float_t) RAND_MAX) - 1.0;
-	    x2 = 2.0 * ((_fv3_float_t)std::rand() / (_fv3_float_t) RAND_MAX) - 1.0;
+	    x1 = 2.0 * gwn1_random.uniform() - 1.0;
+	    x2 = 2.0 * gwn1_random.uniform() - 1.0;
 	    w = x1 * x1 + x2 * x2;
 	  } while(w >= 1.0f);
 	w = std::sqrt (-2.0 * std::log (w) / w);
@@ -324,16 +372,20 @@ class _FV3_(noisegen_gaussian_white_noise_1)
   _FV3_(noisegen_gaussian_white_noise_1)(const _FV3_(noisegen_gaussian_white_noise_1)& x);
   _FV3_(noisegen_gaussian_white_noise_1)& operator=(const _FV3_(noisegen_gaussian_white_noise_1)& x);
   _fv3_float_t gwn1_y2; bool gwn1_pass;
+  _FV3_(noisegen_random) gwn1_random;
 };
 
 class _FV3_(noisegen_gaussian_white_noise_2)
 {
  public:
+  _FV3_(noisegen_gaussian_white_noise_2)(){}
+  void mute(){ gwn2_random.reset(); }
+  void setSeed(uint32_t seed){ gwn2_random.setSeed(seed); }
   inline _fv3_float_t process()
   {
     // http://www.musicdsp.org/archive.php?classid=1#113
-    _fv3_float_t R1 = (_fv3_float_t)std::rand() / (_fv3_float_t)RAND_MAX;
-    _fv3_float_t R2 = (_fv3_float_t)std::rand() / (_fv3_float_t)RAND_MAX;
+    _fv3_float_t R1 = gwn2_random.uniform();
+    _fv3_float_t R2 = gwn2_random.uniform();
     return (_fv3_float_t)std::sqrt(-2.0*std::log(R1))*std::cos(2.0*M_PI*R2);
   }
   inline _fv3_float_t operator()(){ return this->process(); }
@@ -343,6 +395,7 @@ class _FV3_(noisegen_gaussian_white_noise_2)
  private:
   _FV3_(noisegen_gaussian_white_noise_2)(const _FV3_(noisegen_gaussian_white_noise_2)& x);
   _FV3_(noisegen_gaussian_white_noise_2)& operator=(const _FV3_(noisegen_gaussian_white_noise_2)& x);
+  _FV3_(noisegen_random) gwn2_random;
 };
 
 class _FV3_(noisegen_gaussian_white_noise_3)
@@ -356,6 +409,8 @@ class _FV3_(noisegen_gaussian_white_noise_3)
     gwn3_c2 = ((long)(c1 / 3)) + 1;
     gwn3_c3 = 1. / c1;
   }
+  void mute(){ gwn3_random.reset(); }
+  void setSeed(uint32_t seed){ gwn3_random.setSeed(seed); }
   
   inline _fv3_float_t process()
   {
@@ -368,7 +423,7 @@ class _FV3_(noisegen_gaussian_white_noise_3)
     // distance between two numbers will be 1/(2^q div 3)=1/10922 which usually gives good results.
     // Note: the random() function used is the standard random function from Delphi/Pascal that produces *linear*
     // distributed numbers from 0 to parameter-1, the equivalent C function is probably rand().
-    _fv3_float_t random = ((_fv3_float_t)std::rand() / (_fv3_float_t)(RAND_MAX));
+    _fv3_float_t random = gwn3_random.uniform();
     return (2. * ((random * gwn3_c2) + (random * gwn3_c2) + (random * gwn3_c2)) - 3. * (gwn3_c2 - 1.)) * gwn3_c3;
   }
   inline _fv3_float_t operator()(){ return this->process(); }
@@ -379,4 +434,5 @@ class _FV3_(noisegen_gaussian_white_noise_3)
   _FV3_(noisegen_gaussian_white_noise_3)(const _FV3_(noisegen_gaussian_white_noise_3)& x);
   _FV3_(noisegen_gaussian_white_noise_3)& operator=(const _FV3_(noisegen_gaussian_white_noise_3)& x);
   _fv3_float_t gwn3_c2, gwn3_c3;
+  _FV3_(noisegen_random) gwn3_random;
 };
@@ -60,6 +60,11 @@ class _FV3_(frag)
     throw(std::bad_alloc);
   void loadImpulse(const _fv3_float_t * L, long size, long limit, unsigned fftflags, _fv3_float_t * preAllocatedL)
     throw(std::bad_alloc);
+  // read [offset, offset+limit) of one channel straight from the mapped source
+  void loadImpulse(_FV3_(irsource) * source, long channel, long offset, long size, long limit, unsigned fftflags, _fv3_float_t * preAllocatedL)
+    throw(std::bad_alloc);
+  // the preallocated block already holds the spectrum (see fragcache)
+  void loadSpectrum(long size, _fv3_float_t * preAllocatedL);
   void unloadImpulse();
   long getFragmentSize();
   // add size*2, size*2
@@ -0,0 +1,210 @@
+/**
+ *  On-disk cache of IR fragment spectra
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "freeverb/fragcache.hpp"
+#include "freeverb/fv3_type_float.h"
+#include "freeverb/fv3_ns_start.h"
+
+static const char fragcache_magic[8] = {'F','V','3','F','R','A','G','\0'};
+
+static long fragcache_align(long bytes)
+{
+  return (bytes + FV3_FRAGCACHE_ALIGN - 1) / FV3_FRAGCACHE_ALIGN * FV3_FRAGCACHE_ALIGN;
+}
+
+FV3_(fragcache)::FV3_(fragcache)()
+{
+  sampleRate = 0;
+  const char * env = std::getenv("FV3_FRAGCACHE_DIR");
+  if(env != NULL&&*env != '\0')
+    directory = env;
+  else if((env = std::getenv("XDG_CACHE_HOME")) != NULL&&*env != '\0')
+    directory = std::string(env) + "/freeverb3";
+  else if((env = std::getenv("HOME")) != NULL&&*env != '\0')
+    directory = std::string(env) + "/.cache/freeverb3";
+  else
+    directory = "/tmp/freeverb3";
+}
+
+FV3_(fragcache)::FV3_(~fragcache)()
+{
+  ;
+}
+
+void FV3_(fragcache)::setDirectory(const char * path)
+{
+  if(path != NULL) directory = path;
+}
+
+const char * FV3_(fragcache)::getDirectory()
+{
+  return directory.c_str();
+}
+
+void FV3_(fragcache)::setSampleRate(fv3_float_t fs)
+{
+  sampleRate = fs;
+}
+
+fv3_float_t FV3_(fragcache)::getSampleRate()
+{
+  return sampleRate;
+}
+
+uint64_t FV3_(fragcache)::hash(uint64_t h, const void * data, size_t bytes)
+{
+  const unsigned char * p = (const unsigned char *)data;
+  for(size_t i = 0;i < bytes;i ++)
+    {
+      h ^= p[i];
+      h *= 1099511628211ULL;
+    }
+  return h;
+}
+
+uint64_t FV3_(fragcache)::getKey(const fv3_float_t * inputL, FV3_(irsource) * source, long channel, long size,
+                                 long sFragmentSize, long lFragmentSize, long simdSize)
+{
+  uint64_t h = 14695981039346656037ULL;
+  int64_t layout[6] = { (int64_t)sizeof(fv3_float_t), size, sFragmentSize, lFragmentSize, simdSize, FV3_FRAGCACHE_VERSION, };
+  double fs = (double)sampleRate;
+  h = hash(h, layout, sizeof(layout));
+  h = hash(h, &fs, sizeof(fs));
+  if(source == NULL)
+    return hash(h, inputL, sizeof(fv3_float_t)*size);
+
+  // Hash the mapped source in partitions, the IR is never held in memory as a whole.
+  FV3_(slot) chunk;
+  chunk.alloc(sFragmentSize, 1);
+  for(long i = 0;i < size;i += sFragmentSize)
+    {
+      long n = size - i < sFragmentSize ? size - i : sFragmentSize;
+      source->read(channel, i, chunk.L, n);
+      h = hash(h, chunk.L, sizeof(fv3_float_t)*n);
+    }
+  return h;
+}
+
+std::string FV3_(fragcache)::getFileName(uint64_t key)
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "/%016llx.fv3frag", (unsigned long long)key);
+  return directory + name;
+}
+
+bool FV3_(fragcache)::load(uint64_t key, long size, long sFragmentSize, long sBlocks, fv3_float_t * sSpectra,
+                           long lFragmentSize, long lBlocks, fv3_float_t * lSpectra, long simdSize)
+{
+  std::string file = getFileName(key);
+  int fd = open(file.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(fstat(fd, &st) != 0||st.st_size < (off_t)sizeof(FV3_(fragcacheheader)))
+    {
+      close(fd);
+      return false;
+    }
+  void * base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED) return false;
+
+  const FV3_(fragcacheheader) * h = (const FV3_(fragcacheheader) *)base;
+  long sBytes = sizeof(fv3_float_t)*sFragmentSize*2*sBlocks, lBytes = sizeof(fv3_float_t)*lFragmentSize*2*lBlocks;
+  bool valid = std::memcmp(h->magic, fragcache_magic, sizeof(fragcache_magic)) == 0&&
+    h->version == FV3_FRAGCACHE_VERSION&&h->floatSize == sizeof(fv3_float_t)&&h->key == key&&
+    h->impulseSize == size&&h->sFragmentSize == sFragmentSize&&h->sBlocks == sBlocks&&
+    h->lFragmentSize == lFragmentSize&&h->lBlocks == lBlocks&&h->simdSize == simdSize&&
+    h->sOffset + sBytes <= (int64_t)st.st_size&&h->lOffset + lBytes <= (int64_t)st.st_size;
+  if(valid)
+    {
+      std::memcpy(sSpectra, (const char*)base + h->sOffset, sBytes);
+      std::memcpy(lSpectra, (const char*)base + h->lOffset, lBytes);
+    }
+#ifdef DEBUG
+  std::fprintf(stderr, "fragcache::load(%s) %s\n", file.c_str(), valid ? "hit" : "stale");
+#endif
+  munmap(base, (size_t)st.st_size);
+  return valid;
+}
+
+bool FV3_(fragcache)::store(uint64_t key, long size, long sFragmentSize, long sBlocks, const fv3_float_t * sSpectra,
+                            long lFragmentSize, long lBlocks, const fv3_float_t * lSpectra, long simdSize)
+{
+  // mkdir -p
+  for(size_t i = 1;i <= directory.size();i ++)
+    {
+      if(i == directory.size()||directory[i] == '/')
+        mkdir(directory.substr(0, i).c_str(), 0755);
+    }
+
+  FV3_(fragcacheheader) h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, fragcache_magic, sizeof(fragcache_magic));
+  h.version = FV3_FRAGCACHE_VERSION;
+  h.floatSize = sizeof(fv3_float_t);
+  h.key = key;
+  h.impulseSize = size;
+  h.sFragmentSize = sFragmentSize, h.sBlocks = sBlocks;
+  h.lFragmentSize = lFragmentSize, h.lBlocks = lBlocks;
+  h.simdSize = simdSize;
+  long sBytes = sizeof(fv3_float_t)*sFragmentSize*2*sBlocks, lBytes = sizeof(fv3_float_t)*lFragmentSize*2*lBlocks;
+  h.sOffset = fragcache_align(sizeof(h));
+  h.lOffset = fragcache_align(h.sOffset + sBytes);
+
+  // Write to a unique name and rename, concurrent instances and threads
+  // never see a partial file or write to the same one.
+  std::string file = getFileName(key);
+  std::string temp = file + ".XXXXXX";
+  int fd = mkstemp(&temp[0]);
+  FILE * fp = fd < 0 ? NULL : fdopen(fd, "wb");
+  if(fp == NULL)
+    {
+      std::fprintf(stderr, "fragcache::store(%s) open failed\n", temp.c_str());
+      if(fd >= 0)
+        {
+          close(fd);
+          std::remove(temp.c_str());
+        }
+      return false;
+    }
+  fchmod(fd, 0644);
+  static const char pad[FV3_FRAGCACHE_ALIGN] = {0};
+  bool ok = std::fwrite(&h, sizeof(h), 1, fp) == 1&&
+    std::fwrite(pad, 1, h.sOffset - sizeof(h), fp) == (size_t)(h.sOffset - sizeof(h))&&
+    std::fwrite(sSpectra, 1, sBytes, fp) == (size_t)sBytes&&
+    std::fwrite(pad, 1, h.lOffset - h.sOffset - sBytes, fp) == (size_t)(h.lOffset - h.sOffset - sBytes)&&
+    std::fwrite(lSpectra, 1, lBytes, fp) == (size_t)lBytes;
+  ok = std::fclose(fp) == 0&&ok;
+  if(!ok||std::rename(temp.c_str(), file.c_str()) != 0)
+    {
+      std::fprintf(stderr, "fragcache::store(%s) write failed\n", file.c_str());
+      std::remove(temp.c_str());
+      return false;
+    }
+  return true;
+}
+
+#include "freeverb/fv3_ns_end.h"
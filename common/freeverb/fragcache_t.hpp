@@ -0,0 +1,59 @@
+/**
+ *  On-disk cache of IR fragment spectra
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// File layout (native endian, every block starts on a FV3_FRAGCACHE_ALIGN boundary)
+// [header][short fragment spectra sFragmentSize*2*sBlocks][large fragment spectra lFragmentSize*2*lBlocks]
+typedef struct {
+  char magic[8];
+  uint32_t version, floatSize;
+  uint64_t key;
+  int64_t impulseSize, sFragmentSize, sBlocks, lFragmentSize, lBlocks, simdSize;
+  int64_t sOffset, lOffset;
+} _FV3_(fragcacheheader);
+
+class _FV3_(fragcache)
+{
+ public:
+  _FV3_(fragcache)();
+  virtual _FV3_(~fragcache)();
+  // defaults to $FV3_FRAGCACHE_DIR, $XDG_CACHE_HOME/freeverb3 or ~/.cache/freeverb3
+  void setDirectory(const char * path);
+  const char * getDirectory();
+  // sample rate of the impulses loaded through this cache
+  void setSampleRate(_fv3_float_t fs);
+  _fv3_float_t getSampleRate();
+
+  // FNV-1a of the IR data, sample rate and partition layout
+  uint64_t getKey(const _fv3_float_t * inputL, _FV3_(irsource) * source, long channel, long size,
+                  long sFragmentSize, long lFragmentSize, long simdSize);
+  // replace sBlocks*sFragmentSize*2, lBlocks*lFragmentSize*2
+  bool load(uint64_t key, long size, long sFragmentSize, long sBlocks, _fv3_float_t * sSpectra,
+            long lFragmentSize, long lBlocks, _fv3_float_t * lSpectra, long simdSize);
+  bool store(uint64_t key, long size, long sFragmentSize, long sBlocks, const _fv3_float_t * sSpectra,
+             long lFragmentSize, long lBlocks, const _fv3_float_t * lSpectra, long simdSize);
+
+ private:
+  _FV3_(fragcache)(const _FV3_(fragcache)& x);
+  _FV3_(fragcache)& operator=(const _FV3_(fragcache)& x);
+  std::string getFileName(uint64_t key);
+  static uint64_t hash(uint64_t h, const void * data, size_t bytes);
+  std::string directory;
+  _fv3_float_t sampleRate;
+};
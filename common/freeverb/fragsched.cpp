@@ -0,0 +1,310 @@
+/**
+ *  Time distributed large fragment convolver
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "freeverb/fragsched.hpp"
+#include "freeverb/fv3_pthread_tool.hpp"
+#include "freeverb/fv3_type_float.h"
+#include "freeverb/fv3_ns_start.h"
+
+// Work of one large block (M = fragmentSize*2, B = leafCount = 2^depthCount)
+// phase 0                   : forward r2c of the B decimated leaves (M/B)
+// phase 1..depthCount       : forward butterfly passes, depth depthCount-1..0
+// phase depthCount+1        : spectral multiply-accumulate of all fragments
+// phase depthCount+2..2d+1  : inverse butterfly passes, depth 0..depthCount-1
+// phase 2*depthCount+2      : inverse c2r of the B leaves
+// Spectra are stored as half complex [re,im] pairs (M/2+1 bins).
+
+FV3_(fragsched)::FV3_(fragsched)()
+{
+  fragmentSize = fftSize = bins = leafCount = leafSize = depthCount = fragmentCount = 0;
+  phaseCount = phase = phaseIndex = historyPos = 0;
+  doneUnits = totalUnits = 0;
+  pending = false;
+  forwardOut = NULL;
+}
+
+FV3_(fragsched)::FV3_(~fragsched)()
+{
+  unloadImpulse();
+}
+
+long FV3_(fragsched)::getFragmentCount(){ return fragmentCount; }
+long FV3_(fragsched)::getFragmentSize(){ return fragmentSize; }
+
+fv3_float_t * FV3_(fragsched)::level(long depth)
+{
+  return levelSlot.c(depth);
+}
+
+void FV3_(fragsched)::loadImpulse(const fv3_float_t * inputL, FV3_(irsource) * source, long channel, long offset, long size,
+                                  long lsize, long leaves, unsigned fftflags)
+  throw(std::bad_alloc)
+{
+  unloadImpulse();
+  if(size <= 0) return;
+  if(lsize < FV3_IR_Min_FragmentSize||lsize != FV3_(utils)::checkPow2(lsize))
+    {
+      std::fprintf(stderr, "fragsched::loadImpulse(f=%ld): fragmentSize must be 2^n (>%d).\n", lsize, FV3_IR_Min_FragmentSize);
+      throw std::bad_alloc();
+    }
+  fragmentSize = lsize;
+  fftSize = lsize*2;
+  bins = lsize+1;
+  leafCount = FV3_(utils)::checkPow2(leaves < 2 ? 2 : leaves);
+  if(leafCount > fftSize/FV3_IR_Min_FragmentSize) leafCount = fftSize/FV3_IR_Min_FragmentSize;
+  leafSize = fftSize/leafCount;
+  depthCount = 0;
+  while((1L << depthCount) < leafCount) depthCount ++;
+  long count = (size + lsize - 1)/lsize;
+
+  try
+    {
+      frameSlot.alloc(fftSize, 1);
+      outputSlot.alloc(fftSize, 1);
+      twiddleSlot.alloc((fftSize/4+1)*2, 1);
+      levelSlot.alloc(fftSize+2*leafCount, depthCount+1);
+      impulseSpectra.alloc(bins*2*count, 1);
+      inputSpectra.alloc(bins*2*count, 1);
+      phaseCount = 2*depthCount+3;
+      phaseItems.assign(phaseCount, 0);
+      phaseCost.assign(phaseCount, 1);
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "fragsched::loadImpulse(%ld) bad_alloc\n", size);
+      unloadImpulse();
+      throw;
+    }
+
+  for(long k = 0;k <= fftSize/4;k ++)
+    {
+      double w = -2.0*M_PI*(double)k/(double)fftSize;
+      twiddleSlot.L[2*k+0] = (fv3_float_t)std::cos(w);
+      twiddleSlot.L[2*k+1] = (fv3_float_t)std::sin(w);
+    }
+
+  int n = (int)leafSize;
+  FFTWPlannerLock().lock();
+  planLeafR2C = FFTW_(plan_many_dft_r2c)(1, &n, 1, frameSlot.L, NULL, (int)leafCount, 0,
+                                         (FFTW_(complex)*)level(depthCount), NULL, 1, 0, fftflags|FFTW_UNALIGNED);
+  planLeafC2R = FFTW_(plan_many_dft_c2r)(1, &n, 1, (FFTW_(complex)*)level(depthCount), NULL, 1, 0,
+                                         outputSlot.L, NULL, (int)leafCount, 0, fftflags|FFTW_UNALIGNED);
+  FFTWPlannerLock().unlock();
+  fragmentCount = count;
+
+  long leafCost = leafSize/4;
+  for(long s = leafSize;s > 1;s >>= 1) leafCost += leafSize/4;
+  for(long p = 0;p < phaseCount;p ++)
+    {
+      long depth = p <= depthCount ? depthCount - p : p - depthCount - 2;
+      if(p == 0||p == phaseCount-1)
+        phaseItems[p] = leafCount, phaseCost[p] = leafCost;
+      else if(p == depthCount+1)
+        phaseItems[p] = fragmentCount*bins;
+      else
+        phaseItems[p] = (1L << depth)*(fftSize/(4L << depth)+1);
+    }
+  totalUnits = 0;
+  for(long p = 0;p < phaseCount;p ++) totalUnits += (long long)phaseItems[p]*phaseCost[p];
+
+  // The impulse spectra use the same (unsliced) forward transform.
+  for(long j = 0;j < fragmentCount;j ++)
+    {
+      long limit = size - j*lsize < lsize ? size - j*lsize : lsize;
+      frameSlot.mute();
+      if(source != NULL)
+        source->read(channel, offset+j*lsize, frameSlot.L, limit);
+      else
+        std::memcpy(frameSlot.L, inputL+offset+j*lsize, sizeof(fv3_float_t)*limit);
+      for(long i = 0;i < limit;i ++) frameSlot.L[i] /= (fv3_float_t)fftSize;
+      forwardOut = impulseSpectra.L+j*bins*2;
+      for(long p = 0;p <= depthCount;p ++) execute(p, 0, phaseItems[p]);
+    }
+  mute();
+
+#ifdef DEBUG
+  std::fprintf(stderr, "fragsched::loadImpulse(): %ldx%ld leaves=%ldx%ld units=%lld\n", fragmentSize, fragmentCount, leafCount, leafSize, totalUnits);
+#endif
+}
+
+void FV3_(fragsched)::unloadImpulse()
+{
+  if(fragmentCount == 0) return;
+  FFTWPlannerLock().lock();
+  FFTW_(destroy_plan)(planLeafR2C);
+  FFTW_(destroy_plan)(planLeafC2R);
+  FFTWPlannerLock().unlock();
+  frameSlot.free();
+  outputSlot.free();
+  twiddleSlot.free();
+  levelSlot.free();
+  impulseSpectra.free();
+  inputSpectra.free();
+  fragmentCount = 0;
+  pending = false;
+}
+
+void FV3_(fragsched)::mute()
+{
+  if(fragmentCount == 0) return;
+  frameSlot.mute();
+  outputSlot.mute();
+  levelSlot.mute();
+  inputSpectra.mute();
+  phase = phaseIndex = historyPos = 0;
+  doneUnits = 0;
+  pending = false;
+}
+
+void FV3_(fragsched)::start(const fv3_float_t * frame)
+{
+  if(fragmentCount == 0) return;
+  // the upper half of the frame stays zero padded
+  std::memcpy(frameSlot.L, frame, sizeof(fv3_float_t)*fragmentSize);
+  historyPos = (historyPos + 1) % fragmentCount;
+  forwardOut = inputSpectra.L+historyPos*bins*2;
+  phase = phaseIndex = 0;
+  doneUnits = 0;
+  pending = true;
+}
+
+void FV3_(fragsched)::run(long cursor)
+{
+  if(!pending) return;
+  long long target = cursor >= fragmentSize ? totalUnits : totalUnits*cursor/fragmentSize;
+  while(phase < phaseCount&&doneUnits < target)
+    {
+      long cost = phaseCost[phase];
+      long remain = phaseItems[phase] - phaseIndex;
+      long n = (long)((target - doneUnits + cost - 1)/cost);
+      if(n > remain) n = remain;
+      execute(phase, phaseIndex, phaseIndex+n);
+      phaseIndex += n;
+      doneUnits += (long long)n*cost;
+      if(phaseIndex == phaseItems[phase])
+        {
+          phase ++;
+          phaseIndex = 0;
+        }
+    }
+}
+
+void FV3_(fragsched)::finish(fv3_float_t * output)
+{
+  if(!pending) return;
+  run(fragmentSize);
+  for(long i = 0;i < fftSize;i ++) output[i] += outputSlot.L[i];
+  pending = false;
+}
+
+void FV3_(fragsched)::execute(long p, long begin, long end)
+{
+  if(p == 0)
+    {
+      long stride = (leafSize/2+1)*2;
+      for(long o = begin;o < end;o ++)
+        FFTW_(execute_dft_r2c)(planLeafR2C, frameSlot.L+o, (FFTW_(complex)*)(level(depthCount)+o*stride));
+    }
+  else if(p <= depthCount)
+    forwardCombine(depthCount-p, begin, end);
+  else if(p == depthCount+1)
+    multiply(begin, end);
+  else if(p <= 2*depthCount+1)
+    inverseSplit(p-depthCount-2, begin, end);
+  else
+    {
+      long stride = (leafSize/2+1)*2;
+      for(long o = begin;o < end;o ++)
+        FFTW_(execute_dft_c2r)(planLeafC2R, (FFTW_(complex)*)(level(depthCount)+o*stride), outputSlot.L+o);
+    }
+}
+
+void FV3_(fragsched)::forwardCombine(long depth, long begin, long end)
+{
+  // X[k] = E[k] + W^k O[k], X[H-k] = conj(E[k] - W^k O[k]), k = 0..H/2
+  long H = fftSize >> (depth+1), Q = H/2, parents = 1L << depth;
+  const fv3_float_t * child = level(depth+1), * tw = twiddleSlot.L;
+  fv3_float_t * parent = depth == 0 ? forwardOut : level(depth);
+  for(long t = begin;t < end;t ++)
+    {
+      long o = t/(Q+1), k = t%(Q+1);
+      const fv3_float_t * E = child+(o*(Q+1)+k)*2, * O = child+((o+parents)*(Q+1)+k)*2;
+      fv3_float_t wr = tw[(k << depth)*2+0], wi = tw[(k << depth)*2+1];
+      fv3_float_t tr = wr*O[0] - wi*O[1], ti = wr*O[1] + wi*O[0];
+      fv3_float_t * X = parent+o*(H+1)*2;
+      X[2*k+0] = E[0] + tr;
+      X[2*k+1] = E[1] + ti;
+      X[2*(H-k)+0] = E[0] - tr;
+      X[2*(H-k)+1] = ti - E[1];
+    }
+}
+
+void FV3_(fragsched)::inverseSplit(long depth, long begin, long end)
+{
+  // 2E[k] = X[k] + conj(X[H-k]), 2O[k] = (X[k] - conj(X[H-k])) conj(W^k)
+  // The factor 2 per depth and the c2r gain are folded into the impulse scale 1/M.
+  long H = fftSize >> (depth+1), Q = H/2, parents = 1L << depth;
+  const fv3_float_t * parent = level(depth), * tw = twiddleSlot.L;
+  fv3_float_t * child = level(depth+1);
+  for(long t = begin;t < end;t ++)
+    {
+      long o = t/(Q+1), k = t%(Q+1);
+      const fv3_float_t * X = parent+o*(H+1)*2;
+      fv3_float_t ar = X[2*k+0], ai = X[2*k+1], br = X[2*(H-k)+0], bi = -X[2*(H-k)+1];
+      fv3_float_t wr = tw[(k << depth)*2+0], wi = -tw[(k << depth)*2+1];
+      fv3_float_t dr = ar - br, di = ai - bi;
+      fv3_float_t * E = child+(o*(Q+1)+k)*2, * O = child+((o+parents)*(Q+1)+k)*2;
+      E[0] = ar + br;
+      E[1] = ai + bi;
+      O[0] = dr*wr - di*wi;
+      O[1] = dr*wi + di*wr;
+    }
+}
+
+void FV3_(fragsched)::multiply(long begin, long end)
+{
+  fv3_float_t * Y = level(0);
+  for(long t = begin;t < end;)
+    {
+      long j = t/bins, k = t%bins, n = end - t < bins - k ? end - t : bins - k;
+      const fv3_float_t * h = impulseSpectra.L+(j*bins+k)*2;
+      const fv3_float_t * x = inputSpectra.L+(((historyPos-j+fragmentCount)%fragmentCount)*bins+k)*2;
+      fv3_float_t * y = Y+k*2;
+      if(j == 0)
+        {
+          for(long i = 0;i < n;i ++)
+            {
+              y[2*i+0] = h[2*i+0]*x[2*i+0] - h[2*i+1]*x[2*i+1];
+              y[2*i+1] = h[2*i+0]*x[2*i+1] + h[2*i+1]*x[2*i+0];
+            }
+        }
+      else
+        {
+          for(long i = 0;i < n;i ++)
+            {
+              y[2*i+0] += h[2*i+0]*x[2*i+0] - h[2*i+1]*x[2*i+1];
+              y[2*i+1] += h[2*i+0]*x[2*i+1] + h[2*i+1]*x[2*i+0];
+            }
+        }
+      t += n;
+    }
+}
+
+#include "freeverb/fv3_ns_end.h"
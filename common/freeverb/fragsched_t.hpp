@@ -0,0 +1,65 @@
+/**
+ *  Time distributed large fragment convolver
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// The large fragments are convolved with a radix-2 decimation of the
+// real FFT (leaf r2c/c2r transforms + butterfly passes on half spectra)
+// so that the forward transform, the spectral multiply-accumulate and the
+// inverse transform can be cut into small slices. The slices of one large
+// block are run evenly over the following large block, which requires the
+// fragments to start one large block later than in irmodel3m (the head is
+// covered by short fragments).
+
+class _FV3_(fragsched)
+{
+ public:
+  _FV3_(fragsched)();
+  virtual _FV3_(~fragsched)();
+  // the impulse [offset, offset+size) is split into fragments of fragmentSize
+  void loadImpulse(const _fv3_float_t * inputL, _FV3_(irsource) * source, long channel, long offset, long size,
+                   long fragmentSize, long leafCount, unsigned fftflags)
+    throw(std::bad_alloc);
+  void unloadImpulse();
+  long getFragmentCount();
+  long getFragmentSize();
+  // begin the work for a completed input frame (fragmentSize)
+  void start(const _fv3_float_t * frame);
+  // run the scheduled work up to cursor/fragmentSize of the frame
+  void run(long cursor);
+  // complete the work, add fragmentSize*2
+  void finish(_fv3_float_t * output);
+  void mute();
+
+ private:
+  _FV3_(fragsched)(const _FV3_(fragsched)& x);
+  _FV3_(fragsched)& operator=(const _FV3_(fragsched)& x);
+  void execute(long phase, long begin, long end);
+  void forwardCombine(long depth, long begin, long end);
+  void inverseSplit(long depth, long begin, long end);
+  void multiply(long begin, long end);
+  _fv3_float_t * level(long depth);
+  long fragmentSize, fftSize, bins, leafCount, leafSize, depthCount, fragmentCount;
+  long phaseCount, phase, phaseIndex, historyPos;
+  long long doneUnits, totalUnits;
+  bool pending;
+  std::vector<long> phaseItems, phaseCost;
+  _FFTW_(plan) planLeafR2C, planLeafC2R;
+  _FV3_(slot) frameSlot, outputSlot, twiddleSlot, levelSlot, impulseSpectra, inputSpectra;
+  _fv3_float_t * forwardOut;
+};
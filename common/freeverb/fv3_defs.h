@@ -115,6 +115,29 @@
 #define FV3_IR3_DFragmentSize 1024
 #define FV3_IR3_DefaultFactor 16
 
+/* irmodels block FIR / partitioned crossover */
+#define FV3_IRS_BlockSize 256
+#define FV3_IRS_MinCrossoverLength 256
+#define FV3_IRS_MaxCrossoverLength 8192
+#define FV3_IRS_PartitionSize 64
+
+/* irmodel3ts path index = input*2 + output */
+#define FV3_IR3TS_LL 0
+#define FV3_IR3TS_LR 1
+#define FV3_IR3TS_RL 2
+#define FV3_IR3TS_RR 3
+#define FV3_IR3TS_PATHS 4
+
+#define FV3_IRSOURCE_FORMAT_NONE    0
+#define FV3_IRSOURCE_FORMAT_PCM16   1
+#define FV3_IRSOURCE_FORMAT_PCM24   2
+#define FV3_IRSOURCE_FORMAT_PCM32   3
+#define FV3_IRSOURCE_FORMAT_FLOAT32 4
+#define FV3_IRSOURCE_FORMAT_FLOAT64 5
+
+#define FV3_FRAGCACHE_VERSION 1
+#define FV3_FRAGCACHE_ALIGN 64
+
 #define FV3_3BS_IR2_DFragmentSize 1024
 #define FV3_3BS_IR3_DFragmentSize 256
 #define FV3_3BS_IR3_DefaultFactor 4
@@ -149,6 +172,7 @@
 #define FV3_NOISEGEN_PINK_FRACTAL_1_DEFAULT_HURST_CONST 0.5
 #define FV3_NOISEGEN_PINK_FRACTAL_1_DEFAULT_BUFSIZE 15
 #define FV3_NOISEGEN_GAUSSIAN_WHITE_3_DEFAULT_PRECISION 32
+#define FV3_NOISEGEN_DEFAULT_SEED 0x12345678
 
 #define FV3_MLS_INT_BIT 32
 #define FV3_MLS_MAX_BITS 168
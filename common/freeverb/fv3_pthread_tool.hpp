@@ -61,4 +61,12 @@ private:
   pthread_mutex_t mutex;
 };
 
+// The FFTW planner is not reentrant. Plans are created and destroyed
+// under this lock, the irmodel3p loader plans on its own thread.
+inline PthreadLocker & FFTWPlannerLock()
+{
+  static PthreadLocker planner;
+  return planner;
+}
+
 #endif
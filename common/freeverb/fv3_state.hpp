@@ -0,0 +1,93 @@
+/**
+ *  Signal state snapshots of the filters and reverbs
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _FV3_STATE_HPP
+#define _FV3_STATE_HPP
+
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The classes with a state(state_io&) method pass their signal state
+ * (delay buffers, indices and filter memories, not the parameters) through
+ * a state_io. The same method saves, loads or only measures the state,
+ * depending on how the state_io was made, so both directions always agree
+ * on the layout. Each buffer is a single memcpy.
+ *
+ * A snapshot loads into an instance with the same parameters and sample
+ * rate only: a buffer whose length differs from the stored one fails the
+ * load. The layout depends on the float type and the build, snapshots are
+ * not meant to be exchanged between builds.
+ */
+
+namespace fv3
+{
+  class state_io
+  {
+  public:
+    // measure the size of the state only
+    state_io() : out(NULL), in(NULL), limit(0), pos(0), failed(false) {}
+    // save into data
+    state_io(void * data, size_t size) : out((unsigned char*)data), in(NULL), limit(size), pos(0), failed(false) {}
+    // load from data
+    state_io(const void * data, size_t size) : out(NULL), in((const unsigned char*)data), limit(size), pos(0), failed(false) {}
+
+    bool isLoading() const { return in != NULL; }
+    // false after an overflow or a mismatched buffer length
+    bool good() const { return !failed; }
+    // bytes saved, loaded or measured so far
+    size_t size() const { return pos; }
+    void fail(){ failed = true; }
+
+    inline void io(void * data, size_t size)
+    {
+      if(failed) return;
+      if((out != NULL||in != NULL)&&size > limit - pos)
+	{
+	  failed = true;
+	  return;
+	}
+      if(out != NULL) std::memcpy(out + pos, data, size);
+      if(in != NULL) std::memcpy(data, in + pos, size);
+      pos += size;
+    }
+
+    template<typename T> inline void value(T& v){ io(&v, sizeof(T)); }
+
+    template<typename T> inline void buffer(T * data, long length)
+    {
+      int64_t stored = length;
+      value(stored);
+      if(stored != length){ failed = true; return; }
+      if(length > 0) io(data, sizeof(T)*length);
+    }
+
+  private:
+    state_io(const state_io& x);
+    state_io& operator=(const state_io& x);
+    unsigned char * out;
+    const unsigned char * in;
+    size_t limit, pos;
+    bool failed;
+  };
+};
+
+#endif
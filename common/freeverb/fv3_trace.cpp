@@ -0,0 +1,224 @@
+/**
+ *  Trace points with a Chrome/Perfetto trace event export
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <vector>
+#include <unistd.h>
+#include <pthread.h>
+#include "freeverb/fv3_trace.hpp"
+#include "freeverb/fv3_pthread_tool.hpp"
+
+#define FV3_TRACE_RING_SIZE (1<<16)
+#define FV3_TRACE_MAX_THREADS 64
+#define FV3_TRACE_NAME_SIZE 32
+
+namespace fv3
+{
+  struct trace_record
+  {
+    const char * name;
+    uint64_t time;
+    int64_t arg;
+    char phase;
+  };
+
+  // Written by its own thread only, head is published after each record.
+  // start is owned by the dumper and moved by trace_clear().
+  struct trace_ring
+  {
+    trace_record records[FV3_TRACE_RING_SIZE];
+    uint64_t head;
+    uint64_t start;
+    bool used;
+    long tid;
+    char thread[FV3_TRACE_NAME_SIZE];
+  };
+
+  static PthreadLocker trace_lock;
+  static trace_ring * trace_rings[FV3_TRACE_MAX_THREADS];
+  static long trace_ring_count = 0;
+  static __thread trace_ring * trace_local = NULL;
+  static __thread bool trace_full = false;
+  static pthread_key_t trace_key;
+  static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+
+  static uint64_t trace_now()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+  }
+
+  static void trace_release_ring(void * vdParam)
+  {
+    trace_lock.lock();
+    ((trace_ring*)vdParam)->used = false;
+    trace_lock.unlock();
+  }
+
+  static void trace_create_key()
+  {
+    pthread_key_create(&trace_key, trace_release_ring);
+  }
+
+  // A ring is kept after its thread exits so that its events can still be
+  // dumped, and is handed to the next new thread which continues it under
+  // the same tid. Threads beyond FV3_TRACE_MAX_THREADS are not recorded.
+  static trace_ring * trace_get_ring()
+  {
+    if(trace_local != NULL||trace_full) return trace_local;
+    pthread_once(&trace_key_once, trace_create_key);
+    trace_lock.lock();
+    for(long i = 0;i < trace_ring_count&&trace_local == NULL;i ++)
+      {
+	if(!trace_rings[i]->used)
+	  {
+	    trace_local = trace_rings[i];
+	    trace_local->thread[0] = '\0';
+	  }
+      }
+    if(trace_local == NULL&&trace_ring_count < FV3_TRACE_MAX_THREADS)
+      {
+	trace_ring * ring = new(std::nothrow) trace_ring;
+	if(ring != NULL)
+	  {
+	    ring->head = ring->start = 0;
+	    ring->tid = trace_ring_count + 1;
+	    ring->thread[0] = '\0';
+	    trace_rings[trace_ring_count++] = ring;
+	    trace_local = ring;
+	  }
+      }
+    if(trace_local != NULL)
+      {
+	trace_local->used = true;
+	pthread_setspecific(trace_key, trace_local);
+      }
+    trace_lock.unlock();
+    if(trace_local == NULL)
+      {
+	trace_full = true;
+	std::fprintf(stderr, "fv3_trace: no ring for this thread, events are not recorded.\n");
+      }
+    return trace_local;
+  }
+
+  bool trace_enabled()
+  {
+#ifdef FV3_TRACE
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void trace_event(const char * name, char phase, int64_t arg)
+  {
+    trace_ring * ring = trace_get_ring();
+    if(ring == NULL) return;
+    uint64_t head = ring->head;
+    trace_record * record = &ring->records[head&(FV3_TRACE_RING_SIZE-1)];
+    record->name = name;
+    record->time = trace_now();
+    record->arg = arg;
+    record->phase = phase;
+    __atomic_store_n(&ring->head, head+1, __ATOMIC_RELEASE);
+  }
+
+  void trace_thread(const char * name)
+  {
+    trace_ring * ring = trace_get_ring();
+    if(ring == NULL) return;
+    trace_lock.lock();
+    std::strncpy(ring->thread, name, FV3_TRACE_NAME_SIZE-1);
+    ring->thread[FV3_TRACE_NAME_SIZE-1] = '\0';
+    trace_lock.unlock();
+  }
+
+  void trace_clear()
+  {
+    // Only the owner thread moves its head, the events recorded so far are
+    // skipped by the next dump instead.
+    trace_lock.lock();
+    for(long i = 0;i < trace_ring_count;i ++)
+      trace_rings[i]->start = __atomic_load_n(&trace_rings[i]->head, __ATOMIC_ACQUIRE);
+    trace_lock.unlock();
+  }
+
+  bool trace_dump(const char * path)
+  {
+    FILE * file = std::fopen(path, "w");
+    if(file == NULL)
+      {
+	std::fprintf(stderr, "fv3_trace: could not open %s.\n", path);
+	return false;
+      }
+
+    long pid = (long)getpid();
+    std::vector<trace_record> records(FV3_TRACE_RING_SIZE);
+    bool first = true;
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    trace_lock.lock();
+    for(long i = 0;i < trace_ring_count;i ++)
+      {
+	trace_ring * ring = trace_rings[i];
+	if(ring->thread[0] != '\0')
+	  {
+	    std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+			 first ? "" : ",\n", pid, ring->tid, ring->thread);
+	    first = false;
+	  }
+
+	// The owner keeps writing while the ring is copied. Anything the
+	// writer may have reached during the copy is dropped afterwards.
+	uint64_t end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	uint64_t base = end > FV3_TRACE_RING_SIZE ? end - FV3_TRACE_RING_SIZE : 0;
+	for(uint64_t n = base;n < end;n ++)
+	  records[n-base] = ring->records[n&(FV3_TRACE_RING_SIZE-1)];
+	uint64_t after = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	uint64_t begin = after >= FV3_TRACE_RING_SIZE ? after - FV3_TRACE_RING_SIZE + 1 : 0;
+	if(begin < base) begin = base;
+	if(begin < ring->start) begin = ring->start;
+
+	for(uint64_t n = begin;n < end;n ++)
+	  {
+	    const trace_record& r = records[n-base];
+	    std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%ld",
+			 first ? "" : ",\n", r.name, r.phase, (double)r.time/1000., pid, ring->tid);
+	    if(r.phase == 'i')
+	      std::fprintf(file, ",\"s\":\"t\"");
+	    if(r.phase != 'E'&&r.arg != 0)
+	      std::fprintf(file, ",\"args\":{\"arg\":%lld}", (long long)r.arg);
+	    std::fprintf(file, "}");
+	    first = false;
+	  }
+      }
+    trace_lock.unlock();
+
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::ferror(file) == 0;
+    if(std::fclose(file) != 0) ok = false;
+    return ok;
+  }
+};
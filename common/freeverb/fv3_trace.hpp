@@ -0,0 +1,78 @@
+/**
+ *  Trace points with a Chrome/Perfetto trace event export
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _FV3_TRACE_HPP
+#define _FV3_TRACE_HPP
+
+#include <stdint.h>
+
+/**
+ * The trace points are compiled in with -DFV3_TRACE only, otherwise the
+ * macros expand to nothing and their arguments are not evaluated (sizeof
+ * only keeps them from being reported as unused).
+ *
+ * Each thread records into its own ring of FV3_TRACE_RING_SIZE events, so
+ * recording takes no lock. The first event of a thread allocates its ring;
+ * call FV3_TRACE_THREAD() at the start of a thread to do that up front.
+ * Names must be string literals, only the pointer is stored.
+ */
+
+namespace fv3
+{
+  // true if this build records trace points
+  bool trace_enabled();
+  void trace_event(const char * name, char phase, int64_t arg);
+  void trace_thread(const char * name);
+  // write the recorded events as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev)
+  bool trace_dump(const char * path);
+  void trace_clear();
+
+  class trace_scope
+  {
+  public:
+    trace_scope(const char * _name, int64_t arg) : name(_name) { trace_event(name, 'B', arg); }
+    ~trace_scope() { trace_event(name, 'E', 0); }
+  private:
+    trace_scope(const trace_scope& x);
+    trace_scope& operator=(const trace_scope& x);
+    const char * name;
+  };
+};
+
+#define _FV3_TRACE_CAT2(a, b) a ## b
+#define _FV3_TRACE_CAT(a, b) _FV3_TRACE_CAT2(a, b)
+
+#ifdef FV3_TRACE
+#define FV3_TRACE_BEGIN(name) fv3::trace_event(name, 'B', 0)
+#define FV3_TRACE_END(name) fv3::trace_event(name, 'E', 0)
+#define FV3_TRACE_INSTANT(name, arg) fv3::trace_event(name, 'i', arg)
+#define FV3_TRACE_SCOPE(name) fv3::trace_scope _FV3_TRACE_CAT(_fv3_trace_scope_, __LINE__)(name, 0)
+#define FV3_TRACE_SCOPE_ARG(name, arg) fv3::trace_scope _FV3_TRACE_CAT(_fv3_trace_scope_, __LINE__)(name, arg)
+#define FV3_TRACE_THREAD(name) fv3::trace_thread(name)
+#else
+#define FV3_TRACE_BEGIN(name) do{ (void)sizeof(name); }while(0)
+#define FV3_TRACE_END(name) do{ (void)sizeof(name); }while(0)
+#define FV3_TRACE_INSTANT(name, arg) do{ (void)sizeof(name); (void)sizeof(arg); }while(0)
+#define FV3_TRACE_SCOPE(name) do{ (void)sizeof(name); }while(0)
+#define FV3_TRACE_SCOPE_ARG(name, arg) do{ (void)sizeof(name); (void)sizeof(arg); }while(0)
+#define FV3_TRACE_THREAD(name) do{ (void)sizeof(name); }while(0)
+#endif
+
+#endif
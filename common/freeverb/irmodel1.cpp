@@ -19,6 +19,7 @@
  */
 
 #include "freeverb/irmodel1.hpp"
+#include "freeverb/fv3_pthread_tool.hpp"
 #include "freeverb/fv3_type_float.h"
 #include "freeverb/fv3_ns_start.h"
 
@@ -58,13 +59,16 @@ void FV3_(irmodel1m)::loadImpulse(const fv3_float_t * inputL, long size)
 	  impulse.alloc(2*fragmentSize, 1);
 	  for(long i = 0;i < size;i ++){ impulse.L[i] = inputL[i]/(fv3_float_t)(fragmentSize*2); }
 	  FFTW_(plan) planL; // DFT 2^n impulse
-	  planL = FFTW_(plan_r2r_1d)(2*fragmentSize, impulse.L, fftImpl.L, FFTW_R2HC, FFTW_ESTIMATE);
-	  FFTW_(execute)(planL);
-	  FFTW_(destroy_plan)(planL);
-	  
 	  fftRevr.alloc(2*fragmentSize, 1); // input signal processing plans
+	  FFTWPlannerLock().lock();
+	  planL = FFTW_(plan_r2r_1d)(2*fragmentSize, impulse.L, fftImpl.L, FFTW_R2HC, FFTW_ESTIMATE);
 	  planRevrL = FFTW_(plan_r2r_1d)(fragmentSize*2, fftRevr.L, fftRevr.L, FFTW_HC2R, fftflags);
 	  planOrigL = FFTW_(plan_r2r_1d)(fragmentSize*2, fftRevr.L, fftRevr.L, FFTW_R2HC, fftflags);
+	  FFTWPlannerLock().unlock();
+	  FFTW_(execute)(planL);
+	  FFTWPlannerLock().lock();
+	  FFTW_(destroy_plan)(planL);
+	  FFTWPlannerLock().unlock();
 
       latency = impulseSize;
       mute();
@@ -85,8 +89,10 @@ void FV3_(irmodel1m)::unloadImpulse()
   delayline.free();
   fftImpl.free();
   fftRevr.free();
+  FFTWPlannerLock().lock();
   FFTW_(destroy_plan)(planRevrL);
   FFTW_(destroy_plan)(planOrigL);
+  FFTWPlannerLock().unlock();
 }
 
 void FV3_(irmodel1m)::mute()
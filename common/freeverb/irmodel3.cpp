@@ -29,6 +29,8 @@ FV3_(irmodel3m)::FV3_(irmodel3m)()
 {
   setFragmentSize(FV3_IR3_DFragmentSize, FV3_IR3_DefaultFactor);
   Scursor = Lcursor = Lstep = 0;
+  fragCache = NULL;
+  scheduled = false;
 }
 
 FV3_(irmodel3m)::FV3_(~irmodel3m)()
@@ -38,18 +40,38 @@ FV3_(irmodel3m)::FV3_(~irmodel3m)()
 
 void FV3_(irmodel3m)::loadImpulse(const fv3_float_t * inputL, long size)
   throw(std::bad_alloc)
+{
+  loadImpulseFrom(inputL, NULL, 0, size);
+}
+
+void FV3_(irmodel3m)::loadImpulse(FV3_(irsource) * source, long channel)
+  throw(std::bad_alloc)
+{
+  if(source == NULL||!source->isOpen()) return;
+  loadImpulseFrom(NULL, source, channel, source->getSize());
+}
+
+void FV3_(irmodel3m)::loadImpulseFrom(const fv3_float_t * inputL, FV3_(irsource) * source, long channel, long size)
+  throw(std::bad_alloc)
 {
   if(size <= 0) return;
   FV3_(irmodel3m)::unloadImpulse();
   
   impulseSize = size;
+  // In the scheduled mode the large fragments are one large block late.
+  long head = scheduled ? lFragmentSize*2 : lFragmentSize;
   long sFragmentNum = 0, lFragmentNum = 0, sFragmentMod = 0, lFragmentMod = 0;
-  if(size <= lFragmentSize)
+  if(size <= head)
     {
       sFragmentNum = size / sFragmentSize;
       sFragmentMod = size % sFragmentSize;
       lFragmentNum = 0, lFragmentMod = 0;
     }
+  else if(scheduled)
+    {
+      sFragmentNum = head / sFragmentSize;
+      sFragmentMod = 0;
+    }
   else
     {
       sFragmentNum = lFragmentSize / sFragmentSize;
@@ -74,10 +96,30 @@ void FV3_(irmodel3m)::loadImpulse(const fv3_float_t * inputL, long size)
 
       sImpulseFFTBlock.alloc(sFragmentSize*2*(sFragmentNum+1), 1);
       lImpulseFFTBlock.alloc(lFragmentSize*2*(lFragmentNum+1), 1);
-      allocFrags(&sFragments, inputL, sFragmentSize, sFragmentNum, sFragmentMod, fftflags, sImpulseFFTBlock.L);
-      if(size > lFragmentSize)
+      long sBlocks = sFragmentNum + (sFragmentMod != 0 ? 1 : 0), lBlocks = lFragmentNum + (lFragmentMod != 0 ? 1 : 0);
+      long simdSize = sFragmentsFFT.getSIMDSize();
+      uint64_t key = 0;
+      if(fragCache != NULL&&!scheduled)
+        key = fragCache->getKey(inputL, source, channel, size, sFragmentSize, lFragmentSize, simdSize);
+      if(fragCache != NULL&&!scheduled&&fragCache->load(key, size, sFragmentSize, sBlocks, sImpulseFFTBlock.L, lFragmentSize, lBlocks, lImpulseFFTBlock.L, simdSize))
+        {
+          registerFrags(&sFragments, sFragmentSize, sBlocks, sImpulseFFTBlock.L);
+          registerFrags(&lFragments, lFragmentSize, lBlocks, lImpulseFFTBlock.L);
+        }
+      else
         {
-          allocFrags(&lFragments, inputL+lFragmentSize, lFragmentSize, lFragmentNum, lFragmentMod, fftflags, lImpulseFFTBlock.L);
+          allocFrags(&sFragments, inputL, source, channel, 0, sFragmentSize, sFragmentNum, sFragmentMod, fftflags, sImpulseFFTBlock.L);
+          if(size > lFragmentSize)
+            {
+              allocFrags(&lFragments, inputL, source, channel, lFragmentSize, lFragmentSize, lFragmentNum, lFragmentMod, fftflags, lImpulseFFTBlock.L);
+            }
+          if(size > head&&scheduled)
+            {
+              lScheduler.loadImpulse(inputL, source, channel, head, size-head, lFragmentSize,
+                                     2*lFragmentSize/sFragmentSize, fftflags);
+            }
+          if(fragCache != NULL&&!scheduled)
+            fragCache->store(key, size, sFragmentSize, sBlocks, sImpulseFFTBlock.L, lFragmentSize, lBlocks, lImpulseFFTBlock.L, simdSize);
         }
       sBlockDelayL.setBlock(sFragmentSize*2, (long)sFragments.size());
       lBlockDelayL.setBlock(lFragmentSize*2, (long)lFragments.size());
@@ -103,31 +145,55 @@ void FV3_(irmodel3m)::unloadImpulse()
   lFragmentsFFT.freeFFT();
   sImpulseFFTBlock.free();
   lImpulseFFTBlock.free();
+  lScheduler.unloadImpulse();
 }
 
-void FV3_(irmodel3m)::allocFrags(std::vector<FV3_(frag)*> *to, const fv3_float_t *inputL, long fragSize, long num, long mod, unsigned fftflags, fv3_float_t * preAllocL)
+void FV3_(irmodel3m)::allocFrags(std::vector<FV3_(frag)*> *to, const fv3_float_t *inputL, FV3_(irsource) * source, long channel, long offset,
+                                  long fragSize, long num, long mod, unsigned fftflags, fv3_float_t * preAllocL)
   throw(std::bad_alloc)
 {
   try
     {
-      for(long i = 0;i < num;i ++)
+      for(long i = 0;i <= num;i ++)
         {
+          long limit = i < num ? fragSize : mod;
+          if(limit == 0) break;
           FV3_(frag) * f = new FV3_(frag);
           to->push_back(f);
           f->setSIMD(simdFlag1, simdFlag2);
-          f->loadImpulse(inputL+fragSize*i, fragSize, fragSize, fftflags, preAllocL+fragSize*2*i);
+          if(source != NULL)
+            {
+              source->prefetch(offset+fragSize*(i+1), fragSize);
+              f->loadImpulse(source, channel, offset+fragSize*i, fragSize, limit, fftflags, preAllocL+fragSize*2*i);
+            }
+          else
+            f->loadImpulse(inputL+offset+fragSize*i, fragSize, limit, fftflags, preAllocL+fragSize*2*i);
         }
-      if(mod != 0)
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3::allocFrags(%ld) bad_alloc\n", fragSize);
+      freeFrags(to);
+      throw;
+    }
+}
+
+void FV3_(irmodel3m)::registerFrags(std::vector<FV3_(frag)*> *to, long fragSize, long num, fv3_float_t * preAllocL)
+  throw(std::bad_alloc)
+{
+  try
+    {
+      for(long i = 0;i < num;i ++)
         {
           FV3_(frag) * f = new FV3_(frag);
           to->push_back(f);
           f->setSIMD(simdFlag1, simdFlag2);
-          f->loadImpulse(inputL+fragSize*num, fragSize, mod, fftflags, preAllocL+fragSize*2*num);
+          f->loadSpectrum(fragSize, preAllocL+fragSize*2*i);
         }
     }
   catch(std::bad_alloc&)
     {
-      std::fprintf(stderr, "irmodel3::allocFrags(%ld) bad_alloc\n", fragSize);
+      std::fprintf(stderr, "irmodel3::registerFrags(%ld) bad_alloc\n", fragSize);
       freeFrags(to);
       throw;
     }
@@ -181,6 +247,7 @@ void FV3_(irmodel3m)::processreplace(fv3_float_t *inputL, long numsamples)
       for(long i = 0;i < div;i ++)
         processreplace(inputL+cursor+i*sFragmentSize, sFragmentSize);
       processreplace(inputL+cursor+div*sFragmentSize, mod);
+      return;
     }
 
   processZL(inputL, numsamples);
@@ -189,6 +256,7 @@ void FV3_(irmodel3m)::processreplace(fv3_float_t *inputL, long numsamples)
 void FV3_(irmodel3m)::processZL(fv3_float_t *inputL, long numsamples)
 {
   // numsamples <= sFragmentSize - Scursor
+  bool lScheduled = lScheduler.getFragmentCount() > 0;
   if(Lcursor == 0&&lFragments.size() > 0)
     {
       lFrameSlot.mute();
@@ -220,7 +288,7 @@ void FV3_(irmodel3m)::processZL(fv3_float_t *inputL, long numsamples)
       sFragmentsFFT.HC2R(sSwapSlot.L, sReverseSlot.L);
     }
   
-  if(lFragments.size() > 0)
+  if(lFragments.size() > 0||lScheduled)
     {
       for(long i = 0;i < numsamples;i ++){ inputL[i] = (sReverseSlot.L+Scursor)[i] + (restSlot.L+Scursor)[i] + (lReverseSlot.L+Lcursor)[i]; }
     }
@@ -237,6 +305,7 @@ void FV3_(irmodel3m)::processZL(fv3_float_t *inputL, long numsamples)
       if(((long)lFragments.size()) > i + 1){ lFragments[i+1]->MULT(lBlockDelayL.get(i), lSwapSlot.L); }
       Lstep ++;
     }
+  lScheduler.run(Lcursor);
   
   if(Scursor == sFragmentSize&&sFragments.size() > 0)
     {
@@ -252,6 +321,14 @@ void FV3_(irmodel3m)::processZL(fv3_float_t *inputL, long numsamples)
           lFragmentsFFT.R2HC(lFrameSlot.L, lIFFTSlot.L);
           std::memcpy(lReverseSlot.L, lReverseSlot.L+lFragmentSize, sizeof(fv3_float_t)*(lFragmentSize-1));
         }
+      if(lScheduled)
+        {
+          // the previous frame has been convolved during this block
+          std::memcpy(lReverseSlot.L, lReverseSlot.L+lFragmentSize, sizeof(fv3_float_t)*lFragmentSize);
+          lReverseSlot.mute(lFragmentSize, lFragmentSize);
+          lScheduler.finish(lReverseSlot.L);
+          lScheduler.start(lFrameSlot.L);
+        }
       Lcursor = Lstep = 0;
     }
 }
@@ -272,6 +349,7 @@ void FV3_(irmodel3m)::mute()
   fifoSlot.mute();
   lFrameSlot.mute();
   sOnlySlot.mute();
+  lScheduler.mute();
 }
 
 void FV3_(irmodel3m)::setFragmentSize(long size, long factor)
@@ -294,6 +372,17 @@ long FV3_(irmodel3m)::getLFragmentSize(){ return lFragmentSize; }
 long FV3_(irmodel3m)::getSFragmentCount(){ return (long)sFragments.size(); }
 long FV3_(irmodel3m)::getLFragmentCount(){ return (long)lFragments.size(); }
 long FV3_(irmodel3m)::getScursor(){ return Scursor; }
+void FV3_(irmodel3m)::setFragCache(FV3_(fragcache) * cache){ fragCache = cache; }
+FV3_(fragcache) * FV3_(irmodel3m)::getFragCache(){ return fragCache; }
+
+void FV3_(irmodel3m)::setScheduled(bool on)
+{
+  if(scheduled == on) return;
+  FV3_(irmodel3m)::unloadImpulse();
+  scheduled = on;
+}
+
+bool FV3_(irmodel3m)::getScheduled(){ return scheduled; }
 
 // irmodel3
 
@@ -347,6 +436,32 @@ void FV3_(irmodel3)::loadImpulse(const fv3_float_t * inputL, const fv3_float_t *
   FV3_(irmodel1)::mute();
 }
 
+void FV3_(irmodel3)::loadImpulse(FV3_(irsource) * source)
+  throw(std::bad_alloc)
+{
+  if(source == NULL||!source->isOpen()) return;
+  long size = source->getSize();
+  if(size <= 0||getSFragmentSize() < FV3_IR_Min_FragmentSize||getLFragmentSize() < FV3_IR_Min_FragmentSize) return;
+  FV3_(irmodel3)::unloadImpulse();
+  setSIMD(irmL->getSIMD(0),irmL->getSIMD(1));
+  try
+    {
+      ir3mL->loadImpulse(source, 0), ir3mR->loadImpulse(source, source->getChannels() > 1 ? 1 : 0);
+      impulseSize = size;
+      latency = 0;
+      inputW.alloc(getSFragmentSize(), 2);
+      inputD.alloc(getSFragmentSize(), 2);
+      FV3_(irbase)::setInitialDelay(getInitialDelay());
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3::loadImpulse(%ld) bad_alloc\n", size);
+      FV3_(irmodel3)::unloadImpulse();
+      throw;
+    }
+  FV3_(irmodel1)::mute();
+}
+
 void FV3_(irmodel3)::setFragmentSize(long size, long factor)
 {
   if(size <= 0||factor <= 0||size < FV3_IR_Min_FragmentSize||size != FV3_(utils)::checkPow2(size)||factor != FV3_(utils)::checkPow2(factor))
@@ -382,6 +497,20 @@ void FV3_(irmodel3)::processreplace(const fv3_float_t *inputL, const fv3_float_t
     }
 }
 
+void FV3_(irmodel3)::setFragCache(FV3_(fragcache) * cache)
+{
+  ir3mL->setFragCache(cache);
+  ir3mR->setFragCache(cache);
+}
+
+void FV3_(irmodel3)::setScheduled(bool on)
+{
+  bool last = ir3mL->getScheduled();
+  ir3mL->setScheduled(on);
+  ir3mR->setScheduled(on);
+  if(ir3mL->getScheduled() != last) FV3_(irmodel3)::unloadImpulse();
+}
+
 long FV3_(irmodel3)::getSFragmentSize(){ return ir3mL->getSFragmentSize(); }
 long FV3_(irmodel3)::getLFragmentSize(){ return ir3mL->getLFragmentSize(); }
 long FV3_(irmodel3)::getSFragmentCount(){ return ir3mL->getSFragmentCount(); }
@@ -30,6 +30,8 @@
 #include <new>
 
 #include "freeverb/frag.hpp"
+#include "freeverb/fragcache.hpp"
+#include "freeverb/fragsched.hpp"
 #include "freeverb/delay.hpp"
 #include "freeverb/blockDelay.hpp"
 #include "freeverb/efilter.hpp"
@@ -25,6 +25,9 @@ class _FV3_(irmodel3m) : public _FV3_(irbasem)
   virtual _FV3_(~irmodel3m)();
   virtual void loadImpulse(const _fv3_float_t * inputL, long size)
     throw(std::bad_alloc);
+  // build the fragments partition by partition from a mapped IR file
+  virtual void loadImpulse(_FV3_(irsource) * source, long channel)
+    throw(std::bad_alloc);
   virtual void unloadImpulse();
   virtual void processreplace(_fv3_float_t *inputL, long numsamples);
   virtual void mute();
@@ -35,11 +38,23 @@ class _FV3_(irmodel3m) : public _FV3_(irbasem)
   long getSFragmentCount();
   long getLFragmentCount();
   long getScursor();
+  // reuse the fragment spectra of previously loaded impulses (NULL disables)
+  void setFragCache(_FV3_(fragcache) * cache);
+  _FV3_(fragcache) * getFragCache();
+  // spread the large fragment work evenly over the samples of a large block
+  // (the short fragments cover 2*lFragmentSize of the head)
+  virtual void setScheduled(bool on);
+  bool getScheduled();
   
  protected:
   virtual void processZL(_fv3_float_t *inputL, long numsamples);
   
-  void allocFrags(std::vector<_FV3_(frag)*> *to, const _fv3_float_t *inputL, long fragSize, long num, long mod, unsigned fftflags, _fv3_float_t * preAllocL)
+  void loadImpulseFrom(const _fv3_float_t * inputL, _FV3_(irsource) * source, long channel, long size)
+    throw(std::bad_alloc);
+  void allocFrags(std::vector<_FV3_(frag)*> *to, const _fv3_float_t *inputL, _FV3_(irsource) * source, long channel, long offset,
+                  long fragSize, long num, long mod, unsigned fftflags, _fv3_float_t * preAllocL)
+    throw(std::bad_alloc);
+  void registerFrags(std::vector<_FV3_(frag)*> *to, long fragSize, long num, _fv3_float_t * preAllocL)
     throw(std::bad_alloc);
   void freeFrags(std::vector<_FV3_(frag)*> *v);
   void allocSlots(long ssize, long lsize)
@@ -52,6 +67,9 @@ class _FV3_(irmodel3m) : public _FV3_(irbasem)
   std::vector<_FV3_(frag)*> sFragments, lFragments;
   _FV3_(fragfft) sFragmentsFFT, lFragmentsFFT;
   _FV3_(blockDelay) sBlockDelayL, lBlockDelayL;
+  _FV3_(fragcache) * fragCache;
+  bool scheduled;
+  _FV3_(fragsched) lScheduler;
 
  private:
   _FV3_(irmodel3m)(const _FV3_(irmodel3m)& x);
@@ -65,10 +83,15 @@ class _FV3_(irmodel3) : public _FV3_(irmodel1)
   virtual _FV3_(~irmodel3)();
   virtual void loadImpulse(const _fv3_float_t * inputL, const _fv3_float_t * inputR, long size)
     throw(std::bad_alloc);
+  // mono sources feed both channels
+  virtual void loadImpulse(_FV3_(irsource) * source)
+    throw(std::bad_alloc);
   using _FV3_(irbase)::processreplace;
   virtual void processreplace(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
   
   virtual void setFragmentSize(long size, long factor);
+  void setFragCache(_FV3_(fragcache) * cache);
+  void setScheduled(bool on);
   
   long getSFragmentSize();
   long getLFragmentSize(); 
@@ -26,6 +26,7 @@
 static void * irmodel3p_lfthread(void *vdParam)
 {
   FV3_(lfThreadInfoW) *info = (FV3_(lfThreadInfoW)*)vdParam;
+  FV3_TRACE_THREAD("irmodel3p.worker");
   while(1)
     {
       sleep(0);
@@ -34,9 +35,11 @@ static void * irmodel3p_lfthread(void *vdParam)
       if(*info->flags & FV3_IR3P_THREAD_FLAG_RUN)
         {
           info->threadSection->lock();
-          if(info->lFragments->size() > 0)
+          long ready = __atomic_load_n(info->lReady, __ATOMIC_ACQUIRE);
+          if(ready > 0)
             {
-              for(long i = 0;i < (long)info->lFragments->size()-1;i ++)
+              FV3_TRACE_SCOPE_ARG("irmodel3p.lfragments", ready-1);
+              for(long i = 0;i < ready-1;i ++)
                 {
                   if((long)info->lFragments->size() > i+1)
                     {
@@ -65,12 +68,18 @@ FV3_(irmodel3pm)::FV3_(irmodel3pm)()
   validThread = false;
   hostThreadData.lFragmentSize = &lFragmentSize;
   hostThreadData.lFragments = &lFragments;
+  hostThreadData.lReady = &lReady;
   hostThreadData.lBlockDelayL = &lBlockDelayL;
   hostThreadData.lSwapL = &lSwapSlot.L;
   hostThreadData.flags = &threadFlags;
   hostThreadData.threadSection = &threadSection;
   hostThreadData.event_StartThread = &event_StartThread;
   hostThreadData.event_ThreadEnded = &event_ThreadEnded;
+  lReady = 0;
+  prepareInput = NULL;
+  prepareSource = NULL;
+  prepareChannel = prepareNum = prepareMod = 0;
+  prepareKey = 0;
   resume();
 }
 
@@ -123,6 +132,29 @@ void FV3_(irmodel3pm)::loadImpulse(const fv3_float_t * inputL, long size)
       mainSection.unlock();
       throw;
     }
+  __atomic_store_n(&lReady, (long)lFragments.size(), __ATOMIC_RELEASE);
+  threadSection.unlock();
+  mainSection.unlock();
+  resume();
+}
+
+void FV3_(irmodel3pm)::loadImpulse(FV3_(irsource) * source, long channel)
+  throw(std::bad_alloc)
+{
+  suspend();
+  mainSection.lock();
+  threadSection.lock();
+  try
+    {
+      FV3_(irmodel3m)::loadImpulse(source, channel);
+    }
+  catch(std::bad_alloc&)
+    {
+      threadSection.unlock();
+      mainSection.unlock();
+      throw;
+    }
+  __atomic_store_n(&lReady, (long)lFragments.size(), __ATOMIC_RELEASE);
   threadSection.unlock();
   mainSection.unlock();
   resume();
@@ -133,17 +165,150 @@ void FV3_(irmodel3pm)::unloadImpulse()
   suspend();
   mainSection.lock();
   threadSection.lock();
+  __atomic_store_n(&lReady, 0L, __ATOMIC_RELEASE);
   FV3_(irmodel3m)::unloadImpulse();
   threadSection.unlock();
   mainSection.unlock();
   resume();
 }
 
+void FV3_(irmodel3pm)::prepareImpulse(const fv3_float_t * inputL, FV3_(irsource) * source, long channel, long size)
+  throw(std::bad_alloc)
+{
+  if(size <= 0) return;
+  mainSection.lock();
+  threadSection.lock();
+  __atomic_store_n(&lReady, 0L, __ATOMIC_RELEASE);
+  FV3_(irmodel3m)::unloadImpulse();
+  impulseSize = size;
+  long sFragmentNum = 0, sFragmentMod = 0;
+  if(size <= lFragmentSize)
+    {
+      sFragmentNum = size / sFragmentSize;
+      sFragmentMod = size % sFragmentSize;
+      prepareNum = 0, prepareMod = 0;
+    }
+  else
+    {
+      sFragmentNum = lFragmentSize / sFragmentSize;
+      prepareNum = size / lFragmentSize - 1;
+      prepareMod = size % lFragmentSize;
+    }
+  long sBlocks = sFragmentNum + (sFragmentMod != 0 ? 1 : 0), lBlocks = prepareNum + (prepareMod != 0 ? 1 : 0);
+  bool cached = false;
+  try
+    {
+      allocSlots(sFragmentSize, lFragmentSize);
+      sFragmentsFFT.setSIMD(simdFlag1, simdFlag2);
+      sFragmentsFFT.allocFFT(sFragmentSize, fftflags);
+      lFragmentsFFT.setSIMD(simdFlag1, simdFlag2);
+      lFragmentsFFT.allocFFT(lFragmentSize, fftflags);
+      setSIMD(sFragmentsFFT.getSIMD(0),sFragmentsFFT.getSIMD(1));
+      sImpulseFFTBlock.alloc(sFragmentSize*2*(sFragmentNum+1), 1);
+      lImpulseFFTBlock.alloc(lFragmentSize*2*(prepareNum+1), 1);
+      long simdSize = sFragmentsFFT.getSIMDSize();
+      if(fragCache != NULL)
+        {
+          prepareKey = fragCache->getKey(inputL, source, channel, size, sFragmentSize, lFragmentSize, simdSize);
+          cached = fragCache->load(prepareKey, size, sFragmentSize, sBlocks, sImpulseFFTBlock.L, lFragmentSize, lBlocks, lImpulseFFTBlock.L, simdSize);
+        }
+      if(cached)
+        {
+          registerFrags(&sFragments, sFragmentSize, sBlocks, sImpulseFFTBlock.L);
+          registerFrags(&lFragments, lFragmentSize, lBlocks, lImpulseFFTBlock.L);
+        }
+      else
+        {
+          allocFrags(&sFragments, inputL, source, channel, 0, sFragmentSize, sFragmentNum, sFragmentMod, fftflags, sImpulseFFTBlock.L);
+          // the large fragments are created empty and transformed by prepareNext()
+          for(long i = 0;i < lBlocks;i ++)
+            {
+              FV3_(frag) * f = new FV3_(frag);
+              lFragments.push_back(f);
+              f->setSIMD(simdFlag1, simdFlag2);
+            }
+        }
+      sBlockDelayL.setBlock(sFragmentSize*2, (long)sFragments.size());
+      lBlockDelayL.setBlock(lFragmentSize*2, (long)lFragments.size());
+      latency = 0;
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3pm::prepareImpulse(%ld) bad_alloc\n", size);
+      FV3_(irmodel3m)::unloadImpulse();
+      threadSection.unlock();
+      mainSection.unlock();
+      throw;
+    }
+  prepareInput = cached ? NULL : inputL;
+  prepareSource = cached ? NULL : source;
+  prepareChannel = channel;
+  FV3_(irmodel3m)::mute();
+  if(cached)
+    __atomic_store_n(&lReady, lBlocks, __ATOMIC_RELEASE);
+  else if(lBlocks == 0)
+    storeCache();
+  threadSection.unlock();
+  mainSection.unlock();
+}
+
+bool FV3_(irmodel3pm)::prepareNext()
+  throw(std::bad_alloc)
+{
+  long i = readyFragments();
+  if(i >= (long)lFragments.size()) return false;
+  // only fragments beyond lReady are written here, the audio and worker threads read the ones below it
+  long offset = lFragmentSize*(i+1), limit = i < prepareNum ? lFragmentSize : prepareMod;
+  if(prepareSource != NULL)
+    {
+      prepareSource->prefetch(offset+lFragmentSize, lFragmentSize);
+      lFragments[i]->loadImpulse(prepareSource, prepareChannel, offset, lFragmentSize, limit, fftflags, lImpulseFFTBlock.L+lFragmentSize*2*i);
+    }
+  else
+    lFragments[i]->loadImpulse(prepareInput+offset, lFragmentSize, limit, fftflags, lImpulseFFTBlock.L+lFragmentSize*2*i);
+  __atomic_store_n(&lReady, i+1, __ATOMIC_RELEASE);
+  if(i+1 < (long)lFragments.size()) return true;
+  prepareInput = NULL;
+  prepareSource = NULL;
+  storeCache();
+  return false;
+}
+
+void FV3_(irmodel3pm)::storeCache()
+{
+  if(fragCache == NULL) return;
+  fragCache->store(prepareKey, impulseSize, sFragmentSize, (long)sFragments.size(), sImpulseFFTBlock.L,
+                   lFragmentSize, (long)lFragments.size(), lImpulseFFTBlock.L, sFragmentsFFT.getSIMDSize());
+}
+
+long FV3_(irmodel3pm)::readyFragments()
+{
+  return __atomic_load_n(&lReady, __ATOMIC_ACQUIRE);
+}
+
 void FV3_(irmodel3pm)::setFragmentSize(long size, long factor)
 {
   mainSection.lock();
   threadSection.lock();
   FV3_(irmodel3m)::setFragmentSize(size, factor);
+  if(impulseSize == 0) __atomic_store_n(&lReady, 0L, __ATOMIC_RELEASE);
+  threadSection.unlock();
+  mainSection.unlock();
+}
+
+void FV3_(irmodel3pm)::setScheduled(bool on)
+{
+  // processZL() never runs lScheduler, a scheduled load would lose the tail.
+  if(on)
+    {
+#ifdef DEBUG
+      std::fprintf(stderr, "irmodel3pm::setScheduled(true) ignored, the worker thread runs the large fragments\n");
+#endif
+      return;
+    }
+  mainSection.lock();
+  threadSection.lock();
+  FV3_(irmodel3m)::setScheduled(false);
   threadSection.unlock();
   mainSection.unlock();
 }
@@ -171,11 +336,13 @@ void FV3_(irmodel3pm)::processZL(fv3_float_t *inputL, long numsamples)
     {
       lFrameSlot.mute(lFragmentSize);
       lReverseSlot.mute(lFragmentSize-1, lFragmentSize+1);
+      FV3_TRACE_BEGIN("irmodel3p.wait");
       event_ThreadEnded.wait();
+      FV3_TRACE_END("irmodel3p.wait");
       event_ThreadEnded.reset();
       threadSection.lock();
       lBlockDelayL.push(lIFFTSlot.L);
-      lFragments[0]->MULT(lBlockDelayL.get(0), lSwapSlot.L);
+      if(readyFragments() > 0) lFragments[0]->MULT(lBlockDelayL.get(0), lSwapSlot.L);
       lFragmentsFFT.HC2R(lSwapSlot.L, lReverseSlot.L);
       lSwapSlot.mute(lFragmentSize*2);
       threadSection.unlock();
@@ -257,12 +424,21 @@ FV3_(irmodel3p)::FV3_(irmodel3p)()
       delete irmR;
       throw;
     }
+  shadowL = shadowR = NULL;
+  retiredL = retiredR = NULL;
+  pendingSource = NULL;
+  pendingSize = fadeCount = 0;
+  fadeLength = FV3_IR3P_DFadeLength;
+  swapState = FV3_IR3P_SWAP_IDLE;
+  loaderAbort = 0;
+  validLoader = false;
   // REAPER only calls resume() on on/off load.
   resume();
 }
 
 FV3_(irmodel3p)::FV3_(~irmodel3p)()
 {
+  stopLoader(true);
   // REAPER does not call suspend().
   suspend();
 }
@@ -270,28 +446,272 @@ FV3_(irmodel3p)::FV3_(~irmodel3p)()
 void FV3_(irmodel3p)::loadImpulse(const fv3_float_t * inputL, const fv3_float_t * inputR, long size)
   throw(std::bad_alloc)
 {
-  suspend();
+  if(size <= 0||getSFragmentSize() < FV3_IR_Min_FragmentSize||getLFragmentSize() < FV3_IR_Min_FragmentSize) return;
+  stopLoader(true);
   mainSection.lock();
   try
     {
-      FV3_(irmodel3)::loadImpulse(inputL, inputR, size);
+      // the caller may free the impulse while the loader thread is running
+      pendingSlot.alloc(size, 2);
+      std::memcpy(pendingSlot.L, inputL, sizeof(fv3_float_t)*size);
+      std::memcpy(pendingSlot.R, inputR, sizeof(fv3_float_t)*size);
+      pendingSource = NULL;
+      startLoader(size);
     }
   catch(std::bad_alloc&)
     {
+      pendingSlot.free();
       mainSection.unlock();
       throw;
     }
   mainSection.unlock();
-  resume();
+}
+
+void FV3_(irmodel3p)::loadImpulse(FV3_(irsource) * source)
+  throw(std::bad_alloc)
+{
+  if(source == NULL||!source->isOpen()) return;
+  long size = source->getSize();
+  if(size <= 0||getSFragmentSize() < FV3_IR_Min_FragmentSize||getLFragmentSize() < FV3_IR_Min_FragmentSize) return;
+  stopLoader(true);
+  mainSection.lock();
+  try
+    {
+      pendingSource = source;
+      startLoader(size);
+    }
+  catch(std::bad_alloc&)
+    {
+      pendingSource = NULL;
+      mainSection.unlock();
+      throw;
+    }
+  mainSection.unlock();
+}
+
+void FV3_(irmodel3p)::startLoader(long size)
+  throw(std::bad_alloc)
+{
+  if(impulseSize == 0)
+    {
+      // nothing is running, the first impulse is switched in without a crossfade
+      inputW.alloc(getSFragmentSize(), 2);
+      inputD.alloc(getSFragmentSize(), 2);
+      fadeSlot.alloc(getSFragmentSize(), 2);
+      FV3_(irbase)::setInitialDelay(getInitialDelay());
+      FV3_(irmodel1)::mute();
+    }
+  pendingSize = size;
+  fadeCount = 0;
+  loaderAbort = 0;
+  swapState = FV3_IR3P_SWAP_LOAD;
+  if(pthread_create(&loaderHandle, NULL, FV3_(irmodel3p)::loaderThread, this) != 0)
+    {
+      std::fprintf(stderr, "irmodel3p::loadImpulse(%ld) pthread_create failed\n", size);
+      swapState = FV3_IR3P_SWAP_IDLE;
+      throw std::bad_alloc();
+    }
+  validLoader = true;
+}
+
+void * FV3_(irmodel3p)::loaderThread(void * vdParam)
+{
+  FV3_(irmodel3p) * ir = (FV3_(irmodel3p)*)vdParam;
+  FV3_(irmodel3pm) *L = NULL, *R = NULL;
+  FV3_TRACE_THREAD("irmodel3p.loader");
+  FV3_TRACE_BEGIN("irmodel3p.prepareImpulse");
+  try
+    {
+      L = new FV3_(irmodel3pm);
+      R = new FV3_(irmodel3pm);
+      L->setFragmentSize(ir->getSFragmentSize(), ir->getLFragmentSize()/ir->getSFragmentSize());
+      R->setFragmentSize(ir->getSFragmentSize(), ir->getLFragmentSize()/ir->getSFragmentSize());
+      L->setFFTFlags(ir->getFFTFlags()), R->setFFTFlags(ir->getFFTFlags());
+      L->setSIMD(ir->getSIMD(0), ir->getSIMD(1)), R->setSIMD(ir->getSIMD(0), ir->getSIMD(1));
+      L->setFragCache(ir->ir3mL->getFragCache()), R->setFragCache(ir->ir3mR->getFragCache());
+      if(ir->pendingSource != NULL)
+        {
+          L->prepareImpulse(NULL, ir->pendingSource, 0, ir->pendingSize);
+          R->prepareImpulse(NULL, ir->pendingSource, ir->pendingSource->getChannels() > 1 ? 1 : 0, ir->pendingSize);
+        }
+      else
+        {
+          L->prepareImpulse(ir->pendingSlot.L, NULL, 0, ir->pendingSize);
+          R->prepareImpulse(ir->pendingSlot.R, NULL, 0, ir->pendingSize);
+        }
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3p::loaderThread(%ld) bad_alloc\n", ir->pendingSize);
+      FV3_TRACE_END("irmodel3p.prepareImpulse");
+      delete L;
+      delete R;
+      __atomic_store_n(&ir->swapState, FV3_IR3P_SWAP_IDLE, __ATOMIC_RELEASE);
+      pthread_exit(NULL);
+      return 0;
+    }
+
+  FV3_TRACE_END("irmodel3p.prepareImpulse");
+  // The head is ready, the audio thread starts the crossfade.
+  ir->shadowL = L, ir->shadowR = R;
+  __atomic_store_n(&ir->swapState, FV3_IR3P_SWAP_FADE, __ATOMIC_RELEASE);
+
+  try
+    {
+      bool moreL = true, moreR = true;
+      while((moreL||moreR)&&ir->loaderAbort < 2)
+        {
+          FV3_TRACE_SCOPE("irmodel3p.prepareNext");
+          if(moreL) moreL = L->prepareNext();
+          if(moreR) moreR = R->prepareNext();
+        }
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3p::loaderThread(%ld) bad_alloc, the tail is truncated\n", ir->pendingSize);
+    }
+
+  // The retired convolvers are released here, not in the audio thread.
+  while(__atomic_load_n(&ir->swapState, __ATOMIC_ACQUIRE) == FV3_IR3P_SWAP_FADE&&ir->loaderAbort == 0) usleep(1000);
+  if(__atomic_load_n(&ir->swapState, __ATOMIC_ACQUIRE) == FV3_IR3P_SWAP_DONE)
+    {
+      delete ir->retiredL, ir->retiredL = NULL;
+      delete ir->retiredR, ir->retiredR = NULL;
+      __atomic_store_n(&ir->swapState, FV3_IR3P_SWAP_IDLE, __ATOMIC_RELEASE);
+    }
+  pthread_exit(NULL);
+  return 0;
+}
+
+void FV3_(irmodel3p)::stopLoader(bool abort)
+{
+  if(validLoader == false) return;
+  // 1: do not wait for the crossfade, 2: drop the rest of the tail too
+  loaderAbort = abort ? 2 : 1;
+  pthread_join(loaderHandle, NULL);
+  validLoader = false;
+  loaderAbort = 0;
+  swapSection.lock();
+  if(swapState == FV3_IR3P_SWAP_FADE)
+    {
+      // the audio thread did not run (long enough) to finish the crossfade,
+      // an aborted shadow may miss tail fragments and is dropped
+      if(abort)
+        {
+          delete shadowL, shadowL = NULL;
+          delete shadowR, shadowR = NULL;
+          fadeCount = 0;
+        }
+      else
+        adoptShadow();
+    }
+  if(swapState == FV3_IR3P_SWAP_DONE)
+    {
+      delete retiredL, retiredL = NULL;
+      delete retiredR, retiredR = NULL;
+    }
+  swapState = FV3_IR3P_SWAP_IDLE;
+  swapSection.unlock();
+  pendingSlot.free();
+  pendingSource = NULL;
+}
+
+void FV3_(irmodel3p)::adoptShadow()
+{
+  retiredL = ir3mL, retiredR = ir3mR;
+  ir3mL = shadowL, ir3mR = shadowR;
+  irmL = ir3mL, irmR = ir3mR;
+  shadowL = shadowR = NULL;
+  impulseSize = pendingSize;
+  fadeCount = 0;
+  __atomic_store_n(&swapState, FV3_IR3P_SWAP_DONE, __ATOMIC_RELEASE);
+}
+
+void FV3_(irmodel3p)::waitLoad()
+{
+  stopLoader(false);
+}
+
+bool FV3_(irmodel3p)::isLoading()
+{
+  return __atomic_load_n(&swapState, __ATOMIC_ACQUIRE) != FV3_IR3P_SWAP_IDLE;
+}
+
+void FV3_(irmodel3p)::setCrossfadeLength(long numsamples)
+{
+  if(numsamples < 0) numsamples = 0;
+  __atomic_store_n(&fadeLength, numsamples, __ATOMIC_RELAXED);
+}
+
+long FV3_(irmodel3p)::getCrossfadeLength(){ return __atomic_load_n(&fadeLength, __ATOMIC_RELAXED); }
+
+void FV3_(irmodel3p)::processreplace(const fv3_float_t *inputL, const fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+{
+  // The loader thread never takes this lock. Only the host calls which
+  // replace or rebuild the convolvers do, the audio thread does not wait
+  // for them and outputs silence for that block.
+  FV3_TRACE_SCOPE_ARG("irmodel3p.process", numsamples);
+  if(!swapSection.trylock())
+    {
+      FV3_(utils)::mute(outputL, numsamples), FV3_(utils)::mute(outputR, numsamples);
+      return;
+    }
+  if(__atomic_load_n(&swapState, __ATOMIC_ACQUIRE) == FV3_IR3P_SWAP_FADE&&(impulseSize == 0||getCrossfadeLength() == 0))
+    adoptShadow();
+  FV3_(irmodel3)::processreplace(inputL, inputR, outputL, outputR, numsamples);
+  swapSection.unlock();
+}
+
+void FV3_(irmodel3p)::processreplaceS(const fv3_float_t *inputL, const fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+{
+  if(numsamples <= 0||impulseSize <= 0) return;
+  if(__atomic_load_n(&swapState, __ATOMIC_ACQUIRE) != FV3_IR3P_SWAP_FADE)
+    {
+      FV3_(irmodel1)::processreplaceS(inputL, inputR, outputL, outputR, numsamples);
+      return;
+    }
+
+  if((processoptions & FV3_IR_MONO2STEREO) != 0)
+    {
+      for(long i = 0;i < numsamples;i ++) inputW.L[i] = inputW.R[i] = (inputL[i] + inputR[i])/2.0;
+    }
+  else
+    {
+      std::memcpy(inputW.L, inputL, sizeof(fv3_float_t)*numsamples);
+      std::memcpy(inputW.R, inputR, sizeof(fv3_float_t)*numsamples);
+    }
+  std::memcpy(inputD.L, inputL, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(inputD.R, inputR, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(fadeSlot.L, inputW.L, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(fadeSlot.R, inputW.R, sizeof(fv3_float_t)*numsamples);
+
+  irmL->processreplace(inputW.L, numsamples);
+  irmR->processreplace(inputW.R, numsamples);
+  shadowL->processreplace(fadeSlot.L, numsamples);
+  shadowR->processreplace(fadeSlot.R, numsamples);
+
+  // linear (equal gain) crossfade
+  long length = getCrossfadeLength();
+  for(long i = 0;i < numsamples;i ++)
+    {
+      fv3_float_t g = fadeCount+i < length ? (fv3_float_t)(fadeCount+i)/(fv3_float_t)length : 1;
+      inputW.L[i] = (1-g)*inputW.L[i] + g*fadeSlot.L[i];
+      inputW.R[i] = (1-g)*inputW.R[i] + g*fadeSlot.R[i];
+    }
+  fadeCount += numsamples;
+  if(fadeCount >= length) adoptShadow();
+
+  processdrywetout(inputD.L, inputD.R, inputW.L, inputW.R, outputL, outputR, numsamples);
 }
 
 void FV3_(irmodel3p)::unloadImpulse()
 {
-  suspend();
+  stopLoader(true);
+  swapSection.lock();
   mainSection.lock();
   FV3_(irmodel3)::unloadImpulse();
   mainSection.unlock();
-  resume();
+  swapSection.unlock();
 }
 
 void FV3_(irmodel3p)::resume()
@@ -310,25 +730,44 @@ void FV3_(irmodel3p)::suspend()
 
 void FV3_(irmodel3p)::mute()
 {
+  // The loader keeps transforming the tail. A pending crossfade has nothing
+  // left to fade, the shadow is switched in at once.
+  swapSection.lock();
+  if(__atomic_load_n(&swapState, __ATOMIC_ACQUIRE) == FV3_IR3P_SWAP_FADE) adoptShadow();
   mainSection.lock();
   FV3_(irmodel3)::mute();
   mainSection.unlock();
+  swapSection.unlock();
 }
 
 void FV3_(irmodel3p)::setFragmentSize(long size, long factor)
 {
+  stopLoader(true);
+  swapSection.lock();
   mainSection.lock();
   FV3_(irmodel3)::setFragmentSize(size, factor);
   mainSection.unlock();
+  swapSection.unlock();
 }
 
 void FV3_(irmodel3p)::setInitialDelay(long numsamples)
   throw(std::bad_alloc)
 {
+  // the delay lines are reallocated, processreplace() must not run
+  swapSection.lock();
   mainSection.lock();
-  FV3_(irbase)::setInitialDelay(numsamples);
+  try
+    {
+      FV3_(irbase)::setInitialDelay(numsamples);
+    }
+  catch(std::bad_alloc&)
+    {
+      mainSection.unlock();
+      swapSection.unlock();
+      throw;
+    }
   mainSection.unlock();
+  swapSection.unlock();
 }
 
 #include "freeverb/fv3_ns_end.h"
-
@@ -42,11 +42,19 @@
 #include <unistd.h>
 #include <pthread.h>
 #include "freeverb/fv3_pthread_tool.hpp"
+#include "freeverb/fv3_trace.hpp"
 
 #define FV3_IR3P_THREAD_FLAG_0    (0U)
 #define FV3_IR3P_THREAD_FLAG_EXIT (1U << 1)
 #define FV3_IR3P_THREAD_FLAG_RUN  (1U << 2)
 
+#define FV3_IR3P_SWAP_IDLE 0
+#define FV3_IR3P_SWAP_LOAD 1
+#define FV3_IR3P_SWAP_FADE 2
+#define FV3_IR3P_SWAP_DONE 3
+
+#define FV3_IR3P_DFadeLength 2048
+
 namespace fv3
 {
 
@@ -21,6 +21,7 @@
 typedef struct {
   long * lFragmentSize;
   std::vector<_FV3_(frag)*> *lFragments;
+  volatile long *lReady;
   _FV3_(blockDelay) *lBlockDelayL;
   _fv3_float_t **lSwapL;
   volatile int *flags;
@@ -35,14 +36,37 @@ class _FV3_(irmodel3pm) : public _FV3_(irmodel3m)
   virtual _FV3_(~irmodel3pm)();
   virtual void loadImpulse(const _fv3_float_t * inputL, long size)
     throw(std::bad_alloc);
+  virtual void loadImpulse(_FV3_(irsource) * source, long channel)
+    throw(std::bad_alloc);
   virtual void unloadImpulse();
   virtual void resume();
   virtual void suspend();
   virtual void mute();
   virtual void setFragmentSize(long size, long factor);
+  // the large fragments are already processed by the worker thread,
+  // setScheduled(true) is refused and the scheduled mode stays off
+  virtual void setScheduled(bool on);
+  // Incremental load for a convolver which may already be running.
+  // prepareImpulse() builds the buffers and the short fragments, then each
+  // prepareNext() call transforms one large fragment (false when complete).
+  // A large fragment is audible as soon as it has been transformed. With a
+  // fragment cache a hit makes every fragment ready in prepareImpulse(),
+  // a miss is stored once the last one is transformed.
+  void prepareImpulse(const _fv3_float_t * inputL, _FV3_(irsource) * source, long channel, long size)
+    throw(std::bad_alloc);
+  bool prepareNext()
+    throw(std::bad_alloc);
   
  protected:
   virtual void processZL(_fv3_float_t *inputL, long numsamples);
+  long readyFragments();
+  void storeCache();
+
+  volatile long lReady;
+  const _fv3_float_t * prepareInput;
+  _FV3_(irsource) * prepareSource;
+  long prepareChannel, prepareNum, prepareMod;
+  uint64_t prepareKey;
 
   bool validThread;
   _FV3_(lfThreadInfoW) hostThreadData;
@@ -63,6 +87,8 @@ class _FV3_(irmodel3p) : public _FV3_(irmodel3)
   virtual _FV3_(~irmodel3p)();
   virtual void loadImpulse(const _fv3_float_t * inputL, const _fv3_float_t * inputR, long size)
     throw(std::bad_alloc);
+  virtual void loadImpulse(_FV3_(irsource) * source)
+    throw(std::bad_alloc);
   virtual void unloadImpulse();
   virtual void resume();
   virtual void suspend();
@@ -70,9 +96,36 @@ class _FV3_(irmodel3p) : public _FV3_(irmodel3)
   virtual void setFragmentSize(long size, long factor);
   virtual void setInitialDelay(long numsamples)
     throw(std::bad_alloc);
+  using _FV3_(irbase)::processreplace;
+  virtual void processreplace(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
+  virtual void processreplaceS(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
+
+  // loadImpulse() only starts a loader thread which builds a shadow
+  // convolver. The new impulse is crossfaded in as soon as its head is ready
+  // and the tail fragments are added while they are transformed.
+  // The source must stay open until isLoading() returns false.
+  void setCrossfadeLength(long numsamples);
+  long getCrossfadeLength();
+  bool isLoading();
+  // wait for the loader thread and complete a pending swap
+  void waitLoad();
   
  protected:
-  PthreadLocker mainSection;
+  static void * loaderThread(void * vdParam);
+  void startLoader(long size)
+    throw(std::bad_alloc);
+  void stopLoader(bool abort);
+  void adoptShadow();
+
+  PthreadLocker mainSection, swapSection;
+  _FV3_(irmodel3pm) *shadowL, *shadowR;
+  _FV3_(irmodel3m) *retiredL, *retiredR;
+  _FV3_(slot) pendingSlot, fadeSlot;
+  _FV3_(irsource) * pendingSource;
+  long pendingSize, fadeLength, fadeCount;
+  volatile int swapState, loaderAbort;
+  bool validLoader;
+  pthread_t loaderHandle;
 
  private:
   _FV3_(irmodel3p)(const _FV3_(irmodel3)& x);
@@ -0,0 +1,423 @@
+/**
+ *  Impulse Response Processor model implementation
+ *  True Stereo Low Latency Version
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "freeverb/irmodel3ts.hpp"
+#include "freeverb/fv3_type_float.h"
+#include "freeverb/fv3_ns_start.h"
+
+// Each input channel is transformed once per block and its spectrum is reused
+// by both of its paths (L->L/L->R, R->L/R->R). The two paths which feed an
+// output channel are accumulated in the frequency domain, so a block costs two
+// forward and two inverse FFTs instead of four of each.
+
+FV3_(irmodel3ts)::FV3_(irmodel3ts)()
+{
+  sFragmentSize = lFragmentSize = 0;
+  sFragmentNum = lFragmentNum = 0;
+  Scursor = Lcursor = Lstep = 0;
+  sFramePointerL = sFramePointerR = NULL;
+  FV3_(irmodel3ts)::setFragmentSize(FV3_IR3_DFragmentSize, FV3_IR3_DefaultFactor);
+}
+
+FV3_(irmodel3ts)::FV3_(~irmodel3ts)()
+{
+  FV3_(irmodel3ts)::unloadImpulse();
+}
+
+void FV3_(irmodel3ts)::loadImpulse(const fv3_float_t * inputL, const fv3_float_t * inputR, long size)
+  throw(std::bad_alloc)
+{
+  const fv3_float_t * inputs[FV3_IR3TS_PATHS] = { inputL, NULL, NULL, inputR, };
+  const long channels[FV3_IR3TS_PATHS] = { 0, 0, 0, 0, };
+  loadImpulseFrom(inputs, NULL, channels, size);
+}
+
+void FV3_(irmodel3ts)::loadImpulse(const fv3_float_t * inputLL, const fv3_float_t * inputLR,
+                                   const fv3_float_t * inputRL, const fv3_float_t * inputRR, long size)
+  throw(std::bad_alloc)
+{
+  const fv3_float_t * inputs[FV3_IR3TS_PATHS] = { inputLL, inputLR, inputRL, inputRR, };
+  const long channels[FV3_IR3TS_PATHS] = { 0, 0, 0, 0, };
+  loadImpulseFrom(inputs, NULL, channels, size);
+}
+
+void FV3_(irmodel3ts)::loadImpulse(FV3_(irsource) * source)
+  throw(std::bad_alloc)
+{
+  if(source == NULL||!source->isOpen()) return;
+  const fv3_float_t * inputs[FV3_IR3TS_PATHS] = { NULL, NULL, NULL, NULL, };
+  long ch = source->getChannels();
+  long channels[FV3_IR3TS_PATHS] = { 0, -1, -1, 0, };
+  if(ch >= 4)
+    channels[FV3_IR3TS_LR] = 1, channels[FV3_IR3TS_RL] = 2, channels[FV3_IR3TS_RR] = 3;
+  else if(ch >= 2)
+    channels[FV3_IR3TS_RR] = 1;
+  loadImpulseFrom(inputs, source, channels, source->getSize());
+}
+
+void FV3_(irmodel3ts)::loadImpulseFrom(const fv3_float_t * const inputs[FV3_IR3TS_PATHS], FV3_(irsource) * source,
+                                       const long channels[FV3_IR3TS_PATHS], long size)
+  throw(std::bad_alloc)
+{
+  if(size <= 0||sFragmentSize < FV3_IR_Min_FragmentSize||lFragmentSize < FV3_IR_Min_FragmentSize) return;
+  FV3_(irmodel3ts)::unloadImpulse();
+
+  long sNum = 0, lNum = 0, sMod = 0, lMod = 0;
+  if(size <= lFragmentSize)
+    {
+      sNum = size / sFragmentSize;
+      sMod = size % sFragmentSize;
+    }
+  else
+    {
+      sNum = lFragmentSize / sFragmentSize;
+      lNum = size / lFragmentSize - 1;
+      lMod = size % lFragmentSize;
+    }
+
+#ifdef DEBUG
+  std::fprintf(stderr, "irmodel3ts::loadImpulse(): {L%ldx%ld+%ld/S%ldx%ld+%ld}\n", lFragmentSize, lNum, lMod, sFragmentSize, sNum, sMod);
+#endif
+
+  try
+    {
+      allocSlots(sFragmentSize, lFragmentSize);
+      sFragmentsFFT.setSIMD(simdFlag1, simdFlag2);
+      sFragmentsFFT.allocFFT(sFragmentSize, fftflags);
+      lFragmentsFFT.setSIMD(simdFlag1, simdFlag2);
+      lFragmentsFFT.allocFFT(lFragmentSize, fftflags);
+
+      for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+        {
+          if(source != NULL ? channels[p] < 0 : inputs[p] == NULL) continue;
+          sImpulseFFTBlock[p].alloc(sFragmentSize*2*(sNum+1), 1);
+          allocFrags(&sFragments[p], inputs[p], source, channels[p], 0, sFragmentSize, sNum, sMod, sImpulseFFTBlock[p].L);
+          if(size > lFragmentSize)
+            {
+              lImpulseFFTBlock[p].alloc(lFragmentSize*2*(lNum+1), 1);
+              allocFrags(&lFragments[p], inputs[p], source, channels[p], lFragmentSize, lFragmentSize, lNum, lMod, lImpulseFFTBlock[p].L);
+            }
+        }
+
+      sFragmentNum = sNum + (sMod != 0 ? 1 : 0);
+      lFragmentNum = lNum + (lMod != 0 ? 1 : 0);
+      sBlockDelayL.setBlock(sFragmentSize*2, sFragmentNum);
+      sBlockDelayR.setBlock(sFragmentSize*2, sFragmentNum);
+      lBlockDelayL.setBlock(lFragmentSize*2, lFragmentNum);
+      lBlockDelayR.setBlock(lFragmentSize*2, lFragmentNum);
+      inputW.alloc(sFragmentSize, 2);
+      inputD.alloc(sFragmentSize, 2);
+      impulseSize = size;
+      latency = 0;
+      FV3_(irbase)::setInitialDelay(getInitialDelay());
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3ts::loadImpulse(%ld) bad_alloc\n", size);
+      FV3_(irmodel3ts)::unloadImpulse();
+      throw;
+    }
+  FV3_(irmodel3ts)::mute();
+}
+
+void FV3_(irmodel3ts)::unloadImpulse()
+{
+  if(impulseSize == 0) return;
+  impulseSize = 0;
+  for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+    {
+      freeFrags(&sFragments[p]);
+      freeFrags(&lFragments[p]);
+      sImpulseFFTBlock[p].free();
+      lImpulseFFTBlock[p].free();
+    }
+  freeSlots();
+  sFragmentsFFT.freeFFT();
+  lFragmentsFFT.freeFFT();
+  inputW.free();
+  inputD.free();
+  sFragmentNum = lFragmentNum = 0;
+}
+
+void FV3_(irmodel3ts)::allocFrags(std::vector<FV3_(frag)*> *to, const fv3_float_t *input, FV3_(irsource) * source, long channel, long offset,
+                                  long fragSize, long num, long mod, fv3_float_t * preAllocL)
+  throw(std::bad_alloc)
+{
+  try
+    {
+      for(long i = 0;i <= num;i ++)
+        {
+          long limit = i < num ? fragSize : mod;
+          if(limit == 0) break;
+          FV3_(frag) * f = new FV3_(frag);
+          to->push_back(f);
+          f->setSIMD(simdFlag1, simdFlag2);
+          if(source != NULL)
+            f->loadImpulse(source, channel, offset+fragSize*i, fragSize, limit, fftflags, preAllocL+fragSize*2*i);
+          else
+            f->loadImpulse(input+offset+fragSize*i, fragSize, limit, fftflags, preAllocL+fragSize*2*i);
+        }
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodel3ts::allocFrags(%ld) bad_alloc\n", fragSize);
+      freeFrags(to);
+      throw;
+    }
+}
+
+void FV3_(irmodel3ts)::freeFrags(std::vector<FV3_(frag)*> *v)
+{
+  for(std::vector<FV3_(frag)*>::iterator i = v->begin();i != v->end();i ++) delete *i;
+  v->clear();
+}
+
+void FV3_(irmodel3ts)::allocSlots(long ssize, long lsize)
+  throw(std::bad_alloc)
+{
+  lFrameSlot.alloc(lsize, 2);
+  sOnlySlot.alloc(ssize, 2);
+  restSlot.alloc(ssize, 2);
+  sReverseSlot.alloc(2*ssize, 2);
+  lReverseSlot.alloc(2*lsize, 2);
+  // Following slots must be SIMD compatible slots.
+  sIFFTSlot.alloc(2*ssize, 2);
+  lIFFTSlot.alloc(2*lsize, 2);
+  sSwapSlot.alloc(2*ssize, 2);
+  lSwapSlot.alloc(2*lsize, 2);
+}
+
+void FV3_(irmodel3ts)::freeSlots()
+{
+  lFrameSlot.free();
+  sOnlySlot.free();
+  restSlot.free();
+  sReverseSlot.free();
+  lReverseSlot.free();
+  sIFFTSlot.free();
+  lIFFTSlot.free();
+  sSwapSlot.free();
+  lSwapSlot.free();
+}
+
+void FV3_(irmodel3ts)::processreplace(const fv3_float_t *inputL, const fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+{
+  if(numsamples <= 0||impulseSize <= 0) return;
+  long cursor = sFragmentSize - Scursor;
+  if(numsamples > cursor)
+    {
+      processreplaceS(inputL, inputR, outputL, outputR, cursor);
+      long div = (numsamples - cursor)/sFragmentSize;
+      long mod = (numsamples - cursor)%sFragmentSize;
+      for(long i = 0;i < div;i ++)
+        processreplaceS(inputL+cursor+i*sFragmentSize, inputR+cursor+i*sFragmentSize, outputL+cursor+i*sFragmentSize, outputR+cursor+i*sFragmentSize, sFragmentSize);
+      processreplaceS(inputL+cursor+div*sFragmentSize, inputR+cursor+div*sFragmentSize, outputL+cursor+div*sFragmentSize, outputR+cursor+div*sFragmentSize, mod);
+    }
+  else
+    {
+      processreplaceS(inputL, inputR, outputL, outputR, numsamples);
+    }
+}
+
+void FV3_(irmodel3ts)::processreplaceS(const fv3_float_t *inputL, const fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+{
+  if(numsamples <= 0||impulseSize <= 0) return;
+
+  if((processoptions & FV3_IR_MONO2STEREO) != 0)
+    {
+      for(long i = 0;i < numsamples;i ++) inputW.L[i] = inputW.R[i] = (inputL[i] + inputR[i])/2.0;
+    }
+  else
+    {
+      std::memcpy(inputW.L, inputL, sizeof(fv3_float_t)*numsamples);
+      std::memcpy(inputW.R, inputR, sizeof(fv3_float_t)*numsamples);
+    }
+  std::memcpy(inputD.L, inputL, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(inputD.R, inputR, sizeof(fv3_float_t)*numsamples);
+
+  processZL(inputW.L, inputW.R, numsamples);
+  processdrywetout(inputD.L, inputD.R, inputW.L, inputW.R, outputL, outputR, numsamples);
+}
+
+void FV3_(irmodel3ts)::processZL(fv3_float_t *inputL, fv3_float_t *inputR, long numsamples)
+{
+  // numsamples <= sFragmentSize - Scursor
+  FV3_(blockDelay) * sDelay[2] = { &sBlockDelayL, &sBlockDelayR, };
+  FV3_(blockDelay) * lDelay[2] = { &lBlockDelayL, &lBlockDelayR, };
+
+  if(Lcursor == 0&&lFragmentNum > 0)
+    {
+      lFrameSlot.mute();
+      lReverseSlot.mute(lFragmentSize-1, lFragmentSize+1);
+      lBlockDelayL.push(lIFFTSlot.L);
+      lBlockDelayR.push(lIFFTSlot.R);
+      for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+        {
+          if(lFragments[p].size() > 0) lFragments[p][0]->MULT(lDelay[p/2]->get(0), lSwapSlot.c(p%2));
+        }
+      lFragmentsFFT.HC2R(lSwapSlot.L, lReverseSlot.L);
+      lFragmentsFFT.HC2R(lSwapSlot.R, lReverseSlot.R);
+      lSwapSlot.mute();
+      // The rest of the large fragments are spread over the block at [LVECTOR].
+    }
+
+  if(Scursor == 0)
+    {
+      sFramePointerL = lFrameSlot.L+Lcursor;
+      sFramePointerR = lFrameSlot.R+Lcursor;
+      sSwapSlot.mute();
+      sBlockDelayL.push(sIFFTSlot.L);
+      sBlockDelayR.push(sIFFTSlot.R);
+      for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+        {
+          for(long i = 1;i < (long)sFragments[p].size();i ++){ sFragments[p][i]->MULT(sDelay[p/2]->get(i-1), sSwapSlot.c(p%2)); }
+        }
+    }
+  sOnlySlot.mute();
+
+  std::memcpy(lFrameSlot.L+Lcursor, inputL, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(lFrameSlot.R+Lcursor, inputR, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(sOnlySlot.L+Scursor, inputL, sizeof(fv3_float_t)*numsamples);
+  std::memcpy(sOnlySlot.R+Scursor, inputR, sizeof(fv3_float_t)*numsamples);
+
+  if(sFragmentNum > 0)
+    {
+      // one forward FFT per input, one inverse FFT per output
+      sFragmentsFFT.R2HC(sOnlySlot.L, sIFFTSlot.L);
+      sFragmentsFFT.R2HC(sOnlySlot.R, sIFFTSlot.R);
+      for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+        {
+          if(sFragments[p].size() > 0) sFragments[p][0]->MULT(sIFFTSlot.c(p/2), sSwapSlot.c(p%2));
+        }
+      sReverseSlot.mute();
+      sFragmentsFFT.HC2R(sSwapSlot.L, sReverseSlot.L);
+      sFragmentsFFT.HC2R(sSwapSlot.R, sReverseSlot.R);
+    }
+
+  for(long c = 0;c < 2;c ++)
+    {
+      fv3_float_t * output = c == 0 ? inputL : inputR;
+      fv3_float_t * sRev = sReverseSlot.c(c)+Scursor, * rest = restSlot.c(c)+Scursor, * lRev = lReverseSlot.c(c)+Lcursor;
+      if(lFragmentNum > 0)
+        {
+          for(long i = 0;i < numsamples;i ++){ output[i] = sRev[i] + rest[i] + lRev[i]; }
+        }
+      else
+        {
+          for(long i = 0;i < numsamples;i ++){ output[i] = sRev[i] + rest[i]; }
+        }
+    }
+
+  Scursor += numsamples, Lcursor += numsamples;
+
+  // [LVECTOR] large fragment vector multiplier
+  for(long i = Lstep;i < (lFragmentNum-1)*Lcursor/lFragmentSize;i ++)
+    {
+      for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+        {
+          if((long)lFragments[p].size() > i + 1){ lFragments[p][i+1]->MULT(lDelay[p/2]->get(i), lSwapSlot.c(p%2)); }
+        }
+      Lstep ++;
+    }
+
+  if(Scursor == sFragmentSize&&sFragmentNum > 0)
+    {
+      sFragmentsFFT.R2HC(sFramePointerL, sIFFTSlot.L);
+      sFragmentsFFT.R2HC(sFramePointerR, sIFFTSlot.R);
+      std::memcpy(restSlot.L, sReverseSlot.L+sFragmentSize, sizeof(fv3_float_t)*(sFragmentSize-1));
+      std::memcpy(restSlot.R, sReverseSlot.R+sFragmentSize, sizeof(fv3_float_t)*(sFragmentSize-1));
+      Scursor = 0;
+    }
+
+  if(Lcursor == lFragmentSize)
+    {
+      if(lFragmentNum > 0)
+        {
+          lFragmentsFFT.R2HC(lFrameSlot.L, lIFFTSlot.L);
+          lFragmentsFFT.R2HC(lFrameSlot.R, lIFFTSlot.R);
+          std::memcpy(lReverseSlot.L, lReverseSlot.L+lFragmentSize, sizeof(fv3_float_t)*(lFragmentSize-1));
+          std::memcpy(lReverseSlot.R, lReverseSlot.R+lFragmentSize, sizeof(fv3_float_t)*(lFragmentSize-1));
+        }
+      Lcursor = Lstep = 0;
+    }
+}
+
+void FV3_(irmodel3ts)::mute()
+{
+  FV3_(irbase)::mute();
+  if(impulseSize == 0) return;
+  Scursor = Lcursor = Lstep = 0;
+  sBlockDelayL.mute(), sBlockDelayR.mute();
+  lBlockDelayL.mute(), lBlockDelayR.mute();
+  sReverseSlot.mute();
+  lReverseSlot.mute();
+  sIFFTSlot.mute();
+  lIFFTSlot.mute();
+  sSwapSlot.mute();
+  lSwapSlot.mute();
+  restSlot.mute();
+  lFrameSlot.mute();
+  sOnlySlot.mute();
+}
+
+void FV3_(irmodel3ts)::resume()
+{
+  ;
+}
+
+void FV3_(irmodel3ts)::suspend()
+{
+  ;
+}
+
+void FV3_(irmodel3ts)::setFragmentSize(long size, long factor)
+{
+  if(size <= 0||factor <= 0||size < FV3_IR_Min_FragmentSize||size != FV3_(utils)::checkPow2(size)||factor != FV3_(utils)::checkPow2(factor))
+    {
+      std::fprintf(stderr, "irmodel3ts::setFragmentSize(): invalid fragment size/factor (%ld/%ld)\n", size, factor);
+      return;
+    }
+  if(sFragmentSize != size||lFragmentSize != size*factor)
+    {
+      FV3_(irmodel3ts)::unloadImpulse();
+      sFragmentSize = size;
+      lFragmentSize = size*factor;
+    }
+}
+
+long FV3_(irmodel3ts)::getSFragmentSize(){ return sFragmentSize; }
+long FV3_(irmodel3ts)::getLFragmentSize(){ return lFragmentSize; }
+long FV3_(irmodel3ts)::getSFragmentCount(){ return sFragmentNum; }
+long FV3_(irmodel3ts)::getLFragmentCount(){ return lFragmentNum; }
+
+void FV3_(irmodel3ts)::printconfig()
+{
+  std::fprintf(stderr, "*** irmodel3ts config ***\n");
+  std::fprintf(stderr, "impulseSize = %ld\n", impulseSize);
+  std::fprintf(stderr, "short fragment Size = %ld\n", sFragmentSize);
+  std::fprintf(stderr, "large fragment Size = %ld\n", lFragmentSize);
+  std::fprintf(stderr, "short fragment vector Length = %ld\n", sFragmentNum);
+  std::fprintf(stderr, "large fragment vector Length = %ld\n", lFragmentNum);
+  for(long p = 0;p < FV3_IR3TS_PATHS;p ++)
+    std::fprintf(stderr, "path %ld = %s\n", p, sFragments[p].size() > 0 ? "active" : "off");
+}
+
+#include "freeverb/fv3_ns_end.h"
@@ -0,0 +1,80 @@
+/**
+ *  Impulse Response Processor model implementation
+ *  True Stereo Low Latency Version
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+class _FV3_(irmodel3ts) : public _FV3_(irbase)
+{
+ public:
+  _FV3_(irmodel3ts)();
+  virtual _FV3_(~irmodel3ts)();
+  // LL = inputL, RR = inputR, no cross paths
+  virtual void loadImpulse(const _fv3_float_t * inputL, const _fv3_float_t * inputR, long size)
+    throw(std::bad_alloc);
+  // NULL paths are skipped
+  virtual void loadImpulse(const _fv3_float_t * inputLL, const _fv3_float_t * inputLR,
+                           const _fv3_float_t * inputRL, const _fv3_float_t * inputRR, long size)
+    throw(std::bad_alloc);
+  // 4ch sources are LL,LR,RL,RR, 2ch sources LL,RR and 1ch sources feed LL and RR
+  virtual void loadImpulse(_FV3_(irsource) * source)
+    throw(std::bad_alloc);
+  virtual void unloadImpulse();
+  using _FV3_(irbase)::processreplace;
+  virtual void processreplace(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
+  virtual void resume();
+  virtual void suspend();
+  virtual void mute();
+
+  void setFragmentSize(long size, long factor);
+  long getSFragmentSize();
+  long getLFragmentSize();
+  long getSFragmentCount();
+  long getLFragmentCount();
+  void printconfig();
+
+ protected:
+  void loadImpulseFrom(const _fv3_float_t * const inputs[FV3_IR3TS_PATHS], _FV3_(irsource) * source, const long channels[FV3_IR3TS_PATHS], long size)
+    throw(std::bad_alloc);
+  void processreplaceS(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
+  void processZL(_fv3_float_t *inputL, _fv3_float_t *inputR, long numsamples);
+  void allocFrags(std::vector<_FV3_(frag)*> *to, const _fv3_float_t *input, _FV3_(irsource) * source, long channel, long offset,
+                  long fragSize, long num, long mod, _fv3_float_t * preAllocL)
+    throw(std::bad_alloc);
+  void freeFrags(std::vector<_FV3_(frag)*> *v);
+  void allocSlots(long ssize, long lsize)
+    throw(std::bad_alloc);
+  void freeSlots();
+
+  long Lcursor, Scursor, Lstep, sFragmentSize, lFragmentSize, sFragmentNum, lFragmentNum;
+  // per input channel
+  _FV3_(slot) sIFFTSlot, lIFFTSlot, lFrameSlot, sOnlySlot;
+  _fv3_float_t *sFramePointerL, *sFramePointerR;
+  _FV3_(blockDelay) sBlockDelayL, sBlockDelayR, lBlockDelayL, lBlockDelayR;
+  // per output channel
+  _FV3_(slot) sReverseSlot, lReverseSlot, sSwapSlot, lSwapSlot, restSlot;
+  // per path
+  std::vector<_FV3_(frag)*> sFragments[FV3_IR3TS_PATHS], lFragments[FV3_IR3TS_PATHS];
+  _FV3_(slot) sImpulseFFTBlock[FV3_IR3TS_PATHS], lImpulseFFTBlock[FV3_IR3TS_PATHS];
+  _FV3_(fragfft) sFragmentsFFT, lFragmentsFFT;
+  _FV3_(slot) inputW, inputD;
+
+ private:
+  _FV3_(irmodel3ts)(const _FV3_(irmodel3ts)& x);
+  _FV3_(irmodel3ts)& operator=(const _FV3_(irmodel3ts)& x);
+};
@@ -18,13 +18,115 @@
  *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))
+#include <immintrin.h>
+#endif
+
+#include <mutex>
 #include "freeverb/irmodels.hpp"
 #include "freeverb/fv3_type_float.h"
 #include "freeverb/fv3_ns_start.h"
 
+// Block FIR kernels
+// y[i] = sum_k impulse[k]*x[i-k], x = history+taps-1
+// The SIMD versions read the transposed kernel (every tap broadcast to 8 lanes)
+// and apply one tap to 8 consecutive outputs per instruction, the scalar one
+// reads the impulse.
+
+static void FIRBLOCK_FPU(const fv3_float_t * history, const fv3_float_t * impulse, const fv3_float_t * /* kernel */,
+                         fv3_float_t * output, long taps, long n)
+{
+  const fv3_float_t * x = history + taps - 1;
+  for(long i = 0;i < n;i ++)
+    {
+      fv3_float_t acc = 0;
+      for(long k = 0;k < taps;k ++) acc += impulse[k]*x[i-k];
+      output[i] = acc;
+    }
+}
+
+// Built with target attributes and picked at runtime from the CPU flags,
+// no ENABLE_AVX/ENABLE_FMA3 build is needed.
+#if defined(LIBFV3_FLOAT)&&defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))
+#define FV3_IRS_X86SIMD
+static void FIRBLOCK_F_AVX(const fv3_float_t * history, const fv3_float_t * impulse, const fv3_float_t * kernel,
+                           fv3_float_t * output, long taps, long n)
+  __attribute__((noinline, target("avx")))
+  ;
+static void FIRBLOCK_F_AVX(const fv3_float_t * history, const fv3_float_t * impulse, const fv3_float_t * kernel,
+                           fv3_float_t * output, long taps, long n)
+{
+  const fv3_float_t * x = history + taps - 1;
+  long i = 0;
+  for(;i + 8 <= n;i += 8)
+    {
+      // 4 accumulators hide the add latency
+      __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+      const fv3_float_t * xi = x + i;
+      long k = 0;
+      for(;k + 4 <= taps;k += 4)
+        {
+          a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_load_ps(kernel+8*k+ 0), _mm256_loadu_ps(xi-k-0)));
+          a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_load_ps(kernel+8*k+ 8), _mm256_loadu_ps(xi-k-1)));
+          a2 = _mm256_add_ps(a2, _mm256_mul_ps(_mm256_load_ps(kernel+8*k+16), _mm256_loadu_ps(xi-k-2)));
+          a3 = _mm256_add_ps(a3, _mm256_mul_ps(_mm256_load_ps(kernel+8*k+24), _mm256_loadu_ps(xi-k-3)));
+        }
+      for(;k < taps;k ++)
+        a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_load_ps(kernel+8*k), _mm256_loadu_ps(xi-k)));
+      _mm256_storeu_ps(output+i, _mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)));
+    }
+  FIRBLOCK_FPU(history+i, impulse, kernel, output+i, taps, n-i);
+}
+
+static void FIRBLOCK_F_FMA3(const fv3_float_t * history, const fv3_float_t * impulse, const fv3_float_t * kernel,
+                            fv3_float_t * output, long taps, long n)
+  __attribute__((noinline, target("avx,fma")))
+  ;
+static void FIRBLOCK_F_FMA3(const fv3_float_t * history, const fv3_float_t * impulse, const fv3_float_t * kernel,
+                            fv3_float_t * output, long taps, long n)
+{
+  const fv3_float_t * x = history + taps - 1;
+  long i = 0;
+  for(;i + 8 <= n;i += 8)
+    {
+      __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+      const fv3_float_t * xi = x + i;
+      long k = 0;
+      for(;k + 4 <= taps;k += 4)
+        {
+          a0 = _mm256_fmadd_ps(_mm256_load_ps(kernel+8*k+ 0), _mm256_loadu_ps(xi-k-0), a0);
+          a1 = _mm256_fmadd_ps(_mm256_load_ps(kernel+8*k+ 8), _mm256_loadu_ps(xi-k-1), a1);
+          a2 = _mm256_fmadd_ps(_mm256_load_ps(kernel+8*k+16), _mm256_loadu_ps(xi-k-2), a2);
+          a3 = _mm256_fmadd_ps(_mm256_load_ps(kernel+8*k+24), _mm256_loadu_ps(xi-k-3), a3);
+        }
+      for(;k < taps;k ++)
+        a0 = _mm256_fmadd_ps(_mm256_load_ps(kernel+8*k), _mm256_loadu_ps(xi-k), a0);
+      _mm256_storeu_ps(output+i, _mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)));
+    }
+  FIRBLOCK_FPU(history+i, impulse, kernel, output+i, taps, n-i);
+}
+#endif
+
+FV3_(FIRBLOCK_T) FV3_(irmodels)::selectFIRBlock(uint32_t flag)
+{
+  FV3_(FIRBLOCK_T) f = FIRBLOCK_FPU;
+#ifdef FV3_IRS_X86SIMD
+  if((flag & FV3_X86SIMD_FLAG_AVX))
+    f = FIRBLOCK_F_AVX;
+  if((flag & FV3_X86SIMD_FLAG_AVX)&&(flag & FV3_X86SIMD_FLAG_FMA3))
+    f = FIRBLOCK_F_FMA3;
+#else
+  (void)flag;
+#endif
+  return f;
+}
+
 FV3_(irmodels)::FV3_(irmodels)()
 {
-  current = impulseSize;
+  partitioned = NULL;
+  crossoverLength = 0;
+  firBlock = FIRBLOCK_FPU;
+  FV3_(irmodels)::setSIMD(0, 0);
 }
 
 FV3_(irmodels)::FV3_(~irmodels)()
@@ -32,6 +134,110 @@ FV3_(irmodels)::FV3_(~irmodels)()
   freeImpulse();
 }
 
+void FV3_(irmodels)::setSIMD(uint32_t flag1, uint32_t flag2)
+{
+  FV3_(irbase)::setSIMD(flag1, flag2);
+  firBlock = selectFIRBlock(flag1 == 0 ? FV3_(utils)::getSIMDFlag() : flag1);
+  if(partitioned != NULL) partitioned->setSIMD(flag1, flag2);
+}
+
+void FV3_(irmodels)::setCrossoverLength(long length)
+{
+  crossoverLength = length;
+}
+
+long FV3_(irmodels)::getCrossoverLength()
+{
+  return crossoverLength;
+}
+
+bool FV3_(irmodels)::isPartitioned()
+{
+  return partitioned != NULL;
+}
+
+static double irmodels_elapsed(const struct timespec& a, const struct timespec& b)
+{
+  return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec)*1e-9;
+}
+
+// xorshift32, the measurement must not touch the global std::rand() state
+static fv3_float_t irmodels_noise(uint32_t& seed)
+{
+  seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+  return (fv3_float_t)seed/(fv3_float_t)4294967296.0 - 0.5;
+}
+
+long FV3_(irmodels)::measureCrossoverLength()
+{
+  // Measured once per process: time the block FIR and the partitioned engine
+  // on the same material at doubling lengths and cross over where FFT wins.
+  // Instances may load concurrently, the first one measures and the others wait.
+  static std::once_flag once;
+  static long measured = FV3_IRS_MaxCrossoverLength;
+  std::call_once(once, measureOnce, &measured);
+  return measured;
+}
+
+void FV3_(irmodels)::measureOnce(long * measured)
+{
+  long result = FV3_IRS_MaxCrossoverLength;
+  uint32_t seed = 0x2545f491U;
+  FV3_(FIRBLOCK_T) fir = selectFIRBlock(FV3_(utils)::getSIMDFlag());
+  const long n = FV3_IRS_BlockSize*32;
+  try
+    {
+      FV3_(slot) input, output;
+      input.alloc(n, 2);
+      output.alloc(n, 2);
+      for(long i = 0;i < n;i ++) input.L[i] = input.R[i] = irmodels_noise(seed);
+      for(long taps = FV3_IRS_MinCrossoverLength;taps <= FV3_IRS_MaxCrossoverLength;taps *= 2)
+        {
+          FV3_(slot) ir, kern, hist;
+          ir.alloc(taps, 2);
+          kern.alloc(taps*8, 1);
+          hist.alloc(taps-1+FV3_IRS_BlockSize, 1);
+          for(long i = 0;i < taps;i ++)
+            {
+              ir.L[i] = ir.R[i] = irmodels_noise(seed);
+              for(long j = 0;j < 8;j ++) kern.L[8*i+j] = ir.L[i];
+            }
+
+          struct timespec t0, t1, t2, t3;
+          clock_gettime(CLOCK_MONOTONIC, &t0);
+          for(long o = 0;o < n;o += FV3_IRS_BlockSize)
+            {
+              fir(hist.L, ir.L, kern.L, output.L+o, taps, FV3_IRS_BlockSize);
+              fir(hist.L, ir.R, kern.L, output.R+o, taps, FV3_IRS_BlockSize);
+            }
+          clock_gettime(CLOCK_MONOTONIC, &t1);
+
+          FV3_(irmodel3) ir3;
+          ir3.setFragmentSize(FV3_IRS_PartitionSize, FV3_IR3_DefaultFactor);
+          ir3.setprocessoptions(FV3_IR_MUTE_DRY|FV3_IR_SKIP_FILTER);
+          ir3.loadImpulse(ir.L, ir.R, taps);
+          clock_gettime(CLOCK_MONOTONIC, &t2);
+          for(long o = 0;o < n;o += FV3_IRS_BlockSize)
+            ir3.processreplace(input.L+o, input.R+o, output.L+o, output.R+o, FV3_IRS_BlockSize);
+          clock_gettime(CLOCK_MONOTONIC, &t3);
+
+#ifdef DEBUG
+          std::fprintf(stderr, "irmodels::measureCrossoverLength(%ld) fir %g partitioned %g\n", taps, irmodels_elapsed(t0, t1), irmodels_elapsed(t2, t3));
+#endif
+          if(irmodels_elapsed(t2, t3) < irmodels_elapsed(t0, t1))
+            {
+              result = taps;
+              break;
+            }
+        }
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodels::measureCrossoverLength() bad_alloc\n");
+    }
+  *measured = result;
+}
+
 void FV3_(irmodels)::unloadImpulse()
 {
   freeImpulse();
@@ -40,35 +246,80 @@ void FV3_(irmodels)::unloadImpulse()
 void FV3_(irmodels)::loadImpulse(const fv3_float_t * inputL, const fv3_float_t * inputR, long size)
 		    throw(std::bad_alloc)
 {
-  impulseSize = size;
-  allocImpulse(size);
-  std::memcpy(impulse.L, inputL, sizeof(fv3_float_t)*size);
-  std::memcpy(impulse.R, inputR, sizeof(fv3_float_t)*size);
+  if(size <= 0) return;
+  freeImpulse();
+  long crossover = crossoverLength;
+  if(crossover == 0&&size > FV3_IRS_MinCrossoverLength) crossover = measureCrossoverLength();
+  try
+    {
+      if(crossover > 0&&size > crossover)
+        {
+          // zero latency either way, the partitioned engine only returns the wet signal
+          partitioned = new FV3_(irmodel3);
+          partitioned->setSIMD(simdFlag1, simdFlag2);
+          partitioned->setFragmentSize(FV3_IRS_PartitionSize, FV3_IR3_DefaultFactor);
+          partitioned->setprocessoptions(FV3_IR_MUTE_DRY|FV3_IR_SKIP_FILTER);
+          partitioned->setwet(0);
+          partitioned->setwidth(1);
+          partitioned->setLRBalance(0);
+          partitioned->loadImpulse(inputL, inputR, size);
+          wetSlot.alloc(FV3_IRS_BlockSize, 2);
+          impulseSize = size;
+        }
+      else
+        {
+          allocImpulse(size);
+          std::memcpy(impulse.L, inputL, sizeof(fv3_float_t)*size);
+          std::memcpy(impulse.R, inputR, sizeof(fv3_float_t)*size);
+          for(long i = 0;i < size;i ++)
+            {
+              for(long j = 0;j < 8;j ++)
+                {
+                  kernel.L[8*i+j] = inputL[i];
+                  kernel.R[8*i+j] = inputR[i];
+                }
+            }
+        }
+    }
+  catch(std::bad_alloc&)
+    {
+      std::fprintf(stderr, "irmodels::loadImpulse(%ld) bad_alloc\n", size);
+      freeImpulse();
+      throw;
+    }
   mute();
 }
 
 void FV3_(irmodels)::processreplace(const fv3_float_t *inputL, const fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
 {
   if(numsamples <= 0||impulseSize <= 0) return;
+  for(long i = 0;i < numsamples;i += FV3_IRS_BlockSize)
+    {
+      long n = numsamples - i < FV3_IRS_BlockSize ? numsamples - i : FV3_IRS_BlockSize;
+      processBlock(inputL+i, inputR+i, outputL+i, outputR+i, n);
+    }
+}
+
+void FV3_(irmodels)::processBlock(const fv3_float_t *inputL, const fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+{
+  if(partitioned != NULL)
+    {
+      partitioned->processreplace(inputL, inputR, wetSlot.L, wetSlot.R, numsamples);
+    }
+  else
+    {
+      long past = impulseSize - 1;
+      std::memcpy(history.L+past, inputL, sizeof(fv3_float_t)*numsamples);
+      std::memcpy(history.R+past, inputR, sizeof(fv3_float_t)*numsamples);
+      firBlock(history.L, impulse.L, kernel.L, wetSlot.L, impulseSize, numsamples);
+      firBlock(history.R, impulse.R, kernel.R, wetSlot.R, impulseSize, numsamples);
+      std::memmove(history.L, history.L+numsamples, sizeof(fv3_float_t)*past);
+      std::memmove(history.R, history.R+numsamples, sizeof(fv3_float_t)*past);
+    }
+
   for(long i = 0;i < numsamples;i ++)
     {
-      fv3_float_t * offsetL = delay.L + current;
-      fv3_float_t * offsetR = delay.R + current;
-      fv3_float_t L = 0, R = 0;
-      offsetL[0] = inputL[i]; offsetR[0] = inputR[i];
-      
-      for(long j = 0;j < impulseSize;j ++) L += impulse.L[j]*offsetL[j];
-      for(long j = 0;j < impulseSize;j ++) R += impulse.R[j]*offsetR[j];
-      
-      if(current == 0)
-	{
-	  current = impulseSize;
-	  std::memmove(delay.L+impulseSize+1, delay.L, sizeof(fv3_float_t)*(impulseSize-1));
-	  std::memmove(delay.R+impulseSize+1, delay.R, sizeof(fv3_float_t)*(impulseSize-1));
-	}
-      else
-	current --;
-      
+      fv3_float_t L = wetSlot.L[i], R = wetSlot.R[i], dL = inputL[i], dR = inputR[i];
       if((processoptions & FV3_IR_SKIP_FILTER) == 0)
 	{
 	  L = filter.processL(L);
@@ -78,8 +329,8 @@ void FV3_(irmodels)::processreplace(const fv3_float_t *inputL, const fv3_float_t
       outputL[i] = outputR[i] = 0;
       if((processoptions & FV3_IR_MUTE_DRY) == 0)
 	{
-	  outputL[i] += inputL[i]*dry;
-	  outputR[i] += inputR[i]*dry;
+	  outputL[i] += dL*dry;
+	  outputR[i] += dR*dry;
 	}
       if((processoptions & FV3_IR_MUTE_WET) == 0)
 	{
@@ -92,8 +343,19 @@ void FV3_(irmodels)::processreplace(const fv3_float_t *inputL, const fv3_float_t
 void FV3_(irmodels)::mute()
 {
   if(impulseSize == 0) return;
-  delay.mute();
-  current = impulseSize;
+  history.mute();
+  wetSlot.mute();
+  if(partitioned != NULL) partitioned->mute();
+}
+
+void FV3_(irmodels)::resume()
+{
+  if(partitioned != NULL) partitioned->resume();
+}
+
+void FV3_(irmodels)::suspend()
+{
+  if(partitioned != NULL) partitioned->suspend();
 }
 
 void FV3_(irmodels)::allocImpulse(long size)
@@ -104,7 +366,9 @@ void FV3_(irmodels)::allocImpulse(long size)
   try
     {
       impulse.alloc(size, 2);
-      delay.alloc(size*2, 2);
+      kernel.alloc(size*8, 2);
+      history.alloc(size-1+FV3_IRS_BlockSize, 2);
+      wetSlot.alloc(FV3_IRS_BlockSize, 2);
     }
   catch(std::bad_alloc&)
     {
@@ -116,9 +380,12 @@ void FV3_(irmodels)::allocImpulse(long size)
 
 void FV3_(irmodels)::freeImpulse()
 {
-  if(impulseSize == 0) return;
+  delete partitioned;
+  partitioned = NULL;
   impulse.free();
-  delay.free();
+  kernel.free();
+  history.free();
+  wetSlot.free();
   impulseSize = 0;
 }
 
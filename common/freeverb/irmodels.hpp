@@ -26,12 +26,14 @@
 #include <cstring>
 #include <cmath>
 #include <new>
+#include <time.h>
 
 #include "freeverb/delay.hpp"
 #include "freeverb/efilter.hpp"
 #include "freeverb/utils.hpp"
 #include "freeverb/slot.hpp"
 #include "freeverb/irbase.hpp"
+#include "freeverb/irmodel3.hpp"
 #include "freeverb/fv3_defs.h"
 
 namespace fv3
@@ -18,6 +18,10 @@
  *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+// history = [past taps-1 samples][n new samples], kernel = each tap repeated 8 times
+typedef void (_FV3_(*FIRBLOCK_T))(const _fv3_float_t * history, const _fv3_float_t * impulse, const _fv3_float_t * kernel,
+                                  _fv3_float_t * output, long taps, long n);
+
 class _FV3_(irmodels) : public _FV3_(irbase)
 {
  public:
@@ -29,6 +33,15 @@ class _FV3_(irmodels) : public _FV3_(irbase)
   using _FV3_(irbase)::processreplace;
   virtual void processreplace(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
   virtual void mute();
+  virtual void setSIMD(uint32_t flag1, uint32_t flag2);
+  virtual void resume();
+  virtual void suspend();
+
+  // IRs longer than this run on a partitioned (irmodel3) engine, 0 = measure, <0 = never
+  void setCrossoverLength(long length);
+  long getCrossoverLength();
+  bool isPartitioned();
+  static long measureCrossoverLength();
 
  private:
   _FV3_(irmodels)(const _FV3_(irmodels)& x);
@@ -36,7 +49,11 @@ class _FV3_(irmodels) : public _FV3_(irbase)
   void allocImpulse(long size)
     throw(std::bad_alloc);
   void freeImpulse();
-  void update();
-  _FV3_(slot) impulse, delay;
-  long current;
+  void processBlock(const _fv3_float_t *inputL, const _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples);
+  static _FV3_(FIRBLOCK_T) selectFIRBlock(uint32_t flag);
+  static void measureOnce(long * measured);
+  _FV3_(slot) impulse, kernel, history, wetSlot;
+  _FV3_(FIRBLOCK_T) firBlock;
+  _FV3_(irmodel3) * partitioned;
+  long crossoverLength;
 };
@@ -0,0 +1,292 @@
+/**
+ *  Memory-mapped impulse response source
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "freeverb/irsource.hpp"
+#include "freeverb/fv3_type_float.h"
+#include "freeverb/fv3_ns_start.h"
+
+// The mappings are shared read-only between every irsource which opens the
+// same file, so N plugin instances loading one long IR cost one page cache copy.
+std::vector<FV3_(irmapping)*> FV3_(irsource)::mappings;
+PthreadLocker FV3_(irsource)::mappingsLock;
+
+FV3_(irsource)::FV3_(irsource)()
+{
+  mapping = NULL;
+  data = NULL;
+  frames = channels = bytesPerSample = 0;
+  format = FV3_IRSOURCE_FORMAT_NONE;
+  sampleRate = 0;
+}
+
+FV3_(irsource)::FV3_(~irsource)()
+{
+  close();
+}
+
+FV3_(irmapping) * FV3_(irsource)::acquire(const char * filename)
+{
+  int fd = ::open(filename, O_RDONLY);
+  if(fd < 0)
+    {
+      std::fprintf(stderr, "irsource::acquire(%s) open failed\n", filename);
+      return NULL;
+    }
+  struct stat st;
+  if(fstat(fd, &st) != 0||st.st_size <= 0)
+    {
+      std::fprintf(stderr, "irsource::acquire(%s) stat failed\n", filename);
+      ::close(fd);
+      return NULL;
+    }
+
+  mappingsLock.lock();
+  for(std::vector<FV3_(irmapping)*>::iterator i = mappings.begin();i != mappings.end();i ++)
+    {
+      if((*i)->device == (uint64_t)st.st_dev&&(*i)->inode == (uint64_t)st.st_ino&&
+         (*i)->mtime == (int64_t)st.st_mtime&&(*i)->length == (size_t)st.st_size)
+        {
+          (*i)->refs ++;
+          mappingsLock.unlock();
+          ::close(fd);
+          return *i;
+        }
+    }
+
+  void * base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(base == MAP_FAILED)
+    {
+      mappingsLock.unlock();
+      std::fprintf(stderr, "irsource::acquire(%s) mmap failed\n", filename);
+      return NULL;
+    }
+  // Partitions are consumed front to back while the IR is being loaded.
+  madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+  FV3_(irmapping) * m = new FV3_(irmapping);
+  m->device = (uint64_t)st.st_dev;
+  m->inode = (uint64_t)st.st_ino;
+  m->mtime = (int64_t)st.st_mtime;
+  m->base = (const unsigned char*)base;
+  m->length = (size_t)st.st_size;
+  m->refs = 1;
+  mappings.push_back(m);
+  mappingsLock.unlock();
+  return m;
+}
+
+void FV3_(irsource)::release(FV3_(irmapping) * m)
+{
+  if(m == NULL) return;
+  mappingsLock.lock();
+  if(-- m->refs == 0)
+    {
+      for(std::vector<FV3_(irmapping)*>::iterator i = mappings.begin();i != mappings.end();i ++)
+        {
+          if(*i == m)
+            {
+              mappings.erase(i);
+              break;
+            }
+        }
+      munmap((void*)m->base, m->length);
+      delete m;
+    }
+  mappingsLock.unlock();
+}
+
+bool FV3_(irsource)::attach(const char * filename)
+{
+  close();
+  mapping = acquire(filename);
+  return mapping != NULL;
+}
+
+bool FV3_(irsource)::open(const char * filename)
+{
+  if(!attach(filename)) return false;
+  if(!parseWAVE())
+    {
+      std::fprintf(stderr, "irsource::open(%s) unsupported WAVE file\n", filename);
+      close();
+      return false;
+    }
+#ifdef DEBUG
+  std::fprintf(stderr, "irsource::open(%s) %ldch %ld frames fmt=%ld\n", filename, channels, frames, format);
+#endif
+  return true;
+}
+
+bool FV3_(irsource)::openRaw(const char * filename, long ch, fv3_float_t fs)
+{
+  if(ch <= 0) return false;
+  if(!attach(filename)) return false;
+  data = mapping->base;
+  channels = ch;
+  format = FV3_IRSOURCE_FORMAT_FLOAT32;
+  bytesPerSample = 4;
+  frames = (long)(mapping->length / (size_t)(bytesPerSample*channels));
+  sampleRate = fs;
+  return true;
+}
+
+static uint32_t irsource_le32(const unsigned char * p)
+{
+  return (uint32_t)p[0]|((uint32_t)p[1] << 8)|((uint32_t)p[2] << 16)|((uint32_t)p[3] << 24);
+}
+
+static uint16_t irsource_le16(const unsigned char * p)
+{
+  return (uint16_t)(p[0]|(p[1] << 8));
+}
+
+bool FV3_(irsource)::parseWAVE()
+{
+  const unsigned char * p = mapping->base;
+  size_t length = mapping->length;
+  if(length < 12||std::memcmp(p, "RIFF", 4) != 0||std::memcmp(p+8, "WAVE", 4) != 0) return false;
+
+  long tag = 0, bits = 0;
+  size_t pos = 12;
+  const unsigned char * body = NULL;
+  size_t bodySize = 0;
+  while(pos + 8 <= length)
+    {
+      size_t chunkSize = irsource_le32(p+pos+4);
+      const unsigned char * chunk = p + pos + 8;
+      if(chunkSize > length - pos - 8) chunkSize = length - pos - 8;
+      if(std::memcmp(p+pos, "fmt ", 4) == 0&&chunkSize >= 16)
+        {
+          tag = irsource_le16(chunk);
+          channels = irsource_le16(chunk+2);
+          sampleRate = (fv3_float_t)irsource_le32(chunk+4);
+          bits = irsource_le16(chunk+14);
+          // WAVE_FORMAT_EXTENSIBLE carries the real tag in the SubFormat GUID
+          if(tag == 0xFFFE&&chunkSize >= 26) tag = irsource_le16(chunk+24);
+        }
+      else if(std::memcmp(p+pos, "data", 4) == 0)
+        {
+          body = chunk;
+          bodySize = chunkSize;
+        }
+      pos += 8 + chunkSize + (chunkSize & 1);
+    }
+  if(body == NULL||channels <= 0) return false;
+
+  if(tag == 1&&bits == 16) format = FV3_IRSOURCE_FORMAT_PCM16, bytesPerSample = 2;
+  else if(tag == 1&&bits == 24) format = FV3_IRSOURCE_FORMAT_PCM24, bytesPerSample = 3;
+  else if(tag == 1&&bits == 32) format = FV3_IRSOURCE_FORMAT_PCM32, bytesPerSample = 4;
+  else if(tag == 3&&bits == 32) format = FV3_IRSOURCE_FORMAT_FLOAT32, bytesPerSample = 4;
+  else if(tag == 3&&bits == 64) format = FV3_IRSOURCE_FORMAT_FLOAT64, bytesPerSample = 8;
+  else return false;
+
+  data = body;
+  frames = (long)(bodySize / (size_t)(bytesPerSample*channels));
+  return true;
+}
+
+void FV3_(irsource)::close()
+{
+  release(mapping);
+  mapping = NULL;
+  data = NULL;
+  frames = channels = bytesPerSample = 0;
+  format = FV3_IRSOURCE_FORMAT_NONE;
+  sampleRate = 0;
+}
+
+bool FV3_(irsource)::isOpen(){ return mapping != NULL; }
+long FV3_(irsource)::getSize(){ return frames; }
+long FV3_(irsource)::getChannels(){ return channels; }
+long FV3_(irsource)::getFormat(){ return format; }
+fv3_float_t FV3_(irsource)::getSampleRate(){ return sampleRate; }
+
+fv3_float_t FV3_(irsource)::sampleAt(const unsigned char * p)
+{
+  switch(format)
+    {
+    case FV3_IRSOURCE_FORMAT_PCM16:
+      return (fv3_float_t)(int16_t)irsource_le16(p) / (fv3_float_t)32768.0;
+    case FV3_IRSOURCE_FORMAT_PCM24:
+      return (fv3_float_t)((int32_t)((uint32_t)p[0] << 8|(uint32_t)p[1] << 16|(uint32_t)p[2] << 24) >> 8) / (fv3_float_t)8388608.0;
+    case FV3_IRSOURCE_FORMAT_PCM32:
+      return (fv3_float_t)(int32_t)irsource_le32(p) / (fv3_float_t)2147483648.0;
+    case FV3_IRSOURCE_FORMAT_FLOAT32:
+      {
+        float f;
+        std::memcpy(&f, p, sizeof(float));
+        return (fv3_float_t)f;
+      }
+    case FV3_IRSOURCE_FORMAT_FLOAT64:
+      {
+        double d;
+        std::memcpy(&d, p, sizeof(double));
+        return (fv3_float_t)d;
+      }
+    default:
+      return 0;
+    }
+}
+
+long FV3_(irsource)::read(long channel, long offset, fv3_float_t * out, long count)
+{
+  if(count <= 0) return 0;
+  if(data == NULL||channel < 0||channel >= channels||offset < 0||offset >= frames)
+    {
+      FV3_(utils)::mute(out, count);
+      return 0;
+    }
+  long avail = frames - offset;
+  if(avail > count) avail = count;
+  long stride = bytesPerSample*channels;
+  const unsigned char * p = data + (size_t)offset*stride + (size_t)channel*bytesPerSample;
+
+  if(format == FV3_IRSOURCE_FORMAT_FLOAT32&&channels == 1&&sizeof(fv3_float_t) == sizeof(float))
+    {
+      std::memcpy(out, p, sizeof(float)*avail);
+    }
+  else
+    {
+      for(long i = 0;i < avail;i ++, p += stride) out[i] = sampleAt(p);
+    }
+  if(avail < count) FV3_(utils)::mute(out+avail, count-avail);
+  return avail;
+}
+
+void FV3_(irsource)::prefetch(long offset, long count)
+{
+  if(data == NULL||offset >= frames||count <= 0) return;
+  if(offset < 0) offset = 0;
+  if(offset + count > frames) count = frames - offset;
+  long pageSize = sysconf(_SC_PAGESIZE);
+  size_t begin = (size_t)(data - mapping->base) + (size_t)offset*bytesPerSample*channels;
+  size_t end = begin + (size_t)count*bytesPerSample*channels;
+  begin -= begin % (size_t)pageSize;
+  madvise((void*)(mapping->base + begin), end - begin, MADV_WILLNEED);
+}
+
+#include "freeverb/fv3_ns_end.h"
@@ -0,0 +1,63 @@
+/**
+ *  Memory-mapped impulse response source
+ *
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+typedef struct {
+  uint64_t device, inode;
+  int64_t mtime;
+  const unsigned char * base;
+  size_t length;
+  long refs;
+} _FV3_(irmapping);
+
+class _FV3_(irsource)
+{
+ public:
+  _FV3_(irsource)();
+  virtual _FV3_(~irsource)();
+  // RIFF WAVE (PCM 16/24/32bit, IEEE float 32/64bit)
+  bool open(const char * filename);
+  // headerless interleaved native float32
+  bool openRaw(const char * filename, long channels, _fv3_float_t fs);
+  void close();
+  bool isOpen();
+  long getSize();
+  long getChannels();
+  long getFormat();
+  _fv3_float_t getSampleRate();
+  // replace count, samples past the end are muted
+  long read(long channel, long offset, _fv3_float_t * out, long count);
+  // hint the kernel to page in the next partitions
+  void prefetch(long offset, long count);
+
+ private:
+  _FV3_(irsource)(const _FV3_(irsource)& x);
+  _FV3_(irsource)& operator=(const _FV3_(irsource)& x);
+  bool attach(const char * filename);
+  bool parseWAVE();
+  _fv3_float_t sampleAt(const unsigned char * p);
+  static _FV3_(irmapping) * acquire(const char * filename);
+  static void release(_FV3_(irmapping) * m);
+  static std::vector<_FV3_(irmapping)*> mappings;
+  static PthreadLocker mappingsLock;
+  _FV3_(irmapping) * mapping;
+  const unsigned char * data;
+  long frames, channels, format, bytesPerSample;
+  _fv3_float_t sampleRate;
+};
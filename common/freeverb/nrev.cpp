@@ -60,6 +60,29 @@ void FV3_(nrev)::mute()
   inDCC.mute(); lLDCC.mute(); lRDCC.mute();
 }
 
+void FV3_(nrev)::state(state_io& io)
+{
+  FV3_(revbase)::state(io);
+  for (long i = 0;i < FV3_NREV_NUM_COMB;i ++)
+    {
+      combL[i].state(io); combR[i].state(io);
+    }
+  for (long i = 0;i < FV3_NREV_NUM_ALLPASS;i ++)
+    {
+      allpassL[i].state(io); allpassR[i].state(io);
+    }
+  io.value(hpf); io.value(lpfL); io.value(lpfR);
+  inDCC.state(io); lLDCC.state(io); lRDCC.state(io);
+}
+
+long FV3_(nrev)::getMemorySize()
+{
+  long size = 0;
+  for(long i = 0;i < FV3_NREV_NUM_COMB;i ++) size += combL[i].getsize() + combR[i].getsize();
+  for(long i = 0;i < FV3_NREV_NUM_ALLPASS;i ++) size += allpassL[i].getsize() + allpassR[i].getsize();
+  return FV3_(revbase)::getMemorySize() + size*sizeof(fv3_float_t);
+}
+
 void FV3_(nrev)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
 		throw(std::bad_alloc)
 {
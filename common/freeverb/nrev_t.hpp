@@ -23,6 +23,8 @@ class _FV3_(nrev) : public _FV3_(revbase)
  public:
   _FV3_(nrev)() throw(std::bad_alloc);
   virtual void mute();
+  virtual void state(state_io& io);
+  virtual long getMemorySize();
 
   void processreplace(_fv3_float_t *inputL, _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
     throw(std::bad_alloc);
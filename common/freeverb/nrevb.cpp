@@ -52,6 +52,28 @@ void FV3_(nrevb)::mute()
     }
 }
 
+void FV3_(nrevb)::state(state_io& io)
+{
+  FV3_(nrev)::state(io);
+  io.value(lastL); io.value(lastR);
+  for (long i = 0;i < FV3_NREVB_NUM_COMB_2;i ++)
+    {
+      comb2L[i].state(io); comb2R[i].state(io);
+    }
+  for (long i = 0;i < FV3_NREVB_NUM_ALLPASS_2;i ++)
+    {
+      allpass2L[i].state(io); allpass2R[i].state(io);
+    }
+}
+
+long FV3_(nrevb)::getMemorySize()
+{
+  long size = 0;
+  for(long i = 0;i < FV3_NREVB_NUM_COMB_2;i ++) size += comb2L[i].getsize() + comb2R[i].getsize();
+  for(long i = 0;i < FV3_NREVB_NUM_ALLPASS_2;i ++) size += allpass2L[i].getsize() + allpass2R[i].getsize();
+  return FV3_(nrev)::getMemorySize() + size*sizeof(fv3_float_t);
+}
+
 void FV3_(nrevb)::setcombfeedback(fv3_float_t back, long zero)
 {
   FV3_(nrev)::setcombfeedback(back, zero);
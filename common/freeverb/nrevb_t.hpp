@@ -23,6 +23,8 @@ class _FV3_(nrevb) : public _FV3_(nrev)
  public:
   _FV3_(nrevb)() throw(std::bad_alloc);
   virtual void mute();
+  virtual void state(state_io& io);
+  virtual long getMemorySize();
   virtual void setdamp(_fv3_float_t value);
   virtual void setfeedback(_fv3_float_t value);
   void setapfeedback(_fv3_float_t value){apfeedback = value;}
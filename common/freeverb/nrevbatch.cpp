@@ -0,0 +1,522 @@
+/**
+ *  CCRMA NRev for several instances at once (nrevbatch)
+ *
+ *  Copyright (C) 2006-2018 Teru Kamogashira
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "freeverb/nrevbatch.hpp"
+#include "freeverb/fv3_type_float.h"
+#include "freeverb/fv3_ns_start.h"
+
+// Same tuning as nrev
+const long FV3_(nrevbatch)::combCo[] =    {1433, 1601, 1867, 2053, 2251, 2399,};
+const long FV3_(nrevbatch)::allpassCo[] = {347, 113, 37, 59, 53, 43, 37, 29, 19,};
+
+// nrev's allpassL and allpassR in the order nrev runs them, the last
+// allpass of the right channel is allpassL[6]
+const long FV3_(nrevbatch)::allpassChain[2][FV3_NREVBATCH_NUM_ALLPASS] = {{0, 1, 2, 3, 5,}, {0, 1, 2, 3, 6,},};
+
+FV3_(nrevbatch)::FV3_(nrevbatch)()
+		throw(std::bad_alloc)
+{
+  lanes = stride = 0; clock = 0;
+  currentfs = FV3_REVBASE_DEFAULT_FS;
+  work = NULL;
+  long r = 0;
+  for(long c = 0;c < 2;c ++)
+    {
+      for(long i = 0;i < FV3_NREV_NUM_COMB;i ++) rings[r++] = &comb[c][i];
+      for(long i = 0;i < FV3_NREVBATCH_NUM_ALLPASS;i ++) rings[r++] = &allpass[c][i];
+      rings[r++] = &delayW[c];
+      rings[r++] = &delayD[c];
+    }
+  for(r = 0;r < FV3_NREVBATCH_NUM_RING;r ++) rings[r]->buffer = NULL;
+  freeRings();
+
+  // defaults of nrev and revbase
+  for(long k = 0;k < FV3_NREVBATCH_MAX_LANES;k ++)
+    {
+      rsfactor[k] = 1; preDelay[k] = 0; rt60[k] = 1; dccutfq[k] = 8;
+      wet[k] = dry[k] = width[k] = 1;
+      apFeedback[k] = 0.7; dccGain[k] = 0;
+      for(long c = 0;c < 2;c ++)
+	for(long i = 0;i < FV3_NREV_NUM_COMB;i ++) combFeedback[c][i][k] = 0;
+      combDamp1[k] = 0.5; combDamp2[k] = 0.5;
+      damp2[k] = damp2_1[k] = damp3[k] = damp3_1[k] = 0.5;
+      update_wet(k);
+    }
+  setLanes(1);
+}
+
+FV3_(nrevbatch)::FV3_(~nrevbatch)()
+{
+  freeRings();
+  FV3_(utils)::aligned_free(work);
+}
+
+void FV3_(nrevbatch)::freeRings()
+{
+  for(long r = 0;r < FV3_NREVBATCH_NUM_RING;r ++)
+    {
+      FV3_(utils)::aligned_free(rings[r]->buffer);
+      rings[r]->buffer = NULL;
+      rings[r]->capacity = rings[r]->mask = 0;
+      for(long k = 0;k < FV3_NREVBATCH_MAX_LANES;k ++) rings[r]->size[k] = 0;
+      rings[r]->uniform = true;
+    }
+}
+
+void FV3_(nrevbatch)::setLanes(long value)
+		throw(std::bad_alloc)
+{
+  if(value < 1||value > FV3_NREVBATCH_MAX_LANES) return;
+  long newStride = (value + FV3_NREVBATCH_LANE_GROUP - 1)/FV3_NREVBATCH_LANE_GROUP*FV3_NREVBATCH_LANE_GROUP;
+  if(newStride != stride)
+    {
+      // the rings are interleaved by the stride, so they start over
+      freeRings();
+      fv3_float_t * newWork = (fv3_float_t*)FV3_(utils)::aligned_malloc(sizeof(fv3_float_t)*FV3_NREVBATCH_BLOCK*newStride*5, FV3_PTR_ALIGN_BYTE);
+      if(newWork == NULL) throw std::bad_alloc();
+      FV3_(utils)::aligned_free(work);
+      work = newWork;
+      stride = newStride;
+      inBlock[0] = work;
+      inBlock[1] = work + FV3_NREVBATCH_BLOCK*stride;
+      hpfBlock = work + FV3_NREVBATCH_BLOCK*stride*2;
+      outBlock[0] = work + FV3_NREVBATCH_BLOCK*stride*3;
+      outBlock[1] = work + FV3_NREVBATCH_BLOCK*stride*4;
+    }
+  lanes = value;
+  for(long k = 0;k < lanes;k ++) setFsFactors(k);
+  mute();
+}
+
+long FV3_(nrevbatch)::getLanes()
+{
+  return lanes;
+}
+
+void FV3_(nrevbatch)::setSampleRate(fv3_float_t fs)
+		throw(std::bad_alloc)
+{
+  if(fs <= 0) return;
+  currentfs = fs;
+  for(long k = 0;k < lanes;k ++) setFsFactors(k);
+}
+
+fv3_float_t FV3_(nrevbatch)::getSampleRate()
+{
+  return currentfs;
+}
+
+void FV3_(nrevbatch)::setRSFactor(long lane, fv3_float_t value)
+		throw(std::bad_alloc)
+{
+  if(lane < 0||lane >= lanes||value <= 0) return;
+  rsfactor[lane] = value;
+  setFsFactors(lane);
+}
+
+void FV3_(nrevbatch)::setPreDelay(long lane, fv3_float_t value_ms)
+		throw(std::bad_alloc)
+{
+  if(lane < 0||lane >= lanes) return;
+  long initialDelay = (long)(currentfs*(preDelay[lane] = value_ms)/1000.);
+  for(long c = 0;c < 2;c ++)
+    {
+      // a negative pre-delay delays the dry signal instead, as in revbase
+      setRingSize(&delayW[c], lane, initialDelay >= 0 ? initialDelay : 0);
+      setRingSize(&delayD[c], lane, initialDelay >= 0 ? 0 : -initialDelay);
+    }
+}
+
+void FV3_(nrevbatch)::setrt60(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  fv3_float_t back = (rt60[lane] = value)*currentfs;
+  for(long c = 0;c < 2;c ++)
+    for(long i = 0;i < FV3_NREV_NUM_COMB;i ++)
+      {
+	if(back > 0)
+	  combFeedback[c][i][lane] = std::pow((fv3_float_t)10.0, -3 * (fv3_float_t)comb[c][i].size[lane] / back);
+	else
+	  combFeedback[c][i][lane] = 0;
+      }
+}
+
+void FV3_(nrevbatch)::setfeedback(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  apFeedback[lane] = value;
+}
+
+void FV3_(nrevbatch)::setdamp(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  combDamp1[lane] = value; combDamp2[lane] = 1 - value;
+}
+
+void FV3_(nrevbatch)::setdamp2(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  damp2[lane] = value; damp2_1[lane] = 1 - value;
+}
+
+void FV3_(nrevbatch)::setdamp3(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  damp3[lane] = value; damp3_1[lane] = 1 - value;
+}
+
+void FV3_(nrevbatch)::setdccutfreq(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  if(value < 0) value = 0;
+  if(value > currentfs/2) value = currentfs/2;
+  dccutfq[lane] = value;
+  // dccut::setCutOnFreq()
+  fv3_float_t _fc = 2*value/currentfs;
+  dccGain[lane] = (std::sqrt(3.) - 2.*std::sin(M_PI*_fc))/(std::sin(M_PI*_fc) + std::sqrt(3.)*std::cos(M_PI*_fc));
+}
+
+void FV3_(nrevbatch)::setwetr(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  wet[lane] = value;
+  update_wet(lane);
+}
+
+void FV3_(nrevbatch)::setdryr(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  dry[lane] = value;
+}
+
+void FV3_(nrevbatch)::setwidth(long lane, fv3_float_t value)
+{
+  if(lane < 0||lane >= lanes) return;
+  width[lane] = value;
+  update_wet(lane);
+}
+
+void FV3_(nrevbatch)::update_wet(long lane)
+{
+  wet1[lane] = wet[lane]*(width[lane]/2 + 0.5f);
+  wet2[lane] = wet[lane]*((1-width[lane])/2);
+}
+
+void FV3_(nrevbatch)::mute()
+{
+  // with the padding lanes of the last group
+  for(long k = 0;k < stride;k ++) muteState(k);
+  for(long r = 0;r < FV3_NREVBATCH_NUM_RING;r ++)
+    if(rings[r]->buffer != NULL) FV3_(utils)::mute(rings[r]->buffer, rings[r]->capacity*stride);
+}
+
+void FV3_(nrevbatch)::mute(long lane)
+{
+  if(lane < 0||lane >= lanes) return;
+  muteState(lane);
+  for(long r = 0;r < FV3_NREVBATCH_NUM_RING;r ++)
+    for(long t = 0;t < rings[r]->capacity;t ++) rings[r]->buffer[t*stride+lane] = 0;
+}
+
+void FV3_(nrevbatch)::muteState(long lane)
+{
+  hpf[lane] = lpf[0][lane] = lpf[1][lane] = 0;
+  inDCC1[lane] = inDCC2[lane] = 0;
+  for(long c = 0;c < 2;c ++)
+    {
+      outDCC1[c][lane] = outDCC2[c][lane] = 0;
+      for(long i = 0;i < FV3_NREV_NUM_COMB;i ++) combStore[c][i][lane] = 0;
+    }
+}
+
+long FV3_(nrevbatch)::getMemorySize()
+{
+  long size = FV3_NREVBATCH_BLOCK*stride*5;
+  for(long r = 0;r < FV3_NREVBATCH_NUM_RING;r ++) size += rings[r]->capacity*stride;
+  return size*sizeof(fv3_float_t);
+}
+
+void FV3_(nrevbatch)::setFsFactors(long lane)
+		throw(std::bad_alloc)
+{
+  fv3_float_t totalFactor = currentfs*rsfactor[lane]/(fv3_float_t)FV3_NREV_DEFAULT_FS;
+  long stereoSpread = f_((long)FV3_NREV_STEREO_SPREAD, totalFactor);
+  for(long i = 0;i < FV3_NREV_NUM_COMB;i ++)
+    {
+      setRingSize(&comb[0][i], lane, p_(combCo[i],totalFactor));
+      setRingSize(&comb[1][i], lane, p_(f_(combCo[i],totalFactor)+stereoSpread,1));
+    }
+  for(long i = 0;i < FV3_NREVBATCH_NUM_ALLPASS;i ++)
+    {
+      setRingSize(&allpass[0][i], lane, p_(allpassCo[allpassChain[0][i]],totalFactor));
+      // allpassL[6] on the right channel keeps the size of the left one
+      if(i < 4)
+	setRingSize(&allpass[1][i], lane, p_(f_(allpassCo[allpassChain[1][i]],totalFactor)+stereoSpread,1));
+      else
+	setRingSize(&allpass[1][i], lane, p_(allpassCo[allpassChain[1][i]],totalFactor));
+    }
+  setPreDelay(lane, preDelay[lane]);
+  setrt60(lane, rt60[lane]);
+  setdccutfreq(lane, dccutfq[lane]);
+}
+
+void FV3_(nrevbatch)::setRingSize(FV3_(nrevbatch_ring) * ring, long lane, long size)
+		throw(std::bad_alloc)
+{
+  ring->size[lane] = size;
+  if(size >= ring->capacity)
+    {
+      long capacity = FV3_(utils)::checkPow2(size + 1);
+      fv3_float_t * buffer = (fv3_float_t*)FV3_(utils)::aligned_malloc(sizeof(fv3_float_t)*capacity*stride, FV3_PTR_ALIGN_BYTE);
+      if(buffer == NULL) throw std::bad_alloc();
+      FV3_(utils)::mute(buffer, capacity*stride);
+      // keep the samples the other lanes still read, each at its time
+      for(long t = 1;t <= ring->capacity;t ++)
+	{
+	  unsigned long time = clock - t;
+	  for(long k = 0;k < stride;k ++)
+	    buffer[(time & (capacity - 1))*stride+k] = ring->buffer[(time & ring->mask)*stride+k];
+	}
+      FV3_(utils)::aligned_free(ring->buffer);
+      ring->buffer = buffer;
+      ring->capacity = capacity;
+      ring->mask = capacity - 1;
+    }
+  updateRing(ring);
+}
+
+void FV3_(nrevbatch)::updateRing(FV3_(nrevbatch_ring) * ring)
+{
+  // the padding lanes follow lane 0 so that they do not break uniform rings
+  for(long k = lanes;k < stride;k ++) ring->size[k] = ring->size[0];
+  ring->uniform = true;
+  for(long k = 1;k < stride;k ++)
+    if(ring->size[k] != ring->size[0]) ring->uniform = false;
+}
+
+long FV3_(nrevbatch)::f_(long def, fv3_float_t factor)
+{
+  long fact = (long)((fv3_float_t)def*factor); if(fact <= 0) fact = 1;
+  return fact;
+}
+
+long FV3_(nrevbatch)::p_(long def, fv3_float_t factor)
+{
+  long base = f_(def,factor);
+  while(!FV3_(utils)::isPrime(base)) base++;
+  return base;
+}
+
+// The stages below run one after another over a block, each for all lanes
+// of a time step at once. Within a stage the order in time is kept, so the
+// result is that of nrev running sample by sample.
+
+void FV3_(nrevbatch)::processComb(FV3_(nrevbatch_ring) * ring, fv3_float_t * store, const fv3_float_t * feedback,
+				  const fv3_float_t * input, fv3_float_t * output, long count)
+{
+  // local copies, which the compiler knows the rings do not overwrite
+  fv3_float_t fs[FV3_NREVBATCH_MAX_LANES], fb[FV3_NREVBATCH_MAX_LANES];
+  fv3_float_t d1[FV3_NREVBATCH_MAX_LANES], d2[FV3_NREVBATCH_MAX_LANES];
+  for(long k = 0;k < stride;k ++)
+    {
+      fs[k] = store[k]; fb[k] = feedback[k]; d1[k] = combDamp1[k]; d2[k] = combDamp2[k];
+    }
+  for(long j = 0;j < count;j ++)
+    {
+      unsigned long time = clock + j;
+      fv3_float_t * w = ring->buffer + (time & ring->mask)*stride;
+      const fv3_float_t * in = input + j*stride;
+      fv3_float_t * out = output + j*stride;
+      if(ring->uniform)
+	{
+	  const fv3_float_t * r = ring->buffer + ((time - ring->size[0]) & ring->mask)*stride;
+	  for(long k = 0;k < stride;k ++)
+	    {
+	      fv3_float_t bufout = r[k];
+	      fs[k] = (bufout * d2[k]) + (fs[k] * d1[k]);
+	      w[k] = in[k] + (fs[k] * fb[k]);
+	      out[k] += bufout;
+	    }
+	}
+      else
+	{
+	  for(long k = 0;k < stride;k ++)
+	    {
+	      fv3_float_t bufout = ring->buffer[((time - ring->size[k]) & ring->mask)*stride+k];
+	      fs[k] = (bufout * d2[k]) + (fs[k] * d1[k]);
+	      w[k] = in[k] + (fs[k] * fb[k]);
+	      out[k] += bufout;
+	    }
+	}
+    }
+  for(long k = 0;k < stride;k ++) store[k] = fs[k];
+}
+
+void FV3_(nrevbatch)::processAllpass(FV3_(nrevbatch_ring) * ring, const fv3_float_t * feedback, fv3_float_t * signal, long count)
+{
+  for(long j = 0;j < count;j ++)
+    {
+      unsigned long time = clock + j;
+      fv3_float_t * w = ring->buffer + (time & ring->mask)*stride;
+      fv3_float_t * s = signal + j*stride;
+      if(ring->uniform)
+	{
+	  const fv3_float_t * r = ring->buffer + ((time - ring->size[0]) & ring->mask)*stride;
+	  for(long k = 0;k < stride;k ++)
+	    {
+	      fv3_float_t bufout = r[k];
+	      w[k] = s[k] + (bufout * feedback[k]);
+	      s[k] = bufout - s[k];
+	    }
+	}
+      else
+	{
+	  for(long k = 0;k < stride;k ++)
+	    {
+	      fv3_float_t bufout = ring->buffer[((time - ring->size[k]) & ring->mask)*stride+k];
+	      w[k] = s[k] + (bufout * feedback[k]);
+	      s[k] = bufout - s[k];
+	    }
+	}
+    }
+}
+
+void FV3_(nrevbatch)::processDelay(FV3_(nrevbatch_ring) * ring, const fv3_float_t * input, fv3_float_t * output, long count)
+{
+  // written before it is read, so a size of 0 passes the input
+  for(long j = 0;j < count;j ++)
+    {
+      unsigned long time = clock + j;
+      fv3_float_t * w = ring->buffer + (time & ring->mask)*stride;
+      const fv3_float_t * in = input + j*stride;
+      fv3_float_t * out = output + j*stride;
+      for(long k = 0;k < stride;k ++) w[k] = in[k];
+      if(ring->uniform)
+	{
+	  const fv3_float_t * r = ring->buffer + ((time - ring->size[0]) & ring->mask)*stride;
+	  for(long k = 0;k < stride;k ++) out[k] = r[k];
+	}
+      else
+	{
+	  for(long k = 0;k < stride;k ++) out[k] = ring->buffer[((time - ring->size[k]) & ring->mask)*stride+k];
+	}
+    }
+}
+
+void FV3_(nrevbatch)::processChannel(long channel, long count)
+{
+  fv3_float_t * out = outBlock[channel];
+  for(long t = 0;t < count*stride;t ++) out[t] = 0;
+  for(long i = 0;i < FV3_NREV_NUM_COMB;i ++)
+    processComb(&comb[channel][i], combStore[channel][i], combFeedback[channel][i], hpfBlock, out, count);
+  for(long i = 0;i < 3;i ++) processAllpass(&allpass[channel][i], apFeedback, out, count);
+
+  fv3_float_t * lp = lpf[channel];
+  for(long j = 0;j < count;j ++)
+    {
+      fv3_float_t * s = out + j*stride;
+      for(long k = 0;k < stride;k ++) s[k] = lp[k] = damp2[k]*lp[k] + damp2_1[k]*s[k];
+    }
+
+  processAllpass(&allpass[channel][3], apFeedback, out, count);
+  processAllpass(&allpass[channel][4], apFeedback, out, count);
+
+  // dccut::processd1()
+  fv3_float_t * y1 = outDCC1[channel], * y2 = outDCC2[channel];
+  for(long j = 0;j < count;j ++)
+    {
+      fv3_float_t * s = out + j*stride;
+      for(long k = 0;k < stride;k ++)
+	{
+	  fv3_float_t input = s[k];
+	  fv3_float_t output = input - y1[k]; y1[k] = input;
+	  output += dccGain[k] * y2[k]; y2[k] = output;
+	  s[k] = output;
+	}
+    }
+  processDelay(&delayW[channel], out, out, count);
+}
+
+void FV3_(nrevbatch)::processreplace(fv3_float_t * const * inputL, fv3_float_t * const * inputR,
+				     fv3_float_t * const * outputL, fv3_float_t * const * outputR, long numsamples)
+{
+  if(numsamples <= 0) return;
+
+  // flush denormals for the whole call instead of testing every sample.
+  // Scalar nrev only flushes a few values with UNDENORMAL, so once a tail
+  // decays into the denormal range a lane may differ from nrev by denormal
+  // amounts. Above it the lanes follow nrev within rounding.
+  uint32_t mxcsr = FV3_(utils)::getMXCSR();
+  FV3_(utils)::setMXCSR(mxcsr|FV3_X86SIMD_MXCSR_FZ|FV3_X86SIMD_MXCSR_DAZ);
+
+  fv3_float_t * const * inputs[2] = {inputL, inputR,};
+  for(long offset = 0;offset < numsamples;offset += FV3_NREVBATCH_BLOCK)
+    {
+      long count = numsamples - offset;
+      if(count > FV3_NREVBATCH_BLOCK) count = FV3_NREVBATCH_BLOCK;
+
+      for(long c = 0;c < 2;c ++)
+	for(long j = 0;j < count;j ++)
+	  {
+	    fv3_float_t * in = inBlock[c] + j*stride;
+	    for(long k = 0;k < lanes;k ++) in[k] = inputs[c][k][offset+j];
+	    for(long k = lanes;k < stride;k ++) in[k] = 0;
+	  }
+
+      // inDCC and the input filter are shared by both channels
+      for(long j = 0;j < count;j ++)
+	{
+	  const fv3_float_t * l = inBlock[0] + j*stride, * r = inBlock[1] + j*stride;
+	  fv3_float_t * h = hpfBlock + j*stride;
+	  for(long k = 0;k < stride;k ++)
+	    {
+	      fv3_float_t input = l[k] + r[k];
+	      fv3_float_t output = input - inDCC1[k]; inDCC1[k] = input;
+	      output += dccGain[k] * inDCC2[k]; inDCC2[k] = output;
+	      hpf[k] = damp3_1[k]*output - damp3[k]*hpf[k];
+	      hpf[k] *= FV3_NREV_SCALE_WET;
+	      h[k] = hpf[k];
+	    }
+	}
+
+      processChannel(0, count);
+      processChannel(1, count);
+
+      // the dry signal goes through delayD, inBlock is free after it
+      processDelay(&delayD[0], inBlock[0], inBlock[0], count);
+      processDelay(&delayD[1], inBlock[1], inBlock[1], count);
+      for(long j = 0;j < count;j ++)
+	{
+	  const fv3_float_t * oL = outBlock[0] + j*stride, * oR = outBlock[1] + j*stride;
+	  const fv3_float_t * dL = inBlock[0] + j*stride, * dR = inBlock[1] + j*stride;
+	  for(long k = 0;k < lanes;k ++)
+	    {
+	      outputL[k][offset+j] = oL[k]*wet1[k] + oR[k]*wet2[k] + dL[k]*dry[k];
+	      outputR[k][offset+j] = oR[k]*wet1[k] + oL[k]*wet2[k] + dR[k]*dry[k];
+	    }
+	}
+      clock += count;
+    }
+
+  FV3_(utils)::setMXCSR(mxcsr);
+}
+
+#include "freeverb/fv3_ns_end.h"
@@ -0,0 +1,64 @@
+/**
+ *  CCRMA NRev for several instances at once (nrevbatch)
+ *
+ *  Copyright (C) 2006-2018 Teru Kamogashira
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _FV3_NREVBATCH_HPP
+#define _FV3_NREVBATCH_HPP
+
+#include <new>
+#include <stdint.h>
+
+#include "freeverb/nrev.hpp"
+#include "freeverb/utils.hpp"
+#include "freeverb/fv3_defs.h"
+
+// Lanes are processed in groups of FV3_NREVBATCH_LANE_GROUP, so 4, 8 and
+// 16 instances fill SSE, AVX and AVX-512 registers
+#define FV3_NREVBATCH_MAX_LANES  16
+#define FV3_NREVBATCH_LANE_GROUP 4
+#define FV3_NREVBATCH_BLOCK      64
+// allpasses nrev runs per channel
+#define FV3_NREVBATCH_NUM_ALLPASS 5
+#define FV3_NREVBATCH_NUM_RING    (2*FV3_NREV_NUM_COMB + 2*FV3_NREVBATCH_NUM_ALLPASS + 4)
+
+namespace fv3
+{
+
+#define _fv3_float_t float
+#define _FV3_(name) name ## _f
+#include "freeverb/nrevbatch_t.hpp"
+#undef _FV3_
+#undef _fv3_float_t
+
+#define _fv3_float_t double
+#define _FV3_(name) name ## _
+#include "freeverb/nrevbatch_t.hpp"
+#undef _FV3_
+#undef _fv3_float_t
+
+#define _fv3_float_t long double
+#define _FV3_(name) name ## _l
+#include "freeverb/nrevbatch_t.hpp"
+#undef _FV3_
+#undef _fv3_float_t
+
+};
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ *  CCRMA NRev for several instances at once (nrevbatch)
+ *
+ *  Copyright (C) 2006-2018 Teru Kamogashira
+ *  Copyright (c) 2025 luna-co-software
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// One delay element of every lane. Sample t of lane k is stored at
+// ((t & mask)*stride + k), so the lanes share the ring and its clock and
+// only their lengths differ.
+typedef struct {
+  _fv3_float_t * buffer;
+  long capacity, mask;
+  long size[FV3_NREVBATCH_MAX_LANES];
+  bool uniform;
+} _FV3_(nrevbatch_ring);
+
+// nrev for up to FV3_NREVBATCH_MAX_LANES instances with their own
+// parameters. The state is laid out so that lane k of a SIMD register
+// belongs to instance k, and every stage runs for all lanes at once.
+// This is the nrev loop, which nrevb also runs, nrevb's extra combs and
+// allpasses are allocated there but not processed.
+// Denormals are flushed through MXCSR during processreplace(), unlike in
+// nrev.
+class _FV3_(nrevbatch)
+{
+ public:
+  _FV3_(nrevbatch)() throw(std::bad_alloc);
+  virtual _FV3_(~nrevbatch)();
+
+  /**
+   * set the number of instances, which are muted.
+   * @param[in] value 1 to FV3_NREVBATCH_MAX_LANES.
+   */
+  void setLanes(long value) throw(std::bad_alloc);
+  long getLanes();
+
+  // shared by all lanes
+  void setSampleRate(_fv3_float_t fs) throw(std::bad_alloc);
+  _fv3_float_t getSampleRate();
+
+  // per lane, as in nrev and revbase
+  void setRSFactor(long lane, _fv3_float_t value) throw(std::bad_alloc);
+  void setPreDelay(long lane, _fv3_float_t value_ms) throw(std::bad_alloc);
+  void setrt60(long lane, _fv3_float_t value);
+  void setfeedback(long lane, _fv3_float_t value);
+  void setdamp(long lane, _fv3_float_t value);
+  void setdamp2(long lane, _fv3_float_t value);
+  void setdamp3(long lane, _fv3_float_t value);
+  void setdccutfreq(long lane, _fv3_float_t value);
+  void setwetr(long lane, _fv3_float_t value);
+  void setdryr(long lane, _fv3_float_t value);
+  void setwidth(long lane, _fv3_float_t value);
+
+  void mute();
+  void mute(long lane);
+  long getMemorySize();
+
+  /**
+   * process every lane, planar stereo buffers indexed by lane.
+   * @param[in] numsamples frames of every buffer.
+   */
+  void processreplace(_fv3_float_t * const * inputL, _fv3_float_t * const * inputR,
+		      _fv3_float_t * const * outputL, _fv3_float_t * const * outputR, long numsamples);
+
+ private:
+  _FV3_(nrevbatch)(const _FV3_(nrevbatch)& x);
+  _FV3_(nrevbatch)& operator=(const _FV3_(nrevbatch)& x);
+
+  void freeRings();
+  void muteState(long lane);
+  void setFsFactors(long lane) throw(std::bad_alloc);
+  void setRingSize(_FV3_(nrevbatch_ring) * ring, long lane, long size) throw(std::bad_alloc);
+  void updateRing(_FV3_(nrevbatch_ring) * ring);
+  void update_wet(long lane);
+  long f_(long def, _fv3_float_t factor);
+  long p_(long def, _fv3_float_t factor);
+
+  void processComb(_FV3_(nrevbatch_ring) * ring, _fv3_float_t * store, const _fv3_float_t * feedback,
+		   const _fv3_float_t * input, _fv3_float_t * output, long count);
+  void processAllpass(_FV3_(nrevbatch_ring) * ring, const _fv3_float_t * feedback, _fv3_float_t * signal, long count);
+  void processDelay(_FV3_(nrevbatch_ring) * ring, const _fv3_float_t * input, _fv3_float_t * output, long count);
+  void processChannel(long channel, long count);
+
+  long lanes, stride;
+  unsigned long clock;
+  _fv3_float_t currentfs;
+
+  // parameters
+  _fv3_float_t rsfactor[FV3_NREVBATCH_MAX_LANES], preDelay[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t rt60[FV3_NREVBATCH_MAX_LANES], dccutfq[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t wet[FV3_NREVBATCH_MAX_LANES], dry[FV3_NREVBATCH_MAX_LANES], width[FV3_NREVBATCH_MAX_LANES];
+
+  // coefficients
+  _fv3_float_t combFeedback[2][FV3_NREV_NUM_COMB][FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t combDamp1[FV3_NREVBATCH_MAX_LANES], combDamp2[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t apFeedback[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t damp2[FV3_NREVBATCH_MAX_LANES], damp2_1[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t damp3[FV3_NREVBATCH_MAX_LANES], damp3_1[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t dccGain[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t wet1[FV3_NREVBATCH_MAX_LANES], wet2[FV3_NREVBATCH_MAX_LANES];
+
+  // state, [channel] is L and R
+  _fv3_float_t combStore[2][FV3_NREV_NUM_COMB][FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t hpf[FV3_NREVBATCH_MAX_LANES], lpf[2][FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t inDCC1[FV3_NREVBATCH_MAX_LANES], inDCC2[FV3_NREVBATCH_MAX_LANES];
+  _fv3_float_t outDCC1[2][FV3_NREVBATCH_MAX_LANES], outDCC2[2][FV3_NREVBATCH_MAX_LANES];
+
+  // delay elements. allpass[channel] runs the chain nrev runs for it, the
+  // right channel ends with nrev's allpassL[6].
+  _FV3_(nrevbatch_ring) comb[2][FV3_NREV_NUM_COMB];
+  _FV3_(nrevbatch_ring) allpass[2][FV3_NREVBATCH_NUM_ALLPASS];
+  _FV3_(nrevbatch_ring) delayW[2], delayD[2];
+  _FV3_(nrevbatch_ring) * rings[FV3_NREVBATCH_NUM_RING];
+
+  // lane interleaved work buffers, one block
+  _fv3_float_t * work;
+  _fv3_float_t * inBlock[2];
+  _fv3_float_t * hpfBlock;
+  _fv3_float_t * outBlock[2];
+
+  const static long combCo[FV3_NREV_NUM_COMB], allpassCo[FV3_NREV_NUM_ALLPASS];
+  const static long allpassChain[2][FV3_NREVBATCH_NUM_ALLPASS];
+};
@@ -80,6 +80,31 @@ void FV3_(progenitor)::mute()
   outCombL.mute(), outCombR.mute();
 }
 
+void FV3_(progenitor)::state(state_io& io)
+{
+  FV3_(revbase)::state(io);
+  dccutL.state(io), dccutR.state(io);
+  lpfL_in_59_60.state(io), lpfR_in_64_65.state(io), lpfLdamp_11_12.state(io), lpfRdamp_13_14.state(io),
+    lpfL_9_10.state(io), lpfR_7_8.state(io), out1_lpf.state(io), out2_lpf.state(io);
+  delayL_16.state(io), delayL_23.state(io), delayL_31.state(io), delayL_37.state(io);
+  delayR_49.state(io), delayR_ts.state(io), delayR_40.state(io), delayR_41.state(io), delayR_58.state(io);
+  allpassmL_15_16.state(io), allpassmL_17_18.state(io), allpassmR_19_20.state(io), allpassmR_21_22.state(io);
+  allpass2L_25_27.state(io), allpass2R_43_45.state(io);
+  allpass3L_34_37.state(io), allpass3R_52_55.state(io);
+  lfo1.state(io), lfo1_lpf.state(io), lfo2.state(io), lfo2_lpf.state(io);
+  outCombL.state(io), outCombR.state(io);
+}
+
+long FV3_(progenitor)::getMemorySize()
+{
+  long size = delayL_16.getsize() + delayL_23.getsize() + delayL_31.getsize() + delayL_37.getsize()
+    + delayR_49.getsize() + delayR_ts.getsize() + delayR_40.getsize() + delayR_41.getsize() + delayR_58.getsize()
+    + allpassmL_15_16.getsize() + allpassmL_17_18.getsize() + allpassmR_19_20.getsize() + allpassmR_21_22.getsize()
+    + allpass2L_25_27.getsize() + allpass2R_43_45.getsize() + allpass3L_34_37.getsize() + allpass3R_52_55.getsize()
+    + outCombL.getsize() + outCombR.getsize();
+  return FV3_(revbase)::getMemorySize() + size*sizeof(fv3_float_t);
+}
+
 void FV3_(progenitor)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
 		    throw(std::bad_alloc)
 {
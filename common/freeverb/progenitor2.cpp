@@ -33,6 +33,10 @@ const long FV3_(progenitor2)::idxOutCo2[] = {110, 790, 2, 189, 121, 10, 480, 359
 FV3_(progenitor2)::FV3_(progenitor2)()
 	       throw(std::bad_alloc)
 {
+  idiffStages = idiffFadeFrom = FV3_PROGENITOR2_NUM_IALLPASS;
+  idiffFade = 0;
+  idiffFadeLength = (long)(FV3_PROGENITOR2_STAGE_FADE*getTotalSampleRate());
+  modMode = FV3_PROGENITOR2_MOD_ALLPASS;
   setidiffusion1(0.78);
   setodiffusion1(0.78);
   setmodulationnoise1(0.09);
@@ -54,6 +58,37 @@ void FV3_(progenitor2)::mute()
     {
       iAllpassCL[i].mute(); iAllpassCR[i].mute();
     }
+  idiffFade = 0;
+}
+
+void FV3_(progenitor2)::state(state_io& io)
+{
+  FV3_(progenitor)::state(io);
+  bassAPL.state(io), bassAPR.state(io);
+  noise1.state(io);
+  for(long i = 0;i < FV3_PROGENITOR2_NUM_IALLPASS;i ++)
+    {
+      iAllpassL[i].state(io); iAllpassR[i].state(io);
+    }
+  for(long i = 0;i < FV3_PROGENITOR2_NUM_CALLPASS;i ++)
+    {
+      iAllpassCL[i].state(io); iAllpassCR[i].state(io);
+    }
+  io.value(idiffFadeFrom);
+  io.value(idiffFade);
+  if(idiffFadeFrom < 1||idiffFadeFrom > FV3_PROGENITOR2_NUM_IALLPASS||idiffFade < 0||idiffFade > idiffFadeLength)
+    {
+      idiffFade = 0;
+      io.fail();
+    }
+}
+
+long FV3_(progenitor2)::getMemorySize()
+{
+  long size = 0;
+  for(long i = 0;i < FV3_PROGENITOR2_NUM_IALLPASS;i ++) size += iAllpassL[i].getsize() + iAllpassR[i].getsize();
+  for(long i = 0;i < FV3_PROGENITOR2_NUM_CALLPASS;i ++) size += iAllpassCL[i].getsize() + iAllpassCR[i].getsize();
+  return FV3_(progenitor)::getMemorySize() + size*sizeof(fv3_float_t);
 }
 
 void FV3_(progenitor2)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
@@ -69,29 +104,78 @@ void FV3_(progenitor2)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR,
     default:
       ;
     }
-  
+  processloop(inputL, inputR, outputL, outputR, numsamples, false);
+}
+
+void FV3_(progenitor2)::processreplaceM(fv3_float_t *input, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+		       throw(std::bad_alloc)
+{
+  if(reverbType == FV3_REVTYPE_PROG||!dccutL.samestate(dccutR))
+    {
+      processreplace(input, input, outputL, outputR, numsamples);
+      return;
+    }
+  processloop(input, input, outputL, outputR, numsamples, true);
+  // dccutR skipped the block, it takes the state it would have
+  dccutR.copystate(dccutL);
+}
+
+void FV3_(progenitor2)::processloop(fv3_float_t *inputL, fv3_float_t *inputR, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples, bool monoInput)
+{
   if(numsamples <= 0) return;
   long count = numsamples;
 
   fv3_float_t outL, outR;
+  const bool modulate = (modMode != FV3_PROGENITOR2_MOD_OFF);
+  const bool linear = (modMode != FV3_PROGENITOR2_MOD_ALLPASS);
 
   while(count-- > 0)
     {
-      outL = dccutL(*inputL), outR = dccutR(*inputR);
+      if(monoInput) outL = outR = dccutL(*inputL);
+      else outL = dccutL(*inputL), outR = dccutR(*inputR);
       
-      fv3_float_t mnoise = noise1();
-      fv3_float_t lfo = (lfo1() + modnoise1*mnoise)*wander;
-      lfo = lfo1_lpf(lfo);
-      // if(lfo < -1.) lfo = -1.; if(lfo > 1.) lfo = 1.;
-      mnoise *= modnoise2;
+      fv3_float_t mnoise = 0, lfo = 0;
+      if(modulate)
+	{
+	  mnoise = noise1();
+	  lfo = (lfo1() + modnoise1*mnoise)*wander;
+	  lfo = lfo1_lpf(lfo);
+	  // if(lfo < -1.) lfo = -1.; if(lfo > 1.) lfo = 1.;
+	  mnoise *= modnoise2;
+	}
 
-      // input diffusion
+      // input diffusion, a stage count change taps both counts
+      long stages = idiffStages, tap = 0;
+      fv3_float_t tapL = 0, tapR = 0;
+      if(idiffFade > 0)
+	{
+	  if(idiffFadeFrom > stages) stages = idiffFadeFrom, tap = idiffStages;
+	  else tap = idiffFadeFrom;
+	}
       fv3_float_t i_sign = -1;
-      for(long i = 0;i < FV3_PROGENITOR2_NUM_IALLPASS;i ++)
+      for(long i = 0;i < stages;i ++)
 	{
-	  outL = iAllpassL[i]._process(outL, lfo*i_sign, mnoise);
-	  outR = iAllpassR[i]._process(outR, lfo, mnoise*i_sign);
+	  if(linear)
+	    {
+	      outL = iAllpassL[i]._process_li(outL, lfo*i_sign, mnoise);
+	      outR = iAllpassR[i]._process_li(outR, lfo, mnoise*i_sign);
+	    }
+	  else
+	    {
+	      outL = iAllpassL[i]._process(outL, lfo*i_sign, mnoise);
+	      outR = iAllpassR[i]._process(outR, lfo, mnoise*i_sign);
+	    }
 	  i_sign *= -1;
+	  if(i + 1 == tap) tapL = outL, tapR = outR;
+	}
+      if(idiffFade > 0)
+	{
+	  // the old count fades out
+	  fv3_float_t fade = (fv3_float_t)idiffFade/(fv3_float_t)idiffFadeLength;
+	  if(tap == idiffFadeFrom) fade = 1 - fade;
+	  outL = tapL + (outL - tapL)*fade;
+	  outR = tapR + (outR - tapR)*fade;
+	  idiffFade --;
 	}
       
       fv3_float_t crossL = outL, crossR = outR;
@@ -113,8 +197,16 @@ void FV3_(progenitor2)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR,
       outR += loopdecay * (crossL + bassb * lpfR_7_8(bassAPR(crossL)));
             
       /* LPF damping and allpass diffusion */
-      outL = allpassmL_17_18._process_dc(delayL_16._process(allpassmL_15_16._process_dc(lpfLdamp_11_12(outL), lfo, mnoise)), lfo*(-1.), mnoise*(-1.));
-      outR = allpassmR_21_22._process_dc(delayR_ts._process(allpassmR_19_20._process_dc(lpfRdamp_13_14(outR), lfo*(-1.), mnoise*(-1.))), lfo, mnoise);
+      if(linear)
+	{
+	  outL = allpassmL_17_18._process_dc_li(delayL_16._process(allpassmL_15_16._process_dc_li(lpfLdamp_11_12(outL), lfo, mnoise)), lfo*(-1.), mnoise*(-1.));
+	  outR = allpassmR_21_22._process_dc_li(delayR_ts._process(allpassmR_19_20._process_dc_li(lpfRdamp_13_14(outR), lfo*(-1.), mnoise*(-1.))), lfo, mnoise);
+	}
+      else
+	{
+	  outL = allpassmL_17_18._process_dc(delayL_16._process(allpassmL_15_16._process_dc(lpfLdamp_11_12(outL), lfo, mnoise)), lfo*(-1.), mnoise*(-1.));
+	  outR = allpassmR_21_22._process_dc(delayR_ts._process(allpassmR_19_20._process_dc(lpfRdamp_13_14(outR), lfo*(-1.), mnoise*(-1.))), lfo, mnoise);
+	}
       
       delayL_37._process(allpass3L_34_37._process(delayL_31._process(allpass2L_25_27._process(delayL_23._process(outL))), lfo));
       // delayR_58._process(allpass3R_52_55._process(delayR_49._process(allpass2R_43_45._process(delayR_41._process(delayR_40._process(outR)))), lfo*(-1.)));
@@ -166,7 +258,7 @@ void FV3_(progenitor2)::processreplace(fv3_float_t *inputL, fv3_float_t *inputR,
 	   + allpass3R_52_55._get_z1(iOutC2[11]) + allpass3R_52_55._get_z2(iOutC2[13]) + allpass3R_52_55._get_z3(iOutC2[15])
 	   - allpass3L_34_37._get_z2(iOutC2[19]))*0.064 + delayR_58._get_z(iOutC2[17])*0.045;
       
-      lfo = lfo2_lpf(lfo2()*wander2);
+      if(modulate) lfo = lfo2_lpf(lfo2()*wander2);
       outL = outCombL._process_ff(Dout, lfo);
       outR = outCombR._process_ff(Bout, lfo*(-1.));
       
@@ -230,6 +322,17 @@ fv3_float_t FV3_(progenitor2)::getmodulationnoise2()
   return modnoise2;
 }
 
+void FV3_(progenitor2)::setnoiseseed(uint32_t value)
+{
+  noise1.setSeed(value);
+  noise1.mute();
+}
+
+uint32_t FV3_(progenitor2)::getnoiseseed()
+{
+  return noise1.getSeed();
+}
+
 void FV3_(progenitor2)::setcrossfeed(fv3_float_t value)
 {
   crossfeed = value;
@@ -240,6 +343,37 @@ fv3_float_t FV3_(progenitor2)::getcrossfeed()
   return crossfeed;
 }
 
+void FV3_(progenitor2)::setidiffusionstages(long value)
+{
+  if(value < 1) value = 1;
+  if(value > FV3_PROGENITOR2_NUM_IALLPASS) value = FV3_PROGENITOR2_NUM_IALLPASS;
+  if(value == idiffStages) return;
+  // a change during a fade starts over from the current count
+  for(long i = idiffStages;i < value;i ++)
+    {
+      iAllpassL[i].mute(); iAllpassR[i].mute();
+    }
+  idiffFadeFrom = idiffStages;
+  idiffStages = value;
+  idiffFade = idiffFadeLength;
+}
+
+long FV3_(progenitor2)::getidiffusionstages()
+{
+  return idiffStages;
+}
+
+void FV3_(progenitor2)::setmodulationmode(long value)
+{
+  if(value < FV3_PROGENITOR2_MOD_ALLPASS||value > FV3_PROGENITOR2_MOD_OFF) return;
+  modMode = value;
+}
+
+long FV3_(progenitor2)::getmodulationmode()
+{
+  return modMode;
+}
+
 void FV3_(progenitor2)::setbassap(fv3_float_t fc, fv3_float_t bw)
 {
   bassapfc = fc, bassapbw = bw;
@@ -250,6 +384,8 @@ void FV3_(progenitor2)::setbassap(fv3_float_t fc, fv3_float_t bw)
 void FV3_(progenitor2)::setFsFactors()
 {
   FV3_(progenitor)::setFsFactors();
+  idiffFadeLength = (long)(FV3_PROGENITOR2_STAGE_FADE*getTotalSampleRate());
+  idiffFade = 0;
   
   fv3_float_t totalFactor = getTotalFactorFs()/(fv3_float_t)FV3_PROGENITOR_DEFAULT_FS;
   fv3_float_t excurFactor = getTotalSampleRate()/(fv3_float_t)FV3_PROGENITOR_DEFAULT_FS;
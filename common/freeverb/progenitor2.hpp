@@ -29,6 +29,14 @@
 #define FV3_PROGENITOR2_NUM_CALLPASS 4
 #define FV3_PROGENITOR2_OUT_INDEX 20
 
+// Interpolation of the modulated allpasses, see setmodulationmode()
+#define FV3_PROGENITOR2_MOD_ALLPASS 0
+#define FV3_PROGENITOR2_MOD_LINEAR  1
+#define FV3_PROGENITOR2_MOD_OFF     2
+
+// Crossfade of an input diffusion stage count change (seconds)
+#define FV3_PROGENITOR2_STAGE_FADE 0.05
+
 namespace fv3
 {
 
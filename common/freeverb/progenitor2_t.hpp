@@ -24,8 +24,16 @@ class _FV3_(progenitor2) : public _FV3_(progenitor)
 public:
   _FV3_(progenitor2)() throw(std::bad_alloc);
   virtual void mute();
+  virtual void state(state_io& io);
+  virtual long getMemorySize();
   virtual void processreplace(_fv3_float_t *inputL, _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
     throw(std::bad_alloc);
+  /**
+   * process the same input on both channels, one dc cut filters it for
+   * both while the two are in the same state.
+   */
+  virtual void processreplaceM(_fv3_float_t *input, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
+    throw(std::bad_alloc);
   void setidiffusion1(_fv3_float_t value);
   _fv3_float_t getidiffusion1();
   void setodiffusion1(_fv3_float_t value);
@@ -34,15 +42,41 @@ public:
   _fv3_float_t getmodulationnoise1();
   void setmodulationnoise2(_fv3_float_t value);
   _fv3_float_t getmodulationnoise2();
+  /**
+   * set the seed of the modulation noise, which restarts from it. Give
+   * every instance its own seed so that reverbs fed the same signal do not
+   * modulate alike.
+   * @param[in] value the seed, 0 selects FV3_NOISEGEN_DEFAULT_SEED (default).
+   */
+  void setnoiseseed(uint32_t value);
+  uint32_t getnoiseseed();
   void setcrossfeed(_fv3_float_t value);
   _fv3_float_t getcrossfeed();
   void setbassap(_fv3_float_t fc, _fv3_float_t bw);
+  /**
+   * set the number of input diffusion allpasses that are run. The change is
+   * crossfaded over FV3_PROGENITOR2_STAGE_FADE seconds, added allpasses
+   * start muted.
+   * @param[in] value 1 to FV3_PROGENITOR2_NUM_IALLPASS (default).
+   */
+  void setidiffusionstages(long value);
+  long getidiffusionstages();
+  /**
+   * set the interpolation of the modulated allpasses.
+   * @param[in] value FV3_PROGENITOR2_MOD_ALLPASS (default),
+   * FV3_PROGENITOR2_MOD_LINEAR, which is cheaper, or FV3_PROGENITOR2_MOD_OFF,
+   * which reads the delays unmodulated and stops the LFOs and the noise.
+   */
+  void setmodulationmode(long value);
+  long getmodulationmode();
 
  protected:
   _FV3_(progenitor2)(const _FV3_(progenitor2)& x);
   _FV3_(progenitor2)& operator=(const _FV3_(progenitor2)& x);
   virtual void setFsFactors();
+  void processloop(_fv3_float_t *inputL, _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples, bool monoInput);
   _fv3_float_t idiff1, modnoise1, modnoise2, odiff1, crossfeed, bassapfc, bassapbw;
+  long idiffStages, modMode, idiffFadeFrom, idiffFade, idiffFadeLength;
   _FV3_(biquad) bassAPL, bassAPR;
   _FV3_(noisegen_pink_frac) noise1;
   _FV3_(allpassm) iAllpassL[FV3_PROGENITOR2_NUM_IALLPASS], iAllpassR[FV3_PROGENITOR2_NUM_IALLPASS];
@@ -24,6 +24,8 @@ class _FV3_(progenitor) : public _FV3_(revbase)
 public:
   _FV3_(progenitor)() throw(std::bad_alloc);
   virtual void mute();
+  virtual void state(state_io& io);
+  virtual long getMemorySize();
   virtual void processreplace(_fv3_float_t *inputL, _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
     throw(std::bad_alloc);
   
@@ -54,10 +54,19 @@ void FV3_(revbase)::setInitialDelay(long numsamples)
 #ifdef DEBUG
       std::fprintf(stderr, "revbase::setInitialDelay(%ld) delayW(%ld))\n", numsamples, initialDelay);
 #endif
-      delayL.setsize(0);
-      delayR.setsize(0);
-      delayWL.setsize(initialDelay);
-      delayWR.setsize(initialDelay);
+      // delay::setsize(0) keeps the old line, free() passes through
+      delayL.free();
+      delayR.free();
+      if(initialDelay > 0)
+        {
+          delayWL.setsize(initialDelay);
+          delayWR.setsize(initialDelay);
+        }
+      else
+        {
+          delayWL.free();
+          delayWR.free();
+        }
     }
   else
     {
@@ -67,8 +76,8 @@ void FV3_(revbase)::setInitialDelay(long numsamples)
 #endif
       delayL.setsize(dryD);
       delayR.setsize(dryD);
-      delayWL.setsize(0);
-      delayWR.setsize(0);
+      delayWL.free();
+      delayWR.free();
     }
 }
 
@@ -92,6 +101,11 @@ long FV3_(revbase)::getLatency()
   return 0;
 }
 
+long FV3_(revbase)::getMemorySize()
+{
+  return (delayL.getsize() + delayR.getsize() + delayWL.getsize() + delayWR.getsize())*sizeof(fv3_float_t);
+}
+
 void FV3_(revbase)::printconfig()
 {
   std::fprintf(stderr, "*** revbase config ***\n");
@@ -105,6 +119,18 @@ void FV3_(revbase)::mute()
   delayWL.mute(); delayWR.mute();
 }
 
+void FV3_(revbase)::state(state_io& io)
+{
+  delayL.state(io); delayR.state(io);
+  delayWL.state(io); delayWR.state(io);
+}
+
+void FV3_(revbase)::processreplaceM(fv3_float_t *input, fv3_float_t *outputL, fv3_float_t *outputR, long numsamples)
+  throw(std::bad_alloc)
+{
+  processreplace(input, input, outputL, outputR, numsamples);
+}
+
 void FV3_(revbase)::setwet(fv3_float_t value)
 {
   wetDB = value;
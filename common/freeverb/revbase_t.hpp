@@ -54,9 +54,28 @@ public:
   virtual void         setPreDelay(_fv3_float_t value_ms);
   virtual _fv3_float_t getPreDelay() const;
   virtual long getLatency();
+  /**
+   * @return The memory allocated for the delay lines in bytes.
+   */
+  virtual long getMemorySize();
   virtual void mute();
+  /**
+   * Save or load the signal state (see fv3_state.hpp), the parameters
+   * and the sample rate must already match. Implemented by earlyref,
+   * progenitor, progenitor2, nrev and nrevb, the other reverbs only pass
+   * the revbase delays.
+   */
+  virtual void state(state_io& io);
   virtual void processreplace(_fv3_float_t *inputL, _fv3_float_t *inputR, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
     throw(std::bad_alloc) = 0;
+  /**
+   * process the same input on both channels. The output is the same as
+   * processreplace(input, input, ...), calls of both can be mixed.
+   * Implementations may share the input side work of the two channels,
+   * this one just calls processreplace.
+   */
+  virtual void processreplaceM(_fv3_float_t *input, _fv3_float_t *outputL, _fv3_float_t *outputR, long numsamples)
+    throw(std::bad_alloc);
 
   /**
    * set the reverb front sound level.
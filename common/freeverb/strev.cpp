@@ -278,6 +278,17 @@ fv3_float_t FV3_(strev)::getmodulationnoise2()
   return modnoise2;
 }
 
+void FV3_(strev)::setnoiseseed(uint32_t value)
+{
+  noise1L.setSeed(value);
+  noise1L.mute();
+}
+
+uint32_t FV3_(strev)::getnoiseseed()
+{
+  return noise1L.getSeed();
+}
+
 void FV3_(strev)::setinputdamp(fv3_float_t value)
 {
   inputdamp = limFs2(value);
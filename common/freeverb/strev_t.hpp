@@ -103,6 +103,13 @@ public:
   void setmodulationnoise2(_fv3_float_t value);
   _fv3_float_t getmodulationnoise2();
 
+  /**
+   * set the seed of the modulation noise, which restarts from it.
+   * @param[in] value the seed, 0 selects FV3_NOISEGEN_DEFAULT_SEED (default).
+   */
+  void setnoiseseed(uint32_t value);
+  uint32_t getnoiseseed();
+
   void setAutoDiff(bool value);
   bool getAutoDiff();  
 
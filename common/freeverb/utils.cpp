@@ -18,6 +18,10 @@
  *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))
+#include <cpuid.h>
+#endif
+
 #include "freeverb/utils.hpp"
 #include "freeverb/fv3_type_float.h"
 #include "freeverb/fv3_ns_start.h"
@@ -92,4 +96,70 @@ void FV3_(utils)::aligned_free(void *ptr)
   std::free(actualAddress);
 }
 
+void FV3_(utils)::cpuid(uint32_t op, uint32_t *_eax, uint32_t *_ebx, uint32_t *_ecx, uint32_t *_edx)
+{
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))
+  unsigned int a = 0, b = 0, c = 0, d = 0;
+  __cpuid_count(op, 0, a, b, c, d);
+  *_eax = a, *_ebx = b, *_ecx = c, *_edx = d;
+#else
+  *_eax = *_ebx = *_ecx = *_edx = 0;
+#endif
+}
+
+uint32_t FV3_(utils)::getMXCSR()
+{
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))&&defined(__SSE__)
+  uint32_t mxcsr = 0;
+  __asm__ __volatile__ ("stmxcsr %0" : "=m"(mxcsr));
+  return mxcsr;
+#else
+  return 0;
+#endif
+}
+
+void FV3_(utils)::setMXCSR(uint32_t mxcsr)
+{
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))&&defined(__SSE__)
+  __asm__ __volatile__ ("ldmxcsr %0" : : "m"(mxcsr));
+#else
+  (void)mxcsr;
+#endif
+}
+
+void FV3_(utils)::XGETBV(uint32_t op, uint32_t * _eax, uint32_t *_edx)
+{
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))
+  uint32_t a = 0, d = 0;
+  __asm__ __volatile__ ("xgetbv" : "=a"(a), "=d"(d) : "c"(op));
+  *_eax = a, *_edx = d;
+#else
+  *_eax = *_edx = 0;
+#endif
+}
+
+uint32_t FV3_(utils)::getSIMDFlag()
+{
+  uint32_t flag = FV3_X86SIMD_FLAG_FPU, eax = 0, ebx = 0, ecx = 0, edx = 0;
+  cpuid(0, &eax, &ebx, &ecx, &edx);
+  if(eax < 1) return flag;
+  cpuid(1, &eax, &ebx, &ecx, &edx);
+  if(edx & (1U << 25)) flag |= FV3_X86SIMD_FLAG_SSE;
+  if(edx & (1U << 26)) flag |= FV3_X86SIMD_FLAG_SSE2;
+  if(ecx & (1U <<  0)) flag |= FV3_X86SIMD_FLAG_SSE3;
+  if(ecx & (1U << 19)) flag |= FV3_X86SIMD_FLAG_SSE4_1;
+  // AVX needs the OS to save the YMM state (OSXSAVE + XCR0 bits 1,2)
+  if((ecx & (1U << 27))&&(ecx & (1U << 28)))
+    {
+      uint32_t xcr0 = 0, xcr0h = 0;
+      XGETBV(0, &xcr0, &xcr0h);
+      if((xcr0 & 0x6) == 0x6)
+        {
+          flag |= FV3_X86SIMD_FLAG_AVX;
+          if(ecx & (1U << 12)) flag |= FV3_X86SIMD_FLAG_FMA3;
+        }
+    }
+  return flag;
+}
+
 #include "freeverb/fv3_ns_end.h"
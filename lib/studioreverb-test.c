@@ -0,0 +1,190 @@
+/*
+ * Studio Reverb C API test
+ * Builds as C against studioreverb.h and checks the calls an embedding
+ * program makes: create, parameters, processing and a snapshot round trip
+ */
+
+#include "studioreverb.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATE 48000.0
+#define BLOCK 256
+#define BLOCKS 64
+
+static int failures = 0;
+
+static void check(int ok, const char* what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", what);
+        failures++;
+    }
+}
+
+/* BLOCKS blocks of an impulse train into left and right, which hold
+ * BLOCKS * BLOCK frames */
+static void render(studioreverb* reverb, float* left, float* right)
+{
+    float inL[BLOCK], inR[BLOCK];
+    const float* inputs[2] = { inL, inR };
+    float* outputs[2];
+    int b, i;
+
+    for (b = 0; b < BLOCKS; b++)
+    {
+        for (i = 0; i < BLOCK; i++)
+        {
+            inL[i] = (i == 0 && b % 16 == 0) ? 1.0f : 0.0f;
+            inR[i] = (i == 7 && b % 16 == 0) ? 0.5f : 0.0f;
+        }
+        outputs[0] = left + b * BLOCK;
+        outputs[1] = right + b * BLOCK;
+        studioreverb_process(reverb, inputs, outputs, BLOCK);
+    }
+}
+
+static int isSilent(const float* samples, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        if (samples[i] != 0.0f)
+            return 0;
+    }
+    return 1;
+}
+
+static int isFinite(const float* samples, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        if (!isfinite(samples[i]))
+            return 0;
+    }
+    return 1;
+}
+
+static void checkParameters(studioreverb* reverb)
+{
+    studioreverb_parameter_info info;
+
+    check(studioreverb_get_parameter_info(STUDIOREVERB_PARAM_DECAY, &info) == 0, "parameter info");
+    check(studioreverb_get_parameter_info(STUDIOREVERB_PARAM_COUNT, &info) == -1, "unknown parameter info");
+
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_DECAY, 3.0f) == 0, "set decay");
+    check(studioreverb_get_parameter(reverb, STUDIOREVERB_PARAM_DECAY) == 3.0f, "get decay");
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_DECAY, 100.0f) == 0, "set decay out of range");
+    check(studioreverb_get_parameter(reverb, STUDIOREVERB_PARAM_DECAY) == 10.0f, "decay clamped");
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_COUNT, 0.0f) == -1, "unknown parameter");
+
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_TYPE, STUDIOREVERB_TYPE_HALL) == 0, "set type");
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_TYPE, NAN) == -1, "NaN type");
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_DECAY, INFINITY) == -1, "infinite decay");
+    check(studioreverb_get_parameter(reverb, STUDIOREVERB_PARAM_TYPE) == STUDIOREVERB_TYPE_HALL,
+          "type kept after NaN");
+    check(studioreverb_set_parameter(reverb, STUDIOREVERB_PARAM_TYPE, 99.0f) == 0, "set type out of range");
+    check(studioreverb_get_parameter(reverb, STUDIOREVERB_PARAM_TYPE) == STUDIOREVERB_TYPE_COUNT - 1,
+          "type clamped");
+
+    check(studioreverb_set_quality(reverb, STUDIOREVERB_QUALITY_COUNT) == -1, "unknown tier");
+    check(studioreverb_load_program(reverb, studioreverb_get_program_count()) == -1, "unknown program");
+    check(studioreverb_load_program(reverb, 1) == 0, "load program");
+}
+
+/* A render resumed from a snapshot continues as the one it was taken from */
+static void checkSnapshot(studioreverb* reverb, float* left, float* right, float* resumedL, float* resumedR)
+{
+    size_t size = studioreverb_get_snapshot_size(reverb);
+    void* snapshot = malloc(size);
+    const size_t frames = BLOCKS * BLOCK;
+
+    check(size > 0 && snapshot != NULL, "snapshot size");
+    if (snapshot == NULL)
+        return;
+
+    check(studioreverb_save_snapshot(reverb, snapshot, size - 1) == 0, "snapshot too small");
+    check(studioreverb_save_snapshot(reverb, snapshot, size) == size, "save snapshot");
+    render(reverb, left, right);
+
+    studioreverb_reset(reverb);
+    check(studioreverb_load_snapshot(reverb, snapshot, size) == 0, "load snapshot");
+    render(reverb, resumedL, resumedR);
+    check(memcmp(left, resumedL, frames * sizeof(float)) == 0
+          && memcmp(right, resumedR, frames * sizeof(float)) == 0, "resumed render");
+
+    check(studioreverb_load_snapshot(reverb, snapshot, size / 2) == -1, "truncated snapshot");
+    free(snapshot);
+}
+
+static void checkState(studioreverb* reverb)
+{
+    studioreverb* copy = studioreverb_create(RATE);
+    size_t size = studioreverb_save_state(reverb, NULL, 0);
+    char* state = malloc(size);
+    uint32_t i;
+
+    check(copy != NULL && state != NULL, "state buffers");
+    if (copy != NULL && state != NULL)
+    {
+        check(studioreverb_save_state(reverb, state, size) == size, "save state");
+        check(studioreverb_load_state(copy, state) == 0, "load state");
+        for (i = 0; i < STUDIOREVERB_PARAM_COUNT; i++)
+            check(studioreverb_get_parameter(copy, i) == studioreverb_get_parameter(reverb, i), "state parameter");
+        check(studioreverb_load_state(copy, "not a state") == -1, "invalid state");
+    }
+    free(state);
+    studioreverb_destroy(copy);
+}
+
+int main(void)
+{
+    const size_t frames = BLOCKS * BLOCK;
+    float* left = calloc(frames, sizeof(float));
+    float* right = calloc(frames, sizeof(float));
+    float* resumedL = calloc(frames, sizeof(float));
+    float* resumedR = calloc(frames, sizeof(float));
+    studioreverb* reverb;
+
+    if (left == NULL || right == NULL || resumedL == NULL || resumedR == NULL)
+        return 1;
+
+    check(studioreverb_api_version() == STUDIOREVERB_API_VERSION, "api version");
+
+    reverb = studioreverb_create(RATE);
+    check(reverb != NULL, "create");
+    if (reverb == NULL)
+        return 1;
+
+    checkParameters(reverb);
+
+    render(reverb, left, right);
+    check(isFinite(left, frames) && isFinite(right, frames), "finite output");
+    check(!isSilent(left, frames) && !isSilent(right, frames), "reverb output");
+    check(studioreverb_is_tail_active(reverb) == 1, "tail active");
+    check(studioreverb_get_tail_seconds(reverb) > 0.0, "tail seconds");
+
+    checkSnapshot(reverb, left, right, resumedL, resumedR);
+    checkState(reverb);
+
+    check(studioreverb_set_sample_rate(reverb, 44100.0) == 0, "set sample rate");
+    studioreverb_destroy(reverb);
+
+    free(left);
+    free(right);
+    free(resumedL);
+    free(resumedR);
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("C API ok\n");
+    return 0;
+}
@@ -0,0 +1,729 @@
+/*
+ * Studio Reverb C API
+ * Wraps StudioReverbDSP, no DPF
+ */
+
+#include "studioreverb.h"
+
+#include "DSP.hpp"
+#include "Programs.hpp"
+#include "ReverbBatch.hpp"
+#include "ReverbSends.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <locale>
+#include <new>
+#include <sstream>
+#include <string>
+
+static_assert(STUDIOREVERB_PARAM_COUNT == static_cast<int>(paramCount), "parameters differ from the plugin");
+static_assert(STUDIOREVERB_PARAM_DECAY == static_cast<int>(paramDecay), "parameters differ from the plugin");
+static_assert(STUDIOREVERB_PARAM_HIGH_CUT == static_cast<int>(paramHighCut), "parameters differ from the plugin");
+static_assert(STUDIOREVERB_TYPE_COUNT == static_cast<int>(REVERB_TYPE_COUNT), "types differ from the plugin");
+static_assert(STUDIOREVERB_TYPE_HYBRID == static_cast<int>(REVERB_HYBRID), "types differ from the plugin");
+static_assert(STUDIOREVERB_QUALITY_COUNT == static_cast<int>(QUALITY_COUNT), "tiers differ from the plugin");
+static_assert(STUDIOREVERB_QUALITY_HIGH == static_cast<int>(QUALITY_HIGH), "tiers differ from the plugin");
+static_assert(STUDIOREVERB_BATCH_MAX_INSTANCES == BATCH_MAX_INSTANCES, "batch size differs from the engine");
+
+// Ranges as the plugin declares them (Plugin.cpp)
+static const studioreverb_parameter_info parameterInfo[STUDIOREVERB_PARAM_COUNT] = {
+    { "Type",        "type",       "",   0.0f,    REVERB_TYPE_COUNT - 1.0f, 0.0f },
+    { "Dry Level",   "dry",        "%",  0.0f,    100.0f,   100.0f },
+    { "Early Level", "early",      "%",  0.0f,    100.0f,   75.0f },
+    { "Late Level",  "late",       "%",  0.0f,    100.0f,   75.0f },
+    { "Size",        "size",       "%",  0.0f,    100.0f,   50.0f },
+    { "Width",       "width",      "%",  0.0f,    100.0f,   100.0f },
+    { "Pre-Delay",   "predelay",   "ms", 0.0f,    200.0f,   10.0f },
+    { "Decay",       "decay",      "s",  0.1f,    10.0f,    2.0f },
+    { "Diffusion",   "diffuse",    "%",  0.0f,    100.0f,   70.0f },
+    { "Damping",     "damping",    "%",  0.0f,    100.0f,   50.0f },
+    { "Modulation",  "modulation", "%",  0.0f,    100.0f,   20.0f },
+    { "Low Cut",     "lowcut",     "Hz", 20.0f,   500.0f,   20.0f },
+    { "High Cut",    "highcut",    "Hz", 1000.0f, 20000.0f, 16000.0f }
+};
+
+// First line of a saved state, the number is the format version
+static const char* const STATE_HEADER = "studioreverb-state 1";
+static const char* const STATE_IMPULSE_KEY = "irfile";
+static const char* const STATE_QUALITY_KEY = "quality";
+static const char* const STATE_BUDGET_KEY = "cpubudget";
+
+struct studioreverb
+{
+    explicit studioreverb(double sampleRate)
+        : dsp(sampleRate)
+    {
+    }
+
+    StudioReverbDSP dsp;
+};
+
+struct studioreverb_batch
+{
+    studioreverb_batch(ReverbType type, uint32_t count, double sampleRate)
+        : batch(type, count, sampleRate)
+    {
+    }
+
+    StudioReverbBatch batch;
+};
+
+struct studioreverb_sends
+{
+    studioreverb_sends(ReverbType type, uint32_t sourceCount, double sampleRate)
+        : sends(type, sourceCount, sampleRate)
+    {
+    }
+
+    StudioReverbSends sends;
+};
+
+// False for a value that is not finite, a NaN would pass the clamp and
+// round to INT_MIN as a Type
+static bool clampParameter(uint32_t index, float& value)
+{
+    if (!isfinite(value))
+        return false;
+
+    const studioreverb_parameter_info& info = parameterInfo[index];
+    value = std::min(std::max(value, info.min), info.max);
+    if (index == STUDIOREVERB_PARAM_TYPE)
+        value = static_cast<float>(static_cast<int>(value + 0.5f));
+    return true;
+}
+
+// What a block gives when the engine failed
+static void silence(float* const* outputs, uint32_t channels, uint32_t frames)
+{
+    for (uint32_t c = 0; c < channels; c++)
+        std::memset(outputs[c], 0, frames * sizeof(float));
+}
+
+// No C++ exception reaches a C caller: every call into the engine catches
+// them and returns its error value, -1, 0 or NULL, or outputs silence. The
+// calls that only read or store a value cannot throw.
+
+uint32_t studioreverb_api_version(void)
+{
+    return STUDIOREVERB_API_VERSION;
+}
+
+studioreverb* studioreverb_create(double sample_rate)
+{
+    studioreverb* reverb = nullptr;
+    try
+    {
+        reverb = new studioreverb(sample_rate);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+
+    if (studioreverb_load_program(reverb, 0) != 0)
+    {
+        delete reverb;
+        return nullptr;
+    }
+    return reverb;
+}
+
+void studioreverb_destroy(studioreverb* reverb)
+{
+    delete reverb;
+}
+
+int studioreverb_set_sample_rate(studioreverb* reverb, double sample_rate)
+{
+    try
+    {
+        reverb->dsp.sampleRateChanged(sample_rate);
+        reverb->dsp.mute();
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int studioreverb_get_parameter_info(uint32_t index, studioreverb_parameter_info* info)
+{
+    if (index >= STUDIOREVERB_PARAM_COUNT)
+        return -1;
+    *info = parameterInfo[index];
+    return 0;
+}
+
+int studioreverb_set_parameter(studioreverb* reverb, uint32_t index, float value)
+{
+    if (index >= STUDIOREVERB_PARAM_COUNT || !clampParameter(index, value))
+        return -1;
+
+    try
+    {
+        reverb->dsp.setParameterValue(index, value);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+float studioreverb_get_parameter(const studioreverb* reverb, uint32_t index)
+{
+    return reverb->dsp.getParameterValue(index);
+}
+
+uint32_t studioreverb_get_program_count(void)
+{
+    return PROGRAM_COUNT;
+}
+
+const char* studioreverb_get_program_name(uint32_t index)
+{
+    if (index >= PROGRAM_COUNT)
+        return nullptr;
+    return getProgram(index).name;
+}
+
+int studioreverb_load_program(studioreverb* reverb, uint32_t index)
+{
+    if (index >= PROGRAM_COUNT)
+        return -1;
+
+    const Program& program = getProgram(index);
+    try
+    {
+        for (uint32_t i = 0; i < program.count; i++)
+            reverb->dsp.setParameterValue(program.values[i].index, program.values[i].value);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int studioreverb_set_quality(studioreverb* reverb, studioreverb_quality quality)
+{
+    if (quality < 0 || quality >= STUDIOREVERB_QUALITY_COUNT)
+        return -1;
+    reverb->dsp.setQuality(static_cast<ReverbQuality>(quality));
+    return 0;
+}
+
+studioreverb_quality studioreverb_get_quality(const studioreverb* reverb)
+{
+    return static_cast<studioreverb_quality>(reverb->dsp.getQuality());
+}
+
+void studioreverb_set_cpu_budget(studioreverb* reverb, float budget)
+{
+    reverb->dsp.setQualityBudget(budget);
+}
+
+float studioreverb_get_cpu_budget(const studioreverb* reverb)
+{
+    return reverb->dsp.getQualityBudget();
+}
+
+studioreverb_quality studioreverb_get_active_quality(const studioreverb* reverb)
+{
+    return static_cast<studioreverb_quality>(reverb->dsp.getActiveQuality());
+}
+
+int studioreverb_load_impulse(studioreverb* reverb, const char* path)
+{
+    try
+    {
+        return reverb->dsp.loadImpulseFile(path) ? 0 : -1;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+void studioreverb_clear_impulse(studioreverb* reverb)
+{
+    try
+    {
+        reverb->dsp.clearImpulse();
+    }
+    catch (...)
+    {
+    }
+}
+
+int studioreverb_is_impulse_loading(studioreverb* reverb)
+{
+    try
+    {
+        return reverb->dsp.isImpulseLoading() ? 1 : 0;
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+void studioreverb_process(studioreverb* reverb, const float* const* inputs,
+                          float* const* outputs, uint32_t frames)
+{
+    const float* in[2] = { inputs[0], inputs[1] };
+    float* out[2] = { outputs[0], outputs[1] };
+    try
+    {
+        reverb->dsp.run(in, out, frames);
+    }
+    catch (...)
+    {
+        silence(outputs, 2, frames);
+    }
+}
+
+void studioreverb_set_mono_input(studioreverb* reverb, int mono)
+{
+    reverb->dsp.setMonoInput(mono != 0);
+}
+
+int studioreverb_get_mono_input(const studioreverb* reverb)
+{
+    return reverb->dsp.isMonoInput() ? 1 : 0;
+}
+
+void studioreverb_reset(studioreverb* reverb)
+{
+    try
+    {
+        reverb->dsp.mute();
+    }
+    catch (...)
+    {
+    }
+}
+
+int studioreverb_is_tail_active(const studioreverb* reverb)
+{
+    return reverb->dsp.isTailActive() ? 1 : 0;
+}
+
+double studioreverb_get_tail_seconds(studioreverb* reverb)
+{
+    try
+    {
+        return reverb->dsp.getTailSeconds();
+    }
+    catch (...)
+    {
+        return 0.0;
+    }
+}
+
+uint32_t studioreverb_get_latency(studioreverb* reverb)
+{
+    try
+    {
+        return reverb->dsp.getLatency();
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+// One symbol=value line per parameter, C locale, enough digits to restore
+// the exact float
+static size_t saveState(const studioreverb* reverb, char* buffer, size_t size)
+{
+    std::ostringstream state;
+    state.imbue(std::locale::classic());
+    state.precision(9);
+    state << STATE_HEADER << '\n';
+    for (uint32_t i = 0; i < STUDIOREVERB_PARAM_COUNT; i++)
+        state << parameterInfo[i].symbol << '=' << reverb->dsp.getParameterValue(i) << '\n';
+    state << STATE_QUALITY_KEY << '=' << StudioReverbDSP::getQualityName(reverb->dsp.getQuality()) << '\n';
+    state << STATE_BUDGET_KEY << '=' << reverb->dsp.getQualityBudget() << '\n';
+    state << STATE_IMPULSE_KEY << '=' << reverb->dsp.getImpulseFile() << '\n';
+
+    std::string text = state.str();
+    if (buffer != nullptr && size > 0)
+    {
+        size_t count = std::min(text.size(), size - 1);
+        std::memcpy(buffer, text.data(), count);
+        buffer[count] = '\0';
+    }
+    return text.size() + 1;
+}
+
+static int loadState(studioreverb* reverb, const char* state)
+{
+    std::istringstream lines(state != nullptr ? state : "");
+    std::string line;
+    if (!std::getline(lines, line) || line != STATE_HEADER)
+        return -1;
+
+    // Parsed in full before anything is applied
+    float values[STUDIOREVERB_PARAM_COUNT];
+    bool present[STUDIOREVERB_PARAM_COUNT] = {};
+    bool hasImpulse = false;
+    std::string impulse;
+    bool hasQuality = false;
+    ReverbQuality quality = QUALITY_HIGH;
+    bool hasBudget = false;
+    float budget = 0.0f;
+
+    while (std::getline(lines, line))
+    {
+        if (line.empty())
+            continue;
+        size_t equals = line.find('=');
+        if (equals == std::string::npos)
+            return -1;
+        std::string key = line.substr(0, equals);
+        std::string value = line.substr(equals + 1);
+
+        if (key == STATE_IMPULSE_KEY)
+        {
+            hasImpulse = true;
+            impulse = value;
+            continue;
+        }
+        if (key == STATE_QUALITY_KEY)
+        {
+            if (!StudioReverbDSP::parseQuality(value.c_str(), quality))
+                return -1;
+            hasQuality = true;
+            continue;
+        }
+        if (key == STATE_BUDGET_KEY)
+        {
+            std::istringstream number(value);
+            number.imbue(std::locale::classic());
+            if (!(number >> budget))
+                return -1;
+            hasBudget = true;
+            continue;
+        }
+
+        // Keys of later versions are skipped
+        for (uint32_t i = 0; i < STUDIOREVERB_PARAM_COUNT; i++)
+        {
+            if (key != parameterInfo[i].symbol)
+                continue;
+            std::istringstream number(value);
+            number.imbue(std::locale::classic());
+            if (!(number >> values[i]))
+                return -1;
+            present[i] = true;
+        }
+    }
+
+    for (uint32_t i = 0; i < STUDIOREVERB_PARAM_COUNT; i++)
+    {
+        if (present[i])
+            studioreverb_set_parameter(reverb, i, values[i]);
+    }
+    if (hasQuality)
+        reverb->dsp.setQuality(quality);
+    if (hasBudget)
+        reverb->dsp.setQualityBudget(budget);
+
+    if (!hasImpulse)
+        return 0;
+    if (impulse.empty())
+    {
+        reverb->dsp.clearImpulse();
+        return 0;
+    }
+    if (impulse == reverb->dsp.getImpulseFile())
+        return 0;
+    return reverb->dsp.loadImpulseFile(impulse.c_str()) ? 0 : -1;
+}
+
+size_t studioreverb_save_state(const studioreverb* reverb, char* buffer, size_t size)
+{
+    try
+    {
+        return saveState(reverb, buffer, size);
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+int studioreverb_load_state(studioreverb* reverb, const char* state)
+{
+    try
+    {
+        return loadState(reverb, state);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+size_t studioreverb_get_snapshot_size(studioreverb* reverb)
+{
+    try
+    {
+        return reverb->dsp.getSnapshotSize();
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+size_t studioreverb_save_snapshot(studioreverb* reverb, void* data, size_t size)
+{
+    if (data == nullptr)
+        return 0;
+
+    try
+    {
+        return reverb->dsp.saveSnapshot(data, size);
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+int studioreverb_load_snapshot(studioreverb* reverb, const void* data, size_t size)
+{
+    if (data == nullptr)
+        return -1;
+
+    try
+    {
+        return reverb->dsp.loadSnapshot(data, size) ? 0 : -1;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+studioreverb_batch* studioreverb_batch_create(studioreverb_type type, uint32_t count, double sample_rate)
+{
+    if (static_cast<int>(type) < 0 || type >= STUDIOREVERB_TYPE_COUNT)
+        return nullptr;
+    if (count < 1 || count > STUDIOREVERB_BATCH_MAX_INSTANCES)
+        return nullptr;
+
+    try
+    {
+        return new studioreverb_batch(static_cast<ReverbType>(type), count, sample_rate);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void studioreverb_batch_destroy(studioreverb_batch* batch)
+{
+    delete batch;
+}
+
+int studioreverb_batch_is_lane_parallel(const studioreverb_batch* batch)
+{
+    return batch->batch.isLaneParallel() ? 1 : 0;
+}
+
+int studioreverb_batch_set_sample_rate(studioreverb_batch* batch, double sample_rate)
+{
+    try
+    {
+        batch->batch.sampleRateChanged(sample_rate);
+        batch->batch.mute();
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int studioreverb_batch_set_parameter(studioreverb_batch* batch, uint32_t instance,
+                                     uint32_t index, float value)
+{
+    if (instance >= batch->batch.getCount() || index >= STUDIOREVERB_PARAM_COUNT)
+        return -1;
+    if (!clampParameter(index, value))
+        return -1;
+
+    try
+    {
+        batch->batch.setParameterValue(instance, index, value);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+float studioreverb_batch_get_parameter(const studioreverb_batch* batch, uint32_t instance, uint32_t index)
+{
+    return batch->batch.getParameterValue(instance, index);
+}
+
+int studioreverb_batch_load_program(studioreverb_batch* batch, uint32_t instance, uint32_t index)
+{
+    if (instance >= batch->batch.getCount() || index >= PROGRAM_COUNT)
+        return -1;
+
+    const Program& program = getProgram(index);
+    try
+    {
+        for (uint32_t i = 0; i < program.count; i++)
+            batch->batch.setParameterValue(instance, program.values[i].index, program.values[i].value);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+void studioreverb_batch_process(studioreverb_batch* batch, const float* const* inputs,
+                                float* const* outputs, uint32_t frames)
+{
+    try
+    {
+        batch->batch.run(const_cast<const float**>(inputs), const_cast<float**>(outputs), frames);
+    }
+    catch (...)
+    {
+        silence(outputs, 2 * batch->batch.getCount(), frames);
+    }
+}
+
+void studioreverb_batch_reset(studioreverb_batch* batch)
+{
+    try
+    {
+        batch->batch.mute();
+    }
+    catch (...)
+    {
+    }
+}
+
+studioreverb_sends* studioreverb_sends_create(studioreverb_type type, uint32_t source_count, double sample_rate)
+{
+    if (static_cast<int>(type) < 0 || type >= STUDIOREVERB_TYPE_COUNT || source_count < 1)
+        return nullptr;
+
+    try
+    {
+        return new studioreverb_sends(static_cast<ReverbType>(type), source_count, sample_rate);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void studioreverb_sends_destroy(studioreverb_sends* sends)
+{
+    delete sends;
+}
+
+int studioreverb_sends_set_sample_rate(studioreverb_sends* sends, double sample_rate)
+{
+    try
+    {
+        sends->sends.sampleRateChanged(sample_rate);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int studioreverb_sends_set_parameter(studioreverb_sends* sends, uint32_t index, float value)
+{
+    if (index >= STUDIOREVERB_PARAM_COUNT || !clampParameter(index, value))
+        return -1;
+
+    try
+    {
+        sends->sends.setParameterValue(index, value);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+float studioreverb_sends_get_parameter(const studioreverb_sends* sends, uint32_t index)
+{
+    return sends->sends.getParameterValue(index);
+}
+
+int studioreverb_sends_load_program(studioreverb_sends* sends, uint32_t index)
+{
+    if (index >= PROGRAM_COUNT)
+        return -1;
+
+    const Program& program = getProgram(index);
+    try
+    {
+        for (uint32_t i = 0; i < program.count; i++)
+            sends->sends.setParameterValue(program.values[i].index, program.values[i].value);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int studioreverb_sends_set_source(studioreverb_sends* sends, uint32_t source,
+                                  float pre_delay_ms, float send, float early)
+{
+    if (source >= sends->sends.getSourceCount())
+        return -1;
+    if (!isfinite(pre_delay_ms) || !isfinite(send) || !isfinite(early))
+        return -1;
+
+    sends->sends.setSourcePreDelay(source, pre_delay_ms);
+    sends->sends.setSourceSend(source, send);
+    sends->sends.setSourceEarly(source, early);
+    return 0;
+}
+
+void studioreverb_sends_process(studioreverb_sends* sends, const float* const* inputs,
+                                float* const* outputs, uint32_t frames)
+{
+    try
+    {
+        sends->sends.run(const_cast<const float**>(inputs), const_cast<float**>(outputs), frames);
+    }
+    catch (...)
+    {
+        silence(outputs, 2, frames);
+    }
+}
+
+void studioreverb_sends_reset(studioreverb_sends* sends)
+{
+    try
+    {
+        sends->sends.mute();
+    }
+    catch (...)
+    {
+    }
+}
@@ -0,0 +1,270 @@
+/*
+ * Studio Reverb C API
+ * The reverb engine without a plugin host, for embedding
+ */
+
+#ifndef STUDIOREVERB_H_INCLUDED
+#define STUDIOREVERB_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(STUDIOREVERB_BUILD)
+#define STUDIOREVERB_EXPORT __declspec(dllexport)
+#elif defined(__GNUC__)
+#define STUDIOREVERB_EXPORT __attribute__((visibility("default")))
+#else
+#define STUDIOREVERB_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Raised when a function changes incompatibly, the values of the enums
+ * below never change */
+#define STUDIOREVERB_API_VERSION 1
+
+/* No function lets a C++ exception through. When memory runs out a call
+ * returns its error value (-1, 0 or NULL) and processing outputs silence. */
+
+typedef struct studioreverb studioreverb;
+
+/* Same order as the plugin parameters */
+typedef enum
+{
+    STUDIOREVERB_PARAM_TYPE = 0,
+    STUDIOREVERB_PARAM_DRY,
+    STUDIOREVERB_PARAM_EARLY,
+    STUDIOREVERB_PARAM_LATE,
+    STUDIOREVERB_PARAM_SIZE,
+    STUDIOREVERB_PARAM_WIDTH,
+    STUDIOREVERB_PARAM_PREDELAY,
+    STUDIOREVERB_PARAM_DECAY,
+    STUDIOREVERB_PARAM_DIFFUSE,
+    STUDIOREVERB_PARAM_DAMPING,
+    STUDIOREVERB_PARAM_MODULATION,
+    STUDIOREVERB_PARAM_LOW_CUT,
+    STUDIOREVERB_PARAM_HIGH_CUT,
+    STUDIOREVERB_PARAM_COUNT
+} studioreverb_param;
+
+/* Values of STUDIOREVERB_PARAM_TYPE */
+typedef enum
+{
+    STUDIOREVERB_TYPE_ROOM = 0,
+    STUDIOREVERB_TYPE_HALL,
+    STUDIOREVERB_TYPE_PLATE,
+    STUDIOREVERB_TYPE_EARLY_REFLECTIONS,
+    STUDIOREVERB_TYPE_HYBRID,
+    STUDIOREVERB_TYPE_COUNT
+} studioreverb_type;
+
+/* Quality tiers, fewer tank stages for less CPU */
+typedef enum
+{
+    STUDIOREVERB_QUALITY_ECO = 0,
+    STUDIOREVERB_QUALITY_STANDARD,
+    STUDIOREVERB_QUALITY_HIGH,
+    STUDIOREVERB_QUALITY_COUNT
+} studioreverb_quality;
+
+typedef struct
+{
+    const char* name;
+    const char* symbol;     /* as the LV2 port symbol */
+    const char* unit;
+    float min;
+    float max;
+    float def;
+} studioreverb_parameter_info;
+
+/* STUDIOREVERB_API_VERSION of the library that is loaded */
+STUDIOREVERB_EXPORT uint32_t studioreverb_api_version(void);
+
+/* A new engine on factory program 0, NULL when out of memory */
+STUDIOREVERB_EXPORT studioreverb* studioreverb_create(double sample_rate);
+STUDIOREVERB_EXPORT void studioreverb_destroy(studioreverb* reverb);
+
+/* Not while studioreverb_process() runs. The tails are muted. Returns 0,
+ * or -1 when out of memory. */
+STUDIOREVERB_EXPORT int studioreverb_set_sample_rate(studioreverb* reverb, double sample_rate);
+
+/* Returns 0, or -1 for an unknown index */
+STUDIOREVERB_EXPORT int studioreverb_get_parameter_info(uint32_t index, studioreverb_parameter_info* info);
+
+/* Values are clamped to the parameter range. Call from the thread that
+ * processes, between blocks, as a plugin host does. Returns 0, or -1 for
+ * an unknown index, a value that is not finite or when out of memory. */
+STUDIOREVERB_EXPORT int studioreverb_set_parameter(studioreverb* reverb, uint32_t index, float value);
+STUDIOREVERB_EXPORT float studioreverb_get_parameter(const studioreverb* reverb, uint32_t index);
+
+/* Factory programs, a program sets only the parameters it lists */
+STUDIOREVERB_EXPORT uint32_t studioreverb_get_program_count(void);
+STUDIOREVERB_EXPORT const char* studioreverb_get_program_name(uint32_t index);
+STUDIOREVERB_EXPORT int studioreverb_load_program(studioreverb* reverb, uint32_t index);
+
+/* STUDIOREVERB_QUALITY_HIGH by default. From any thread, the next
+ * studioreverb_process() applies it with a crossfade. Returns 0, or -1 for
+ * an unknown tier. */
+STUDIOREVERB_EXPORT int studioreverb_set_quality(studioreverb* reverb, studioreverb_quality quality);
+STUDIOREVERB_EXPORT studioreverb_quality studioreverb_get_quality(const studioreverb* reverb);
+
+/* Automatic quality for live use: while processing takes more than budget
+ * (0.1-1) of the block duration, the tier steps down, and back up towards
+ * the one set above once there is room again. Steps are crossfaded. 0, the
+ * default, switches it off. From any thread. */
+STUDIOREVERB_EXPORT void studioreverb_set_cpu_budget(studioreverb* reverb, float budget);
+STUDIOREVERB_EXPORT float studioreverb_get_cpu_budget(const studioreverb* reverb);
+
+/* Tier that processing uses, lower than studioreverb_get_quality() while
+ * the CPU budget holds it down */
+STUDIOREVERB_EXPORT studioreverb_quality studioreverb_get_active_quality(const studioreverb* reverb);
+
+/* Impulse response for the hybrid type. Loading reads and analyzes the
+ * file, so not on the audio thread. The new response is crossfaded in
+ * by the following blocks, until studioreverb_is_impulse_loading()
+ * returns 0. Returns 0, or -1 if the file could not be read. */
+STUDIOREVERB_EXPORT int studioreverb_load_impulse(studioreverb* reverb, const char* path);
+STUDIOREVERB_EXPORT void studioreverb_clear_impulse(studioreverb* reverb);
+STUDIOREVERB_EXPORT int studioreverb_is_impulse_loading(studioreverb* reverb);
+
+/* Planar stereo, inputs[0] and inputs[1] to outputs[0] and outputs[1].
+ * Any number of frames, the inputs and outputs may be the same buffers.
+ * Real-time safe. */
+STUDIOREVERB_EXPORT void studioreverb_process(studioreverb* reverb, const float* const* inputs,
+                                              float* const* outputs, uint32_t frames);
+
+/* For a mono source: inputs[0] feeds both channels and inputs[1] is
+ * ignored. 0 by default, a block with the same samples on both inputs is
+ * then still processed as mono. Mono blocks share part of the input
+ * processing, the output is the same. From any thread. */
+STUDIOREVERB_EXPORT void studioreverb_set_mono_input(studioreverb* reverb, int mono);
+STUDIOREVERB_EXPORT int studioreverb_get_mono_input(const studioreverb* reverb);
+
+/* Mutes the tails, as when a host deactivates the plugin */
+STUDIOREVERB_EXPORT void studioreverb_reset(studioreverb* reverb);
+
+/* 1 while the wet output of the last block is above -100 dBFS */
+STUDIOREVERB_EXPORT int studioreverb_is_tail_active(const studioreverb* reverb);
+
+/* Seconds the output takes to decay by 60 dB after the input stops,
+ * estimated from the current settings */
+STUDIOREVERB_EXPORT double studioreverb_get_tail_seconds(studioreverb* reverb);
+
+/* Frames the output is delayed by */
+STUDIOREVERB_EXPORT uint32_t studioreverb_get_latency(studioreverb* reverb);
+
+/* The settings as text: every parameter, the quality tier, the CPU budget
+ * and the impulse response file.
+ * Writes at most size bytes with the terminating NUL and returns the size
+ * the whole state needs, like snprintf. */
+STUDIOREVERB_EXPORT size_t studioreverb_save_state(const studioreverb* reverb, char* buffer, size_t size);
+
+/* Restores a state from studioreverb_save_state(), loading its impulse
+ * response, so not on the audio thread. Parameters it does not list keep
+ * their value. Returns 0, or -1 if the state is invalid or the impulse
+ * response could not be read. */
+STUDIOREVERB_EXPORT int studioreverb_load_state(studioreverb* reverb, const char* state);
+
+/* The signal state: the delay lines and filter memories of the current
+ * type, with the parameters, quality tier and sample rate. A render resumes from a
+ * snapshot without pre-roll. A snapshot loads into an engine of the same
+ * library build with the same impulse response, the convolved head of
+ * the hybrid type restarts from silence. Not while studioreverb_process()
+ * runs; with the engine's settings unchanged loading only copies buffers. */
+STUDIOREVERB_EXPORT size_t studioreverb_get_snapshot_size(studioreverb* reverb);
+
+/* Returns the bytes written, 0 if size is too small */
+STUDIOREVERB_EXPORT size_t studioreverb_save_snapshot(studioreverb* reverb, void* data, size_t size);
+
+/* Returns 0, or -1 for a snapshot that does not fit this engine, which
+ * leaves the tails muted */
+STUDIOREVERB_EXPORT int studioreverb_load_snapshot(studioreverb* reverb, const void* data, size_t size);
+
+/* Several engines of one type with their own parameters, processed
+ * together. Plate instances run side by side in SIMD lanes, the other
+ * types one engine after another. */
+typedef struct studioreverb_batch studioreverb_batch;
+
+/* Most instances in a batch */
+#define STUDIOREVERB_BATCH_MAX_INSTANCES 16
+
+/* count instances on factory program 0, NULL when out of memory or for an
+ * invalid type or count */
+STUDIOREVERB_EXPORT studioreverb_batch* studioreverb_batch_create(studioreverb_type type, uint32_t count,
+                                                                 double sample_rate);
+STUDIOREVERB_EXPORT void studioreverb_batch_destroy(studioreverb_batch* batch);
+
+/* 1 when the instances run in SIMD lanes */
+STUDIOREVERB_EXPORT int studioreverb_batch_is_lane_parallel(const studioreverb_batch* batch);
+
+/* Not while studioreverb_batch_process() runs. The tails are muted.
+ * Returns 0, or -1 when out of memory. */
+STUDIOREVERB_EXPORT int studioreverb_batch_set_sample_rate(studioreverb_batch* batch, double sample_rate);
+
+/* As studioreverb_set_parameter(), STUDIOREVERB_PARAM_TYPE is fixed at
+ * creation and ignored. Returns 0, or -1 for an unknown instance or index,
+ * a value that is not finite or when out of memory. */
+STUDIOREVERB_EXPORT int studioreverb_batch_set_parameter(studioreverb_batch* batch, uint32_t instance,
+                                                         uint32_t index, float value);
+STUDIOREVERB_EXPORT float studioreverb_batch_get_parameter(const studioreverb_batch* batch, uint32_t instance,
+                                                           uint32_t index);
+STUDIOREVERB_EXPORT int studioreverb_batch_load_program(studioreverb_batch* batch, uint32_t instance,
+                                                        uint32_t index);
+
+/* Planar stereo, instance i reads inputs[2 * i] and inputs[2 * i + 1] and
+ * writes the same outputs. Any number of frames, the inputs and outputs
+ * may be the same buffers. Real-time safe. */
+STUDIOREVERB_EXPORT void studioreverb_batch_process(studioreverb_batch* batch, const float* const* inputs,
+                                                    float* const* outputs, uint32_t frames);
+
+/* Mutes the tails of every instance */
+STUDIOREVERB_EXPORT void studioreverb_batch_reset(studioreverb_batch* batch);
+
+/* Many sources in one space: each source has its own pre-delay and early
+ * reflections and is summed with a send gain into one shared tank. The
+ * output is wet only. */
+typedef struct studioreverb_sends studioreverb_sends;
+
+/* Longest pre-delay of a single source, on top of STUDIOREVERB_PARAM_PREDELAY */
+#define STUDIOREVERB_SENDS_MAX_PREDELAY_MS 200.0f
+
+/* source_count sources in a space on factory program 0, each with send
+ * and early gains of 1 and no pre-delay. NULL when out of memory or for
+ * an invalid type or count. */
+STUDIOREVERB_EXPORT studioreverb_sends* studioreverb_sends_create(studioreverb_type type, uint32_t source_count,
+                                                                 double sample_rate);
+STUDIOREVERB_EXPORT void studioreverb_sends_destroy(studioreverb_sends* sends);
+
+/* Not while studioreverb_sends_process() runs. The tails are muted.
+ * Returns 0, or -1 when out of memory. */
+STUDIOREVERB_EXPORT int studioreverb_sends_set_sample_rate(studioreverb_sends* sends, double sample_rate);
+
+/* The space, as studioreverb_set_parameter(). STUDIOREVERB_PARAM_TYPE is
+ * fixed at creation and STUDIOREVERB_PARAM_DRY has no effect. */
+STUDIOREVERB_EXPORT int studioreverb_sends_set_parameter(studioreverb_sends* sends, uint32_t index, float value);
+STUDIOREVERB_EXPORT float studioreverb_sends_get_parameter(const studioreverb_sends* sends, uint32_t index);
+STUDIOREVERB_EXPORT int studioreverb_sends_load_program(studioreverb_sends* sends, uint32_t index);
+
+/* A source's pre-delay in ms (clamped to 0-STUDIOREVERB_SENDS_MAX_PREDELAY_MS),
+ * its linear gain into the tank and of its early reflections. Call from
+ * the thread that processes. Returns 0, or -1 for an unknown source or a
+ * value that is not finite. */
+STUDIOREVERB_EXPORT int studioreverb_sends_set_source(studioreverb_sends* sends, uint32_t source,
+                                                      float pre_delay_ms, float send, float early);
+
+/* Source s reads inputs[2 * s] and inputs[2 * s + 1], outputs[0] and
+ * outputs[1] receive the mix of all sources. Any number of frames.
+ * Real-time safe. */
+STUDIOREVERB_EXPORT void studioreverb_sends_process(studioreverb_sends* sends, const float* const* inputs,
+                                                    float* const* outputs, uint32_t frames);
+
+/* Mutes the tank and every source */
+STUDIOREVERB_EXPORT void studioreverb_sends_reset(studioreverb_sends* sends);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STUDIOREVERB_H_INCLUDED */
@@ -0,0 +1,754 @@
+/*
+ * Studio Reverb Offline Benchmark
+ * Runs StudioReverbDSP without a plugin host
+ */
+
+#include "bench.hpp"
+#include "perfcounters.hpp"
+#include "Programs.hpp"
+#include "freeverb/fv3_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Audio rendered before timing starts, lets delay lines fill and an IR load settle
+static const double BENCH_WARMUP_SECONDS = 0.25;
+static const double BENCH_LOAD_TIMEOUT_SECONDS = 10.0;
+
+// Period of the parameter storm sweep
+static const double BENCH_STORM_PERIOD_SECONDS = 1.0;
+
+const char* const benchTypeNames[REVERB_TYPE_COUNT] = {
+    "room", "hall", "plate", "early", "hybrid"
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// Counter sets: the whole run, then one per DSPStage
+static const int BENCH_COUNTER_SETS = 1 + DSP_STAGE_COUNT;
+static const char* const counterSetNames[BENCH_COUNTER_SETS] = {
+    "all", "early", "late", "mix"
+};
+
+struct BenchResult
+{
+    double nsPerSample;
+    double realtimeFactor;
+    double worstBlockNs;
+    double worstBlockLoad;   // worst block time / block duration
+    double setNsPerBlock;    // parameter updates only, storm runs
+    double worstSetNs;
+    bool hasCounters;
+    double counters[BENCH_COUNTER_SETS][PERF_EVENT_COUNT];   // per sample, negative if unavailable
+};
+
+// Counts events inside each stage of StudioReverbDSP::run()
+class CounterProbe : public StudioReverbProbe
+{
+public:
+    bool open()
+    {
+        for (int s = 0; s < DSP_STAGE_COUNT; s++)
+        {
+            if (!stages[s].open())
+                return false;
+        }
+        return true;
+    }
+
+    void reset()
+    {
+        for (int s = 0; s < DSP_STAGE_COUNT; s++)
+            stages[s].reset();
+    }
+
+    void stageBegin(DSPStage stage) override
+    {
+        stages[stage].start();
+    }
+
+    void stageEnd(DSPStage stage) override
+    {
+        stages[stage].stop();
+    }
+
+    PerfCounters stages[DSP_STAGE_COUNT];
+};
+
+// Range each parameter is swept across during a storm
+struct StormRange
+{
+    float low;
+    float high;
+};
+
+static double elapsedNs(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --types LIST     reverb types by name or number (room,hall,plate,early,hybrid)\n"
+        "  --rates LIST     sample rates (default 44100,48000,88200,96000,176400,192000)\n"
+        "  --blocks LIST    block sizes, 16-%u (default 16,32,...,4096)\n"
+        "  --programs LIST  factory programs, 0-%u (default all)\n"
+        "  --qualities LIST quality tiers, eco,standard,high (default high)\n"
+        "  --seconds S      audio rendered per case (default 1.0)\n"
+        "  --ir FILE        impulse response for the hybrid type\n"
+        "  --mono           the same noise on both inputs\n"
+        "  --steady-only    skip the parameter storm runs\n"
+        "  --storm-only     skip the steady state runs\n"
+        "  --csv            comma separated output\n"
+        "  --counters       also read hardware counters, for the whole run and per stage\n"
+        "  --trace FILE     write the trace points as Chrome trace JSON (TRACE=true builds)\n"
+        "\n"
+        "Scaling mode, a mix of instances processed by a pool of threads per block:\n"
+        "  --scaling        run the scaling mode (default rate 48000, block 256)\n"
+        "  --instances LIST instance counts (default 1,2,4,8,16,32,64)\n"
+        "  --threads LIST   thread counts (default 1,2,4,8)\n"
+        "\n"
+        "Sends mode, sources sharing one tank against one engine per source at Dry 0:\n"
+        "  --sends          run the sends mode (default rate 48000, block 256), the\n"
+        "                   first program sets the space, --instances the source counts,\n"
+        "                   no impulse response\n",
+        name, BENCH_MAX_BLOCK, PROGRAM_COUNT - 1);
+}
+
+static int parseType(const std::string& token)
+{
+    for (int i = 0; i < REVERB_TYPE_COUNT; i++)
+    {
+        if (token == benchTypeNames[i])
+            return i;
+    }
+
+    char* end = nullptr;
+    long value = std::strtol(token.c_str(), &end, 10);
+    if (end == token.c_str() || *end != '\0' || value < 0 || value >= REVERB_TYPE_COUNT)
+        return -1;
+    return static_cast<int>(value);
+}
+
+// Comma separated list, integers may be given as ranges ("0-15")
+static bool parseList(const char* text, std::vector<int>& list, bool types)
+{
+    list.clear();
+    std::string all(text);
+    size_t start = 0;
+
+    while (start <= all.size())
+    {
+        size_t comma = all.find(',', start);
+        if (comma == std::string::npos)
+            comma = all.size();
+        std::string token = all.substr(start, comma - start);
+        start = comma + 1;
+
+        if (token.empty())
+            return false;
+
+        if (types)
+        {
+            int type = parseType(token);
+            if (type < 0)
+                return false;
+            list.push_back(type);
+            continue;
+        }
+
+        char* end = nullptr;
+        long first = std::strtol(token.c_str(), &end, 10);
+        long last = first;
+        if (end == token.c_str())
+            return false;
+        if (*end == '-')
+        {
+            const char* second = end + 1;
+            last = std::strtol(second, &end, 10);
+            if (end == second)
+                return false;
+        }
+        if (*end != '\0' || first < 0 || last < first)
+            return false;
+
+        for (long value = first; value <= last; value++)
+            list.push_back(static_cast<int>(value));
+    }
+
+    return !list.empty();
+}
+
+// Comma separated quality tier names
+static bool parseQualities(const char* text, std::vector<int>& list)
+{
+    list.clear();
+    std::string all(text);
+    size_t start = 0;
+
+    while (start <= all.size())
+    {
+        size_t comma = all.find(',', start);
+        if (comma == std::string::npos)
+            comma = all.size();
+        std::string token = all.substr(start, comma - start);
+        start = comma + 1;
+
+        ReverbQuality quality;
+        if (!StudioReverbDSP::parseQuality(token.c_str(), quality))
+            return false;
+        list.push_back(quality);
+    }
+
+    return !list.empty();
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options)
+{
+    options.types.clear();
+    for (int i = 0; i < REVERB_TYPE_COUNT; i++)
+        options.types.push_back(i);
+
+    const int rates[] = { 44100, 48000, 88200, 96000, 176400, 192000 };
+    options.rates.assign(rates, rates + sizeof(rates) / sizeof(rates[0]));
+
+    options.blocks.clear();
+    for (uint32_t block = 16; block <= BENCH_MAX_BLOCK; block *= 2)
+        options.blocks.push_back(static_cast<int>(block));
+
+    options.programs.clear();
+    for (uint32_t i = 0; i < PROGRAM_COUNT; i++)
+        options.programs.push_back(static_cast<int>(i));
+
+    options.qualities.assign(1, QUALITY_HIGH);
+
+    options.seconds = 1.0;
+    options.irFile = nullptr;
+    options.steady = true;
+    options.storm = true;
+    options.csv = false;
+    options.counters = false;
+    options.traceFile = nullptr;
+    options.mono = false;
+
+    options.scaling = false;
+    options.sends = false;
+    const int instances[] = { 1, 2, 4, 8, 16, 32, 64 };
+    options.instances.assign(instances, instances + sizeof(instances) / sizeof(instances[0]));
+    const int threads[] = { 1, 2, 4, 8 };
+    options.threads.assign(threads, threads + sizeof(threads) / sizeof(threads[0]));
+    bool ratesGiven = false;
+    bool blocksGiven = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--types") == 0 && value != nullptr)
+            ok = parseList(argv[++i], options.types, true);
+        else if (std::strcmp(arg, "--rates") == 0 && value != nullptr)
+            ok = ratesGiven = parseList(argv[++i], options.rates, false);
+        else if (std::strcmp(arg, "--blocks") == 0 && value != nullptr)
+            ok = blocksGiven = parseList(argv[++i], options.blocks, false);
+        else if (std::strcmp(arg, "--programs") == 0 && value != nullptr)
+            ok = parseList(argv[++i], options.programs, false);
+        else if (std::strcmp(arg, "--qualities") == 0 && value != nullptr)
+            ok = parseQualities(argv[++i], options.qualities);
+        else if (std::strcmp(arg, "--seconds") == 0 && value != nullptr)
+            ok = (options.seconds = std::atof(argv[++i])) > 0.0;
+        else if (std::strcmp(arg, "--ir") == 0 && value != nullptr)
+            options.irFile = argv[++i];
+        else if (std::strcmp(arg, "--mono") == 0)
+            options.mono = true;
+        else if (std::strcmp(arg, "--steady-only") == 0)
+            options.storm = false;
+        else if (std::strcmp(arg, "--storm-only") == 0)
+            options.steady = false;
+        else if (std::strcmp(arg, "--csv") == 0)
+            options.csv = true;
+        else if (std::strcmp(arg, "--counters") == 0)
+            options.counters = true;
+        else if (std::strcmp(arg, "--trace") == 0 && value != nullptr)
+            options.traceFile = argv[++i];
+        else if (std::strcmp(arg, "--scaling") == 0)
+            options.scaling = true;
+        else if (std::strcmp(arg, "--sends") == 0)
+            options.sends = true;
+        else if (std::strcmp(arg, "--instances") == 0 && value != nullptr)
+            ok = parseList(argv[++i], options.instances, false);
+        else if (std::strcmp(arg, "--threads") == 0 && value != nullptr)
+            ok = parseList(argv[++i], options.threads, false);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    // The full matrix times instances and threads would take hours
+    if (options.scaling || options.sends)
+    {
+        if (!ratesGiven)
+            options.rates.assign(1, 48000);
+        if (!blocksGiven)
+            options.blocks.assign(1, 256);
+    }
+
+    for (size_t i = 0; i < options.rates.size(); i++)
+    {
+        if (options.rates[i] < 8000)
+        {
+            std::fprintf(stderr, "Invalid sample rate: %d\n", options.rates[i]);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < options.blocks.size(); i++)
+    {
+        if (options.blocks[i] < 1 || options.blocks[i] > static_cast<int>(BENCH_MAX_BLOCK))
+        {
+            std::fprintf(stderr, "Invalid block size: %d\n", options.blocks[i]);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < options.programs.size(); i++)
+    {
+        if (options.programs[i] >= static_cast<int>(PROGRAM_COUNT))
+        {
+            std::fprintf(stderr, "Invalid program: %d\n", options.programs[i]);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < options.instances.size(); i++)
+    {
+        if (options.instances[i] < 1)
+        {
+            std::fprintf(stderr, "Invalid instance count: %d\n", options.instances[i]);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < options.threads.size(); i++)
+    {
+        if (options.threads[i] < 1)
+        {
+            std::fprintf(stderr, "Invalid thread count: %d\n", options.threads[i]);
+            return false;
+        }
+    }
+
+    return options.steady || options.storm;
+}
+
+// Parameter state after each factory program, loaded in order from the
+// defaults the same way a host stepping through the programs would.
+void collectProgramStates(std::vector<std::vector<float> >& states)
+{
+    StudioReverbDSP dsp(48000.0);
+    states.assign(PROGRAM_COUNT, std::vector<float>(paramCount));
+
+    for (uint32_t p = 0; p < PROGRAM_COUNT; p++)
+    {
+        const Program& defaults = getProgram(0);
+        for (uint32_t i = 0; i < defaults.count; i++)
+            dsp.setParameterValue(defaults.values[i].index, defaults.values[i].value);
+
+        const Program& program = getProgram(p);
+        for (uint32_t i = 0; i < program.count; i++)
+            dsp.setParameterValue(program.values[i].index, program.values[i].value);
+
+        for (uint32_t i = 0; i < paramCount; i++)
+            states[p][i] = dsp.getParameterValue(i);
+    }
+}
+
+// Storms sweep every parameter across the span the factory programs use,
+// so the values stay within the plugin ranges.
+static void collectStormRanges(const std::vector<std::vector<float> >& states,
+                               std::vector<StormRange>& ranges)
+{
+    ranges.resize(paramCount);
+
+    for (uint32_t i = 0; i < paramCount; i++)
+    {
+        ranges[i].low = ranges[i].high = states[0][i];
+        for (uint32_t p = 1; p < PROGRAM_COUNT; p++)
+        {
+            ranges[i].low = std::min(ranges[i].low, states[p][i]);
+            ranges[i].high = std::max(ranges[i].high, states[p][i]);
+        }
+    }
+}
+
+void fillNoise(std::vector<float>& buffer, uint32_t seed)
+{
+    // xorshift32, white noise at -12 dBFS peak
+    uint32_t state = seed;
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        buffer[i] = 0.25f * (static_cast<float>(state) / 2147483648.0f - 1.0f);
+    }
+}
+
+class Bench
+{
+public:
+    Bench(double sampleRate, const BenchOptions& options)
+        : sampleRate(sampleRate),
+          options(options),
+          dsp(sampleRate),
+          noiseL(BENCH_NOISE_FRAMES + BENCH_MAX_BLOCK),
+          noiseR(BENCH_NOISE_FRAMES + BENCH_MAX_BLOCK),
+          outL(BENCH_MAX_BLOCK),
+          outR(BENCH_MAX_BLOCK),
+          position(0),
+          counting(false)
+    {
+        fillNoise(noiseL, 0x12345678u);
+        fillNoise(noiseR, options.mono ? 0x12345678u : 0x9abcdef0u);
+    }
+
+    bool openCounters()
+    {
+        static bool warned = false;
+
+        counting = total.open() && probe.open();
+        if (!counting && !warned)
+        {
+            warned = true;
+            std::fprintf(stderr, "Hardware counters unavailable (%s), see /proc/sys/kernel/perf_event_paranoid\n",
+                         total.error());
+        }
+        return counting;
+    }
+
+    bool loadImpulse(const char* path)
+    {
+        return dsp.loadImpulseFile(path);
+    }
+
+    void setup(int type, int quality, const std::vector<float>& state)
+    {
+        dsp.setQuality(static_cast<ReverbQuality>(quality));
+        for (uint32_t i = 0; i < paramCount; i++)
+        {
+            if (i != paramReverbType)
+                dsp.setParameterValue(i, state[i]);
+        }
+        // Also mutes every processor
+        dsp.setParameterValue(paramReverbType, static_cast<float>(type));
+    }
+
+    void warmup(uint32_t block)
+    {
+        uint32_t frames = static_cast<uint32_t>(sampleRate * BENCH_WARMUP_SECONDS);
+        uint32_t timeout = static_cast<uint32_t>(sampleRate * BENCH_LOAD_TIMEOUT_SECONDS);
+
+        // A crossfade to a new IR head only advances while audio is running
+        for (uint32_t done = 0; done < timeout && dsp.isImpulseLoading(); done += block)
+            runBlock(block);
+        for (uint32_t done = 0; done < frames; done += block)
+            runBlock(block);
+    }
+
+    BenchResult measure(uint32_t block, const std::vector<float>* state,
+                        const std::vector<StormRange>* ranges)
+    {
+        uint64_t blocks = std::max<uint64_t>(1, static_cast<uint64_t>(sampleRate * options.seconds / block));
+        double blockNs = 1e9 * block / sampleRate;
+        double stormStep = static_cast<double>(block) / (sampleRate * BENCH_STORM_PERIOD_SECONDS);
+
+        BenchResult result;
+        std::memset(&result, 0, sizeof(result));
+        double totalNs = 0.0;
+        double totalSetNs = 0.0;
+
+        if (counting)
+        {
+            total.reset();
+            total.start();
+        }
+
+        for (uint64_t b = 0; b < blocks; b++)
+        {
+            Clock::time_point start = Clock::now();
+
+            if (state != nullptr)
+                storm(b * stormStep, *ranges);
+
+            Clock::time_point set = Clock::now();
+            runBlock(block);
+            Clock::time_point end = Clock::now();
+
+            double setNs = elapsedNs(start, set);
+            double ns = elapsedNs(start, end);
+            totalSetNs += setNs;
+            totalNs += ns;
+            result.worstSetNs = std::max(result.worstSetNs, setNs);
+            result.worstBlockNs = std::max(result.worstBlockNs, ns);
+        }
+
+        double frames = static_cast<double>(blocks) * block;
+        result.nsPerSample = totalNs / frames;
+        result.realtimeFactor = (frames / sampleRate) / (totalNs * 1e-9);
+        result.worstBlockLoad = result.worstBlockNs / blockNs;
+        result.setNsPerBlock = totalSetNs / blocks;
+
+        if (counting)
+        {
+            total.stop();
+            total.read(result.counters[0]);
+
+            // The stage counters are switched on and off around every stage,
+            // so they get a pass of their own that does not disturb the timing
+            probe.reset();
+            dsp.setProbe(&probe);
+            for (uint64_t b = 0; b < blocks; b++)
+            {
+                if (state != nullptr)
+                    storm(b * stormStep, *ranges);
+                runBlock(block);
+            }
+            dsp.setProbe(nullptr);
+
+            for (int s = 0; s < DSP_STAGE_COUNT; s++)
+                probe.stages[s].read(result.counters[1 + s]);
+
+            for (int s = 0; s < BENCH_COUNTER_SETS; s++)
+            {
+                for (int e = 0; e < PERF_EVENT_COUNT; e++)
+                {
+                    if (result.counters[s][e] > 0.0)
+                        result.counters[s][e] /= frames;
+                }
+            }
+            result.hasCounters = true;
+        }
+
+        // Leave the storm state behind for the next case
+        if (state != nullptr)
+            setup(static_cast<int>(dsp.getParameterValue(paramReverbType) + 0.5f), dsp.getQuality(), *state);
+
+        return result;
+    }
+
+private:
+    // Every parameter but the type moves on every block, each on its own
+    // phase of a triangle sweep across its range
+    void storm(double position, const std::vector<StormRange>& ranges)
+    {
+        for (uint32_t i = 0; i < paramCount; i++)
+        {
+            if (i == paramReverbType)
+                continue;
+            double phase = std::fmod(position + static_cast<double>(i) / paramCount, 1.0);
+            double tri = phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase;
+            const StormRange& range = ranges[i];
+            dsp.setParameterValue(i, static_cast<float>(range.low + tri * (range.high - range.low)));
+        }
+    }
+
+    void runBlock(uint32_t block)
+    {
+        if (position + block > BENCH_NOISE_FRAMES)
+            position = 0;
+
+        const float* inputs[2] = { &noiseL[position], &noiseR[position] };
+        float* outputs[2] = { &outL[0], &outR[0] };
+        dsp.run(inputs, outputs, block);
+        position += block;
+    }
+
+    double sampleRate;
+    const BenchOptions& options;
+    StudioReverbDSP dsp;
+    std::vector<float> noiseL, noiseR;
+    std::vector<float> outL, outR;
+    uint32_t position;
+
+    bool counting;
+    PerfCounters total;
+    CounterProbe probe;
+};
+
+static void printHeader(const BenchOptions& options)
+{
+    if (options.csv)
+    {
+        std::printf("type,rate,block,program,quality,mode,ns_per_sample,realtime_factor,"
+                    "worst_block_us,worst_block_load,set_ns_per_block,worst_set_us");
+        if (options.counters)
+        {
+            for (int s = 0; s < BENCH_COUNTER_SETS; s++)
+            {
+                for (int e = 0; e < PERF_EVENT_COUNT; e++)
+                    std::printf(",%s_%s_per_sample", counterSetNames[s], PerfCounters::name(static_cast<PerfEvent>(e)));
+            }
+        }
+        std::printf("\n");
+        return;
+    }
+
+    std::printf("%-7s %6s %5s %-14s %-8s %-6s %9s %9s %10s %7s %10s %10s\n",
+                "type", "rate", "block", "program", "quality", "mode", "ns/smp", "rt-factor",
+                "worst us", "load %", "set ns/blk", "worst set");
+}
+
+static void printCounters(const BenchResult& r)
+{
+    for (int s = 0; s < BENCH_COUNTER_SETS; s++)
+    {
+        const double* c = r.counters[s];
+        if (s > 0 && c[PERF_CYCLES] <= 0.0 && c[PERF_INSTRUCTIONS] <= 0.0)
+            continue;
+
+        double ipc = (c[PERF_CYCLES] > 0.0 && c[PERF_INSTRUCTIONS] >= 0.0) ? c[PERF_INSTRUCTIONS] / c[PERF_CYCLES] : -1.0;
+        double missRate = (c[PERF_BRANCHES] > 0.0 && c[PERF_BRANCH_MISSES] >= 0.0)
+            ? 100.0 * c[PERF_BRANCH_MISSES] / c[PERF_BRANCHES] : -1.0;
+
+        std::printf("%45s %-5s cyc/smp %8.1f  ins/smp %8.1f  ipc %5.2f  br-miss/smp %7.3f (%5.2f %%)"
+                    "  l1d-miss/smp %7.3f  llc-miss/smp %7.4f\n",
+                    "", counterSetNames[s], c[PERF_CYCLES], c[PERF_INSTRUCTIONS], ipc,
+                    c[PERF_BRANCH_MISSES], missRate, c[PERF_L1D_MISSES], c[PERF_LLC_MISSES]);
+    }
+}
+
+static void printResult(const BenchOptions& options, int type, int rate, int block,
+                        int program, int quality, const char* mode, const BenchResult& r)
+{
+    const char* name = getProgram(program).name;
+    const char* tier = StudioReverbDSP::getQualityName(static_cast<ReverbQuality>(quality));
+
+    if (options.csv)
+    {
+        std::printf("%s,%d,%d,\"%s\",%s,%s,%.3f,%.2f,%.3f,%.4f,%.1f,%.3f",
+                    benchTypeNames[type], rate, block, name, tier, mode, r.nsPerSample, r.realtimeFactor,
+                    r.worstBlockNs * 1e-3, r.worstBlockLoad, r.setNsPerBlock, r.worstSetNs * 1e-3);
+        if (options.counters)
+        {
+            for (int s = 0; s < BENCH_COUNTER_SETS; s++)
+            {
+                for (int e = 0; e < PERF_EVENT_COUNT; e++)
+                {
+                    if (r.hasCounters && r.counters[s][e] >= 0.0)
+                        std::printf(",%.4f", r.counters[s][e]);
+                    else
+                        std::printf(",");
+                }
+            }
+        }
+        std::printf("\n");
+        return;
+    }
+
+    std::printf("%-7s %6d %5d %-14s %-8s %-6s %9.2f %9.1f %10.2f %7.2f %10.0f %10.2f\n",
+                benchTypeNames[type], rate, block, name, tier, mode, r.nsPerSample, r.realtimeFactor,
+                r.worstBlockNs * 1e-3, r.worstBlockLoad * 100.0, r.setNsPerBlock, r.worstSetNs * 1e-3);
+    if (r.hasCounters)
+        printCounters(r);
+}
+
+static int runMatrix(const BenchOptions& options, const std::vector<std::vector<float> >& states,
+                     const std::vector<StormRange>& ranges)
+{
+    printHeader(options);
+
+    for (size_t r = 0; r < options.rates.size(); r++)
+    {
+        int rate = options.rates[r];
+        Bench bench(rate, options);
+        if (options.counters)
+            bench.openCounters();
+
+        if (options.irFile != nullptr && !bench.loadImpulse(options.irFile))
+        {
+            std::fprintf(stderr, "Could not load impulse response: %s\n", options.irFile);
+            return 1;
+        }
+
+        for (size_t t = 0; t < options.types.size(); t++)
+        {
+            int type = options.types[t];
+            for (size_t b = 0; b < options.blocks.size(); b++)
+            {
+                uint32_t block = static_cast<uint32_t>(options.blocks[b]);
+                for (size_t p = 0; p < options.programs.size(); p++)
+                {
+                    int program = options.programs[p];
+                    const std::vector<float>& state = states[program];
+
+                    for (size_t q = 0; q < options.qualities.size(); q++)
+                    {
+                        int quality = options.qualities[q];
+                        bench.setup(type, quality, state);
+                        bench.warmup(block);
+
+                        if (options.steady)
+                        {
+                            BenchResult result = bench.measure(block, nullptr, nullptr);
+                            printResult(options, type, rate, block, program, quality, "steady", result);
+                        }
+                        if (options.storm)
+                        {
+                            BenchResult result = bench.measure(block, &state, &ranges);
+                            printResult(options, type, rate, block, program, quality, "storm", result);
+                        }
+                        std::fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (options.traceFile != nullptr && !fv3::trace_enabled())
+        std::fprintf(stderr, "Warning: built without TRACE=true, %s will be empty\n", options.traceFile);
+    FV3_TRACE_THREAD("bench");
+
+    std::vector<std::vector<float> > states;
+    std::vector<StormRange> ranges;
+    collectProgramStates(states);
+    collectStormRanges(states, ranges);
+
+    int status;
+    if (options.scaling)
+        status = runScaling(options, states);
+    else if (options.sends)
+        status = runSends(options, states);
+    else
+        status = runMatrix(options, states, ranges);
+
+    // The rings keep the most recent events of each thread
+    if (options.traceFile != nullptr && !fv3::trace_dump(options.traceFile))
+    {
+        std::fprintf(stderr, "Could not write trace: %s\n", options.traceFile);
+        return 1;
+    }
+    return status;
+}
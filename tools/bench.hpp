@@ -0,0 +1,55 @@
+/*
+ * Studio Reverb Offline Benchmark
+ * Declarations shared by the benchmark modes
+ */
+
+#ifndef STUDIO_REVERB_BENCH_HPP_INCLUDED
+#define STUDIO_REVERB_BENCH_HPP_INCLUDED
+
+#include "DSP.hpp"
+
+#include <vector>
+
+// Test signal, long enough that blocks do not see a repeating pattern
+static const uint32_t BENCH_NOISE_FRAMES = 65536;
+static const uint32_t BENCH_MAX_BLOCK = 4096;
+
+extern const char* const benchTypeNames[REVERB_TYPE_COUNT];
+
+struct BenchOptions
+{
+    std::vector<int> types;
+    std::vector<int> rates;
+    std::vector<int> blocks;
+    std::vector<int> programs;
+    std::vector<int> qualities;
+    double seconds;
+    const char* irFile;
+    bool steady;
+    bool storm;
+    bool csv;
+    bool counters;
+    const char* traceFile;
+    bool mono;              // the same noise on both inputs
+
+    // Multi-instance scaling mode, the sends mode takes the instances as
+    // source counts
+    bool scaling;
+    bool sends;
+    std::vector<int> instances;
+    std::vector<int> threads;
+};
+
+// Parameter state of each factory program
+void collectProgramStates(std::vector<std::vector<float> >& states);
+
+// Deterministic white noise at -12 dBFS peak
+void fillNoise(std::vector<float>& buffer, uint32_t seed);
+
+// N instances processed by M threads, see scaling.cpp
+int runScaling(const BenchOptions& options, const std::vector<std::vector<float> >& states);
+
+// N sources in one shared tank against N engines, see sends.cpp
+int runSends(const BenchOptions& options, const std::vector<std::vector<float> >& states);
+
+#endif // STUDIO_REVERB_BENCH_HPP_INCLUDED
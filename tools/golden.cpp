@@ -0,0 +1,1218 @@
+/*
+ * Studio Reverb Golden Output Check
+ * Renders a reference set and compares later builds against it
+ */
+
+#include "DSP.hpp"
+#include "Programs.hpp"
+#include "ReverbBatch.hpp"
+#include "ReverbSends.hpp"
+#include "spectrum.hpp"
+
+#include "freeverb/frag.hpp"
+#include "freeverb/irsource.hpp"
+#include "freeverb/irmodel3.hpp"
+#include "freeverb/irmodel3ts.hpp"
+#include "freeverb/irmodels.hpp"
+#include "freeverb/nrev.hpp"
+#include "freeverb/nrevbatch.hpp"
+#include "freeverb/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char* const typeNames[REVERB_TYPE_COUNT] = {
+    "room", "hall", "plate", "early", "hybrid"
+};
+
+// Input: a stereo noise burst, then silence for the tail
+static const double GOLDEN_BURST_SECONDS = 0.05;
+static const double GOLDEN_DEFAULT_SECONDS = 0.5;
+static const uint32_t GOLDEN_DEFAULT_BLOCK = 256;
+
+// Welch spectrum in third octave bands. Bands more than GOLDEN_FLOOR_DB
+// below the loudest band of the reference are not compared.
+static const uint32_t GOLDEN_FFT_SIZE = 4096;
+static const double GOLDEN_FIRST_BAND_HZ = 50.0;
+static const double GOLDEN_FLOOR_DB = 80.0;
+
+// Default tolerances: -80 dBFS per sample, 0.1 dB per band
+static const double GOLDEN_MAX_ERROR = 1e-4;
+static const double GOLDEN_SPECTRAL_DB = 0.1;
+
+// Level envelope of the committed levels file, RMS of both channels
+static const double GOLDEN_ENVELOPE_SECONDS = 0.05;
+
+// Every render draws the same modulation noise, however many engines the
+// process has made before
+static const uint32_t GOLDEN_NOISE_SEED = 0;
+
+struct GoldenOptions
+{
+    const char* writeDir;
+    const char* compareDir;
+    const char* writeLevels;
+    const char* levels;
+    std::vector<int> rates;
+    double seconds;
+    uint32_t block;
+    double maxError;
+    double spectralDb;
+    const char* only;
+    bool kernels;
+};
+
+struct GoldenCase
+{
+    std::string name;
+    int rate;
+    int type;       // -1 for a program case
+    int program;    // loaded on top of program 0
+};
+
+// One case of the levels file
+struct GoldenLevels
+{
+    std::string name;
+    size_t frames;
+    std::vector<double> bands;
+    std::vector<double> envelope;
+};
+
+struct GoldenResult
+{
+    double maxError;
+    double errorDb;     // error energy relative to the reference
+    double spectralDb;  // largest band level difference
+};
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s --write DIR | --compare DIR | --write-levels FILE | --levels FILE | --kernels [options]\n"
+        "Renders every reverb type and factory program at several sample rates.\n"
+        "--write stores the renders as reference WAV files, --compare checks the\n"
+        "current build against them and exits with 1 if any case is out of tolerance.\n"
+        "--write-levels and --levels do the same with the third octave band levels\n"
+        "and the level envelope of each case in a text file.\n"
+        "--kernels checks the fast kernel paths against their plain versions, it\n"
+        "needs no references and can be combined with --compare and --levels.\n"
+        "  --rates LIST       sample rates (default 44100,48000,96000)\n"
+        "  --seconds S        length of each render (default %.1f)\n"
+        "  --block N          block size (default %u)\n"
+        "  --max-error E      largest sample difference (default %g)\n"
+        "  --spectral-db D    largest third octave band difference (default %g)\n"
+        "  --only TEXT        cases whose name contains TEXT\n",
+        name, GOLDEN_DEFAULT_SECONDS, GOLDEN_DEFAULT_BLOCK, GOLDEN_MAX_ERROR, GOLDEN_SPECTRAL_DB);
+}
+
+static bool parseRates(const char* text, std::vector<int>& rates)
+{
+    rates.clear();
+    const char* p = text;
+    while (*p != '\0')
+    {
+        char* end = nullptr;
+        long rate = std::strtol(p, &end, 10);
+        if (end == p || rate < 8000 || (*end != ',' && *end != '\0'))
+            return false;
+        rates.push_back(static_cast<int>(rate));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !rates.empty();
+}
+
+static bool parseOptions(int argc, char* argv[], GoldenOptions& options)
+{
+    options.writeDir = nullptr;
+    options.compareDir = nullptr;
+    options.writeLevels = nullptr;
+    options.levels = nullptr;
+    const int rates[] = { 44100, 48000, 96000 };
+    options.rates.assign(rates, rates + sizeof(rates) / sizeof(rates[0]));
+    options.seconds = GOLDEN_DEFAULT_SECONDS;
+    options.block = GOLDEN_DEFAULT_BLOCK;
+    options.maxError = GOLDEN_MAX_ERROR;
+    options.spectralDb = GOLDEN_SPECTRAL_DB;
+    options.only = nullptr;
+    options.kernels = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--write") == 0 && value != nullptr)
+            options.writeDir = argv[++i];
+        else if (std::strcmp(arg, "--compare") == 0 && value != nullptr)
+            options.compareDir = argv[++i];
+        else if (std::strcmp(arg, "--write-levels") == 0 && value != nullptr)
+            options.writeLevels = argv[++i];
+        else if (std::strcmp(arg, "--levels") == 0 && value != nullptr)
+            options.levels = argv[++i];
+        else if (std::strcmp(arg, "--rates") == 0 && value != nullptr)
+            ok = parseRates(argv[++i], options.rates);
+        else if (std::strcmp(arg, "--seconds") == 0 && value != nullptr)
+            ok = (options.seconds = std::atof(argv[++i])) > GOLDEN_BURST_SECONDS;
+        else if (std::strcmp(arg, "--block") == 0 && value != nullptr)
+            ok = (options.block = static_cast<uint32_t>(std::atol(argv[++i]))) > 0;
+        else if (std::strcmp(arg, "--max-error") == 0 && value != nullptr)
+            ok = (options.maxError = std::atof(argv[++i])) >= 0.0;
+        else if (std::strcmp(arg, "--spectral-db") == 0 && value != nullptr)
+            ok = (options.spectralDb = std::atof(argv[++i])) >= 0.0;
+        else if (std::strcmp(arg, "--only") == 0 && value != nullptr)
+            options.only = argv[++i];
+        else if (std::strcmp(arg, "--kernels") == 0)
+            options.kernels = true;
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    bool writing = options.writeDir != nullptr || options.writeLevels != nullptr;
+    bool comparing = options.compareDir != nullptr || options.levels != nullptr;
+    if (writing && comparing)
+        return false;
+    return options.kernels || writing || comparing;
+}
+
+static void collectCases(const GoldenOptions& options, std::vector<GoldenCase>& cases)
+{
+    char name[64];
+    for (size_t r = 0; r < options.rates.size(); r++)
+    {
+        int rate = options.rates[r];
+        for (int t = 0; t < REVERB_TYPE_COUNT; t++)
+        {
+            std::snprintf(name, sizeof(name), "type-%s-%d", typeNames[t], rate);
+            GoldenCase c = { name, rate, t, 0 };
+            cases.push_back(c);
+        }
+        for (uint32_t p = 0; p < PROGRAM_COUNT; p++)
+        {
+            std::snprintf(name, sizeof(name), "program-%02u-%d", p, rate);
+            GoldenCase c = { name, rate, -1, static_cast<int>(p) };
+            cases.push_back(c);
+        }
+    }
+
+    if (options.only != nullptr)
+    {
+        std::vector<GoldenCase> all;
+        all.swap(cases);
+        for (size_t i = 0; i < all.size(); i++)
+        {
+            if (all[i].name.find(options.only) != std::string::npos)
+                cases.push_back(all[i]);
+        }
+    }
+}
+
+static void applyProgram(StudioReverbDSP& dsp, uint32_t index)
+{
+    const Program& program = getProgram(index);
+    for (uint32_t i = 0; i < program.count; i++)
+        dsp.setParameterValue(program.values[i].index, program.values[i].value);
+}
+
+// Interleaved stereo. The DSP is created for every case, so no state
+// carries over from the previous one.
+static void render(const GoldenCase& c, const GoldenOptions& options, std::vector<float>& output)
+{
+    StudioReverbDSP dsp(c.rate);
+    dsp.setNoiseSeed(GOLDEN_NOISE_SEED);
+    applyProgram(dsp, 0);
+    if (c.type >= 0)
+        dsp.setParameterValue(paramReverbType, static_cast<float>(c.type));
+    else
+        applyProgram(dsp, static_cast<uint32_t>(c.program));
+
+    uint32_t frames = static_cast<uint32_t>(c.rate * options.seconds);
+    uint32_t burst = static_cast<uint32_t>(c.rate * GOLDEN_BURST_SECONDS);
+    std::vector<float> inL(options.block), inR(options.block), outL(options.block), outR(options.block);
+    output.resize(2 * static_cast<size_t>(frames));
+
+    // xorshift32 at -12 dBFS peak, a different sequence per channel
+    uint32_t stateL = 0x12345678u, stateR = 0x9abcdef0u;
+    for (uint32_t done = 0; done < frames; done += options.block)
+    {
+        uint32_t block = std::min(options.block, frames - done);
+        for (uint32_t i = 0; i < block; i++)
+        {
+            bool noise = done + i < burst;
+            stateL ^= stateL << 13; stateL ^= stateL >> 17; stateL ^= stateL << 5;
+            stateR ^= stateR << 13; stateR ^= stateR >> 17; stateR ^= stateR << 5;
+            inL[i] = noise ? 0.25f * (static_cast<float>(stateL) / 2147483648.0f - 1.0f) : 0.0f;
+            inR[i] = noise ? 0.25f * (static_cast<float>(stateR) / 2147483648.0f - 1.0f) : 0.0f;
+        }
+
+        const float* inputs[2] = { &inL[0], &inR[0] };
+        float* outputs[2] = { &outL[0], &outR[0] };
+        dsp.run(inputs, outputs, block);
+
+        for (uint32_t i = 0; i < block; i++)
+        {
+            output[2 * (done + i)] = outL[i];
+            output[2 * (done + i) + 1] = outR[i];
+        }
+    }
+}
+
+// --------------------------------------------------------------
+// 32 bit float stereo WAV, only the layout written here is read back
+
+static void putLE(std::vector<unsigned char>& bytes, uint32_t value, int size)
+{
+    for (int i = 0; i < size; i++)
+        bytes.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+static uint32_t getLE(const unsigned char* bytes, int size)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < size; i++)
+        value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    return value;
+}
+
+static bool writeWav(const std::string& path, int rate, const std::vector<float>& samples)
+{
+    uint32_t dataSize = static_cast<uint32_t>(samples.size() * sizeof(float));
+    std::vector<unsigned char> header;
+    header.insert(header.end(), "RIFF", "RIFF" + 4);
+    putLE(header, 36 + dataSize, 4);
+    header.insert(header.end(), "WAVEfmt ", "WAVEfmt " + 8);
+    putLE(header, 16, 4);
+    putLE(header, 3, 2);                // IEEE float
+    putLE(header, 2, 2);
+    putLE(header, static_cast<uint32_t>(rate), 4);
+    putLE(header, static_cast<uint32_t>(rate) * 8, 4);
+    putLE(header, 8, 2);
+    putLE(header, 32, 2);
+    header.insert(header.end(), "data", "data" + 4);
+    putLE(header, dataSize, 4);
+
+    std::vector<unsigned char> data(dataSize);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &samples[i], sizeof(bits));
+        for (int b = 0; b < 4; b++)
+            data[4 * i + b] = static_cast<unsigned char>(bits >> (8 * b));
+    }
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool ok = std::fwrite(&header[0], 1, header.size(), file) == header.size() &&
+              std::fwrite(&data[0], 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+static bool readWav(const std::string& path, int& rate, std::vector<float>& samples)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    unsigned char header[44];
+    bool ok = std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+              std::memcmp(header, "RIFF", 4) == 0 && std::memcmp(header + 8, "WAVEfmt ", 8) == 0 &&
+              getLE(header + 20, 2) == 3 && getLE(header + 22, 2) == 2 && getLE(header + 34, 2) == 32 &&
+              std::memcmp(header + 36, "data", 4) == 0;
+    if (ok)
+    {
+        rate = static_cast<int>(getLE(header + 24, 4));
+        std::vector<unsigned char> data(getLE(header + 40, 4));
+        ok = data.empty() || std::fread(&data[0], 1, data.size(), file) == data.size();
+        samples.resize(data.size() / 4);
+        for (size_t i = 0; ok && i < samples.size(); i++)
+        {
+            uint32_t bits = getLE(&data[4 * i], 4);
+            std::memcpy(&samples[i], &bits, sizeof(bits));
+        }
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// --------------------------------------------------------------
+// Kernel checks: each fast path against its plain version, in-process
+
+struct KernelCheck
+{
+    const char* name;
+    bool (*run)(double& maxError);   // true if within the check's tolerance
+};
+
+static void noiseImpulse(std::vector<float>& samples, size_t frames, uint32_t seed)
+{
+    samples.resize(2 * frames);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        float decay = std::exp(-static_cast<float>(i / 2) / (0.25f * frames));
+        samples[i] = decay * (static_cast<float>(seed) / 2147483648.0f - 1.0f);
+    }
+}
+
+static double maxDifference(const float* a, const float* b, size_t count)
+{
+    double maxError = 0.0;
+    for (size_t i = 0; i < count; i++)
+        maxError = std::max(maxError, std::fabs(static_cast<double>(a[i]) - b[i]));
+    return maxError;
+}
+
+// Partitions streamed from a mapped WAV (irsource) against the same
+// partitions loaded from memory, bit-identical spectra and convolver output
+static bool checkIrSource(double& maxError)
+{
+    static const long fragmentSize = 1024;
+    static const size_t frames = 10000;
+    std::vector<float> impulse;
+    noiseImpulse(impulse, frames, 0x2468ace1u);
+
+    const char* tmp = std::getenv("TMPDIR");
+    std::string path = std::string(tmp != nullptr ? tmp : "/tmp") + "/studioreverb-golden-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    int fd = mkstemp(&name[0]);
+    if (fd < 0)
+        return false;
+    close(fd);
+    fv3::irsource_f source;
+    bool ok = writeWav(&name[0], 48000, impulse) && source.open(&name[0]);
+    unlink(&name[0]);
+    if (!ok || source.getSize() != static_cast<long>(frames) || source.getChannels() != 2)
+        return false;
+
+    std::vector<float> channel(frames), spectrum(2 * fragmentSize), streamed(2 * fragmentSize), block(2 * fragmentSize);
+    maxError = 0.0;
+    for (long c = 0; c < 2; c++)
+    {
+        for (size_t i = 0; i < frames; i++)
+            channel[i] = impulse[2 * i + c];
+        for (long offset = 0; offset < static_cast<long>(frames); offset += fragmentSize)
+        {
+            long limit = std::min(fragmentSize, static_cast<long>(frames) - offset);
+            fv3::frag_f memory, mapped;
+            memory.loadImpulse(&channel[offset], fragmentSize, limit, FFTW_ESTIMATE);
+            mapped.loadImpulse(&source, c, offset, fragmentSize, limit, FFTW_ESTIMATE, &block[0]);
+            memory.getFFT(&spectrum[0]);
+            mapped.getFFT(&streamed[0]);
+            maxError = std::max(maxError, maxDifference(&spectrum[0], &streamed[0], spectrum.size()));
+        }
+    }
+
+    std::vector<float> left(frames), right(frames);
+    for (size_t i = 0; i < frames; i++)
+    {
+        left[i] = impulse[2 * i];
+        right[i] = impulse[2 * i + 1];
+    }
+    fv3::irmodel3_f fromMemory, fromSource;
+    fromMemory.setFragmentSize(256, 4);
+    fromSource.setFragmentSize(256, 4);
+    fromMemory.loadImpulse(&left[0], &right[0], static_cast<long>(frames));
+    fromSource.loadImpulse(&source);
+
+    static const long length = 3 * frames, blockSize = 300;
+    std::vector<float> inL(length), inR(length), memoryL(length), memoryR(length), sourceL(length), sourceR(length);
+    noiseImpulse(impulse, length, 0x13579bdfu);
+    for (long i = 0; i < length; i++)
+    {
+        inL[i] = impulse[2 * i];
+        inR[i] = impulse[2 * i + 1];
+    }
+    for (long done = 0; done < length; done += blockSize)
+    {
+        fromMemory.processreplace(&inL[done], &inR[done], &memoryL[done], &memoryR[done], blockSize);
+        fromSource.processreplace(&inL[done], &inR[done], &sourceL[done], &sourceR[done], blockSize);
+    }
+    maxError = std::max(maxError, maxDifference(&memoryL[0], &sourceL[0], length));
+    maxError = std::max(maxError, maxDifference(&memoryR[0], &sourceR[0], length));
+    return maxError == 0.0;
+}
+
+// True stereo: each output of irmodel3ts against the sum of two
+// irmodel3m mono convolvers, one per input path
+static bool checkTrueStereo(double& maxError)
+{
+    static const long frames = 5000, length = 4 * frames, blockSize = 250;
+    std::vector<float> pair;
+    std::vector<float> paths[FV3_IR3TS_PATHS];
+    for (long p = 0; p < FV3_IR3TS_PATHS; p += 2)
+    {
+        noiseImpulse(pair, frames, 0x0badcafeu + p);
+        paths[p].resize(frames);
+        paths[p + 1].resize(frames);
+        for (long i = 0; i < frames; i++)
+        {
+            paths[p][i] = pair[2 * i];
+            paths[p + 1][i] = pair[2 * i + 1] * 0.5f;
+        }
+    }
+
+    fv3::irmodel3ts_f stereo;
+    stereo.setFragmentSize(256, 4);
+    stereo.setwetr(1);
+    stereo.setdryr(0);
+    stereo.setwidth(1);
+    stereo.setprocessoptions(FV3_IR_SKIP_FILTER);
+    stereo.loadImpulse(&paths[FV3_IR3TS_LL][0], &paths[FV3_IR3TS_LR][0], &paths[FV3_IR3TS_RL][0], &paths[FV3_IR3TS_RR][0], frames);
+    fv3::irmodel3m_f mono[FV3_IR3TS_PATHS];
+    for (long p = 0; p < FV3_IR3TS_PATHS; p++)
+    {
+        mono[p].setFragmentSize(256, 4);
+        mono[p].loadImpulse(&paths[p][0], frames);
+    }
+
+    std::vector<float> in[2], out[2], reference[2], path(blockSize);
+    noiseImpulse(pair, length, 0x5eed1234u);
+    for (long c = 0; c < 2; c++)
+    {
+        in[c].resize(length);
+        out[c].resize(length);
+        reference[c].assign(length, 0.0f);
+        for (long i = 0; i < length; i++)
+            in[c][i] = pair[2 * i + c];
+    }
+    for (long done = 0; done < length; done += blockSize)
+    {
+        stereo.processreplace(&in[0][done], &in[1][done], &out[0][done], &out[1][done], blockSize);
+        // path index is input * 2 + output
+        for (long p = 0; p < FV3_IR3TS_PATHS; p++)
+        {
+            std::copy(&in[p / 2][done], &in[p / 2][done] + blockSize, path.begin());
+            mono[p].processreplace(&path[0], blockSize);
+            for (long i = 0; i < blockSize; i++)
+                reference[p % 2][done + i] += path[i];
+        }
+    }
+    maxError = std::max(maxDifference(&out[0][0], &reference[0][0], length),
+                        maxDifference(&out[1][0], &reference[1][0], length));
+    return maxError < 1e-4;
+}
+
+// irmodel3m with the large fragment work spread over the block (fragsched)
+// against the plain irmodel3m, the same IR and input. Blocks of changing
+// size, shorter and longer than a large fragment. The IR is scaled for an
+// output peak near 1, the two differ only by float rounding.
+static bool checkScheduled(double& maxError)
+{
+    static const long frames = 20000, length = 4 * frames;
+    static const long blockSizes[] = { 300, 64, 1024, 4096, 1000, 17 };
+    std::vector<float> pair, impulse(frames);
+    noiseImpulse(pair, frames, 0x5c4ed0ffu);
+    for (long i = 0; i < frames; i++)
+        impulse[i] = 0.02f * pair[2 * i];
+
+    fv3::irmodel3m_f plain, scheduled;
+    plain.setFragmentSize(256, 4);
+    scheduled.setFragmentSize(256, 4);
+    scheduled.setScheduled(true);
+    plain.loadImpulse(&impulse[0], frames);
+    scheduled.loadImpulse(&impulse[0], frames);
+
+    std::vector<float> plainOut(length), scheduledOut(length);
+    noiseImpulse(pair, length, 0x0ddba115u);
+    for (long i = 0; i < length; i++)
+        plainOut[i] = scheduledOut[i] = pair[2 * i];
+
+    long done = 0;
+    for (long b = 0; done < length; b++)
+    {
+        long blockSize = std::min(blockSizes[b % (sizeof(blockSizes) / sizeof(blockSizes[0]))], length - done);
+        plain.processreplace(&plainOut[done], blockSize);
+        scheduled.processreplace(&scheduledOut[done], blockSize);
+        done += blockSize;
+    }
+    maxError = maxDifference(&plainOut[0], &scheduledOut[0], length);
+    return maxError < 1e-5;
+}
+
+// The direct FIR of irmodels, with the plain and the fastest block
+// kernel the CPU has, against a convolution summed in double
+static bool checkDirectFir(double& maxError)
+{
+    static const long taps = 1500, length = 6000, blockSize = 150;
+    std::vector<float> pair;
+    noiseImpulse(pair, taps, 0x7f4a7c15u);
+    std::vector<float> irL(taps), irR(taps);
+    for (long i = 0; i < taps; i++)
+    {
+        irL[i] = pair[2 * i];
+        irR[i] = pair[2 * i + 1];
+    }
+
+    std::vector<float> in[2];
+    noiseImpulse(pair, length, 0x31415926u);
+    for (long c = 0; c < 2; c++)
+    {
+        in[c].resize(length);
+        for (long i = 0; i < length; i++)
+            in[c][i] = pair[2 * i + c];
+    }
+
+    std::vector<float> reference[2];
+    for (long c = 0; c < 2; c++)
+    {
+        const std::vector<float>& ir = c == 0 ? irL : irR;
+        reference[c].resize(length);
+        for (long i = 0; i < length; i++)
+        {
+            double sum = 0.0;
+            for (long k = 0; k < taps && k <= i; k++)
+                sum += static_cast<double>(ir[k]) * in[c][i - k];
+            reference[c][i] = static_cast<float>(sum);
+        }
+    }
+
+    const uint32_t flags[2] = { FV3_X86SIMD_FLAG_FPU, fv3::utils_f::getSIMDFlag() };
+    maxError = 0.0;
+    for (int f = 0; f < 2; f++)
+    {
+        fv3::irmodels_f fir;
+        fir.setCrossoverLength(-1);
+        fir.setSIMD(flags[f], 0);
+        fir.setwetr(1);
+        fir.setdryr(0);
+        fir.setwidth(1);
+        fir.setprocessoptions(FV3_IR_SKIP_FILTER);
+        fir.loadImpulse(&irL[0], &irR[0], taps);
+        if (fir.isPartitioned())
+            return false;
+
+        std::vector<float> out[2];
+        out[0].resize(length);
+        out[1].resize(length);
+        for (long done = 0; done < length; done += blockSize)
+            fir.processreplace(&in[0][done], &in[1][done], &out[0][done], &out[1][done], blockSize);
+        for (long c = 0; c < 2; c++)
+            maxError = std::max(maxError, maxDifference(&out[c][0], &reference[c][0], length));
+    }
+    return maxError < 1e-4;
+}
+
+// Each lane of nrevbatch against a scalar nrev with the same settings. The
+// batch flushes all denormals through MXCSR, nrev only a few values, so
+// the lanes may differ from it by denormal amounts.
+static bool checkNrevLanes(double& maxError)
+{
+    static const long lanes = 5, length = 96000, burst = 4800, blockSize = 200;
+    static const float rate = 48000.0f;
+    fv3::nrevbatch_f batch;
+    batch.setLanes(lanes);
+    batch.setSampleRate(rate);
+    fv3::nrev_f scalar[lanes];
+
+    std::vector<float> in[2][lanes], batchOut[2][lanes], scalarOut[2][lanes], pair;
+    float* inPtr[2][lanes];
+    float* outPtr[2][lanes];
+    for (long k = 0; k < lanes; k++)
+    {
+        fv3::nrev_f& s = scalar[k];
+        s.setSampleRate(rate);
+        float rt60 = 0.1f + 0.5f * k, feedback = 0.3f + 0.1f * k, damp = 0.05f * (k + 1);
+        float preDelay = 3.0f * k, width = 1.0f - 0.2f * k, lowCut = 10.0f + 20.0f * k;
+        batch.setrt60(k, rt60);
+        s.setrt60(rt60);
+        batch.setfeedback(k, feedback);
+        s.setfeedback(feedback);
+        batch.setdamp(k, damp);
+        s.setdamp(damp);
+        batch.setPreDelay(k, preDelay);
+        s.setPreDelay(preDelay);
+        batch.setwidth(k, width);
+        s.setwidth(width);
+        batch.setdccutfreq(k, lowCut);
+        s.setdccutfreq(lowCut);
+        batch.setdryr(k, 0.5f);
+        s.setdryr(0.5f);
+        batch.setwetr(k, 1.0f);
+        s.setwetr(1.0f);
+
+        // A burst and then the tail, the shortest decays into the
+        // denormal range
+        noiseImpulse(pair, burst, 0x600dcafeu + k);
+        for (long c = 0; c < 2; c++)
+        {
+            in[c][k].assign(length, 0.0f);
+            for (long i = 0; i < burst; i++)
+                in[c][k][i] = pair[2 * i + c];
+            batchOut[c][k].resize(length);
+            scalarOut[c][k].resize(length);
+        }
+    }
+    batch.mute();
+    for (long k = 0; k < lanes; k++)
+        scalar[k].mute();
+
+    for (long done = 0; done < length; done += blockSize)
+    {
+        for (long k = 0; k < lanes; k++)
+        {
+            for (long c = 0; c < 2; c++)
+            {
+                inPtr[c][k] = &in[c][k][done];
+                outPtr[c][k] = &batchOut[c][k][done];
+            }
+            scalar[k].processreplace(&in[0][k][done], &in[1][k][done], &scalarOut[0][k][done], &scalarOut[1][k][done], blockSize);
+        }
+        batch.processreplace(inPtr[0], inPtr[1], outPtr[0], outPtr[1], blockSize);
+    }
+
+    maxError = 0.0;
+    for (long k = 0; k < lanes; k++)
+        for (long c = 0; c < 2; c++)
+            maxError = std::max(maxError, maxDifference(&batchOut[c][k][0], &scalarOut[c][k][0], length));
+    return maxError < 1e-6;
+}
+
+// The batch plate against StudioReverbDSP on Plate, one lane per factory
+// program with its parameters, so every instance has other settings. The
+// batch flushes denormals and the engine does not.
+static bool checkBatchPlate(double& maxError)
+{
+    static const uint32_t length = 48000, burst = 2400, blockSize = 200;
+    static const double rate = 48000.0;
+    static const uint32_t count = PROGRAM_COUNT;
+    StudioReverbBatch batch(REVERB_PLATE, count, rate);
+    std::vector<StudioReverbDSP*> engines;
+
+    std::vector<float> in[count][2], batchOut[count][2], engineOut[count][2], pair;
+    for (uint32_t k = 0; k < count; k++)
+    {
+        StudioReverbDSP* dsp = new StudioReverbDSP(rate);
+        dsp->setNoiseSeed(GOLDEN_NOISE_SEED);
+        applyProgram(*dsp, 0);
+        applyProgram(*dsp, k);
+        dsp->setParameterValue(paramReverbType, REVERB_PLATE);
+        engines.push_back(dsp);
+        for (uint32_t index = 0; index < paramCount; index++)
+            batch.setParameterValue(k, index, dsp->getParameterValue(index));
+
+        noiseImpulse(pair, burst, 0x7e57ab1eu + k);
+        for (uint32_t c = 0; c < 2; c++)
+        {
+            in[k][c].assign(length, 0.0f);
+            for (uint32_t i = 0; i < burst; i++)
+                in[k][c][i] = pair[2 * i + c];
+            batchOut[k][c].resize(length);
+            engineOut[k][c].resize(length);
+        }
+    }
+    batch.mute();
+
+    const float* batchIn[2 * count];
+    float* batchOutPtr[2 * count];
+    for (uint32_t done = 0; done < length; done += blockSize)
+    {
+        for (uint32_t k = 0; k < count; k++)
+        {
+            const float* inputs[2] = { &in[k][0][done], &in[k][1][done] };
+            float* outputs[2] = { &engineOut[k][0][done], &engineOut[k][1][done] };
+            engines[k]->run(inputs, outputs, blockSize);
+            for (uint32_t c = 0; c < 2; c++)
+            {
+                batchIn[2 * k + c] = &in[k][c][done];
+                batchOutPtr[2 * k + c] = &batchOut[k][c][done];
+            }
+        }
+        batch.run(batchIn, batchOutPtr, blockSize);
+    }
+
+    maxError = 0.0;
+    for (uint32_t k = 0; k < count; k++)
+    {
+        for (uint32_t c = 0; c < 2; c++)
+            maxError = std::max(maxError, maxDifference(&batchOut[k][c][0], &engineOut[k][c][0], length));
+        delete engines[k];
+    }
+    return maxError < 1e-6;
+}
+
+// One source of a space, no pre-delay and gains of 1, against
+// StudioReverbDSP at Dry 0, every type: the tank is the engine's runLate()
+// and the source's early reflections are the engine's
+static bool checkSendsEngine(double& maxError)
+{
+    static const uint32_t length = 24000, burst = 2400, blockSize = 200;
+    static const double rate = 48000.0;
+    std::vector<float> in[2], sendsOut[2], engineOut[2], pair;
+    noiseImpulse(pair, burst, 0x5e4d5e4du);
+    for (uint32_t c = 0; c < 2; c++)
+    {
+        in[c].assign(length, 0.0f);
+        for (uint32_t i = 0; i < burst; i++)
+            in[c][i] = pair[2 * i + c];
+        sendsOut[c].resize(length);
+        engineOut[c].resize(length);
+    }
+
+    maxError = 0.0;
+    for (int type = 0; type < REVERB_TYPE_COUNT; type++)
+    {
+        StudioReverbSends sends(static_cast<ReverbType>(type), 1, rate);
+        sends.setNoiseSeed(GOLDEN_NOISE_SEED);
+        StudioReverbDSP dsp(rate);
+        dsp.setNoiseSeed(GOLDEN_NOISE_SEED);
+        for (uint32_t index = 0; index < paramCount; index++)
+            dsp.setParameterValue(index, sends.getParameterValue(index));
+        dsp.setParameterValue(paramDry, 0.0f);
+
+        for (uint32_t done = 0; done < length; done += blockSize)
+        {
+            const float* inputs[2] = { &in[0][done], &in[1][done] };
+            float* outputs[2] = { &engineOut[0][done], &engineOut[1][done] };
+            dsp.run(inputs, outputs, blockSize);
+            outputs[0] = &sendsOut[0][done];
+            outputs[1] = &sendsOut[1][done];
+            sends.run(inputs, outputs, blockSize);
+        }
+        for (uint32_t c = 0; c < 2; c++)
+            maxError = std::max(maxError, maxDifference(&sendsOut[c][0], &engineOut[c][0], length));
+    }
+    return maxError < 1e-6;
+}
+
+// A source fed mono, through one buffer or the same samples on both
+// inputs, against the stereo path built from its parts: the input delayed
+// by the pre-delay, stereo early reflections and the engine's runLate().
+// The input switches between mono and stereo blocks, and the pre-delay
+// spans more than a block, every type.
+static bool checkSendsMono(double& maxError)
+{
+    static const uint32_t length = 24000, noise = 12000, blockSize = 200;
+    static const double rate = 48000.0;
+    static const float preDelay = 7.5f;
+    const uint32_t delayFrames = static_cast<uint32_t>(rate * preDelay / 1000.0);
+
+    // Three mono blocks, then three stereo ones
+    std::vector<float> in[2], delayed[2], sendsOut[2], early[2], late[2], pair;
+    noiseImpulse(pair, noise, 0x3a3a5c5cu);
+    for (uint32_t c = 0; c < 2; c++)
+    {
+        in[c].assign(length, 0.0f);
+        delayed[c].assign(length, 0.0f);
+        sendsOut[c].resize(length);
+        early[c].resize(length);
+        late[c].resize(length);
+    }
+    for (uint32_t i = 0; i < noise; i++)
+    {
+        bool mono = (i / blockSize / 3) % 2 == 0;
+        in[0][i] = pair[2 * i];
+        in[1][i] = mono ? pair[2 * i] : pair[2 * i + 1];
+    }
+    for (uint32_t c = 0; c < 2; c++)
+        std::copy(in[c].begin(), in[c].end() - delayFrames, delayed[c].begin() + delayFrames);
+
+    maxError = 0.0;
+    for (int type = 0; type < REVERB_TYPE_COUNT; type++)
+    {
+        StudioReverbSends sends(static_cast<ReverbType>(type), 1, rate);
+        sends.setNoiseSeed(GOLDEN_NOISE_SEED);
+        sends.setSourcePreDelay(0, preDelay);
+
+        StudioReverbDSP tank(rate);
+        tank.setNoiseSeed(GOLDEN_NOISE_SEED);
+        fv3::earlyref_f reflections;
+        StudioReverbDSP::initializeEarly(reflections, static_cast<ReverbType>(type), rate);
+        for (uint32_t index = 0; index < paramCount; index++)
+        {
+            tank.setParameterValue(index, sends.getParameterValue(index));
+            StudioReverbDSP::setEarlyParameter(reflections, static_cast<ReverbType>(type), index,
+                                               sends.getParameterValue(index));
+        }
+        reflections.mute();
+
+        for (uint32_t done = 0; done < length; done += blockSize)
+        {
+            // Every other mono block passes the left buffer twice
+            bool shared = (done / blockSize) % 2 == 0 && in[0][done] == in[1][done];
+            const float* inputs[2] = { &in[0][done], shared ? &in[0][done] : &in[1][done] };
+            float* outputs[2] = { &sendsOut[0][done], &sendsOut[1][done] };
+            sends.run(inputs, outputs, blockSize);
+
+            const float* tankIn[2] = { &delayed[0][done], &delayed[1][done] };
+            float* tankOut[2] = { &late[0][done], &late[1][done] };
+            tank.runLate(tankIn, tankOut, blockSize);
+            reflections.processreplace(&delayed[0][done], &delayed[1][done],
+                                       &early[0][done], &early[1][done], blockSize);
+        }
+
+        float earlyLevel = type == REVERB_PLATE ? 0.0f : sends.getParameterValue(paramEarly) / 100.0f;
+        if (type == REVERB_HALL)
+            earlyLevel *= HALL_EARLY_MIX;
+        for (uint32_t c = 0; c < 2; c++)
+        {
+            for (uint32_t i = 0; i < length; i++)
+                late[c][i] += earlyLevel * early[c][i];
+            maxError = std::max(maxError, maxDifference(&sendsOut[c][0], &late[c][0], length));
+        }
+    }
+    return maxError < 1e-6;
+}
+
+static const KernelCheck kernelChecks[] = {
+    { "irsource-partitions", checkIrSource },
+    { "irmodel3ts-paths", checkTrueStereo },
+    { "irmodel3m-scheduled", checkScheduled },
+    { "irmodels-fir", checkDirectFir },
+    { "nrevbatch-lanes", checkNrevLanes },
+    { "plate-batch", checkBatchPlate },
+    { "sends-engine", checkSendsEngine },
+    { "sends-mono", checkSendsMono },
+};
+
+static int runKernelChecks(const GoldenOptions& options)
+{
+    std::printf("%-22s %12s  %s\n", "kernel", "max error", "result");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(kernelChecks) / sizeof(kernelChecks[0]); i++)
+    {
+        const KernelCheck& k = kernelChecks[i];
+        if (options.only != nullptr && std::strstr(k.name, options.only) == nullptr)
+            continue;
+        double maxError = -1.0;
+        bool ok = k.run(maxError);
+        std::printf("%-22s %12.3g  %s\n", k.name, maxError, ok ? "ok" : "FAILED");
+        if (!ok)
+            failed++;
+    }
+    std::printf("\n");
+    return failed;
+}
+
+// --------------------------------------------------------------
+// Comparison
+
+// Band levels in dB, both channels together, Hann windows with 50% overlap
+static void bandLevels(const std::vector<float>& samples, int rate, std::vector<double>& levels)
+{
+    size_t frames = samples.size() / 2;
+    std::vector<double> power(GOLDEN_FFT_SIZE / 2 + 1, 0.0);
+    std::vector<std::complex<double> > data(GOLDEN_FFT_SIZE);
+
+    for (size_t start = 0; start < frames; start += GOLDEN_FFT_SIZE / 2)
+    {
+        for (int channel = 0; channel < 2; channel++)
+        {
+            for (uint32_t i = 0; i < GOLDEN_FFT_SIZE; i++)
+            {
+                double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / GOLDEN_FFT_SIZE);
+                double sample = start + i < frames ? samples[2 * (start + i) + channel] : 0.0;
+                data[i] = std::complex<double>(sample * window, 0.0);
+            }
+            fft(data);
+            for (size_t k = 0; k < power.size(); k++)
+                power[k] += std::norm(data[k]);
+        }
+    }
+
+    levels.clear();
+    double binHz = static_cast<double>(rate) / GOLDEN_FFT_SIZE;
+    for (double low = GOLDEN_FIRST_BAND_HZ; low * std::pow(2.0, 1.0 / 3.0) < rate / 2.0; low *= std::pow(2.0, 1.0 / 3.0))
+    {
+        double high = low * std::pow(2.0, 1.0 / 3.0);
+        double sum = 0.0;
+        for (size_t k = static_cast<size_t>(std::ceil(low / binHz)); k < power.size() && k * binHz < high; k++)
+            sum += power[k];
+        levels.push_back(10.0 * std::log10(sum + 1e-30));
+    }
+}
+
+// RMS of both channels in dB, GOLDEN_ENVELOPE_SECONDS windows
+static void envelopeLevels(const std::vector<float>& samples, int rate, std::vector<double>& levels)
+{
+    size_t frames = samples.size() / 2;
+    size_t window = static_cast<size_t>(rate * GOLDEN_ENVELOPE_SECONDS);
+    levels.clear();
+    for (size_t start = 0; start < frames; start += window)
+    {
+        size_t end = std::min(frames, start + window);
+        double sum = 0.0;
+        for (size_t i = 2 * start; i < 2 * end; i++)
+            sum += static_cast<double>(samples[i]) * samples[i];
+        levels.push_back(10.0 * std::log10(sum / (2 * (end - start)) + 1e-30));
+    }
+}
+
+// Largest difference of the levels that are less than GOLDEN_FLOOR_DB
+// below the loudest level of the reference
+static double levelDifference(const std::vector<double>& output, const std::vector<double>& reference)
+{
+    if (output.size() != reference.size() || reference.empty())
+        return HUGE_VAL;
+    double loudest = *std::max_element(reference.begin(), reference.end());
+    double difference = 0.0;
+    for (size_t b = 0; b < reference.size(); b++)
+    {
+        if (reference[b] > loudest - GOLDEN_FLOOR_DB)
+            difference = std::max(difference, std::fabs(output[b] - reference[b]));
+    }
+    return difference;
+}
+
+static GoldenResult compare(const std::vector<float>& output, const std::vector<float>& reference, int rate)
+{
+    GoldenResult result;
+    double errorEnergy = 0.0, referenceEnergy = 0.0;
+    result.maxError = 0.0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        double error = static_cast<double>(output[i]) - reference[i];
+        result.maxError = std::max(result.maxError, std::fabs(error));
+        errorEnergy += error * error;
+        referenceEnergy += static_cast<double>(reference[i]) * reference[i];
+    }
+    result.errorDb = 10.0 * std::log10((errorEnergy + 1e-30) / (referenceEnergy + 1e-30));
+
+    std::vector<double> outputLevels, referenceLevels;
+    bandLevels(output, rate, outputLevels);
+    bandLevels(reference, rate, referenceLevels);
+    result.spectralDb = levelDifference(outputLevels, referenceLevels);
+    return result;
+}
+
+// --------------------------------------------------------------
+// Levels file: a line per case, "name frames bands N levels... envelope
+// N levels..." in dB, lines starting with # are comments
+
+static void measureLevels(const GoldenCase& c, const std::vector<float>& output, GoldenLevels& levels)
+{
+    levels.name = c.name;
+    levels.frames = output.size() / 2;
+    bandLevels(output, c.rate, levels.bands);
+    envelopeLevels(output, c.rate, levels.envelope);
+}
+
+static void printLevels(std::string& text, const char* label, const std::vector<double>& levels)
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), " %s %u", label, static_cast<unsigned>(levels.size()));
+    text += number;
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        // Silence as -300 dB, below every floor
+        std::snprintf(number, sizeof(number), " %.2f", std::max(levels[i], -300.0));
+        text += number;
+    }
+}
+
+static bool writeLevelsFile(const char* path, const GoldenOptions& options, const std::vector<GoldenLevels>& cases)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line),
+                  "# studioreverb-golden --write-levels, %.2f s, %u frame blocks\n"
+                  "# case frames, third octave band levels from %g Hz, %g ms envelope (dB)\n",
+                  options.seconds, options.block, GOLDEN_FIRST_BAND_HZ, 1000.0 * GOLDEN_ENVELOPE_SECONDS);
+    std::string text = line;
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        std::snprintf(line, sizeof(line), "%s %u", cases[i].name.c_str(), static_cast<unsigned>(cases[i].frames));
+        text += line;
+        printLevels(text, "bands", cases[i].bands);
+        printLevels(text, "envelope", cases[i].envelope);
+        text += "\n";
+    }
+
+    FILE* file = std::fopen(path, "w");
+    if (file == nullptr)
+        return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+static bool readLevels(std::istringstream& in, const char* label, std::vector<double>& levels)
+{
+    std::string word;
+    size_t count = 0;
+    if (!(in >> word >> count) || word != label)
+        return false;
+    levels.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!(in >> levels[i]))
+            return false;
+    }
+    return true;
+}
+
+static bool readLevelsFile(const char* path, std::vector<GoldenLevels>& cases)
+{
+    FILE* file = std::fopen(path, "r");
+    if (file == nullptr)
+        return false;
+    std::string text;
+    char buffer[4096];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, size);
+    std::fclose(file);
+
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream in(line);
+        GoldenLevels levels;
+        if (!(in >> levels.name >> levels.frames) || !readLevels(in, "bands", levels.bands) ||
+            !readLevels(in, "envelope", levels.envelope))
+            return false;
+        cases.push_back(levels);
+    }
+    return true;
+}
+
+static const GoldenLevels* findLevels(const std::vector<GoldenLevels>& cases, const std::string& name)
+{
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        if (cases[i].name == name)
+            return &cases[i];
+    }
+    return nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+    GoldenOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int kernelsFailed = options.kernels ? runKernelChecks(options) : 0;
+    if (options.writeDir == nullptr && options.compareDir == nullptr &&
+        options.writeLevels == nullptr && options.levels == nullptr)
+        return kernelsFailed > 0 ? 1 : 0;
+
+    std::vector<GoldenCase> cases;
+    collectCases(options, cases);
+    if (cases.empty())
+    {
+        std::fprintf(stderr, "No case matches %s\n", options.only);
+        return 2;
+    }
+
+    if (options.writeDir != nullptr || options.writeLevels != nullptr)
+    {
+        if (options.writeDir != nullptr)
+            mkdir(options.writeDir, 0755);
+        std::vector<GoldenLevels> levels(cases.size());
+        for (size_t i = 0; i < cases.size(); i++)
+        {
+            std::vector<float> output;
+            render(cases[i], options, output);
+            measureLevels(cases[i], output, levels[i]);
+            if (options.writeDir == nullptr)
+                continue;
+            std::string path = std::string(options.writeDir) + "/" + cases[i].name + ".wav";
+            if (!writeWav(path, cases[i].rate, output))
+            {
+                std::fprintf(stderr, "Could not write %s\n", path.c_str());
+                return 2;
+            }
+        }
+        if (options.writeLevels != nullptr && !writeLevelsFile(options.writeLevels, options, levels))
+        {
+            std::fprintf(stderr, "Could not write %s\n", options.writeLevels);
+            return 2;
+        }
+        if (options.writeDir != nullptr)
+            std::printf("Wrote %u reference renders to %s\n", static_cast<unsigned>(cases.size()), options.writeDir);
+        if (options.writeLevels != nullptr)
+            std::printf("Wrote the levels of %u cases to %s\n", static_cast<unsigned>(cases.size()), options.writeLevels);
+        return 0;
+    }
+
+    std::vector<GoldenLevels> committed;
+    if (options.levels != nullptr && !readLevelsFile(options.levels, committed))
+    {
+        std::fprintf(stderr, "Could not read %s\n", options.levels);
+        return 2;
+    }
+
+    std::printf("%-22s %12s %10s %12s %10s  %s\n", "case", "max error", "error dB", "spectral dB", "levels dB", "result");
+    int failed = 0;
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        const GoldenCase& c = cases[i];
+        std::vector<float> output;
+        render(c, options, output);
+
+        char maxError[16] = "-", errorDb[16] = "-", spectralDb[16] = "-", levelsDb[16] = "-";
+        std::string problem;
+        bool ok = true;
+
+        if (options.compareDir != nullptr)
+        {
+            std::string path = std::string(options.compareDir) + "/" + c.name + ".wav";
+            std::vector<float> reference;
+            int rate = 0;
+            if (!readWav(path, rate, reference))
+                problem = "missing " + path;
+            else if (rate != c.rate || output.size() != reference.size())
+                problem = "length or rate differs";
+            else
+            {
+                GoldenResult result = compare(output, reference, c.rate);
+                std::snprintf(maxError, sizeof(maxError), "%.3g", result.maxError);
+                std::snprintf(errorDb, sizeof(errorDb), "%.1f", result.errorDb);
+                std::snprintf(spectralDb, sizeof(spectralDb), "%.3f", result.spectralDb);
+                ok = result.maxError <= options.maxError && result.spectralDb <= options.spectralDb;
+            }
+        }
+
+        if (options.levels != nullptr && problem.empty())
+        {
+            const GoldenLevels* reference = findLevels(committed, c.name);
+            GoldenLevels levels;
+            measureLevels(c, output, levels);
+            if (reference == nullptr)
+                problem = std::string("missing in ") + options.levels;
+            else if (reference->frames != levels.frames)
+                problem = "length differs from the levels file";
+            else
+            {
+                double difference = std::max(levelDifference(levels.bands, reference->bands),
+                                             levelDifference(levels.envelope, reference->envelope));
+                std::snprintf(levelsDb, sizeof(levelsDb), "%.3f", difference);
+                ok = ok && difference <= options.spectralDb;
+            }
+        }
+
+        if (!problem.empty())
+            ok = false;
+        std::printf("%-22s %12s %10s %12s %10s  %s\n", c.name.c_str(), maxError, errorDb, spectralDb, levelsDb,
+                    !problem.empty() ? problem.c_str() : ok ? "ok" : "FAILED");
+        if (!ok)
+            failed++;
+    }
+
+    std::printf("\n%d of %u cases out of tolerance (max error %g, spectral %g dB)\n",
+                failed, static_cast<unsigned>(cases.size()), options.maxError, options.spectralDb);
+    return failed + kernelsFailed > 0 ? 1 : 0;
+}
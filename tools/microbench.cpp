@@ -0,0 +1,586 @@
+/*
+ * Studio Reverb Primitive Microbenchmarks
+ * Times each freeverb building block on its own and writes JSON
+ */
+
+#include "freeverb/allpass.hpp"
+#include "freeverb/biquad.hpp"
+#include "freeverb/comb.hpp"
+#include "freeverb/delay.hpp"
+#include "freeverb/delayline.hpp"
+#include "freeverb/efilter.hpp"
+#include "freeverb/frag.hpp"
+
+#include "perfcounters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Working set sweep, L1 resident up to well beyond the last level cache
+static const size_t MICRO_DEFAULT_MIN_BYTES = 1 << 10;
+static const size_t MICRO_DEFAULT_MAX_BYTES = 64 << 20;
+
+// Each timed repetition processes at least this many samples and walks any
+// state buffer at least MICRO_STATE_PASSES times
+static const long MICRO_MIN_SAMPLES = 1 << 20;
+static const long MICRO_STATE_PASSES = 4;
+static const int MICRO_DEFAULT_REPEATS = 5;
+
+// Input for primitives whose working set is their own state, kept L1 resident
+static const long MICRO_STREAM_FRAMES = 4096;
+
+// Read taps per sample in the delayline::at case, as in a multi-tap tank
+static const long MICRO_DELAYLINE_TAPS = 8;
+
+static const double MICRO_SAMPLE_RATE = 48000.0;
+
+typedef std::chrono::steady_clock Clock;
+
+struct MicroOptions
+{
+    std::vector<std::string> only;
+    size_t minBytes;
+    size_t maxBytes;
+    int repeats;
+    const char* output;
+    bool counters;
+};
+
+struct MicroResult
+{
+    std::string primitive;
+    std::string variant;
+    long size;           // state length or stream length in samples, FFT size for frag
+    size_t bytes;        // working set
+    long samples;        // samples per repetition
+    double nsMin;
+    double nsMedian;
+    bool hasCounters;
+    double counters[PERF_EVENT_COUNT];   // per sample, negative if unavailable
+};
+
+// Keeps the compiler from discarding the processed samples
+static volatile float sink;
+
+static std::vector<float> makeNoise(long length, uint32_t seed)
+{
+    std::vector<float> buffer(length);
+    uint32_t state = seed;
+    for (long i = 0; i < length; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        buffer[i] = 0.25f * (static_cast<float>(state) / 2147483648.0f - 1.0f);
+    }
+    return buffer;
+}
+
+class MicroBench
+{
+public:
+    MicroBench(const MicroOptions& options)
+        : options(options),
+          counting(false)
+    {
+        if (options.counters)
+        {
+            counting = counters.open();
+            if (!counting)
+                std::fprintf(stderr, "Hardware counters unavailable (%s), see /proc/sys/kernel/perf_event_paranoid\n",
+                             counters.error());
+        }
+    }
+
+    bool enabled(const char* primitive) const
+    {
+        if (options.only.empty())
+            return true;
+        return std::find(options.only.begin(), options.only.end(), primitive) != options.only.end();
+    }
+
+    // Working set sizes to visit, doubling from min to max
+    std::vector<size_t> sizes() const
+    {
+        std::vector<size_t> list;
+        for (size_t bytes = options.minBytes; bytes <= options.maxBytes; bytes *= 2)
+            list.push_back(bytes);
+        return list;
+    }
+
+    // kernel(in, out, frames) processes frames samples from in to out. A
+    // stream of streamLength samples is fed repeatedly until the repetition
+    // has covered both MICRO_MIN_SAMPLES and stateLength passes.
+    template <typename Kernel>
+    void run(const char* primitive, const char* variant, long size, size_t bytes,
+             long streamLength, long stateLength, long samplesPerCall, Kernel kernel)
+    {
+        std::vector<float> in = makeNoise(streamLength, 0x2545f491u);
+        std::vector<float> out(streamLength);
+
+        long calls = std::max(MICRO_MIN_SAMPLES, MICRO_STATE_PASSES * stateLength) / samplesPerCall;
+        calls = std::max(1L, calls);
+
+        // First pass untimed, faults in the state and warms the caches
+        kernel(&in[0], &out[0], streamLength);
+
+        std::vector<double> times;
+        for (int r = 0; r < options.repeats; r++)
+        {
+            float acc = 0.0f;
+            Clock::time_point start = Clock::now();
+            for (long c = 0; c < calls; c++)
+            {
+                kernel(&in[0], &out[0], streamLength);
+                acc += out[c % streamLength];
+            }
+            Clock::time_point end = Clock::now();
+            sink = acc;
+            times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        double samples = static_cast<double>(calls) * samplesPerCall;
+
+        MicroResult result;
+        result.primitive = primitive;
+        result.variant = variant;
+        result.size = size;
+        result.bytes = bytes;
+        result.samples = static_cast<long>(samples);
+        result.nsMin = times.front() / samples;
+        result.nsMedian = times[times.size() / 2] / samples;
+        result.hasCounters = false;
+
+        // One more repetition under the counters, apart from the timed ones
+        if (counting)
+        {
+            float acc = 0.0f;
+            counters.reset();
+            counters.start();
+            for (long c = 0; c < calls; c++)
+            {
+                kernel(&in[0], &out[0], streamLength);
+                acc += out[c % streamLength];
+            }
+            counters.stop();
+            sink = acc;
+
+            counters.read(result.counters);
+            for (int e = 0; e < PERF_EVENT_COUNT; e++)
+            {
+                if (result.counters[e] > 0.0)
+                    result.counters[e] /= samples;
+            }
+            result.hasCounters = true;
+        }
+
+        results.push_back(result);
+
+        std::fprintf(stderr, "%-18s %-10s %10zu B %9.3f ns/sample\n",
+                     primitive, variant, bytes, result.nsMedian);
+    }
+
+    bool write() const
+    {
+        FILE* file = stdout;
+        if (options.output != nullptr)
+        {
+            file = std::fopen(options.output, "w");
+            if (file == nullptr)
+            {
+                std::fprintf(stderr, "Could not open %s\n", options.output);
+                return false;
+            }
+        }
+
+        std::fprintf(file, "{\n  \"benchmark\": \"studioreverb-microbench\",\n");
+        std::fprintf(file, "  \"sample_bytes\": %zu,\n", sizeof(float));
+        std::fprintf(file, "  \"repeats\": %d,\n", options.repeats);
+        std::fprintf(file, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const MicroResult& r = results[i];
+            std::fprintf(file,
+                "    {\"primitive\": \"%s\", \"variant\": \"%s\", \"size\": %ld, \"bytes\": %zu, "
+                "\"samples\": %ld, \"ns_per_sample_min\": %.4f, \"ns_per_sample_median\": %.4f",
+                r.primitive.c_str(), r.variant.c_str(), r.size, r.bytes, r.samples,
+                r.nsMin, r.nsMedian);
+            if (r.hasCounters)
+            {
+                std::fprintf(file, ", \"counters_per_sample\": {");
+                bool first = true;
+                for (int e = 0; e < PERF_EVENT_COUNT; e++)
+                {
+                    if (r.counters[e] < 0.0)
+                        continue;
+                    std::fprintf(file, "%s\"%s\": %.5f", first ? "" : ", ",
+                                 PerfCounters::name(static_cast<PerfEvent>(e)), r.counters[e]);
+                    first = false;
+                }
+                std::fprintf(file, "}");
+            }
+            std::fprintf(file, "}%s\n", (i + 1 < results.size()) ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+
+        if (file != stdout)
+            std::fclose(file);
+        return true;
+    }
+
+private:
+    const MicroOptions& options;
+    std::vector<MicroResult> results;
+    bool counting;
+    PerfCounters counters;
+};
+
+// -----------------------------------------------------------------------------
+// Delay based primitives, the sweep sets the length of the delay buffer
+
+static void benchDelays(MicroBench& bench)
+{
+    std::vector<size_t> sizes = bench.sizes();
+
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        long length = static_cast<long>(sizes[s] / sizeof(float));
+        long modLength = std::min(length / 4, 1024L);
+
+        if (bench.enabled("delay"))
+        {
+            fv3::delay_f delay;
+            delay.setsize(length);
+            delay.setfeedback(1);
+            bench.run("delay", "process", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = delay._process(in[i]);
+                });
+        }
+
+        if (bench.enabled("delaym"))
+        {
+            fv3::delaym_f delay;
+            fv3::lfo_f lfo;
+            delay.setsize(length - 2 * modLength, modLength);
+            delay.setfeedback(1);
+            lfo.setFreq(0.5, MICRO_SAMPLE_RATE);
+            bench.run("delaym", "process", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = delay._process(in[i], lfo.process());
+                });
+        }
+
+        if (bench.enabled("allpass"))
+        {
+            fv3::allpass_f allpass;
+            allpass.setsize(length);
+            allpass.setfeedback(0.6f);
+            bench.run("allpass", "process", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = allpass._process(in[i]);
+                });
+        }
+
+        if (bench.enabled("allpassm"))
+        {
+            fv3::allpassm_f allpass;
+            fv3::lfo_f lfo;
+            allpass.setsize(length - 2 * modLength, modLength);
+            allpass.setfeedback(0.6f);
+            allpass.setdecay(1.0f);
+            lfo.setFreq(0.5, MICRO_SAMPLE_RATE);
+            bench.run("allpassm", "process", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = allpass._process(in[i], lfo.process());
+                });
+            bench.run("allpassm", "process_li", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = allpass._process_li(in[i], lfo.process());
+                });
+        }
+
+        if (bench.enabled("comb"))
+        {
+            fv3::comb_f comb;
+            comb.setsize(length);
+            comb.setfeedback(0.8f);
+            comb.setdamp(0.2f);
+            bench.run("comb", "process", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = comb._process(in[i]);
+                });
+        }
+
+        if (bench.enabled("combm"))
+        {
+            fv3::combm_f comb;
+            fv3::lfo_f lfo;
+            comb.setsize(length - 2 * modLength, modLength);
+            comb.setfeedback(0.8f);
+            comb.setdamp(0.2f);
+            lfo.setFreq(0.5, MICRO_SAMPLE_RATE);
+            bench.run("combm", "process", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = comb.process(in[i], lfo.process());
+                });
+        }
+
+        if (bench.enabled("delayline"))
+        {
+            // Taps spread across the whole line like the outputs of a tank
+            fv3::delayline_f line;
+            line.setsize(length);
+            long taps[MICRO_DELAYLINE_TAPS];
+            for (long t = 0; t < MICRO_DELAYLINE_TAPS; t++)
+                taps[t] = (length - 1) * (t + 1) / MICRO_DELAYLINE_TAPS;
+            bench.run("delayline", "at", length, sizes[s], MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                    {
+                        float sum = 0;
+                        for (long t = 0; t < MICRO_DELAYLINE_TAPS; t++)
+                            sum += line.at(taps[t]);
+                        line.process(in[i]);
+                        out[i] = sum;
+                    }
+                });
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Stateless or tiny state primitives, the sweep sets the length of the
+// input and output buffers they stream through
+
+static void benchFilters(MicroBench& bench)
+{
+    std::vector<size_t> sizes = bench.sizes();
+
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        // in and out share the working set
+        long length = std::max(1L, static_cast<long>(sizes[s] / (2 * sizeof(float))));
+
+        if (bench.enabled("biquad"))
+        {
+            fv3::biquad_f biquad;
+            biquad.setLPF_RBJ(4000, FV3_BIQUAD_RBJ_Q_BUTTERWORTH, MICRO_SAMPLE_RATE, FV3_BIQUAD_RBJ_Q);
+            bench.run("biquad", "df1", length, sizes[s], length, 0, length,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = biquad.processd1(in[i]);
+                });
+            bench.run("biquad", "df2", length, sizes[s], length, 0, length,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = biquad.processd2(in[i]);
+                });
+        }
+
+        if (bench.enabled("iir_1st"))
+        {
+            fv3::iir_1st_f iir;
+            iir.setLPF_BW(4000, MICRO_SAMPLE_RATE);
+            bench.run("iir_1st", "process", length, sizes[s], length, 0, length,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = iir.process(in[i]);
+                });
+        }
+
+        if (bench.enabled("dccut"))
+        {
+            fv3::dccut_f dccut;
+            dccut.setCutOnFreq(20, MICRO_SAMPLE_RATE);
+            bench.run("dccut", "process", length, sizes[s], length, 0, length,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = dccut.process(in[i]);
+                });
+        }
+
+        if (bench.enabled("lfo"))
+        {
+            fv3::lfo_f lfo;
+            lfo.setFreq(0.5, MICRO_SAMPLE_RATE);
+            bench.run("lfo", "process", length, sizes[s], length, 0, length,
+                [&](const float* in, float* out, long frames)
+                {
+                    for (long i = 0; i < frames; i++)
+                        out[i] = lfo.process(in[i]);
+                });
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Pink noise, the sweep sets the fractal generator length (2^n samples),
+// which is regenerated in one go whenever it runs out
+
+static void benchNoise(MicroBench& bench)
+{
+    if (!bench.enabled("noisegen_pink_frac"))
+        return;
+
+    std::vector<size_t> sizes = bench.sizes();
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        long order = 0;
+        while ((static_cast<size_t>(2) << order) * sizeof(float) <= sizes[s])
+            order++;
+        long length = 1L << order;
+
+        fv3::noisegen_pink_frac_f noise;
+        noise.setParams(FV3_NOISEGEN_PINK_FRACTAL_1_DEFAULT_HURST_CONST, order);
+        bench.run("noisegen_pink_frac", "process", length, length * sizeof(float),
+                  MICRO_STREAM_FRAMES, length, MICRO_STREAM_FRAMES,
+            [&](const float*, float* out, long frames)
+            {
+                for (long i = 0; i < frames; i++)
+                    out[i] = noise.process();
+            });
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Spectrum multiply-accumulate of one partition. Each call holds the
+// impulse, input and output spectra (2*n samples each) and advances the
+// convolution by n samples.
+
+static void benchFrag(MicroBench& bench)
+{
+    if (!bench.enabled("frag"))
+        return;
+
+    std::vector<size_t> sizes = bench.sizes();
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        long fragmentSize = 1;
+        while (static_cast<size_t>(fragmentSize * 2) * 6 * sizeof(float) <= sizes[s])
+            fragmentSize *= 2;
+        if (fragmentSize < 16)
+            continue;
+
+        std::vector<float> impulse = makeNoise(fragmentSize, 0x7f4a7c15u);
+        fv3::frag_f frag;
+        frag.loadImpulse(&impulse[0], fragmentSize, fragmentSize, FFTW_ESTIMATE);
+
+        long spectrum = fragmentSize * 2;
+        bench.run("frag", "MULT", fragmentSize, spectrum * 3 * sizeof(float), spectrum, spectrum, fragmentSize,
+            [&](const float* in, float* out, long)
+            {
+                frag.MULT(in, out);
+            });
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --only LIST       primitives to run: delay,delaym,allpass,allpassm,comb,combm,\n"
+        "                    biquad,iir_1st,dccut,lfo,noisegen_pink_frac,delayline,frag\n"
+        "  --min-bytes N     smallest working set (default %zu)\n"
+        "  --max-bytes N     largest working set (default %zu)\n"
+        "  --repeats N       timed repetitions per case (default %d)\n"
+        "  --output FILE     write JSON to FILE instead of stdout\n"
+        "  --counters        add hardware counters per sample (perf_event_open)\n",
+        name, MICRO_DEFAULT_MIN_BYTES, MICRO_DEFAULT_MAX_BYTES, MICRO_DEFAULT_REPEATS);
+}
+
+static bool parseOptions(int argc, char* argv[], MicroOptions& options)
+{
+    options.minBytes = MICRO_DEFAULT_MIN_BYTES;
+    options.maxBytes = MICRO_DEFAULT_MAX_BYTES;
+    options.repeats = MICRO_DEFAULT_REPEATS;
+    options.output = nullptr;
+    options.counters = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--only") == 0 && hasValue)
+        {
+            std::string list(argv[++i]);
+            size_t start = 0;
+            while (start <= list.size())
+            {
+                size_t comma = list.find(',', start);
+                if (comma == std::string::npos)
+                    comma = list.size();
+                if (comma > start)
+                    options.only.push_back(list.substr(start, comma - start));
+                start = comma + 1;
+            }
+        }
+        else if (std::strcmp(arg, "--min-bytes") == 0 && hasValue)
+            options.minBytes = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(arg, "--max-bytes") == 0 && hasValue)
+            options.maxBytes = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(arg, "--repeats") == 0 && hasValue)
+            options.repeats = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--output") == 0 && hasValue)
+            options.output = argv[++i];
+        else if (std::strcmp(arg, "--counters") == 0)
+            options.counters = true;
+        else
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    // A delay needs room for its modulation span
+    if (options.minBytes < 64 || options.maxBytes < options.minBytes || options.repeats < 1)
+        return false;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    MicroOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    MicroBench bench(options);
+    benchDelays(bench);
+    benchFilters(bench);
+    benchNoise(bench);
+    benchFrag(bench);
+
+    return bench.write() ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/*
+ * Studio Reverb Offline Benchmark
+ * Hardware performance counters through perf_event_open (Linux)
+ */
+
+#include "perfcounters.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* const eventNames[PERF_EVENT_COUNT] = {
+    "cycles", "instructions", "branches", "branch_misses", "l1d_misses", "llc_misses"
+};
+
+PerfCounters::PerfCounters()
+    : lastErrno(0)
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        fds[i] = -1;
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+#if defined(__linux__)
+
+static int openEvent(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // This thread only, on any CPU
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+bool PerfCounters::open()
+{
+    close();
+    lastErrno = 0;
+
+    const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    fds[PERF_CYCLES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[PERF_INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[PERF_BRANCHES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+    fds[PERF_BRANCH_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[PERF_L1D_MISSES] = openEvent(PERF_TYPE_HW_CACHE, l1dReadMiss);
+    fds[PERF_LLC_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (fds[i] < 0 && lastErrno == 0)
+            lastErrno = errno;
+    }
+
+    if (!isOpen())
+        return false;
+    lastErrno = 0;
+    return true;
+}
+
+void PerfCounters::close()
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (fds[i] >= 0)
+            ::close(fds[i]);
+        fds[i] = -1;
+    }
+}
+
+void PerfCounters::reset()
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (fds[i] >= 0)
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+    }
+}
+
+void PerfCounters::start()
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (fds[i] >= 0)
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::stop()
+{
+    // Reverse order, so the cycle counter brackets the others
+    for (int i = PERF_EVENT_COUNT - 1; i >= 0; i--)
+    {
+        if (fds[i] >= 0)
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+void PerfCounters::read(double values[PERF_EVENT_COUNT]) const
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        values[i] = -1.0;
+        if (fds[i] < 0)
+            continue;
+
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (::read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)))
+            continue;
+
+        if (data[2] == 0)
+            values[i] = 0.0;
+        else
+            values[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    }
+}
+
+#else
+
+bool PerfCounters::open()
+{
+    lastErrno = ENOSYS;
+    return false;
+}
+
+void PerfCounters::close()
+{
+}
+
+void PerfCounters::reset()
+{
+}
+
+void PerfCounters::start()
+{
+}
+
+void PerfCounters::stop()
+{
+}
+
+void PerfCounters::read(double values[PERF_EVENT_COUNT]) const
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        values[i] = -1.0;
+}
+
+#endif
+
+bool PerfCounters::isOpen() const
+{
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (fds[i] >= 0)
+            return true;
+    }
+    return false;
+}
+
+bool PerfCounters::has(PerfEvent event) const
+{
+    return fds[event] >= 0;
+}
+
+const char* PerfCounters::error() const
+{
+    return lastErrno != 0 ? std::strerror(lastErrno) : "";
+}
+
+const char* PerfCounters::name(PerfEvent event)
+{
+    return eventNames[event];
+}
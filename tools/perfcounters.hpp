@@ -0,0 +1,56 @@
+/*
+ * Studio Reverb Offline Benchmark
+ * Hardware performance counters through perf_event_open (Linux)
+ */
+
+#ifndef STUDIO_REVERB_PERFCOUNTERS_HPP_INCLUDED
+#define STUDIO_REVERB_PERFCOUNTERS_HPP_INCLUDED
+
+#include <cstdint>
+
+enum PerfEvent
+{
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_EVENT_COUNT
+};
+
+// A set of user space counters for the calling thread. Events the CPU or
+// the kernel does not offer are skipped, the others are read on their own
+// and scaled when the kernel had to multiplex them. The counts accumulate
+// over every start()/stop() pair until reset().
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    // Returns false when no event could be opened, see error()
+    bool open();
+    void close();
+    bool isOpen() const;
+    bool has(PerfEvent event) const;
+    const char* error() const;
+
+    void reset();
+    void start();
+    void stop();
+
+    // Scaled counts, negative for events that are not available
+    void read(double values[PERF_EVENT_COUNT]) const;
+
+    static const char* name(PerfEvent event);
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    int fds[PERF_EVENT_COUNT];
+    int lastErrno;
+};
+
+#endif // STUDIO_REVERB_PERFCOUNTERS_HPP_INCLUDED
@@ -0,0 +1,711 @@
+/*
+ * Studio Reverb Batch Render
+ * Offline rendering of audio files, one engine per worker thread
+ */
+
+#include "DSP.hpp"
+#include "Programs.hpp"
+#include "freeverb/irsource.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* const typeNames[REVERB_TYPE_COUNT] = {
+    "room", "hall", "plate", "early", "hybrid"
+};
+
+// Symbols of the plugin parameters, as the LV2 port symbols
+static const char* const paramSymbols[paramCount] = {
+    "type", "dry", "early", "late", "size", "width", "predelay",
+    "decay", "diffuse", "damping", "modulation", "lowcut", "highcut"
+};
+
+// Frames handed to run() at once, the DSP splits them into BUFFER_SIZE
+static const uint32_t RENDER_DEFAULT_BLOCK = 8192;
+static const uint32_t RENDER_MAX_BLOCK = 65536;
+
+// Tail rendering with --tail-db: stops after this much output below the
+// threshold, longer than the largest pre-delay, or at --max-tail
+static const double RENDER_SILENT_HOLD_SECONDS = 0.5;
+static const double RENDER_DEFAULT_MAX_TAIL_SECONDS = 30.0;
+static const double RENDER_LOAD_TIMEOUT_SECONDS = 10.0;
+
+// The data chunk size is a 32 bit field
+static const uint64_t RENDER_MAX_DATA_BYTES = 0xffffffffull - 36;
+
+struct RenderOptions
+{
+    std::vector<std::string> files;
+    std::string outputDir;
+    int program;                        // -1: defaults
+    std::vector<ProgramValue> values;   // parameter file and --set, in order
+    const char* irFile;
+    ReverbQuality quality;
+    int jobs;
+    uint32_t block;
+    double tailSeconds;
+    bool untilSilent;
+    double silenceDb;
+    double maxTailSeconds;
+    long rawChannels;                   // 0: WAV input
+    double rawRate;
+};
+
+struct RenderResult
+{
+    bool ok;
+    std::string error;
+    double sampleRate;
+    uint64_t inputFrames;
+    uint64_t outputFrames;
+    double seconds;
+};
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options] --output DIR FILE...\n"
+        "Renders each input file through the reverb to a 32 bit float stereo WAV\n"
+        "of the same name in DIR. Files are rendered in parallel, one engine per\n"
+        "worker.\n"
+        "  --output DIR       output directory, must exist\n"
+        "  --program N        factory program 0-%u (default: parameter defaults)\n"
+        "  --params FILE      parameter file, one 'symbol = value' per line\n"
+        "  --set SYMBOL=VALUE one parameter, applied in order with --params\n"
+        "  --ir FILE          impulse response for the hybrid type\n"
+        "  --quality NAME     eco, standard or high (default high)\n"
+        "  --jobs N           worker threads (default: one per core)\n"
+        "  --block N          frames per run() call, 1-%u (default %u)\n"
+        "  --tail S           seconds of tail appended to each file (default 0)\n"
+        "  --tail-db DB       append the tail until it stays below DB dBFS\n"
+        "  --max-tail S       longest tail with --tail-db (default %.0f)\n"
+        "  --raw CH:RATE      inputs are headerless native float32, CH channels\n"
+        "Parameter symbols: type (room,hall,plate,early,hybrid or 0-%d), dry,\n"
+        "early, late, size, width, predelay, decay, diffuse, damping, modulation,\n"
+        "lowcut, highcut.\n",
+        name, PROGRAM_COUNT - 1, RENDER_MAX_BLOCK, RENDER_DEFAULT_BLOCK,
+        RENDER_DEFAULT_MAX_TAIL_SECONDS, REVERB_TYPE_COUNT - 1);
+}
+
+static std::string trim(const std::string& text)
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+        return std::string();
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+// symbol=value, the type also by name
+static bool parseValue(const std::string& text, ProgramValue& parsed)
+{
+    size_t equals = text.find('=');
+    if (equals == std::string::npos)
+        return false;
+    std::string symbol = trim(text.substr(0, equals));
+    std::string value = trim(text.substr(equals + 1));
+    if (value.empty())
+        return false;
+
+    for (uint32_t i = 0; i < paramCount; i++)
+    {
+        if (symbol != paramSymbols[i])
+            continue;
+        parsed.index = i;
+        if (i == paramReverbType)
+        {
+            for (int t = 0; t < REVERB_TYPE_COUNT; t++)
+            {
+                if (value == typeNames[t])
+                {
+                    parsed.value = static_cast<float>(t);
+                    return true;
+                }
+            }
+        }
+        char* end = nullptr;
+        parsed.value = std::strtof(value.c_str(), &end);
+        return end != value.c_str() && *end == '\0';
+    }
+
+    return false;
+}
+
+static bool parseParamFile(const char* path, std::vector<ProgramValue>& values)
+{
+    FILE* file = std::fopen(path, "r");
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int number = 0;
+    bool ok = true;
+    while (ok && std::fgets(line, sizeof(line), file) != nullptr)
+    {
+        number++;
+        std::string text(line);
+        size_t comment = text.find('#');
+        if (comment != std::string::npos)
+            text.erase(comment);
+        if (trim(text).empty())
+            continue;
+
+        ProgramValue value;
+        ok = parseValue(text, value);
+        if (ok)
+            values.push_back(value);
+        else
+            std::fprintf(stderr, "%s:%d: invalid parameter line\n", path, number);
+    }
+
+    std::fclose(file);
+    return ok;
+}
+
+static bool parseOptions(int argc, char* argv[], RenderOptions& options)
+{
+    options.files.clear();
+    options.outputDir.clear();
+    options.program = -1;
+    options.values.clear();
+    options.irFile = nullptr;
+    options.quality = QUALITY_HIGH;
+    options.jobs = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    options.block = RENDER_DEFAULT_BLOCK;
+    options.tailSeconds = 0.0;
+    options.untilSilent = false;
+    options.silenceDb = -90.0;
+    options.maxTailSeconds = RENDER_DEFAULT_MAX_TAIL_SECONDS;
+    options.rawChannels = 0;
+    options.rawRate = 0.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--output") == 0 && value != nullptr)
+            options.outputDir = argv[++i];
+        else if (std::strcmp(arg, "--program") == 0 && value != nullptr)
+        {
+            long program = std::atol(argv[++i]);
+            ok = program >= 0 && program < static_cast<long>(PROGRAM_COUNT);
+            options.program = static_cast<int>(program);
+        }
+        else if (std::strcmp(arg, "--params") == 0 && value != nullptr)
+            ok = parseParamFile(argv[++i], options.values);
+        else if (std::strcmp(arg, "--set") == 0 && value != nullptr)
+        {
+            ProgramValue parsed;
+            ok = parseValue(argv[++i], parsed);
+            if (ok)
+                options.values.push_back(parsed);
+        }
+        else if (std::strcmp(arg, "--ir") == 0 && value != nullptr)
+            options.irFile = argv[++i];
+        else if (std::strcmp(arg, "--quality") == 0 && value != nullptr)
+            ok = StudioReverbDSP::parseQuality(argv[++i], options.quality);
+        else if (std::strcmp(arg, "--jobs") == 0 && value != nullptr)
+            ok = (options.jobs = std::atoi(argv[++i])) >= 1;
+        else if (std::strcmp(arg, "--block") == 0 && value != nullptr)
+        {
+            long block = std::atol(argv[++i]);
+            ok = block >= 1 && block <= static_cast<long>(RENDER_MAX_BLOCK);
+            options.block = static_cast<uint32_t>(block);
+        }
+        else if (std::strcmp(arg, "--tail") == 0 && value != nullptr)
+        {
+            ok = (options.tailSeconds = std::atof(argv[++i])) >= 0.0;
+            options.untilSilent = false;
+        }
+        else if (std::strcmp(arg, "--tail-db") == 0 && value != nullptr)
+        {
+            ok = (options.silenceDb = std::atof(argv[++i])) < 0.0;
+            options.untilSilent = true;
+        }
+        else if (std::strcmp(arg, "--max-tail") == 0 && value != nullptr)
+            ok = (options.maxTailSeconds = std::atof(argv[++i])) >= 0.0;
+        else if (std::strcmp(arg, "--raw") == 0 && value != nullptr)
+        {
+            ok = std::sscanf(argv[++i], "%ld:%lf", &options.rawChannels, &options.rawRate) == 2 &&
+                 options.rawChannels >= 1 && options.rawChannels <= 2 && options.rawRate >= 8000.0;
+        }
+        else if (arg[0] != '-')
+            options.files.push_back(arg);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options.outputDir.empty() || options.files.empty())
+        return false;
+
+    return true;
+}
+
+// Output path: the input's base name with a .wav extension
+static std::string outputPath(const RenderOptions& options, const std::string& input)
+{
+    size_t slash = input.find_last_of('/');
+    std::string name = slash == std::string::npos ? input : input.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0)
+        name.erase(dot);
+    return options.outputDir + "/" + name + ".wav";
+}
+
+// --------------------------------------------------------------
+// 32 bit float stereo WAV, written as it is rendered
+
+class WavWriter
+{
+public:
+    WavWriter()
+        : file(nullptr),
+          dataBytes(0),
+          ok(false)
+    {
+    }
+
+    ~WavWriter()
+    {
+        if (file != nullptr)
+            std::fclose(file);
+    }
+
+    // The sizes are filled in by close()
+    bool open(const std::string& path, double sampleRate)
+    {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        uint32_t rate = static_cast<uint32_t>(sampleRate + 0.5);
+        unsigned char header[44];
+        std::memcpy(header, "RIFF", 4);
+        putLE(header + 4, 0, 4);
+        std::memcpy(header + 8, "WAVEfmt ", 8);
+        putLE(header + 16, 16, 4);
+        putLE(header + 20, 3, 2);       // IEEE float
+        putLE(header + 22, 2, 2);
+        putLE(header + 24, rate, 4);
+        putLE(header + 28, rate * 8, 4);
+        putLE(header + 32, 8, 2);
+        putLE(header + 34, 32, 2);
+        std::memcpy(header + 36, "data", 4);
+        putLE(header + 40, 0, 4);
+
+        ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+        return ok;
+    }
+
+    // Interleaves the two channels
+    bool write(const float* left, const float* right, uint32_t frames)
+    {
+        if (!ok)
+            return false;
+        if (dataBytes + 8ull * frames > RENDER_MAX_DATA_BYTES)
+            return ok = false;
+
+        bytes.resize(8 * static_cast<size_t>(frames));
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &left[i], sizeof(bits));
+            putLE(&bytes[8 * i], bits, 4);
+            std::memcpy(&bits, &right[i], sizeof(bits));
+            putLE(&bytes[8 * i + 4], bits, 4);
+        }
+        dataBytes += bytes.size();
+        ok = std::fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+        return ok;
+    }
+
+    bool close()
+    {
+        if (file == nullptr)
+            return false;
+
+        unsigned char size[4];
+        if (ok)
+        {
+            putLE(size, static_cast<uint32_t>(36 + dataBytes), 4);
+            ok = std::fseek(file, 4, SEEK_SET) == 0 && std::fwrite(size, 1, 4, file) == 4;
+        }
+        if (ok)
+        {
+            putLE(size, static_cast<uint32_t>(dataBytes), 4);
+            ok = std::fseek(file, 40, SEEK_SET) == 0 && std::fwrite(size, 1, 4, file) == 4;
+        }
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    static void putLE(unsigned char* bytes, uint32_t value, int size)
+    {
+        for (int i = 0; i < size; i++)
+            bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    FILE* file;
+    uint64_t dataBytes;
+    bool ok;
+    std::vector<unsigned char> bytes;
+};
+
+// --------------------------------------------------------------
+// Rendering
+
+// One DSP per sample rate, owned by a worker and reused across its files
+class Engine
+{
+public:
+    Engine(const RenderOptions& options, double sampleRate)
+        : dsp(new StudioReverbDSP(sampleRate)),
+          sampleRate(sampleRate),
+          block(options.block),
+          input(2 * options.block, 0.0f),
+          output(2 * options.block, 0.0f)
+    {
+        // The same modulation noise in every worker
+        dsp->setNoiseSeed(0);
+        applyProgram(0);
+        if (options.program >= 0)
+            applyProgram(static_cast<uint32_t>(options.program));
+        for (size_t i = 0; i < options.values.size(); i++)
+            dsp->setParameterValue(options.values[i].index, options.values[i].value);
+        dsp->setQuality(options.quality);
+    }
+
+    double getSampleRate() const
+    {
+        return sampleRate;
+    }
+
+    // Once, before the first file
+    bool loadImpulse(const char* path)
+    {
+        if (!dsp->loadImpulseFile(path))
+            return false;
+
+        // The new head is crossfaded in while audio runs
+        std::fill(input.begin(), input.end(), 0.0f);
+        for (double waited = 0.0; dsp->isImpulseLoading() && waited < RENDER_LOAD_TIMEOUT_SECONDS;
+             waited += block / sampleRate)
+            run(block);
+        return true;
+    }
+
+    bool isHybrid() const
+    {
+        return static_cast<int>(dsp->getParameterValue(paramReverbType) + 0.5f) == REVERB_HYBRID;
+    }
+
+    bool render(const RenderOptions& options, fv3::irsource_f& source, WavWriter& writer,
+                RenderResult& result)
+    {
+        // Every file starts from silence, with the same noise
+        dsp->mute();
+
+        float* inL = &input[0];
+        float* inR = &input[block];
+        long channels = source.getChannels();
+        long frames = source.getSize();
+
+        for (long offset = 0; offset < frames; offset += block)
+        {
+            uint32_t count = static_cast<uint32_t>(std::min<long>(block, frames - offset));
+            source.read(0, offset, inL, count);
+            if (channels > 1)
+                source.read(1, offset, inR, count);
+            else
+                std::memcpy(inR, inL, count * sizeof(float));
+
+            run(count);
+            if (!writer.write(&output[0], &output[block], count))
+                return false;
+            result.outputFrames += count;
+        }
+        result.inputFrames = static_cast<uint64_t>(frames);
+
+        std::fill(input.begin(), input.end(), 0.0f);
+        if (options.untilSilent)
+            return renderUntilSilent(options, writer, result);
+
+        uint64_t tail = static_cast<uint64_t>(options.tailSeconds * sampleRate + 0.5);
+        for (uint64_t done = 0; done < tail; )
+        {
+            uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(block, tail - done));
+            run(count);
+            if (!writer.write(&output[0], &output[block], count))
+                return false;
+            done += count;
+            result.outputFrames += count;
+        }
+        return true;
+    }
+
+private:
+    void applyProgram(uint32_t index)
+    {
+        const Program& program = getProgram(index);
+        for (uint32_t i = 0; i < program.count; i++)
+            dsp->setParameterValue(program.values[i].index, program.values[i].value);
+    }
+
+    void run(uint32_t frames)
+    {
+        const float* inputs[2] = { &input[0], &input[block] };
+        float* outputs[2] = { &output[0], &output[block] };
+        dsp->run(inputs, outputs, frames);
+    }
+
+    // Renders silence until the output has stayed below the threshold for
+    // RENDER_SILENT_HOLD_SECONDS and ends the file at its last sample above
+    bool renderUntilSilent(const RenderOptions& options, WavWriter& writer, RenderResult& result)
+    {
+        float threshold = static_cast<float>(std::pow(10.0, options.silenceDb / 20.0));
+        uint64_t hold = static_cast<uint64_t>(RENDER_SILENT_HOLD_SECONDS * sampleRate);
+        uint64_t limit = static_cast<uint64_t>(options.maxTailSeconds * sampleRate + 0.5);
+
+        // Output after the last sample above the threshold, not written yet
+        std::vector<float> pendingL, pendingR;
+        uint64_t silent = 0;
+
+        for (uint64_t done = 0; done < limit && silent < hold; )
+        {
+            uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(block, limit - done));
+            run(count);
+            done += count;
+
+            const float* outL = &output[0];
+            const float* outR = &output[block];
+            uint32_t loud = 0;
+            for (uint32_t i = count; i > 0; i--)
+            {
+                if (std::fabs(outL[i - 1]) >= threshold || std::fabs(outR[i - 1]) >= threshold)
+                {
+                    loud = i;
+                    break;
+                }
+            }
+
+            if (loud == 0)
+            {
+                pendingL.insert(pendingL.end(), outL, outL + count);
+                pendingR.insert(pendingR.end(), outR, outR + count);
+                silent += count;
+                continue;
+            }
+
+            if (!pendingL.empty())
+            {
+                if (!writer.write(&pendingL[0], &pendingR[0], static_cast<uint32_t>(pendingL.size())))
+                    return false;
+                result.outputFrames += pendingL.size();
+            }
+            if (!writer.write(outL, outR, loud))
+                return false;
+            result.outputFrames += loud;
+
+            pendingL.assign(outL + loud, outL + count);
+            pendingR.assign(outR + loud, outR + count);
+            silent = count - loud;
+        }
+
+        return true;
+    }
+
+    std::unique_ptr<StudioReverbDSP> dsp;
+    double sampleRate;
+    uint32_t block;
+    std::vector<float> input;
+    std::vector<float> output;
+};
+
+class BatchRender
+{
+public:
+    BatchRender(const RenderOptions& options)
+        : options(options),
+          results(options.files.size()),
+          next(0)
+    {
+    }
+
+    void run()
+    {
+        int jobs = std::min<int>(options.jobs, static_cast<int>(options.files.size()));
+        std::vector<std::thread> threads;
+        for (int w = 0; w < jobs; w++)
+            threads.push_back(std::thread(&BatchRender::workerLoop, this));
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+    }
+
+    const std::vector<RenderResult>& getResults() const
+    {
+        return results;
+    }
+
+private:
+    void workerLoop()
+    {
+        std::vector<std::unique_ptr<Engine> > engines;
+
+        for (;;)
+        {
+            size_t index = next.fetch_add(1);
+            if (index >= options.files.size())
+                break;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            RenderResult& result = results[index];
+            result.ok = false;
+            result.sampleRate = 0.0;
+            result.inputFrames = 0;
+            result.outputFrames = 0;
+            renderFile(engines, options.files[index], result);
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(printMutex);
+            printResult(options.files[index], result);
+        }
+    }
+
+    void renderFile(std::vector<std::unique_ptr<Engine> >& engines, const std::string& path,
+                    RenderResult& result)
+    {
+        fv3::irsource_f source;
+        bool opened = options.rawChannels > 0
+            ? source.openRaw(path.c_str(), options.rawChannels, static_cast<float>(options.rawRate))
+            : source.open(path.c_str());
+        if (!opened)
+        {
+            result.error = "could not read";
+            return;
+        }
+        if (source.getChannels() > 2)
+        {
+            result.error = "more than two channels";
+            return;
+        }
+        result.sampleRate = source.getSampleRate();
+
+        Engine* engine = nullptr;
+        for (size_t e = 0; e < engines.size() && engine == nullptr; e++)
+        {
+            if (engines[e]->getSampleRate() == result.sampleRate)
+                engine = engines[e].get();
+        }
+        if (engine == nullptr)
+        {
+            engines.push_back(std::unique_ptr<Engine>(new Engine(options, result.sampleRate)));
+            engine = engines.back().get();
+            if (options.irFile != nullptr && engine->isHybrid() && !engine->loadImpulse(options.irFile))
+            {
+                engines.pop_back();
+                result.error = std::string("could not load ") + options.irFile;
+                return;
+            }
+        }
+
+        WavWriter writer;
+        std::string output = outputPath(options, path);
+        if (!writer.open(output, result.sampleRate) || !engine->render(options, source, writer, result) ||
+            !writer.close())
+        {
+            result.error = "could not write " + output;
+            return;
+        }
+        result.ok = true;
+    }
+
+    static void printResult(const std::string& path, const RenderResult& result)
+    {
+        if (!result.ok)
+        {
+            std::printf("%-40s failed: %s\n", path.c_str(), result.error.c_str());
+        }
+        else
+        {
+            double audio = result.outputFrames / result.sampleRate;
+            std::printf("%-40s %7.0f %10.2f %10.2f %10.1f\n", path.c_str(), result.sampleRate,
+                        result.inputFrames / result.sampleRate, audio,
+                        result.seconds > 0.0 ? audio / result.seconds : 0.0);
+        }
+        std::fflush(stdout);
+    }
+
+    const RenderOptions& options;
+    std::vector<RenderResult> results;
+    std::atomic<size_t> next;
+    std::mutex printMutex;
+};
+
+int main(int argc, char* argv[])
+{
+    RenderOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Two inputs with the same base name would write the same file
+    std::set<std::string> outputs;
+    for (size_t i = 0; i < options.files.size(); i++)
+    {
+        if (!outputs.insert(outputPath(options, options.files[i])).second)
+        {
+            std::fprintf(stderr, "More than one input renders to %s\n",
+                         outputPath(options, options.files[i]).c_str());
+            return 2;
+        }
+    }
+
+    std::printf("%-40s %7s %10s %10s %10s\n", "file", "rate", "input_s", "output_s", "realtime");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    BatchRender batch(options);
+    batch.run();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::vector<RenderResult>& results = batch.getResults();
+    size_t rendered = 0;
+    double audio = 0.0;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (!results[i].ok)
+            continue;
+        rendered++;
+        audio += results[i].outputFrames / results[i].sampleRate;
+    }
+
+    std::printf("\n%zu of %zu files, %.1f s of audio in %.2f s on %d threads: %.1fx realtime, %.0f files/hour\n",
+                rendered, results.size(), audio, wall, std::min<int>(options.jobs, static_cast<int>(results.size())),
+                wall > 0.0 ? audio / wall : 0.0, wall > 0.0 ? rendered * 3600.0 / wall : 0.0);
+    return rendered == results.size() ? 0 : 1;
+}
@@ -0,0 +1,730 @@
+/*
+ * Studio Reverb Decay Measurement
+ * RT60, EDT and energy decay curves from a sweep or MLS response
+ */
+
+#include "DSP.hpp"
+#include "Programs.hpp"
+#include "spectrum.hpp"
+#include "freeverb/mls.hpp"
+#include "freeverb/sweep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+static const char* const typeNames[REVERB_TYPE_COUNT] = {
+    "room", "hall", "plate", "early", "hybrid"
+};
+
+// Octave bands, the broadband response is band 0
+static const int RT60_BAND_COUNT = 8;
+static const double octaveCenters[RT60_BAND_COUNT] = {
+    0.0, 125.0, 250.0, 500.0, 1000.0, 2000.0, 4000.0, 8000.0
+};
+static const char* const bandNames[RT60_BAND_COUNT] = {
+    "all", "125", "250", "500", "1k", "2k", "4k", "8k"
+};
+
+// The Decay check averages T30 over these bands, where damping matters least
+static const int RT60_CHECK_FIRST_BAND = 3;
+static const int RT60_CHECK_LAST_BAND = 4;
+static const double RT60_DEFAULT_TOLERANCE = 0.2;
+
+// Excitation peak level, and the sweep fades in and out
+static const double RT60_LEVEL = 0.25;
+static const double RT60_SWEEP_START_HZ = 20.0;
+static const double RT60_SWEEP_FADE_MS = 100.0;
+static const double RT60_DEFAULT_SWEEP_SECONDS = 4.0;
+
+// Response length: the expected RT60 twice over, at least RT60_MIN_SECONDS
+static const double RT60_MIN_SECONDS = 2.0;
+static const double RT60_MARGIN_SECONDS = 0.5;
+static const double RT60_LOAD_TIMEOUT_SECONDS = 10.0;
+
+// The response starts where it first comes within this of its peak (dB)
+static const double RT60_ONSET_DB = 20.0;
+// Energy within this of the noise floor is cut before integrating (dB)
+static const double RT60_NOISE_MARGIN_DB = 10.0;
+static const double RT60_SMOOTH_SECONDS = 0.01;
+
+enum Excitation
+{
+    EXCITATION_SWEEP = 0,
+    EXCITATION_MLS
+};
+
+struct Rt60Options
+{
+    std::vector<int> types;
+    std::vector<int> programs;      // empty: every type on program 0
+    std::vector<double> decays;     // empty: the program's Decay
+    double sampleRate;
+    Excitation excitation;
+    double sweepSeconds;
+    const char* irFile;
+    const char* edcFile;
+    double tolerance;
+    bool csv;
+};
+
+struct Rt60Case
+{
+    std::string name;
+    int type;       // -1 keeps the program's type
+    int program;
+    double decay;   // negative keeps the program's Decay
+};
+
+struct BandResult
+{
+    double edt;
+    double t20;
+    double t30;
+    std::vector<double> edc;    // dB, from the onset
+};
+
+static const double NOT_MEASURED = std::numeric_limits<double>::quiet_NaN();
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "Measures the impulse response of the DSP with a log sweep or an MLS and\n"
+        "reports EDT, T20 and T30 per octave. T30 at 500 Hz and 1 kHz is checked\n"
+        "against the Decay parameter, the exit code is 1 if a case is off.\n"
+        "  --types LIST       reverb types (default room,hall,plate,early,hybrid)\n"
+        "  --programs LIST    factory programs instead of the types, 0-%u\n"
+        "  --decays LIST      Decay values in seconds (default 1,2,4)\n"
+        "  --rate R           sample rate (default 48000)\n"
+        "  --mls              MLS excitation instead of the sweep\n"
+        "  --sweep-seconds S  sweep length (default %.1f)\n"
+        "  --ir FILE          impulse response for the hybrid type\n"
+        "  --tolerance T      allowed relative T30 error (default %.2f)\n"
+        "  --edc FILE         write the energy decay curves as CSV\n"
+        "  --csv              comma separated output, one line per band\n",
+        name, PROGRAM_COUNT - 1, RT60_DEFAULT_SWEEP_SECONDS, RT60_DEFAULT_TOLERANCE);
+}
+
+static bool parseNumbers(const char* text, std::vector<double>& list)
+{
+    list.clear();
+    const char* p = text;
+    while (*p != '\0')
+    {
+        char* end = nullptr;
+        double value = std::strtod(p, &end);
+        if (end == p || (*end != ',' && *end != '\0'))
+            return false;
+        list.push_back(value);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !list.empty();
+}
+
+static bool parseTypes(const char* text, std::vector<int>& types)
+{
+    types.clear();
+    std::string all(text);
+    size_t start = 0;
+    while (start <= all.size())
+    {
+        size_t comma = all.find(',', start);
+        if (comma == std::string::npos)
+            comma = all.size();
+        std::string token = all.substr(start, comma - start);
+        start = comma + 1;
+
+        int found = -1;
+        for (int i = 0; i < REVERB_TYPE_COUNT && found < 0; i++)
+        {
+            if (token == typeNames[i])
+                found = i;
+        }
+        if (found < 0)
+            return false;
+        types.push_back(found);
+    }
+    return !types.empty();
+}
+
+static bool parseOptions(int argc, char* argv[], Rt60Options& options)
+{
+    options.types.clear();
+    for (int i = 0; i < REVERB_TYPE_COUNT; i++)
+        options.types.push_back(i);
+    options.programs.clear();
+    const double decays[] = { 1.0, 2.0, 4.0 };
+    options.decays.assign(decays, decays + sizeof(decays) / sizeof(decays[0]));
+    options.sampleRate = 48000.0;
+    options.excitation = EXCITATION_SWEEP;
+    options.sweepSeconds = RT60_DEFAULT_SWEEP_SECONDS;
+    options.irFile = nullptr;
+    options.edcFile = nullptr;
+    options.tolerance = RT60_DEFAULT_TOLERANCE;
+    options.csv = false;
+    bool decaysGiven = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--types") == 0 && value != nullptr)
+            ok = parseTypes(argv[++i], options.types);
+        else if (std::strcmp(arg, "--programs") == 0 && value != nullptr)
+        {
+            std::vector<double> programs;
+            ok = parseNumbers(argv[++i], programs);
+            for (size_t p = 0; ok && p < programs.size(); p++)
+            {
+                ok = programs[p] >= 0 && programs[p] < PROGRAM_COUNT;
+                options.programs.push_back(static_cast<int>(programs[p]));
+            }
+        }
+        else if (std::strcmp(arg, "--decays") == 0 && value != nullptr)
+            ok = decaysGiven = parseNumbers(argv[++i], options.decays);
+        else if (std::strcmp(arg, "--rate") == 0 && value != nullptr)
+            ok = (options.sampleRate = std::atof(argv[++i])) >= 8000.0;
+        else if (std::strcmp(arg, "--mls") == 0)
+            options.excitation = EXCITATION_MLS;
+        else if (std::strcmp(arg, "--sweep-seconds") == 0 && value != nullptr)
+            ok = (options.sweepSeconds = std::atof(argv[++i])) >= 1.0;
+        else if (std::strcmp(arg, "--ir") == 0 && value != nullptr)
+            options.irFile = argv[++i];
+        else if (std::strcmp(arg, "--tolerance") == 0 && value != nullptr)
+            ok = (options.tolerance = std::atof(argv[++i])) > 0.0;
+        else if (std::strcmp(arg, "--edc") == 0 && value != nullptr)
+            options.edcFile = argv[++i];
+        else if (std::strcmp(arg, "--csv") == 0)
+            options.csv = true;
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    // Programs are measured with their own Decay unless asked otherwise
+    if (!options.programs.empty() && !decaysGiven)
+        options.decays.clear();
+
+    return true;
+}
+
+static void collectCases(const Rt60Options& options, std::vector<Rt60Case>& cases)
+{
+    char name[64];
+    std::vector<double> decays = options.decays;
+    if (decays.empty())
+        decays.push_back(-1.0);
+
+    for (size_t d = 0; d < decays.size(); d++)
+    {
+        if (options.programs.empty())
+        {
+            for (size_t t = 0; t < options.types.size(); t++)
+            {
+                std::snprintf(name, sizeof(name), "%s-%.2fs", typeNames[options.types[t]], decays[d]);
+                Rt60Case c = { name, options.types[t], 0, decays[d] };
+                cases.push_back(c);
+            }
+            continue;
+        }
+        for (size_t p = 0; p < options.programs.size(); p++)
+        {
+            if (decays[d] < 0.0)
+                std::snprintf(name, sizeof(name), "program-%02d", options.programs[p]);
+            else
+                std::snprintf(name, sizeof(name), "program-%02d-%.2fs", options.programs[p], decays[d]);
+            Rt60Case c = { name, -1, options.programs[p], decays[d] };
+            cases.push_back(c);
+        }
+    }
+}
+
+static void applyProgram(StudioReverbDSP& dsp, uint32_t index)
+{
+    const Program& program = getProgram(index);
+    for (uint32_t i = 0; i < program.count; i++)
+        dsp.setParameterValue(program.values[i].index, program.values[i].value);
+}
+
+// RT60 the DSP is set to, NaN for the types without a Decay (early
+// reflections, hybrid without an IR)
+static double expectedRT60(int type, double decay, bool hasImpulse)
+{
+    switch (type)
+    {
+    case REVERB_ROOM:
+    case REVERB_PLATE:
+        return decay;
+    case REVERB_HALL:
+        return decay * HALL_DECAY_SCALE;
+    case REVERB_HYBRID:
+        return hasImpulse ? decay : NOT_MEASURED;
+    default:
+        return NOT_MEASURED;
+    }
+}
+
+// --------------------------------------------------------------
+// Excitation and deconvolution
+
+// Feeds the same signal to both inputs and returns both outputs
+static void process(StudioReverbDSP& dsp, const std::vector<double>& input,
+                    std::vector<double>& outL, std::vector<double>& outR)
+{
+    std::vector<float> inBlock(BUFFER_SIZE), blockL(BUFFER_SIZE), blockR(BUFFER_SIZE);
+    outL.resize(input.size());
+    outR.resize(input.size());
+
+    for (size_t done = 0; done < input.size(); done += BUFFER_SIZE)
+    {
+        uint32_t frames = static_cast<uint32_t>(std::min<size_t>(BUFFER_SIZE, input.size() - done));
+        for (uint32_t i = 0; i < frames; i++)
+            inBlock[i] = static_cast<float>(input[done + i]);
+
+        const float* inputs[2] = { &inBlock[0], &inBlock[0] };
+        float* outputs[2] = { &blockL[0], &blockR[0] };
+        dsp.run(inputs, outputs, frames);
+
+        for (uint32_t i = 0; i < frames; i++)
+        {
+            outL[done + i] = blockL[i];
+            outR[done + i] = blockR[i];
+        }
+    }
+}
+
+static void configureSweep(fv3::sweep_f& sweep, double sampleRate, double sweepSeconds, double tailSeconds)
+{
+    sweep.setSampleRate(sampleRate);
+    sweep.setStartFs(RT60_SWEEP_START_HZ);
+    sweep.setEndFs(std::min(20000.0, 0.45 * sampleRate));
+    sweep.setInitialMuteLength(0);
+    sweep.setLeadInLength(RT60_SWEEP_FADE_MS);
+    sweep.setSweepLength(sweepSeconds * 1000.0);
+    sweep.setLeadOutLength(RT60_SWEEP_FADE_MS);
+    sweep.setEndMuteLength(tailSeconds * 1000.0);
+    sweep.setSweepMode(FV3_SWP_EXP);
+}
+
+// Log sweep deconvolved with its inverse filter. The sweep convolved with
+// the same filter gives the position and gain of a unit impulse.
+static void measureSweep(StudioReverbDSP& dsp, const Rt60Options& options, size_t length,
+                         std::vector<double>& irL, std::vector<double>& irR)
+{
+    double tailSeconds = length / options.sampleRate;
+    fv3::sweep_f forward, inverse;
+    configureSweep(forward, options.sampleRate, options.sweepSeconds, tailSeconds);
+    configureSweep(inverse, options.sampleRate, options.sweepSeconds, tailSeconds);
+    forward.init();
+    inverse.setInverseMode(true);
+    inverse.init();
+
+    std::vector<double> excitation(forward.getTotalLength());
+    for (size_t i = 0; i < excitation.size(); i++)
+        excitation[i] = RT60_LEVEL * forward.process(1.0);
+    std::vector<double> filter(static_cast<size_t>(options.sweepSeconds * options.sampleRate));
+    for (size_t i = 0; i < filter.size(); i++)
+        filter[i] = inverse.process(1.0);
+
+    std::vector<double> reference;
+    convolve(excitation, filter, reference);
+    size_t onset = 0;
+    for (size_t i = 1; i < reference.size(); i++)
+    {
+        if (std::fabs(reference[i]) > std::fabs(reference[onset]))
+            onset = i;
+    }
+    double gain = reference[onset];
+
+    std::vector<double> outL, outR, full;
+    process(dsp, excitation, outL, outR);
+
+    convolve(outL, filter, full);
+    irL.assign(length, 0.0);
+    for (size_t i = 0; i < length && onset + i < full.size(); i++)
+        irL[i] = full[onset + i] / gain;
+    convolve(outR, filter, full);
+    irR.assign(length, 0.0);
+    for (size_t i = 0; i < length && onset + i < full.size(); i++)
+        irR[i] = full[onset + i] / gain;
+}
+
+// Two periods of an MLS at least as long as the response. The second
+// period is correlated with the sequence, which leaves (P + 1) h[k] - sum(h).
+static void measureMLS(StudioReverbDSP& dsp, size_t length,
+                       std::vector<double>& irL, std::vector<double>& irR)
+{
+    long bits = 10;
+    while ((static_cast<size_t>(1) << bits) - 1 < length)
+        bits++;
+    size_t period = (static_cast<size_t>(1) << bits) - 1;
+
+    fv3::lfsr_f lfsr;
+    lfsr.setBitSize(bits);
+    lfsr.initState();
+    size_t words = 2 * ((period + 1) / FV3_MLS_INT_BIT);
+    std::vector<uint32_t> buffer(words);
+    for (size_t done = 0; done < words; )
+        done += lfsr.mls(&buffer[done], words - done);
+
+    std::vector<double> sequence(period);
+    for (size_t i = 0; i < period; i++)
+        sequence[i] = ((buffer[i / FV3_MLS_INT_BIT] >> (i % FV3_MLS_INT_BIT)) & 1u) ? 1.0 : -1.0;
+
+    std::vector<double> excitation(2 * period);
+    for (size_t i = 0; i < excitation.size(); i++)
+        excitation[i] = RT60_LEVEL * sequence[i % period];
+
+    std::vector<double> outL, outR;
+    process(dsp, excitation, outL, outR);
+
+    // Circular correlation through a linear one of two steady state
+    // periods with the reversed sequence
+    std::vector<double> reversed(sequence.rbegin(), sequence.rend());
+    double scale = RT60_LEVEL * (period + 1);
+    const std::vector<double>* outputs[2] = { &outL, &outR };
+    std::vector<double>* irs[2] = { &irL, &irR };
+    for (int channel = 0; channel < 2; channel++)
+    {
+        const std::vector<double>& out = *outputs[channel];
+        std::vector<double> steady(2 * period), correlation;
+        for (size_t i = 0; i < 2 * period; i++)
+            steady[i] = out[period + (i % period)];
+        convolve(steady, reversed, correlation);
+
+        irs[channel]->assign(length, 0.0);
+        for (size_t k = 0; k < length; k++)
+            (*irs[channel])[k] = correlation[k + period - 1] / scale;
+    }
+}
+
+// --------------------------------------------------------------
+// Decay analysis
+
+// Zero phase octave band, flat within the band with raised cosine skirts
+// of a third octave on each side
+static void octaveFilter(const std::vector<double>& ir, double center, double sampleRate,
+                         std::vector<double>& band)
+{
+    if (center <= 0.0)
+    {
+        band = ir;
+        return;
+    }
+
+    size_t n = fftSize(2 * ir.size());
+    std::vector<std::complex<double> > data(n);
+    std::copy(ir.begin(), ir.end(), data.begin());
+    fft(data);
+
+    double skirt = 1.0 / 3.0;
+    for (size_t k = 0; k <= n / 2; k++)
+    {
+        double frequency = k * sampleRate / n;
+        double octaves = frequency > 0.0 ? std::fabs(std::log2(frequency / center)) : 1e9;
+        double gain = 0.0;
+        if (octaves <= 0.5 - skirt / 2)
+            gain = 1.0;
+        else if (octaves < 0.5 + skirt / 2)
+            gain = 0.5 + 0.5 * std::cos(M_PI * (octaves - (0.5 - skirt / 2)) / skirt);
+        data[k] *= gain;
+        if (k > 0 && k < n / 2)
+            data[n - k] *= gain;
+    }
+
+    fft(data, true);
+    band.resize(ir.size());
+    for (size_t i = 0; i < ir.size(); i++)
+        band[i] = data[i].real();
+}
+
+// Schroeder backward integration from the onset. The noise floor is the
+// mean energy of the last tenth, the response is cut where its smoothed
+// energy comes within RT60_NOISE_MARGIN_DB of it and the floor is
+// subtracted from what remains.
+static void decayCurve(const std::vector<double>& energy, size_t onset, double sampleRate,
+                       std::vector<double>& edc)
+{
+    size_t length = energy.size();
+    size_t tail = length - length / 10;
+    double noise = 0.0;
+    for (size_t i = tail; i < length; i++)
+        noise += energy[i];
+    noise /= std::max<size_t>(1, length - tail);
+
+    size_t window = std::max<size_t>(1, static_cast<size_t>(RT60_SMOOTH_SECONDS * sampleRate));
+    double threshold = noise * std::pow(10.0, RT60_NOISE_MARGIN_DB / 10.0);
+    size_t end = length;
+    if (noise > 0.0)
+    {
+        double sum = 0.0;
+        for (size_t i = length; i-- > onset; )
+        {
+            sum += energy[i];
+            if (i + window < length)
+                sum -= energy[i + window];
+            if (sum / window > threshold)
+            {
+                end = std::min(length, i + window);
+                break;
+            }
+        }
+    }
+
+    edc.assign(end > onset ? end - onset : 0, 0.0);
+    double integral = 0.0;
+    for (size_t i = end; i-- > onset; )
+    {
+        integral += std::max(0.0, energy[i] - noise);
+        edc[i - onset] = integral;
+    }
+
+    double total = edc.empty() ? 0.0 : edc[0];
+    for (size_t i = 0; i < edc.size(); i++)
+        edc[i] = total > 0.0 ? 10.0 * std::log10(std::max(edc[i] / total, 1e-30)) : -300.0;
+}
+
+// Least squares line through the curve between from and to dB, returned
+// as the time to decay by 60 dB
+static double decayTime(const std::vector<double>& edc, double sampleRate, double from, double to)
+{
+    size_t first = 0;
+    while (first < edc.size() && edc[first] > from)
+        first++;
+    size_t last = first;
+    while (last < edc.size() && edc[last] > to)
+        last++;
+    if (last >= edc.size() || last <= first + 1)
+        return NOT_MEASURED;
+
+    double n = 0.0, sumT = 0.0, sumL = 0.0, sumTT = 0.0, sumTL = 0.0;
+    for (size_t i = first; i <= last; i++)
+    {
+        double t = i / sampleRate;
+        n += 1.0;
+        sumT += t;
+        sumL += edc[i];
+        sumTT += t * t;
+        sumTL += t * edc[i];
+    }
+    double slope = (n * sumTL - sumT * sumL) / (n * sumTT - sumT * sumT);
+    return slope < 0.0 ? -60.0 / slope : NOT_MEASURED;
+}
+
+static void analyze(const std::vector<double>& irL, const std::vector<double>& irR, double sampleRate,
+                    BandResult results[RT60_BAND_COUNT])
+{
+    // Onset from the broadband response, shared by all bands
+    double peak = 0.0;
+    for (size_t i = 0; i < irL.size(); i++)
+        peak = std::max(peak, irL[i] * irL[i] + irR[i] * irR[i]);
+    double onsetLevel = peak * std::pow(10.0, -RT60_ONSET_DB / 10.0);
+    size_t onset = 0;
+    while (onset < irL.size() && irL[onset] * irL[onset] + irR[onset] * irR[onset] < onsetLevel)
+        onset++;
+
+    std::vector<double> bandL, bandR, energy(irL.size());
+    for (int b = 0; b < RT60_BAND_COUNT; b++)
+    {
+        BandResult& result = results[b];
+        if (octaveCenters[b] * std::sqrt(2.0) >= sampleRate / 2.0)
+        {
+            result.edt = result.t20 = result.t30 = NOT_MEASURED;
+            result.edc.clear();
+            continue;
+        }
+
+        octaveFilter(irL, octaveCenters[b], sampleRate, bandL);
+        octaveFilter(irR, octaveCenters[b], sampleRate, bandR);
+        for (size_t i = 0; i < energy.size(); i++)
+            energy[i] = bandL[i] * bandL[i] + bandR[i] * bandR[i];
+
+        decayCurve(energy, onset, sampleRate, result.edc);
+        result.edt = decayTime(result.edc, sampleRate, 0.0, -10.0);
+        result.t20 = decayTime(result.edc, sampleRate, -5.0, -25.0);
+        result.t30 = decayTime(result.edc, sampleRate, -5.0, -35.0);
+    }
+}
+
+static double reverberationTime(const BandResult& result)
+{
+    return std::isnan(result.t30) ? result.t20 : result.t30;
+}
+
+// --------------------------------------------------------------
+// Output
+
+static void printTime(double value)
+{
+    if (std::isnan(value))
+        std::printf(" %6s", "-");
+    else
+        std::printf(" %6.2f", value);
+}
+
+static void writeCurves(FILE* file, const std::string& name, const BandResult results[RT60_BAND_COUNT],
+                        double sampleRate)
+{
+    // One point per millisecond down to -100 dB
+    size_t step = std::max<size_t>(1, static_cast<size_t>(sampleRate / 1000.0));
+    for (int b = 0; b < RT60_BAND_COUNT; b++)
+    {
+        const std::vector<double>& edc = results[b].edc;
+        for (size_t i = 0; i < edc.size() && edc[i] > -100.0; i += step)
+            std::fprintf(file, "%s,%s,%.1f,%.2f\n", name.c_str(), bandNames[b], 1000.0 * i / sampleRate, edc[i]);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Rt60Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Rt60Case> cases;
+    collectCases(options, cases);
+
+    FILE* edcFile = nullptr;
+    if (options.edcFile != nullptr)
+    {
+        edcFile = std::fopen(options.edcFile, "w");
+        if (edcFile == nullptr)
+        {
+            std::fprintf(stderr, "Could not write %s\n", options.edcFile);
+            return 2;
+        }
+        std::fprintf(edcFile, "case,band,time_ms,edc_db\n");
+    }
+
+    if (options.csv)
+        std::printf("case,type,decay,expected_rt60,band,edt,t20,t30\n");
+    else
+    {
+        std::printf("%-20s %6s %6s %6s %6s %6s", "case", "decay", "expect", "EDT", "T20", "T30");
+        for (int b = 1; b < RT60_BAND_COUNT; b++)
+            std::printf(" %6s", bandNames[b]);
+        std::printf("  check\n");
+    }
+
+    int failed = 0;
+    for (size_t c = 0; c < cases.size(); c++)
+    {
+        const Rt60Case& rc = cases[c];
+        StudioReverbDSP dsp(options.sampleRate);
+        // The same modulation noise on every run
+        dsp.setNoiseSeed(0);
+        applyProgram(dsp, 0);
+        if (rc.type >= 0)
+            dsp.setParameterValue(paramReverbType, static_cast<float>(rc.type));
+        else
+            applyProgram(dsp, static_cast<uint32_t>(rc.program));
+        if (rc.decay >= 0.0)
+            dsp.setParameterValue(paramDecay, static_cast<float>(rc.decay));
+
+        // The wet signal only, the dry path would hide the start of the decay
+        dsp.setParameterValue(paramDry, 0.0f);
+
+        int type = static_cast<int>(dsp.getParameterValue(paramReverbType) + 0.5f);
+        double decay = dsp.getParameterValue(paramDecay);
+        bool hasImpulse = false;
+        if (options.irFile != nullptr && type == REVERB_HYBRID)
+        {
+            if (!dsp.loadImpulseFile(options.irFile))
+            {
+                std::fprintf(stderr, "Could not load %s\n", options.irFile);
+                return 2;
+            }
+            // The new head is crossfaded in while audio runs
+            std::vector<double> silence(BUFFER_SIZE, 0.0), outL, outR;
+            for (double waited = 0.0; dsp.isImpulseLoading() && waited < RT60_LOAD_TIMEOUT_SECONDS;
+                 waited += BUFFER_SIZE / options.sampleRate)
+                process(dsp, silence, outL, outR);
+            dsp.mute();
+            hasImpulse = true;
+        }
+
+        double expected = expectedRT60(type, decay, hasImpulse);
+        double seconds = std::max(RT60_MIN_SECONDS, std::isnan(expected) ? 0.0 : 2.0 * expected) + RT60_MARGIN_SECONDS;
+        size_t length = static_cast<size_t>(seconds * options.sampleRate);
+
+        std::vector<double> irL, irR;
+        if (options.excitation == EXCITATION_MLS)
+            measureMLS(dsp, length, irL, irR);
+        else
+            measureSweep(dsp, options, length, irL, irR);
+
+        BandResult results[RT60_BAND_COUNT];
+        analyze(irL, irR, options.sampleRate, results);
+
+        double measured = 0.0;
+        int measuredBands = 0;
+        for (int b = RT60_CHECK_FIRST_BAND; b <= RT60_CHECK_LAST_BAND; b++)
+        {
+            double rt = reverberationTime(results[b]);
+            if (!std::isnan(rt))
+            {
+                measured += rt;
+                measuredBands++;
+            }
+        }
+        measured = measuredBands > 0 ? measured / measuredBands : NOT_MEASURED;
+
+        const char* check = "-";
+        if (!std::isnan(expected))
+        {
+            bool ok = !std::isnan(measured) && std::fabs(measured - expected) <= options.tolerance * expected;
+            check = ok ? "ok" : "FAILED";
+            if (!ok)
+                failed++;
+        }
+
+        if (options.csv)
+        {
+            for (int b = 0; b < RT60_BAND_COUNT; b++)
+            {
+                std::printf("%s,%s,%.3f,%.3f,%s,%.4f,%.4f,%.4f\n", rc.name.c_str(), typeNames[type], decay,
+                            expected, bandNames[b], results[b].edt, results[b].t20, results[b].t30);
+            }
+        }
+        else
+        {
+            std::printf("%-20s", rc.name.c_str());
+            printTime(decay);
+            printTime(expected);
+            printTime(results[0].edt);
+            printTime(results[0].t20);
+            printTime(results[0].t30);
+            for (int b = 1; b < RT60_BAND_COUNT; b++)
+                printTime(reverberationTime(results[b]));
+            std::printf("  %s\n", check);
+        }
+        std::fflush(stdout);
+
+        if (edcFile != nullptr)
+            writeCurves(edcFile, rc.name, results, options.sampleRate);
+    }
+
+    if (edcFile != nullptr)
+        std::fclose(edcFile);
+
+    if (!options.csv)
+        std::printf("\n%d of %u cases off the Decay parameter by more than %.0f%%\n",
+                    failed, static_cast<unsigned>(cases.size()), options.tolerance * 100.0);
+    return failed > 0 ? 1 : 0;
+}
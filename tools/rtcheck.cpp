@@ -0,0 +1,356 @@
+/*
+ * Studio Reverb Real-Time Checker
+ * Scripted automation on a thread marked as the audio thread
+ */
+
+#include "rtintercept.hpp"
+#include "DSP.hpp"
+#include "Programs.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char* const typeNames[REVERB_TYPE_COUNT] = {
+    "room", "hall", "plate", "early", "hybrid"
+};
+
+enum Scenario
+{
+    SCENARIO_STEADY = 0,    // audio only
+    SCENARIO_AUTOMATION,    // every parameter but the type, every block
+    SCENARIO_PROGRAMS,      // factory program changes, which also switch types
+    SCENARIO_TYPES,         // reverb type switches
+    SCENARIO_RELOAD,        // IR reloads from another thread, with --ir only
+    SCENARIO_COUNT
+};
+
+static const char* const scenarioNames[SCENARIO_COUNT] = {
+    "steady", "automation", "programs", "types", "reload"
+};
+
+static const uint32_t RTCHECK_MAX_BLOCK = 4096;
+
+// Period of the automation sweep, and time between program, type and IR
+// changes (s)
+static const double RTCHECK_SWEEP_SECONDS = 1.0;
+static const double RTCHECK_CHANGE_SECONDS = 0.1;
+static const double RTCHECK_RELOAD_SECONDS = 0.5;
+
+struct RtCheckOptions
+{
+    std::vector<int> types;
+    std::vector<int> scenarios;
+    double sampleRate;
+    uint32_t block;
+    double seconds;
+    const char* irFile;
+    bool abort;
+};
+
+// Range each parameter is automated across, the span of the factory programs
+struct AutomationRange
+{
+    float low;
+    float high;
+};
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "Runs the DSP on a thread marked as the audio thread and reports every\n"
+        "allocation, lock and system call made from it, with a backtrace.\n"
+        "Exits with 1 if there was any.\n"
+        "  --types LIST      reverb types (room,hall,plate,early,hybrid)\n"
+        "  --scenarios LIST  steady,automation,programs,types,reload (default all)\n"
+        "  --rate R          sample rate (default 48000)\n"
+        "  --block N         block size, 1-%u (default 256)\n"
+        "  --seconds S       audio rendered per scenario (default 2.0)\n"
+        "  --ir FILE         impulse response for the hybrid type, enables reload\n"
+        "  --abort           abort() on the first violation\n",
+        name, RTCHECK_MAX_BLOCK);
+}
+
+static bool parseNames(const char* text, const char* const* names, int count, std::vector<int>& list)
+{
+    list.clear();
+    std::string all(text);
+    size_t start = 0;
+
+    while (start <= all.size())
+    {
+        size_t comma = all.find(',', start);
+        if (comma == std::string::npos)
+            comma = all.size();
+        std::string token = all.substr(start, comma - start);
+        start = comma + 1;
+
+        int found = -1;
+        for (int i = 0; i < count && found < 0; i++)
+        {
+            if (token == names[i])
+                found = i;
+        }
+        if (found < 0)
+            return false;
+        list.push_back(found);
+    }
+
+    return !list.empty();
+}
+
+static bool parseOptions(int argc, char* argv[], RtCheckOptions& options)
+{
+    options.types.clear();
+    for (int i = 0; i < REVERB_TYPE_COUNT; i++)
+        options.types.push_back(i);
+    options.scenarios.clear();
+    for (int i = 0; i < SCENARIO_COUNT; i++)
+        options.scenarios.push_back(i);
+    options.sampleRate = 48000.0;
+    options.block = 256;
+    options.seconds = 2.0;
+    options.irFile = nullptr;
+    options.abort = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--types") == 0 && value != nullptr)
+            ok = parseNames(argv[++i], typeNames, REVERB_TYPE_COUNT, options.types);
+        else if (std::strcmp(arg, "--scenarios") == 0 && value != nullptr)
+            ok = parseNames(argv[++i], scenarioNames, SCENARIO_COUNT, options.scenarios);
+        else if (std::strcmp(arg, "--rate") == 0 && value != nullptr)
+            ok = (options.sampleRate = std::atof(argv[++i])) >= 8000.0;
+        else if (std::strcmp(arg, "--block") == 0 && value != nullptr)
+        {
+            long block = std::atol(argv[++i]);
+            ok = block >= 1 && block <= static_cast<long>(RTCHECK_MAX_BLOCK);
+            options.block = static_cast<uint32_t>(block);
+        }
+        else if (std::strcmp(arg, "--seconds") == 0 && value != nullptr)
+            ok = (options.seconds = std::atof(argv[++i])) > 0.0;
+        else if (std::strcmp(arg, "--ir") == 0 && value != nullptr)
+            options.irFile = argv[++i];
+        else if (std::strcmp(arg, "--abort") == 0)
+            options.abort = true;
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void applyProgram(StudioReverbDSP& dsp, uint32_t index)
+{
+    const Program& program = getProgram(index);
+    for (uint32_t i = 0; i < program.count; i++)
+        dsp.setParameterValue(program.values[i].index, program.values[i].value);
+}
+
+// Loads the factory programs in order from the defaults, as a host stepping
+// through them would, and keeps the span each parameter covers
+static void collectRanges(std::vector<AutomationRange>& ranges)
+{
+    StudioReverbDSP dsp(48000.0);
+    ranges.resize(paramCount);
+
+    for (uint32_t p = 0; p < PROGRAM_COUNT; p++)
+    {
+        applyProgram(dsp, 0);
+        applyProgram(dsp, p);
+        for (uint32_t i = 0; i < paramCount; i++)
+        {
+            float value = dsp.getParameterValue(i);
+            ranges[i].low = p == 0 ? value : std::min(ranges[i].low, value);
+            ranges[i].high = p == 0 ? value : std::max(ranges[i].high, value);
+        }
+    }
+}
+
+// One instance as the plugin drives it, with its own buffers
+class Session
+{
+public:
+    Session(double sampleRate, uint32_t block)
+        : dsp(new StudioReverbDSP(sampleRate)),
+          block(block),
+          input(2 * block),
+          output(2 * block)
+    {
+        // -12 dBFS xorshift32 noise, the same on every block
+        uint32_t state = 0x12345678u;
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            input[i] = 0.25f * (static_cast<float>(state) / 2147483648.0f - 1.0f);
+        }
+        applyProgram(*dsp, 0);
+    }
+
+    StudioReverbDSP& getDSP()
+    {
+        return *dsp;
+    }
+
+    void run()
+    {
+        const float* inputs[2] = { &input[0], &input[block] };
+        float* outputs[2] = { &output[0], &output[block] };
+        dsp->run(inputs, outputs, block);
+    }
+
+private:
+    std::unique_ptr<StudioReverbDSP> dsp;
+    uint32_t block;
+    std::vector<float> input;
+    std::vector<float> output;
+};
+
+// Runs one scenario, returns the number of violations. type is the fixed
+// type, or the first one for the scenarios that switch.
+static uint64_t runScenario(const RtCheckOptions& options, int scenario, int type,
+                            const std::vector<AutomationRange>& ranges)
+{
+    char context[32];
+    std::snprintf(context, sizeof(context), "%s/%s", typeNames[type], scenarioNames[scenario]);
+
+    // Instantiation and state restore happen on the host's main thread
+    Session session(options.sampleRate, options.block);
+    StudioReverbDSP& dsp = session.getDSP();
+    dsp.setParameterValue(paramReverbType, static_cast<float>(type));
+    if (options.irFile != nullptr && !dsp.loadImpulseFile(options.irFile))
+    {
+        std::fprintf(stderr, "Could not load %s\n", options.irFile);
+        std::exit(2);
+    }
+
+    uint64_t blocks = std::max<uint64_t>(1, static_cast<uint64_t>(options.sampleRate * options.seconds / options.block));
+    uint64_t changeBlocks = std::max<uint64_t>(1, static_cast<uint64_t>(options.sampleRate * RTCHECK_CHANGE_SECONDS / options.block));
+    uint64_t reloadBlocks = std::max<uint64_t>(1, static_cast<uint64_t>(options.sampleRate * RTCHECK_RELOAD_SECONDS / options.block));
+    double sweepStep = static_cast<double>(options.block) / (options.sampleRate * RTCHECK_SWEEP_SECONDS);
+    uint32_t change = 0;
+
+    rtSetContext(context);
+    uint64_t before = rtViolationCount();
+    rtAudioThreadBegin();
+
+    for (uint64_t b = 0; b < blocks; b++)
+    {
+        // DPF delivers parameter and program changes on the audio thread,
+        // right before run()
+        switch (scenario)
+        {
+        case SCENARIO_AUTOMATION:
+            for (uint32_t i = 0; i < paramCount; i++)
+            {
+                if (i == paramReverbType)
+                    continue;
+                double phase = std::fmod(b * sweepStep + static_cast<double>(i) / paramCount, 1.0);
+                double tri = phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase;
+                dsp.setParameterValue(i, static_cast<float>(ranges[i].low + tri * (ranges[i].high - ranges[i].low)));
+            }
+            break;
+
+        case SCENARIO_PROGRAMS:
+            if (b % changeBlocks == 0)
+                applyProgram(dsp, change++ % PROGRAM_COUNT);
+            break;
+
+        case SCENARIO_TYPES:
+            if (b % changeBlocks == 0)
+                dsp.setParameterValue(paramReverbType, static_cast<float>((type + change++) % REVERB_TYPE_COUNT));
+            break;
+
+        case SCENARIO_RELOAD:
+            // The load itself belongs to the host's main thread, the
+            // crossfade that follows to the audio thread
+            if (b > 0 && b % reloadBlocks == 0)
+            {
+                rtAudioThreadEnd();
+                dsp.loadImpulseFile(options.irFile);
+                rtAudioThreadBegin();
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        session.run();
+    }
+
+    rtAudioThreadEnd();
+    uint64_t count = rtViolationCount() - before;
+
+    std::printf("%-24s %8llu %10llu\n", context, static_cast<unsigned long long>(blocks),
+                static_cast<unsigned long long>(count));
+    std::fflush(stdout);
+    return count;
+}
+
+int main(int argc, char* argv[])
+{
+    rtInterceptInit();
+
+    RtCheckOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    rtSetAbort(options.abort);
+
+    std::vector<AutomationRange> ranges;
+    collectRanges(ranges);
+
+    std::printf("%-24s %8s %10s\n", "scenario", "blocks", "violations");
+    uint64_t total = 0;
+    for (size_t s = 0; s < options.scenarios.size(); s++)
+    {
+        int scenario = options.scenarios[s];
+        if (scenario == SCENARIO_RELOAD && options.irFile == nullptr)
+            continue;
+
+        // Programs and type switches cover every type from the first one
+        if (scenario == SCENARIO_PROGRAMS || scenario == SCENARIO_TYPES)
+        {
+            total += runScenario(options, scenario, options.types[0], ranges);
+            continue;
+        }
+        for (size_t t = 0; t < options.types.size(); t++)
+        {
+            if (scenario == SCENARIO_RELOAD && options.types[t] != REVERB_HYBRID)
+                continue;
+            total += runScenario(options, scenario, options.types[t], ranges);
+        }
+    }
+
+    if (total == 0)
+    {
+        std::printf("\nNo allocations, locks or system calls on the audio thread\n");
+        return 0;
+    }
+
+    std::printf("\n");
+    rtPrintViolations(stdout);
+    std::printf("%llu violations on the audio thread\n", static_cast<unsigned long long>(total));
+    return 1;
+}
@@ -0,0 +1,611 @@
+/*
+ * Studio Reverb Real-Time Checker
+ * Interposed allocation, locking and system calls (Linux, glibc)
+ */
+
+#include "rtintercept.hpp"
+
+#if !defined(__linux__) || !defined(__GLIBC__)
+#error "The real-time checker interposes glibc functions and only builds on Linux"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// The allocator behind malloc(), the replacements below forward to it
+// without going through dlsym, which allocates itself
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+}
+
+struct RtSite
+{
+    const char* function;
+    char context[32];
+    void* frames[RT_MAX_FRAMES];
+    int frameCount;
+    uint64_t count;
+};
+
+static RtSite sites[RT_MAX_SITES];
+static uint32_t siteCount = 0;
+static uint64_t unrecorded = 0;
+static std::atomic_flag sitesLock = ATOMIC_FLAG_INIT;
+static std::atomic<uint64_t> violations(0);
+
+static char currentContext[32] = "";
+static bool abortOnViolation = false;
+
+static __thread bool audioThread = false;
+static __thread bool inChecker = false;
+
+// --------------------------------------------------------------
+// Reports
+
+static void printFrame(FILE* file, int index, void* address)
+{
+    Dl_info info;
+    if (dladdr(address, &info) == 0)
+    {
+        std::fprintf(file, "    #%-2d %p\n", index, address);
+        return;
+    }
+
+    if (info.dli_sname != nullptr)
+    {
+        int status = 0;
+        char* name = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::fprintf(file, "    #%-2d %s+0x%lx\n", index, status == 0 ? name : info.dli_sname,
+                     static_cast<unsigned long>(static_cast<char*>(address) - static_cast<char*>(info.dli_saddr)));
+        std::free(name);
+    }
+    else
+    {
+        // Static functions, addr2line -e <module> <offset> finds them
+        std::fprintf(file, "    #%-2d %s+0x%lx\n", index, info.dli_fname,
+                     static_cast<unsigned long>(static_cast<char*>(address) - static_cast<char*>(info.dli_fbase)));
+    }
+}
+
+static void printSite(FILE* file, uint32_t number, const RtSite& site)
+{
+    std::fprintf(file, "#%u  %llu x %s  (%s)\n", number, static_cast<unsigned long long>(site.count),
+                 site.function, site.context);
+    for (int i = 0; i < site.frameCount; i++)
+        printFrame(file, i, site.frames[i]);
+}
+
+static bool sameSite(const RtSite& site, const char* function, void* const* frames, int frameCount)
+{
+    int compared = std::min(frameCount, RT_SITE_FRAMES);
+    return site.function == function && std::min(site.frameCount, RT_SITE_FRAMES) == compared &&
+           std::memcmp(site.frames, frames, compared * sizeof(void*)) == 0;
+}
+
+// Called first thing by every interposed function. Does not allocate, so it
+// is safe on any thread and from inside the allocator.
+static void __attribute__((noinline)) violation(const char* function)
+{
+    if (!audioThread || inChecker)
+        return;
+    inChecker = true;
+
+    // Drops this function and the interposed one
+    void* frames[RT_MAX_FRAMES + 2];
+    int frameCount = backtrace(frames, RT_MAX_FRAMES + 2);
+    int skip = std::min(frameCount, 2);
+    frameCount -= skip;
+
+    violations.fetch_add(1, std::memory_order_relaxed);
+
+    while (sitesLock.test_and_set(std::memory_order_acquire))
+        ;
+
+    const RtSite* recorded = nullptr;
+    for (uint32_t i = 0; i < siteCount && recorded == nullptr; i++)
+    {
+        if (sameSite(sites[i], function, frames + skip, frameCount))
+        {
+            sites[i].count++;
+            recorded = &sites[i];
+        }
+    }
+    if (recorded == nullptr && siteCount < RT_MAX_SITES)
+    {
+        RtSite& site = sites[siteCount++];
+        site.function = function;
+        std::memcpy(site.context, currentContext, sizeof(site.context));
+        std::memcpy(site.frames, frames + skip, frameCount * sizeof(void*));
+        site.frameCount = frameCount;
+        site.count = 1;
+        recorded = &site;
+    }
+    else if (recorded == nullptr)
+        unrecorded++;
+
+    sitesLock.clear(std::memory_order_release);
+
+    if (abortOnViolation)
+    {
+        std::fprintf(stderr, "Real-time violation on the audio thread:\n");
+        if (recorded != nullptr)
+            printSite(stderr, 1, *recorded);
+        std::abort();
+    }
+
+    inChecker = false;
+}
+
+// --------------------------------------------------------------
+// Functions found after this executable, resolved once by rtInterceptInit()
+
+template <typename F>
+static F next(F& real, const char* name)
+{
+    if (real == nullptr)
+    {
+        bool wasInChecker = inChecker;
+        inChecker = true;
+        real = reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+        inChecker = wasInChecker;
+
+        if (real == nullptr)
+        {
+            std::fprintf(stderr, "rtcheck: %s not found (%s)\n", name, dlerror());
+            std::abort();
+        }
+    }
+    return real;
+}
+
+#define RT_REAL(name) static decltype(&::name) real_##name = nullptr
+#define RT_NEXT(name) next(real_##name, #name)
+
+RT_REAL(pthread_mutex_lock);
+RT_REAL(pthread_rwlock_rdlock);
+RT_REAL(pthread_rwlock_wrlock);
+RT_REAL(pthread_create);
+RT_REAL(pthread_join);
+RT_REAL(sem_wait);
+RT_REAL(sem_timedwait);
+RT_REAL(read);
+RT_REAL(write);
+RT_REAL(open);
+RT_REAL(openat);
+RT_REAL(close);
+RT_REAL(nanosleep);
+RT_REAL(clock_nanosleep);
+RT_REAL(usleep);
+RT_REAL(sched_yield);
+RT_REAL(mmap);
+RT_REAL(munmap);
+RT_REAL(syscall);
+RT_REAL(fopen);
+RT_REAL(fwrite);
+RT_REAL(fputs);
+RT_REAL(puts);
+RT_REAL(vfprintf);
+
+// --------------------------------------------------------------
+// Interface
+
+void rtInterceptInit()
+{
+    RT_NEXT(pthread_mutex_lock);
+    RT_NEXT(pthread_rwlock_rdlock);
+    RT_NEXT(pthread_rwlock_wrlock);
+    RT_NEXT(pthread_create);
+    RT_NEXT(pthread_join);
+    RT_NEXT(sem_wait);
+    RT_NEXT(sem_timedwait);
+    RT_NEXT(read);
+    RT_NEXT(write);
+    RT_NEXT(open);
+    RT_NEXT(openat);
+    RT_NEXT(close);
+    RT_NEXT(nanosleep);
+    RT_NEXT(clock_nanosleep);
+    RT_NEXT(usleep);
+    RT_NEXT(sched_yield);
+    RT_NEXT(mmap);
+    RT_NEXT(munmap);
+    RT_NEXT(syscall);
+    RT_NEXT(fopen);
+    RT_NEXT(fwrite);
+    RT_NEXT(fputs);
+    RT_NEXT(puts);
+    RT_NEXT(vfprintf);
+
+    // The first backtrace() loads the unwinder, which must not happen on
+    // the audio thread
+    void* frames[2];
+    backtrace(frames, 2);
+}
+
+void rtAudioThreadBegin()
+{
+    audioThread = true;
+}
+
+void rtAudioThreadEnd()
+{
+    audioThread = false;
+}
+
+void rtSetContext(const char* context)
+{
+    std::strncpy(currentContext, context, sizeof(currentContext) - 1);
+    currentContext[sizeof(currentContext) - 1] = '\0';
+}
+
+void rtSetAbort(bool abort)
+{
+    abortOnViolation = abort;
+}
+
+uint64_t rtViolationCount()
+{
+    return violations.load(std::memory_order_relaxed);
+}
+
+void rtPrintViolations(FILE* file)
+{
+    while (sitesLock.test_and_set(std::memory_order_acquire))
+        ;
+
+    // Most frequent first
+    uint32_t order[RT_MAX_SITES];
+    for (uint32_t i = 0; i < siteCount; i++)
+        order[i] = i;
+    std::stable_sort(order, order + siteCount, [](uint32_t a, uint32_t b) {
+        return sites[a].count > sites[b].count;
+    });
+
+    for (uint32_t i = 0; i < siteCount; i++)
+    {
+        printSite(file, i + 1, sites[order[i]]);
+        std::fprintf(file, "\n");
+    }
+    if (unrecorded > 0)
+        std::fprintf(file, "%llu more violations at call sites beyond the first %u\n",
+                     static_cast<unsigned long long>(unrecorded), RT_MAX_SITES);
+
+    sitesLock.clear(std::memory_order_release);
+}
+
+// --------------------------------------------------------------
+// Allocation. glibc calls these through the PLT too, so allocations made
+// inside libc (strdup, fopen, ...) are seen as well.
+
+static void* allocate(size_t size)
+{
+    void* pointer = __libc_malloc(size > 0 ? size : 1);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+extern "C" void* malloc(size_t size) __THROW
+{
+    violation("malloc");
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) __THROW
+{
+    violation("calloc");
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) __THROW
+{
+    violation("realloc");
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) __THROW
+{
+    if (pointer != nullptr)
+        violation("free");
+    __libc_free(pointer);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) __THROW
+{
+    violation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) __THROW
+{
+    violation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* valloc(size_t size) __THROW
+{
+    violation("valloc");
+    return __libc_memalign(sysconf(_SC_PAGESIZE), size);
+}
+
+extern "C" int posix_memalign(void** result, size_t alignment, size_t size) __THROW
+{
+    violation("posix_memalign");
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void* pointer = __libc_memalign(alignment, size);
+    if (pointer == nullptr)
+        return ENOMEM;
+    *result = pointer;
+    return 0;
+}
+
+void* operator new(std::size_t size)
+{
+    violation("operator new");
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    violation("operator new[]");
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    violation("operator new");
+    return __libc_malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    violation("operator new[]");
+    return __libc_malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        violation("operator delete");
+    __libc_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        violation("operator delete[]");
+    __libc_free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    if (pointer != nullptr)
+        violation("operator delete");
+    __libc_free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    if (pointer != nullptr)
+        violation("operator delete[]");
+    __libc_free(pointer);
+}
+
+// --------------------------------------------------------------
+// Locks and threads. Condition variables are only used under a mutex in
+// this code base, so they are seen through pthread_mutex_lock. trylock and
+// unlock never block and are allowed.
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) __THROWNL
+{
+    violation("pthread_mutex_lock");
+    return RT_NEXT(pthread_mutex_lock)(mutex);
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t* lock) __THROWNL
+{
+    violation("pthread_rwlock_rdlock");
+    return RT_NEXT(pthread_rwlock_rdlock)(lock);
+}
+
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t* lock) __THROWNL
+{
+    violation("pthread_rwlock_wrlock");
+    return RT_NEXT(pthread_rwlock_wrlock)(lock);
+}
+
+extern "C" int pthread_create(pthread_t* thread, const pthread_attr_t* attributes,
+                              void* (*routine)(void*), void* argument) __THROWNL
+{
+    violation("pthread_create");
+    return RT_NEXT(pthread_create)(thread, attributes, routine, argument);
+}
+
+extern "C" int pthread_join(pthread_t thread, void** result)
+{
+    violation("pthread_join");
+    return RT_NEXT(pthread_join)(thread, result);
+}
+
+extern "C" int sem_wait(sem_t* semaphore)
+{
+    violation("sem_wait");
+    return RT_NEXT(sem_wait)(semaphore);
+}
+
+extern "C" int sem_timedwait(sem_t* semaphore, const struct timespec* timeout)
+{
+    violation("sem_timedwait");
+    return RT_NEXT(sem_timedwait)(semaphore, timeout);
+}
+
+// --------------------------------------------------------------
+// System calls and stdio. Calls between libc functions do not go through
+// the PLT, so fprintf() is caught here and not as a write().
+
+extern "C" ssize_t read(int fd, void* buffer, size_t size)
+{
+    violation("read");
+    return RT_NEXT(read)(fd, buffer, size);
+}
+
+extern "C" ssize_t write(int fd, const void* buffer, size_t size)
+{
+    violation("write");
+    return RT_NEXT(write)(fd, buffer, size);
+}
+
+extern "C" int open(const char* path, int flags, ...)
+{
+    violation("open");
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+    {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    return RT_NEXT(open)(path, flags, mode);
+}
+
+extern "C" int openat(int directory, const char* path, int flags, ...)
+{
+    violation("openat");
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+    {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    return RT_NEXT(openat)(directory, path, flags, mode);
+}
+
+extern "C" int close(int fd)
+{
+    violation("close");
+    return RT_NEXT(close)(fd);
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    violation("nanosleep");
+    return RT_NEXT(nanosleep)(duration, remaining);
+}
+
+extern "C" int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration,
+                               struct timespec* remaining)
+{
+    violation("clock_nanosleep");
+    return RT_NEXT(clock_nanosleep)(clock, flags, duration, remaining);
+}
+
+extern "C" int usleep(useconds_t duration)
+{
+    violation("usleep");
+    return RT_NEXT(usleep)(duration);
+}
+
+extern "C" int sched_yield() __THROW
+{
+    violation("sched_yield");
+    return RT_NEXT(sched_yield)();
+}
+
+extern "C" void* mmap(void* address, size_t size, int protection, int flags, int fd, off_t offset) __THROW
+{
+    violation("mmap");
+    return RT_NEXT(mmap)(address, size, protection, flags, fd, offset);
+}
+
+extern "C" int munmap(void* address, size_t size) __THROW
+{
+    violation("munmap");
+    return RT_NEXT(munmap)(address, size);
+}
+
+extern "C" long syscall(long number, ...) __THROW
+{
+    violation("syscall");
+    va_list args;
+    va_start(args, number);
+    long a = va_arg(args, long), b = va_arg(args, long), c = va_arg(args, long);
+    long d = va_arg(args, long), e = va_arg(args, long), f = va_arg(args, long);
+    va_end(args);
+    return RT_NEXT(syscall)(number, a, b, c, d, e, f);
+}
+
+extern "C" FILE* fopen(const char* path, const char* mode)
+{
+    violation("fopen");
+    return RT_NEXT(fopen)(path, mode);
+}
+
+extern "C" size_t fwrite(const void* buffer, size_t size, size_t count, FILE* file)
+{
+    violation("fwrite");
+    return RT_NEXT(fwrite)(buffer, size, count, file);
+}
+
+extern "C" int fputs(const char* text, FILE* file)
+{
+    violation("fputs");
+    return RT_NEXT(fputs)(text, file);
+}
+
+extern "C" int puts(const char* text)
+{
+    violation("puts");
+    return RT_NEXT(puts)(text);
+}
+
+extern "C" int vfprintf(FILE* file, const char* format, va_list args)
+{
+    violation("vfprintf");
+    return RT_NEXT(vfprintf)(file, format, args);
+}
+
+extern "C" int fprintf(FILE* file, const char* format, ...)
+{
+    violation("fprintf");
+    va_list args;
+    va_start(args, format);
+    int result = RT_NEXT(vfprintf)(file, format, args);
+    va_end(args);
+    return result;
+}
+
+extern "C" int printf(const char* format, ...)
+{
+    violation("printf");
+    va_list args;
+    va_start(args, format);
+    int result = RT_NEXT(vfprintf)(stdout, format, args);
+    va_end(args);
+    return result;
+}
@@ -0,0 +1,40 @@
+/*
+ * Studio Reverb Real-Time Checker
+ * Interposed allocation, locking and system calls (Linux, glibc)
+ */
+
+#ifndef STUDIO_REVERB_RTINTERCEPT_HPP_INCLUDED
+#define STUDIO_REVERB_RTINTERCEPT_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstdio>
+
+// Call sites kept with a backtrace, later ones are only counted
+static const uint32_t RT_MAX_SITES = 256;
+static const int RT_MAX_FRAMES = 24;
+
+// Violations whose innermost frames match are counted as one call site
+static const int RT_SITE_FRAMES = 8;
+
+// Resolves the interposed functions and loads the unwinder, call before
+// any thread is marked
+void rtInterceptInit();
+
+// Marks the calling thread as the audio thread. While it is marked, every
+// call it makes to an interposed function is recorded as a violation.
+void rtAudioThreadBegin();
+void rtAudioThreadEnd();
+
+// Stored with the first violation of each call site, up to 31 characters
+void rtSetContext(const char* context);
+
+// abort() on the first violation, to stop in a debugger
+void rtSetAbort(bool abort);
+
+uint64_t rtViolationCount();
+
+// Every call site with its count, function and backtrace. Not on a marked
+// thread.
+void rtPrintViolations(FILE* file);
+
+#endif // STUDIO_REVERB_RTINTERCEPT_HPP_INCLUDED
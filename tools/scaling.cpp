@@ -0,0 +1,326 @@
+/*
+ * Studio Reverb Offline Benchmark
+ * Multi-instance scaling, N instances processed by M threads per block
+ */
+
+#include "bench.hpp"
+#include "Programs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+static const double SCALING_WARMUP_SECONDS = 0.25;
+
+typedef std::chrono::steady_clock Clock;
+
+struct ScalingInstance
+{
+    std::unique_ptr<StudioReverbDSP> dsp;
+    uint32_t position;
+    std::vector<float> outL, outR;
+};
+
+// The instances are split statically across the threads, as a host assigns
+// tracks to its audio workers. Thread 0 is the calling thread.
+struct ScalingWorker
+{
+    std::vector<ScalingInstance*> instances;
+    std::vector<float> callbackNs;
+};
+
+struct ScalingStats
+{
+    double p50;
+    double p99;
+    double p999;
+    double max;
+};
+
+// Resident set size, 0 where it can not be read
+static size_t residentBytes()
+{
+#if defined(__linux__)
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+        return 0;
+    unsigned long size = 0, resident = 0;
+    int read = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    if (read != 2)
+        return 0;
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+static ScalingStats percentiles(std::vector<float>& values)
+{
+    ScalingStats stats = { 0.0, 0.0, 0.0, 0.0 };
+    if (values.empty())
+        return stats;
+
+    std::sort(values.begin(), values.end());
+    size_t last = values.size() - 1;
+    stats.p50 = values[last * 50 / 100];
+    stats.p99 = values[last * 99 / 100];
+    stats.p999 = values[last * 999 / 1000];
+    stats.max = values[last];
+    return stats;
+}
+
+class ScalingRun
+{
+public:
+    ScalingRun(std::vector<ScalingInstance>& instances, uint32_t threadCount,
+               uint32_t block, const std::vector<float>& noiseL, const std::vector<float>& noiseR)
+        : workers(threadCount),
+          block(block),
+          noiseL(noiseL),
+          noiseR(noiseR),
+          period(0),
+          done(0),
+          recording(false),
+          stop(false)
+    {
+        for (size_t i = 0; i < instances.size(); i++)
+            workers[i % threadCount].instances.push_back(&instances[i]);
+    }
+
+    // Runs periods blocks, returns the wall time of each one
+    void run(uint64_t periods, bool record, std::vector<float>& periodNs)
+    {
+        recording = record;
+        stop = false;
+        period.store(0, std::memory_order_relaxed);
+
+        for (size_t w = 0; w < workers.size(); w++)
+        {
+            workers[w].callbackNs.clear();
+            if (record)
+                workers[w].callbackNs.reserve(periods * workers[w].instances.size());
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t w = 1; w < workers.size(); w++)
+            threads.push_back(std::thread(&ScalingRun::workerLoop, this, w));
+
+        periodNs.clear();
+        if (record)
+            periodNs.reserve(periods);
+
+        for (uint64_t p = 1; p <= periods; p++)
+        {
+            Clock::time_point start = Clock::now();
+
+            done.store(0, std::memory_order_relaxed);
+            period.store(p, std::memory_order_release);
+            processWorker(workers[0]);
+            while (done.load(std::memory_order_acquire) < workers.size() - 1)
+                std::this_thread::yield();
+
+            if (record)
+                periodNs.push_back(std::chrono::duration<float, std::nano>(Clock::now() - start).count());
+        }
+
+        stop = true;
+        period.store(periods + 1, std::memory_order_release);
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+    }
+
+    void collectCallbacks(std::vector<float>& callbackNs) const
+    {
+        callbackNs.clear();
+        for (size_t w = 0; w < workers.size(); w++)
+            callbackNs.insert(callbackNs.end(), workers[w].callbackNs.begin(), workers[w].callbackNs.end());
+    }
+
+private:
+    void workerLoop(size_t index)
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            uint64_t current;
+            // Spin like a host worker waiting for the next cycle
+            while ((current = period.load(std::memory_order_acquire)) == seen)
+                std::this_thread::yield();
+            if (stop)
+                return;
+            seen = current;
+            processWorker(workers[index]);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void processWorker(ScalingWorker& worker)
+    {
+        for (size_t i = 0; i < worker.instances.size(); i++)
+        {
+            ScalingInstance& instance = *worker.instances[i];
+            if (instance.position + block > BENCH_NOISE_FRAMES)
+                instance.position = 0;
+
+            const float* inputs[2] = { &noiseL[instance.position], &noiseR[instance.position] };
+            float* outputs[2] = { &instance.outL[0], &instance.outR[0] };
+
+            Clock::time_point start = Clock::now();
+            instance.dsp->run(inputs, outputs, block);
+            if (recording)
+                worker.callbackNs.push_back(std::chrono::duration<float, std::nano>(Clock::now() - start).count());
+
+            instance.position += block;
+        }
+    }
+
+    std::vector<ScalingWorker> workers;
+    uint32_t block;
+    const std::vector<float>& noiseL;
+    const std::vector<float>& noiseR;
+    std::atomic<uint64_t> period;
+    std::atomic<size_t> done;
+    bool recording;
+    volatile bool stop;
+};
+
+static void printHeader(const BenchOptions& options)
+{
+    if (options.csv)
+    {
+        std::printf("instances,threads,rate,block,realtime_factor,ns_per_sample,"
+                    "callback_p50_us,callback_p99_us,callback_p999_us,"
+                    "period_p50_us,period_p99_us,period_p999_us,period_max_load,"
+                    "memory_bytes,bytes_per_instance\n");
+        return;
+    }
+
+    std::printf("%5s %4s %6s %5s %9s %8s | %8s %8s %8s | %8s %8s %8s %7s | %9s %9s\n",
+                "inst", "thr", "rate", "block", "rt-factor", "ns/smp",
+                "cb p50", "cb p99", "cb p999", "per p50", "per p99", "per p999", "max %",
+                "mem MiB", "KiB/inst");
+}
+
+int runScaling(const BenchOptions& options, const std::vector<std::vector<float> >& states)
+{
+    std::vector<float> noiseL(BENCH_NOISE_FRAMES + BENCH_MAX_BLOCK);
+    std::vector<float> noiseR(BENCH_NOISE_FRAMES + BENCH_MAX_BLOCK);
+    fillNoise(noiseL, 0x12345678u);
+    fillNoise(noiseR, options.mono ? 0x12345678u : 0x9abcdef0u);
+
+    unsigned cores = std::thread::hardware_concurrency();
+    for (size_t t = 0; t < options.threads.size(); t++)
+    {
+        if (cores > 0 && static_cast<unsigned>(options.threads[t]) > cores)
+            std::fprintf(stderr, "Warning: %d threads on %u cores, periods will include scheduling delays\n",
+                         options.threads[t], cores);
+    }
+
+    printHeader(options);
+
+    for (size_t r = 0; r < options.rates.size(); r++)
+    {
+        double rate = options.rates[r];
+        for (size_t b = 0; b < options.blocks.size(); b++)
+        {
+            uint32_t block = static_cast<uint32_t>(options.blocks[b]);
+            uint64_t periods = std::max<uint64_t>(1, static_cast<uint64_t>(rate * options.seconds / block));
+            uint64_t warmupPeriods = static_cast<uint64_t>(rate * SCALING_WARMUP_SECONDS / block) + 1;
+
+            for (size_t n = 0; n < options.instances.size(); n++)
+            {
+                size_t count = static_cast<size_t>(options.instances[n]);
+                size_t before = residentBytes();
+
+                // Instances cycle through the selected types, and through the
+                // factory programs for their parameters, for a session-like mix
+                std::vector<ScalingInstance> instances(count);
+                for (size_t i = 0; i < count; i++)
+                {
+                    ScalingInstance& instance = instances[i];
+                    instance.dsp.reset(new StudioReverbDSP(rate));
+                    instance.position = static_cast<uint32_t>((i * 7919) % BENCH_NOISE_FRAMES);
+                    instance.outL.resize(block);
+                    instance.outR.resize(block);
+
+                    if (options.irFile != nullptr && !instance.dsp->loadImpulseFile(options.irFile))
+                    {
+                        std::fprintf(stderr, "Could not load impulse response: %s\n", options.irFile);
+                        return 1;
+                    }
+
+                    const std::vector<float>& state =
+                        states[options.programs[(i / options.types.size()) % options.programs.size()]];
+                    for (uint32_t p = 0; p < paramCount; p++)
+                    {
+                        if (p != paramReverbType)
+                            instance.dsp->setParameterValue(p, state[p]);
+                    }
+                    instance.dsp->setParameterValue(paramReverbType,
+                        static_cast<float>(options.types[i % options.types.size()]));
+                }
+
+                std::vector<float> periodNs;
+                std::vector<float> callbackNs;
+                size_t memory = 0;
+
+                for (size_t t = 0; t < options.threads.size(); t++)
+                {
+                    uint32_t threadCount = static_cast<uint32_t>(options.threads[t]);
+                    ScalingRun run(instances, threadCount, block, noiseL, noiseR);
+
+                    // Touches every buffer, the footprint is taken after the first warmup
+                    run.run(warmupPeriods, false, periodNs);
+                    if (memory == 0)
+                    {
+                        size_t after = residentBytes();
+                        memory = after > before ? after - before : 0;
+                    }
+
+                    Clock::time_point start = Clock::now();
+                    run.run(periods, true, periodNs);
+                    double wallNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+                    run.collectCallbacks(callbackNs);
+                    ScalingStats callback = percentiles(callbackNs);
+                    ScalingStats perPeriod = percentiles(periodNs);
+
+                    double samples = static_cast<double>(periods) * block * count;
+                    double realtimeFactor = (samples / rate) / (wallNs * 1e-9);
+                    double nsPerSample = wallNs / samples;
+                    double deadlineNs = 1e9 * block / rate;
+
+                    if (options.csv)
+                    {
+                        std::printf("%zu,%u,%d,%u,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%zu,%zu\n",
+                                    count, threadCount, options.rates[r], block, realtimeFactor, nsPerSample,
+                                    callback.p50 * 1e-3, callback.p99 * 1e-3, callback.p999 * 1e-3,
+                                    perPeriod.p50 * 1e-3, perPeriod.p99 * 1e-3, perPeriod.p999 * 1e-3,
+                                    perPeriod.max / deadlineNs, memory, memory / count);
+                    }
+                    else
+                    {
+                        std::printf("%5zu %4u %6d %5u %9.1f %8.2f | %8.2f %8.2f %8.2f | %8.2f %8.2f %8.2f %7.1f | %9.1f %9.1f\n",
+                                    count, threadCount, options.rates[r], block, realtimeFactor, nsPerSample,
+                                    callback.p50 * 1e-3, callback.p99 * 1e-3, callback.p999 * 1e-3,
+                                    perPeriod.p50 * 1e-3, perPeriod.p99 * 1e-3, perPeriod.p999 * 1e-3,
+                                    100.0 * perPeriod.max / deadlineNs,
+                                    memory / (1024.0 * 1024.0), memory / (1024.0 * count));
+                    }
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Studio Reverb Offline Benchmark
+ * Sends mode, N sources in one shared tank against N separate engines
+ */
+
+#include "bench.hpp"
+#include "Programs.hpp"
+#include "ReverbSends.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static const double SENDS_WARMUP_SECONDS = 0.25;
+
+typedef std::chrono::steady_clock Clock;
+
+// The same sources for both setups, each reading the noise at its own offset
+class SendsInput
+{
+public:
+    SendsInput(size_t count, uint32_t block, const std::vector<float>& noiseL, const std::vector<float>& noiseR)
+        : positions(count),
+          inputs(2 * count),
+          block(block),
+          noiseL(noiseL),
+          noiseR(noiseR)
+    {
+        for (size_t s = 0; s < count; s++)
+            positions[s] = static_cast<uint32_t>((s * 7919) % BENCH_NOISE_FRAMES);
+    }
+
+    // Inputs of the next block, planar stereo per source
+    const float** next()
+    {
+        for (size_t s = 0; s < positions.size(); s++)
+        {
+            if (positions[s] + block > BENCH_NOISE_FRAMES)
+                positions[s] = 0;
+            inputs[2 * s] = &noiseL[positions[s]];
+            inputs[2 * s + 1] = &noiseR[positions[s]];
+            positions[s] += block;
+        }
+        return &inputs[0];
+    }
+
+private:
+    std::vector<uint32_t> positions;
+    std::vector<const float*> inputs;
+    uint32_t block;
+    const std::vector<float>& noiseL;
+    const std::vector<float>& noiseR;
+};
+
+// The space with every source at send and early gains of 1, no pre-delay
+static double timeSends(StudioReverbSends& sends, SendsInput& input, uint32_t block,
+                        uint64_t warmupPeriods, uint64_t periods)
+{
+    std::vector<float> outL(block), outR(block);
+    float* outputs[2] = { &outL[0], &outR[0] };
+
+    for (uint64_t p = 0; p < warmupPeriods; p++)
+        sends.run(input.next(), outputs, block);
+
+    Clock::time_point start = Clock::now();
+    for (uint64_t p = 0; p < periods; p++)
+        sends.run(input.next(), outputs, block);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// One engine per source at Dry 0, what the space replaces
+static void runEngines(std::vector<std::unique_ptr<StudioReverbDSP> >& engines, SendsInput& input,
+                       float** outputs, uint32_t block)
+{
+    const float** inputs = input.next();
+    for (size_t e = 0; e < engines.size(); e++)
+        engines[e]->run(inputs + 2 * e, outputs, block);
+}
+
+static double timeEngines(std::vector<std::unique_ptr<StudioReverbDSP> >& engines, SendsInput& input,
+                          uint32_t block, uint64_t warmupPeriods, uint64_t periods)
+{
+    std::vector<float> outL(block), outR(block);
+    float* outputs[2] = { &outL[0], &outR[0] };
+
+    for (uint64_t p = 0; p < warmupPeriods; p++)
+        runEngines(engines, input, outputs, block);
+
+    Clock::time_point start = Clock::now();
+    for (uint64_t p = 0; p < periods; p++)
+        runEngines(engines, input, outputs, block);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static void printHeader(const BenchOptions& options)
+{
+    if (options.csv)
+    {
+        std::printf("type,rate,block,sources,sends_ns_per_sample,engines_ns_per_sample,time_ratio,"
+                    "sends_memory_bytes,engines_memory_bytes,memory_ratio\n");
+        return;
+    }
+
+    std::printf("%-7s %6s %5s %7s | %10s %10s %7s | %9s %9s %7s\n",
+                "type", "rate", "block", "sources", "sends ns", "engines ns", "time %",
+                "sends MiB", "eng MiB", "mem %");
+}
+
+int runSends(const BenchOptions& options, const std::vector<std::vector<float> >& states)
+{
+    std::vector<float> noiseL(BENCH_NOISE_FRAMES + BENCH_MAX_BLOCK);
+    std::vector<float> noiseR(BENCH_NOISE_FRAMES + BENCH_MAX_BLOCK);
+    fillNoise(noiseL, 0x12345678u);
+    fillNoise(noiseR, options.mono ? 0x12345678u : 0x9abcdef0u);
+
+    const std::vector<float>& state = states[options.programs[0]];
+
+    printHeader(options);
+
+    for (size_t r = 0; r < options.rates.size(); r++)
+    {
+        double rate = options.rates[r];
+        for (size_t b = 0; b < options.blocks.size(); b++)
+        {
+            uint32_t block = static_cast<uint32_t>(options.blocks[b]);
+            uint64_t periods = std::max<uint64_t>(1, static_cast<uint64_t>(rate * options.seconds / block));
+            uint64_t warmupPeriods = static_cast<uint64_t>(rate * SENDS_WARMUP_SECONDS / block) + 1;
+
+            for (size_t t = 0; t < options.types.size(); t++)
+            {
+                ReverbType type = static_cast<ReverbType>(options.types[t]);
+                for (size_t n = 0; n < options.instances.size(); n++)
+                {
+                    size_t count = static_cast<size_t>(options.instances[n]);
+
+                    StudioReverbSends sends(type, static_cast<uint32_t>(count), rate);
+                    std::vector<std::unique_ptr<StudioReverbDSP> > engines(count);
+                    for (size_t e = 0; e < count; e++)
+                        engines[e].reset(new StudioReverbDSP(rate));
+
+                    for (uint32_t p = 0; p < paramCount; p++)
+                    {
+                        if (p == paramReverbType)
+                            continue;
+                        sends.setParameterValue(p, state[p]);
+                        for (size_t e = 0; e < count; e++)
+                            engines[e]->setParameterValue(p, p == paramDry ? 0.0f : state[p]);
+                    }
+                    for (size_t e = 0; e < count; e++)
+                        engines[e]->setParameterValue(paramReverbType, static_cast<float>(type));
+
+                    SendsInput sendsInput(count, block, noiseL, noiseR);
+                    SendsInput enginesInput(count, block, noiseL, noiseR);
+                    double sendsNs = timeSends(sends, sendsInput, block, warmupPeriods, periods);
+                    double enginesNs = timeEngines(engines, enginesInput, block, warmupPeriods, periods);
+
+                    size_t sendsMemory = sends.getMemorySize();
+                    size_t enginesMemory = 0;
+                    for (size_t e = 0; e < count; e++)
+                        enginesMemory += engines[e]->getMemorySize();
+
+                    // Per frame of the mix, all sources together
+                    double frames = static_cast<double>(periods) * block;
+                    double timeRatio = sendsNs / enginesNs;
+                    double memoryRatio = static_cast<double>(sendsMemory) / enginesMemory;
+
+                    if (options.csv)
+                    {
+                        std::printf("%s,%d,%u,%zu,%.3f,%.3f,%.4f,%zu,%zu,%.4f\n",
+                                    benchTypeNames[type], options.rates[r], block, count,
+                                    sendsNs / frames, enginesNs / frames, timeRatio,
+                                    sendsMemory, enginesMemory, memoryRatio);
+                    }
+                    else
+                    {
+                        std::printf("%-7s %6d %5u %7zu | %10.1f %10.1f %7.1f | %9.2f %9.2f %7.1f\n",
+                                    benchTypeNames[type], options.rates[r], block, count,
+                                    sendsNs / frames, enginesNs / frames, 100.0 * timeRatio,
+                                    sendsMemory / (1024.0 * 1024.0), enginesMemory / (1024.0 * 1024.0),
+                                    100.0 * memoryRatio);
+                    }
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Studio Reverb Offline Analysis
+ * FFT and convolution shared by the analysis tools
+ */
+
+#include "spectrum.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+size_t fftSize(size_t length)
+{
+    size_t size = 1;
+    while (size < length)
+        size <<= 1;
+    return size;
+}
+
+void fft(std::vector<std::complex<double> >& data, bool inverse)
+{
+    size_t n = data.size();
+    if (n < 2)
+        return;
+
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    // Twiddles computed once for the largest stage, the recurrence would
+    // lose too much precision over a million points
+    double sign = inverse ? 1.0 : -1.0;
+    std::vector<std::complex<double> > twiddles(n / 2);
+    for (size_t k = 0; k < n / 2; k++)
+        twiddles[k] = std::polar(1.0, sign * 2.0 * M_PI * k / n);
+
+    for (size_t length = 2; length <= n; length <<= 1)
+    {
+        size_t half = length / 2, stride = n / length;
+        for (size_t start = 0; start < n; start += length)
+        {
+            for (size_t k = 0; k < half; k++)
+            {
+                std::complex<double> even = data[start + k];
+                std::complex<double> odd = data[start + k + half] * twiddles[k * stride];
+                data[start + k] = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+
+    if (inverse)
+    {
+        for (size_t i = 0; i < n; i++)
+            data[i] /= static_cast<double>(n);
+    }
+}
+
+void convolve(const std::vector<double>& a, const std::vector<double>& b, std::vector<double>& result)
+{
+    result.clear();
+    if (a.empty() || b.empty())
+        return;
+
+    size_t length = a.size() + b.size() - 1;
+    size_t n = fftSize(length);
+    std::vector<std::complex<double> > fa(n), fb(n);
+    std::copy(a.begin(), a.end(), fa.begin());
+    std::copy(b.begin(), b.end(), fb.begin());
+    fft(fa);
+    fft(fb);
+    for (size_t i = 0; i < n; i++)
+        fa[i] *= fb[i];
+    fft(fa, true);
+
+    result.resize(length);
+    for (size_t i = 0; i < length; i++)
+        result[i] = fa[i].real();
+}
@@ -0,0 +1,23 @@
+/*
+ * Studio Reverb Offline Analysis
+ * FFT and convolution shared by the analysis tools
+ */
+
+#ifndef STUDIO_REVERB_SPECTRUM_HPP_INCLUDED
+#define STUDIO_REVERB_SPECTRUM_HPP_INCLUDED
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Smallest power of two of at least length
+size_t fftSize(size_t length);
+
+// In place radix-2 FFT, the size must be a power of two. The inverse is
+// scaled by 1/N, so a forward and inverse pair returns the input.
+void fft(std::vector<std::complex<double> >& data, bool inverse = false);
+
+// Linear convolution, a.size() + b.size() - 1 samples
+void convolve(const std::vector<double>& a, const std::vector<double>& b, std::vector<double>& result);
+
+#endif // STUDIO_REVERB_SPECTRUM_HPP_INCLUDED
@@ -0,0 +1,198 @@
+/*
+ * Studio Reverb Telemetry Reader
+ * Lists the instances that publish telemetry, see Telemetry.hpp
+ */
+
+#include "DistrhoPluginInfo.h"
+#include "Telemetry.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const char* const typeNames[REVERB_TYPE_COUNT] = {
+    "room", "hall", "plate", "early", "hybrid"
+};
+
+// An instance whose last update is older than this is shown as stalled (ms)
+static const double STALLED_MS = 500.0;
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options] [PID...]\n"
+        "Shows the Studio Reverb instances of each process, all processes without PID.\n"
+        "Instances publish telemetry when started with %s=1.\n"
+        "  --watch S   refresh every S seconds\n"
+        "  --csv       comma separated output\n",
+        name, TELEMETRY_ENV);
+}
+
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Processes with a segment, found in /dev/shm where POSIX shm is a tmpfs
+static void findProcesses(std::vector<long>& pids)
+{
+    DIR* dir = opendir("/dev/shm");
+    if (dir == nullptr)
+        return;
+
+    // The names in /dev/shm have no leading slash
+    const char* prefix = TELEMETRY_PREFIX + 1;
+    size_t prefixLength = std::strlen(prefix);
+    while (struct dirent* entry = readdir(dir))
+    {
+        if (std::strncmp(entry->d_name, prefix, prefixLength) == 0)
+            pids.push_back(std::atol(entry->d_name + prefixLength));
+    }
+    closedir(dir);
+}
+
+static const TelemetrySegment* mapSegment(long pid)
+{
+    char name[64];
+    telemetrySegmentName(name, sizeof(name), pid);
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+    void* memory = mmap(nullptr, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return nullptr;
+
+    const TelemetrySegment* segment = static_cast<const TelemetrySegment*>(memory);
+    if (segment->magic != TELEMETRY_MAGIC || segment->version != TELEMETRY_VERSION ||
+        segment->slotCount != TELEMETRY_SLOTS || segment->slotSize != sizeof(TelemetrySlot))
+    {
+        std::fprintf(stderr, "Process %ld: unknown telemetry layout\n", pid);
+        munmap(memory, sizeof(TelemetrySegment));
+        return nullptr;
+    }
+    return segment;
+}
+
+static void printHeader(bool csv)
+{
+    if (csv)
+    {
+        std::printf("pid,instance,algorithm,sample_rate,block,average_run_us,max_run_us,"
+                    "average_load,memory_bytes,sleeping,tail_active,blocks,age_ms\n");
+        return;
+    }
+    std::printf("%7s %5s %-7s %6s %5s %9s %9s %6s %9s %-8s %12s\n",
+                "pid", "inst", "type", "rate", "block", "avg us", "max us", "load %",
+                "mem KiB", "state", "blocks");
+}
+
+static int printProcess(long pid, bool csv)
+{
+    const TelemetrySegment* segment = mapSegment(pid);
+    if (segment == nullptr)
+        return 0;
+
+    uint64_t now = monotonicNs();
+    int count = 0;
+    for (uint32_t i = 0; i < TELEMETRY_SLOTS; i++)
+    {
+        const TelemetrySlot& slot = segment->slots[i];
+        if (slot.state.load(std::memory_order_acquire) != TELEMETRY_SLOT_USED)
+            continue;
+
+        uint32_t algorithm = slot.algorithm.load(std::memory_order_relaxed);
+        uint32_t rate = slot.sampleRate.load(std::memory_order_relaxed);
+        uint32_t block = slot.blockSize.load(std::memory_order_relaxed);
+        uint64_t average = slot.averageRunNs.load(std::memory_order_relaxed);
+        uint64_t max = slot.maxRunNs.load(std::memory_order_relaxed);
+        uint64_t memory = slot.memoryBytes.load(std::memory_order_relaxed);
+        bool sleeping = slot.sleeping.load(std::memory_order_relaxed) != 0;
+        bool tail = slot.tailActive.load(std::memory_order_relaxed) != 0;
+        uint64_t blocks = slot.blocks.load(std::memory_order_relaxed);
+        uint64_t updated = slot.updatedNs.load(std::memory_order_relaxed);
+        double ageMs = now > updated ? (now - updated) * 1e-6 : 0.0;
+
+        double load = (rate > 0 && block > 0) ? average * 1e-9 * rate / block : 0.0;
+        const char* type = algorithm < REVERB_TYPE_COUNT ? typeNames[algorithm] : "?";
+
+        if (csv)
+        {
+            std::printf("%ld,%u,%s,%u,%u,%.2f,%.2f,%.4f,%llu,%d,%d,%llu,%.1f\n",
+                        pid, slot.instance.load(std::memory_order_relaxed), type, rate, block,
+                        average * 1e-3, max * 1e-3, load, static_cast<unsigned long long>(memory),
+                        sleeping ? 1 : 0, tail ? 1 : 0, static_cast<unsigned long long>(blocks), ageMs);
+        }
+        else
+        {
+            const char* state = sleeping ? "sleep" : ageMs > STALLED_MS ? "stalled" : tail ? "tail" : "silent";
+            std::printf("%7ld %5u %-7s %6u %5u %9.1f %9.1f %6.1f %9.0f %-8s %12llu\n",
+                        pid, slot.instance.load(std::memory_order_relaxed), type, rate, block,
+                        average * 1e-3, max * 1e-3, load * 100.0, memory / 1024.0, state,
+                        static_cast<unsigned long long>(blocks));
+        }
+        count++;
+    }
+
+    munmap(const_cast<TelemetrySegment*>(segment), sizeof(TelemetrySegment));
+    return count;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<long> pids;
+    double watch = 0.0;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+            watch = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if (argv[i][0] != '-' && std::atol(argv[i]) > 0)
+            pids.push_back(std::atol(argv[i]));
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bool scan = pids.empty();
+    for (;;)
+    {
+        if (scan)
+        {
+            pids.clear();
+            findProcesses(pids);
+        }
+
+        printHeader(csv);
+        int count = 0;
+        for (size_t p = 0; p < pids.size(); p++)
+            count += printProcess(pids[p], csv);
+        if (count == 0 && !csv)
+            std::printf("No instances publish telemetry (start the host with %s=1)\n", TELEMETRY_ENV);
+        std::fflush(stdout);
+
+        if (watch <= 0.0)
+            break;
+        usleep(static_cast<useconds_t>(watch * 1e6));
+        if (!csv)
+            std::printf("\n");
+    }
+
+    return 0;
+}